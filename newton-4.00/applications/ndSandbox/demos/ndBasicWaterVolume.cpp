@@ -157,8 +157,7 @@ class ndWaterVolumeCallback: public ndDemoEntityNotify
 		ndBodySphFluid* const fluid = GetBody()->GetAsBodySphFluid();
 		dAssert(fluid);
 
-		//fluid->GenerateIsoSurface(m_manager->GetWorld(), 0.25f);
-		fluid->GenerateIsoSurface(m_manager->GetWorld());
+		// the fluid rebuilds the iso surface once per update
 		const dIsoSurface& isoSurface = fluid->GetIsoSurface();
 
 		ndWaterVolumeEntity* const entity = (ndWaterVolumeEntity*)GetUserData();
@@ -183,6 +182,7 @@ static void AddWaterVolume(ndDemoEntityManager* const scene, const dMatrix& loca
 	fluidObject->SetMatrix(matrix);
 
 	fluidObject->SetParticleRadius(diameter * 0.5f);
+	fluidObject->SetUpdateIsoSurface(true);
 
 	//dInt32 particleCountPerAxis = 32;
 	dInt32 particleCountPerAxis = 1;
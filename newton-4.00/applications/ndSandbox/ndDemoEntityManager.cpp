@@ -633,6 +633,7 @@ void ndDemoEntityManager::ShowMainMenuBar()
 			ImGui::Text("solvers");
 			ImGui::RadioButton("default", &m_solverMode, 0);
 			ImGui::RadioButton("avx2", &m_solverMode, 1);
+			ImGui::RadioButton("block jacobi", &m_solverMode, 2);
 			ImGui::Separator();
 
 			//int index = 0;
@@ -962,7 +963,8 @@ void ndDemoEntityManager::RenderStats()
 			sprintf(text, "Substeps:       %d", m_world->GetSubSteps());
 			ImGui::Text(text, "");
 
-			sprintf(text, "%s", m_solverMode ? "solver:         avx2" : "solver:         default");
+			const char* const solverNames[] = { "solver:         default", "solver:         avx2", "solver:         block jacobi" };
+			sprintf(text, "%s", solverNames[m_solverMode]);
 			ImGui::Text(text, "");
 
 			m_suspendPhysicsUpdate = m_suspendPhysicsUpdate || (ImGui::IsMouseHoveringWindow() && ImGui::IsMouseDown(0));  
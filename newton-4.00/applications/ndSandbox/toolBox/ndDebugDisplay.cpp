@@ -408,9 +408,9 @@ void RenderContactPoints(ndDemoEntityManager* const scene)
 	glEnableClientState(GL_VERTEX_ARRAY);
 	glVertexPointer(3, GL_FLOAT, sizeof (ndMeshVector), pointBuffer);
 	const ndContactList& contactList = world->GetContactList();
-	for (ndContactList::dListNode* contactNode = contactList.GetFirst(); contactNode; contactNode = contactNode->GetNext())
+	for (dInt32 i = 0; i < contactList.GetCount(); i++)
 	{
-		const ndContact* const contact = &contactNode->GetInfo();
+		const ndContact* const contact = contactList.GetContact(i);
 		if (contact->IsActive())
 		{
 			const ndContactPointList& contactPoints = contact->GetContactPoints();
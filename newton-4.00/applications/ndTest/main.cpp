@@ -10,12 +10,16 @@
 */
 
 #include "testStdafx.h"
+#include "testCases.h"
 
 
+static dUnsigned64 g_peakMemory = 0;
+
 // memory allocation for Newton
 static void* PhysicsAlloc(size_t sizeInBytes)
 {
 	void* const ptr = malloc(sizeInBytes);
+	g_peakMemory = dMax(g_peakMemory, dMemory::GetMemoryUsed() + sizeInBytes);
 	return ptr;
 }
 
@@ -98,6 +102,44 @@ class ndDemoEntityNotify: public ndBodyNotify
 	void* m_applicationUserData;
 };
 
+static int g_failedChecks = 0;
+static dUnsigned32 g_randSeed = 0;
+
+void ndTestCheck(bool passed, const char* const expression, const char* const file, int line)
+{
+	if (!passed)
+	{
+		g_failedChecks++;
+		printf("%s(%d): check failed: %s\n", file, line, expression);
+	}
+}
+
+dFloat64 ndTestTime()
+{
+	return dFloat64(dGetTimeInMicrosenconds()) * dFloat64(1.0e-3f);
+}
+
+void ndTestSetRandSeed(dUnsigned32 seed)
+{
+	g_randSeed = seed;
+}
+
+dFloat32 ndTestRand()
+{
+	g_randSeed = g_randSeed * 1664525u + 1013904223u;
+	return dFloat32(g_randSeed >> 8) * dFloat32(1.0f / 16777216.0f);
+}
+
+void ndTestResetPeakMemory()
+{
+	g_peakMemory = dMemory::GetMemoryUsed();
+}
+
+dUnsigned64 ndTestPeakMemory()
+{
+	return g_peakMemory;
+}
+
 dVector FindFloor(const ndWorld& world, const dVector& origin, dFloat32 dist)
 {
 	// shot a vertical ray from a high altitude and collect the intersection parameter.
@@ -208,6 +250,25 @@ matrix.m_posit.m_y += xxxx;
 
 int main (int argc, const char * argv[]) 
 {
+	bool benchmark = false;
+	for (int i = 1; i < argc; i++)
+	{
+		benchmark = benchmark || !strcmp(argv[i], "-bench");
+	}
+
+	TestPolygonSoup(benchmark);
+	TestPolygonSoupBuilder(benchmark);
+	TestStaticWorldStreamer(benchmark);
+	TestConvexHullSupport(benchmark);
+	TestIsoSurface(benchmark);
+	TestSphFluid(benchmark);
+	TestForceField(benchmark);
+	TestTransformExport(benchmark);
+	TestRowKernels(benchmark);
+	TestTriggerVolume(benchmark);
+	TestSelectScene(benchmark);
+	TestContinueCollision(benchmark);
+
 	ndWorld world;
 	world.SetSubSteps(2);
 	//world.SetThreadCount(2);
@@ -237,5 +298,9 @@ int main (int argc, const char * argv[])
 		//newton.Sync();
 	}
 
-	return 0;
+	if (g_failedChecks)
+	{
+		printf("%d checks failed\n", g_failedChecks);
+	}
+	return g_failedChecks ? 1 : 0;
 }
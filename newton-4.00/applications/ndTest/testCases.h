@@ -0,0 +1,44 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#ifndef _TEST_CASES_H_
+#define _TEST_CASES_H_
+
+#include "testStdafx.h"
+
+// a failed check is reported and makes the test return an error code.
+#define D_TEST_CHECK(expression) ndTestCheck(bool(expression), #expression, __FILE__, __LINE__)
+
+void ndTestCheck(bool passed, const char* const expression, const char* const file, int line);
+dFloat64 ndTestTime();
+dFloat32 ndTestRand();
+void ndTestSetRandSeed(dUnsigned32 seed);
+
+// peak of the memory allocated by the engine since the last reset
+void ndTestResetPeakMemory();
+dUnsigned64 ndTestPeakMemory();
+
+// every test runs its checks, the timings are only
+// measured and printed when the test runs with -bench.
+void TestPolygonSoup(bool benchmark);
+void TestPolygonSoupBuilder(bool benchmark);
+void TestStaticWorldStreamer(bool benchmark);
+void TestConvexHullSupport(bool benchmark);
+void TestIsoSurface(bool benchmark);
+void TestSphFluid(bool benchmark);
+void TestForceField(bool benchmark);
+void TestTransformExport(bool benchmark);
+void TestRowKernels(bool benchmark);
+void TestTriggerVolume(bool benchmark);
+void TestSelectScene(bool benchmark);
+void TestContinueCollision(bool benchmark);
+
+#endif
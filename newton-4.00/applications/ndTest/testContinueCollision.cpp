@@ -0,0 +1,91 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#include "testStdafx.h"
+#include "testCases.h"
+
+#define D_TEST_TIMESTEP	dFloat32(1.0f / 60.0f)
+
+static ndBodyDynamic* AddBody(ndWorld& world, const dVector& posit, const dVector& veloc, ndShape* const shape)
+{
+	dMatrix matrix(dGetIdentityMatrix());
+	matrix.m_posit = posit;
+	matrix.m_posit.m_w = dFloat32(1.0f);
+	ndBodyDynamic* const body = new ndBodyDynamic();
+	body->SetNotifyCallback(new ndBodyNotify(dVector::m_zero));
+	body->SetMatrix(matrix);
+	body->SetCollisionShape(ndShapeInstance(shape));
+	body->SetMassMatrix(dFloat32(1.0f), body->GetCollisionShape());
+	body->SetAutoSleep(false);
+	body->SetVelocity(veloc);
+	world.AddBody(body);
+	return body;
+}
+
+// a fast sphere moving at an angle hits the center of a thin dynamic plate.
+// the sphere crosses three quarters of a meter along the plate in the step
+// of the impact, so the contact point must be placed where the bodies touch
+// for the impulse to spin the plate around the right lever arm.
+// the test also runs in the frame of the sphere, with the plate flying into 
+// it, so that the continue collision body is the one moving at the impact.
+static void CheckThinDynamicBox(bool plateMoves)
+{
+	ndWorld world;
+	world.SetThreadCount(1);
+
+	// the surface of the sphere reaches the plate 3.5 meters later, at z = 0
+	const dFloat32 thickness = dFloat32(0.1f);
+	const dFloat32 side = dFloat32(2.0f);
+	const dFloat32 radius = dFloat32(0.1f);
+	const dVector veloc(dFloat32(120.0f), dFloat32(0.0f), dFloat32(60.0f), dFloat32(0.0f));
+	const dVector posit(dFloat32(-3.5f) - thickness * dFloat32(0.5f) - radius, dFloat32(0.0f), dFloat32(-1.75f), dFloat32(1.0f));
+	const dVector plateVeloc(plateMoves ? veloc * dVector::m_negOne : dVector::m_zero);
+	const dVector platePosit(plateMoves ? (dVector::m_zero - posit) | dVector::m_wOne : dVector::m_wOne);
+	const dVector spherePosit(plateMoves ? dVector::m_wOne : posit);
+
+	ndBodyDynamic* const plate = AddBody(world, platePosit, plateVeloc, new ndShapeBox(thickness, side, side));
+	ndBodyDynamic* const sphere = AddBody(world, spherePosit, veloc + plateVeloc, new ndShapeSphere(radius));
+	ndBodyDynamic* const fastBody = plateMoves ? plate : sphere;
+	fastBody->SetContinueCollisionMode(true);
+
+	for (dInt32 i = 0; i < 4; i++)
+	{
+		const dVector diff(plate->GetVelocity() - plateVeloc);
+		if (diff.DotProduct(diff).GetScalar() > dFloat32(0.0f))
+		{
+			break;
+		}
+		world.Update(D_TEST_TIMESTEP);
+		world.Sync();
+	}
+
+	// the sphere did not go through, and the plate took the impulse at the
+	// center of the face, the angular velocity is the one of that lever arm.
+	const dVector impulse(plate->GetVelocity() - plateVeloc);
+	const dVector omega(plate->GetOmega());
+	const dVector arm(-thickness * dFloat32(0.5f), dFloat32(0.0f), dFloat32(0.0f), dFloat32(0.0f));
+	const dVector torque(arm.CrossProduct(impulse));
+	const dFloat32 inertia = (thickness * thickness + side * side) / dFloat32(12.0f);
+
+	D_TEST_CHECK(sphere->GetMatrix().m_posit.m_x < plate->GetMatrix().m_posit.m_x);
+	D_TEST_CHECK(impulse.m_x > dFloat32(10.0f));
+	D_TEST_CHECK(dAbs(omega.m_x) < dFloat32(0.1f));
+	D_TEST_CHECK(dAbs(omega.m_z) < dFloat32(0.1f));
+
+	// the lever arm along the plate is off by less than five centimeters
+	D_TEST_CHECK(dAbs(omega.m_y - torque.m_y / inertia) * inertia < dFloat32(0.05f) * impulse.m_x);
+}
+
+void TestContinueCollision(bool)
+{
+	CheckThinDynamicBox(false);
+	CheckThinDynamicBox(true);
+}
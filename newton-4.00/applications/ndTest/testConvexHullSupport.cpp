@@ -0,0 +1,114 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#include "testStdafx.h"
+#include "testCases.h"
+
+static dVector RandomDirection()
+{
+	dVector dir(ndTestRand() - dFloat32(0.5f), ndTestRand() - dFloat32(0.5f), ndTestRand() - dFloat32(0.5f), dFloat32(0.0f));
+	return dir.Normalize();
+}
+
+// points on a sphere, each one is a vertex of the hull
+static ndShapeConvexHull* CreateHull(dInt32 count)
+{
+	ndTestSetRandSeed(11);
+	dArray<dVector> points;
+	points.SetCount(count);
+	for (dInt32 i = 0; i < count; i++)
+	{
+		points[i] = RandomDirection();
+	}
+	return new ndShapeConvexHull(count, sizeof(dVector), dFloat32(0.0f), &points[0].m_x);
+}
+
+// the support vertex with or without a hint, and with or without hill 
+// climbing, must be as far along the direction as the brute force one.
+static void CheckSupport(dInt32 pointCount)
+{
+	ndShapeConvexHull* const hull = CreateHull(pointCount);
+	ndShapeInstance instance(hull);
+	const dInt32 vertexCount = instance.GetConvexVertexCount();
+
+	for (dInt32 mode = 0; mode < 2; mode++)
+	{
+		hull->SetSupportHillClimbing(mode ? true : false);
+		D_TEST_CHECK(hull->GetSupportHillClimbing() == (mode ? true : false));
+		dInt32 coherentIndex = -1;
+		for (dInt32 i = 0; i < 1000; i++)
+		{
+			const dVector dir(RandomDirection());
+			const dVector support(instance.SupportVertexSpecial(dir, nullptr));
+			const dFloat32 maxProjection = dir.DotProduct(support).GetScalar();
+
+			// a stale hint from the previous direction, and a foreign one from some other shape
+			dInt32 foreignIndex = dInt32(ndTestRand() * dFloat32(vertexCount)) % vertexCount;
+			const dVector coherent(instance.SupportVertexSpecial(dir, &coherentIndex));
+			const dVector foreign(instance.SupportVertexSpecial(dir, &foreignIndex));
+			D_TEST_CHECK(dAbs(dir.DotProduct(coherent).GetScalar() - maxProjection) < dFloat32(1.0e-5f));
+			D_TEST_CHECK(dAbs(dir.DotProduct(foreign).GetScalar() - maxProjection) < dFloat32(1.0e-5f));
+			D_TEST_CHECK((coherentIndex >= 0) && (coherentIndex < vertexCount));
+		}
+	}
+}
+
+static void Benchmark(dInt32 pointCount)
+{
+	ndShapeConvexHull* const hull = CreateHull(pointCount);
+	ndShapeInstance instance(hull);
+	const dInt32 count = 1000000;
+
+	dArray<dVector> randomDirs;
+	dArray<dVector> coherentDirs;
+	randomDirs.SetCount(count);
+	coherentDirs.SetCount(count);
+	const dMatrix rotation(dPitchMatrix(dFloat32(0.01f)) * dYawMatrix(dFloat32(0.013f)));
+	dVector dir(RandomDirection());
+	for (dInt32 i = 0; i < count; i++)
+	{
+		randomDirs[i] = RandomDirection();
+		coherentDirs[i] = dir;
+		dir = rotation.RotateVector(dir);
+	}
+
+	dFloat64 times[2][2];
+	dVector sum(dVector::m_zero);
+	for (dInt32 mode = 0; mode < 2; mode++)
+	{
+		hull->SetSupportHillClimbing(mode ? true : false);
+		for (dInt32 set = 0; set < 2; set++)
+		{
+			const dArray<dVector>& dirs = set ? randomDirs : coherentDirs;
+			dInt32 index = -1;
+			const dFloat64 time = ndTestTime();
+			for (dInt32 i = 0; i < count; i++)
+			{
+				sum += instance.SupportVertexSpecial(dirs[i], &index);
+			}
+			times[mode][set] = (ndTestTime() - time) * dFloat64(1.0e6f) / count;
+		}
+	}
+
+	printf("convex hull support %d vertices (ns per call): coherent %.0f, hill climbing %.0f; random %.0f, hill climbing %.0f (%g)\n",
+		instance.GetConvexVertexCount(), times[0][0], times[1][0], times[0][1], times[1][1], sum.m_x);
+}
+
+void TestConvexHullSupport(bool benchmark)
+{
+	CheckSupport(24);
+	CheckSupport(400);
+	if (benchmark)
+	{
+		Benchmark(24);
+		Benchmark(400);
+	}
+}
@@ -0,0 +1,182 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#include "testStdafx.h"
+#include "testCases.h"
+
+#define D_TEST_TIMESTEP	dFloat32(1.0f / 60.0f)
+
+// applies the gravity by calling the base notification
+class ndTestCountingNotify: public ndBodyNotify
+{
+	public:
+	ndTestCountingNotify(const dVector& gravity)
+		:ndBodyNotify(gravity)
+		,m_calls(0)
+	{
+	}
+
+	virtual void OnApplyExternalForce(dInt32 threadIndex, dFloat32 timestep)
+	{
+		m_calls++;
+		ndBodyNotify::OnApplyExternalForce(threadIndex, timestep);
+	}
+
+	dInt32 m_calls;
+};
+
+static ndBodyDynamic* AddBody(ndWorld& world, const dVector& posit, ndBodyNotify* const notify, ndShape* const shape)
+{
+	dMatrix matrix(dGetIdentityMatrix());
+	matrix.m_posit = posit;
+	matrix.m_posit.m_w = dFloat32(1.0f);
+	ndBodyDynamic* const body = new ndBodyDynamic();
+	body->SetNotifyCallback(notify);
+	body->SetMatrix(matrix);
+	body->SetCollisionShape(ndShapeInstance(shape));
+	body->SetMassMatrix(dFloat32(2.0f), body->GetCollisionShape());
+	world.AddBody(body);
+	return body;
+}
+
+static bool SameVector(const dVector& v0, const dVector& v1)
+{
+	const dVector diff((v1 - v0) & dVector::m_triplexMask);
+	return diff.DotProduct(diff).GetScalar() < dFloat32(1.0e-6f);
+}
+
+// the default gravity is applied directly only when the notification asks for it,
+// a notification that calls the base implementation is still called every step.
+static void CheckDefaultExternalForce()
+{
+	ndWorld world;
+	world.SetThreadCount(1);
+	const dVector gravity(dFloat32(0.0f), dFloat32(-10.0f), dFloat32(0.0f), dFloat32(0.0f));
+
+	ndBodyNotify* const notify = new ndBodyNotify(gravity);
+	notify->SetDefaultExternalForce(true);
+	ndBodyDynamic* const body0 = AddBody(world, dVector(dFloat32(0.0f), dFloat32(0.0f), dFloat32(0.0f), dFloat32(1.0f)), notify, new ndShapeSphere(dFloat32(0.5f)));
+
+	ndTestCountingNotify* const countingNotify = new ndTestCountingNotify(gravity);
+	ndBodyDynamic* const body1 = AddBody(world, dVector(dFloat32(10.0f), dFloat32(0.0f), dFloat32(0.0f), dFloat32(1.0f)), countingNotify, new ndShapeSphere(dFloat32(0.5f)));
+
+	for (dInt32 i = 0; i < 2; i++)
+	{
+		world.Update(D_TEST_TIMESTEP);
+		world.Sync();
+	}
+
+	const dVector veloc(gravity.Scale(D_TEST_TIMESTEP * dFloat32(2.0f)));
+	D_TEST_CHECK(SameVector(body0->GetVelocity(), veloc));
+	D_TEST_CHECK(SameVector(body1->GetVelocity(), veloc));
+	D_TEST_CHECK(countingNotify->m_calls == 2);
+	D_TEST_CHECK(!countingNotify->HasDefaultExternalForce());
+}
+
+// one body per field and one outside all of them, seven bodies also make a padded batch.
+static void CheckFields()
+{
+	ndWorld world;
+	world.SetThreadCount(1);
+
+	const dFloat32 height = dFloat32(10.0f);
+	const dVector gravity(dFloat32(0.0f), dFloat32(-10.0f), dFloat32(0.0f), dFloat32(0.0f));
+	ndForceFieldGravity* const gravityField = new ndForceFieldGravity(gravity);
+	gravityField->SetBox(dVector(dFloat32(-5.0f), dFloat32(-100.0f), dFloat32(-100.0f), dFloat32(0.0f)), dVector(dFloat32(10.0f), dFloat32(100.0f), dFloat32(100.0f), dFloat32(0.0f)));
+	world.AddForceField(gravityField);
+	world.AddForceField(new ndForceFieldRadial(dVector(dFloat32(100.0f), height, dFloat32(0.0f), dFloat32(0.0f)), dFloat32(10.0f), dFloat32(5.0f)));
+	world.AddForceField(new ndForceFieldWind(dVector(dFloat32(190.0f), dFloat32(-100.0f), dFloat32(-100.0f), dFloat32(0.0f)),
+		dVector(dFloat32(210.0f), dFloat32(100.0f), dFloat32(100.0f), dFloat32(0.0f)), dVector(dFloat32(0.0f), dFloat32(0.0f), dFloat32(4.0f), dFloat32(0.0f)), dFloat32(1.0f)));
+	world.AddForceField(new ndForceFieldBuoyancy(dPlane(dFloat32(0.0f), dFloat32(1.0f), dFloat32(0.0f), dFloat32(0.0f)), gravity, dFloat32(10.0f)));
+
+	ndBodyDynamic* bodies[7];
+	const dFloat32 xPositions[] = { dFloat32(0.0f), dFloat32(1.0f), dFloat32(2.0f), dFloat32(20.0f), dFloat32(103.0f), dFloat32(200.0f), dFloat32(300.0f) };
+	for (dInt32 i = 0; i < 7; i++)
+	{
+		// the last body is a unit box, half submerged
+		const bool submerged = (i == 6);
+		const dFloat32 y = submerged ? dFloat32(0.0f) : height;
+		ndShape* const shape = submerged ? (ndShape*)new ndShapeBox(dFloat32(1.0f), dFloat32(1.0f), dFloat32(1.0f)) : (ndShape*)new ndShapeSphere(dFloat32(0.5f));
+		bodies[i] = AddBody(world, dVector(xPositions[i], y, dFloat32(0.0f), dFloat32(1.0f)), new ndBodyNotify(dVector::m_zero), shape);
+	}
+
+	world.Update(D_TEST_TIMESTEP);
+	world.Sync();
+
+	const dFloat32 mass = dFloat32(2.0f);
+	for (dInt32 i = 0; i < 3; i++)
+	{
+		D_TEST_CHECK(SameVector(bodies[i]->GetVelocity(), gravity.Scale(D_TEST_TIMESTEP)));
+	}
+	D_TEST_CHECK(SameVector(bodies[3]->GetVelocity(), dVector::m_zero));
+
+	// three units from the center of a radial field of radius ten
+	const dFloat32 radialAccel = dFloat32(5.0f) * (dFloat32(1.0f) - dFloat32(0.3f));
+	D_TEST_CHECK(SameVector(bodies[4]->GetVelocity(), dVector(-radialAccel * D_TEST_TIMESTEP, dFloat32(0.0f), dFloat32(0.0f), dFloat32(0.0f))));
+
+	const dFloat32 windAccel = dFloat32(4.0f) / mass;
+	D_TEST_CHECK(SameVector(bodies[5]->GetVelocity(), dVector(dFloat32(0.0f), dFloat32(0.0f), windAccel * D_TEST_TIMESTEP, dFloat32(0.0f))));
+
+	// a buoyancy force of half the box volume of fluid
+	const dFloat32 volume = dFloat32(0.5f);
+	const dFloat32 buoyancyAccel = dFloat32(10.0f) * dFloat32(10.0f) * volume / mass;
+	const dVector veloc(bodies[6]->GetVelocity());
+	D_TEST_CHECK(dAbs(veloc.m_y - buoyancyAccel * D_TEST_TIMESTEP) < buoyancyAccel * D_TEST_TIMESTEP * dFloat32(0.02f));
+	D_TEST_CHECK(dAbs(veloc.m_x) + dAbs(veloc.m_z) < dFloat32(1.0e-4f));
+}
+
+static dFloat64 Benchmark(dInt32 size, bool fields)
+{
+	ndWorld world;
+	world.SetThreadCount(1);
+	const dVector gravity(dFloat32(0.0f), dFloat32(-10.0f), dFloat32(0.0f), dFloat32(0.0f));
+	if (fields)
+	{
+		const dFloat32 extent = dFloat32(3.0f * size);
+		world.AddForceField(new ndForceFieldRadial(dVector(extent * dFloat32(0.5f), dFloat32(0.0f), extent * dFloat32(0.5f), dFloat32(0.0f)), extent, dFloat32(1.0f)));
+		world.AddForceField(new ndForceFieldWind(dVector(dFloat32(0.0f), dFloat32(-100.0f), dFloat32(0.0f), dFloat32(0.0f)),
+			dVector(extent * dFloat32(0.5f), dFloat32(100.0f), extent, dFloat32(0.0f)), dVector(dFloat32(1.0f), dFloat32(0.0f), dFloat32(0.0f), dFloat32(0.0f)), dFloat32(0.1f)));
+		world.AddForceField(new ndForceFieldBuoyancy(dPlane(dFloat32(0.0f), dFloat32(1.0f), dFloat32(0.0f), dFloat32(100.0f)), gravity, dFloat32(1.0f)));
+	}
+	for (dInt32 z = 0; z < size; z++)
+	{
+		for (dInt32 x = 0; x < size; x++)
+		{
+			ndBodyNotify* const notify = new ndBodyNotify(gravity);
+			notify->SetDefaultExternalForce(true);
+			AddBody(world, dVector(dFloat32(3 * x), dFloat32(0.0f), dFloat32(3 * z), dFloat32(1.0f)), notify, new ndShapeSphere(dFloat32(0.5f)));
+		}
+	}
+
+	world.Update(D_TEST_TIMESTEP);
+	world.Sync();
+	const dInt32 steps = 10;
+	const dFloat64 time = ndTestTime();
+	for (dInt32 i = 0; i < steps; i++)
+	{
+		world.Update(D_TEST_TIMESTEP);
+		world.Sync();
+	}
+	return (ndTestTime() - time) / steps;
+}
+
+void TestForceField(bool benchmark)
+{
+	CheckDefaultExternalForce();
+	CheckFields();
+	if (benchmark)
+	{
+		const dInt32 size = 100;
+		const dFloat64 time0 = Benchmark(size, false);
+		const dFloat64 time1 = Benchmark(size, true);
+		printf("force fields %d bodies, 1 thread: update %.2f ms, with three fields %.2f ms\n", size * size, time0, time1);
+	}
+}
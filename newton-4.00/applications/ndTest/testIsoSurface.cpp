@@ -0,0 +1,190 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#include "testStdafx.h"
+#include "testCases.h"
+
+// points spacing apart, with a small jitter
+static void AddBlock(dArray<dVector>& points, dInt32 size, dFloat32 spacing, dFloat32 sphereRadius)
+{
+	ndTestSetRandSeed(5);
+	const dFloat32 center = dFloat32(size) * spacing * dFloat32(0.5f);
+	for (dInt32 z = 0; z < size; z++)
+	{
+		for (dInt32 y = 0; y < size; y++)
+		{
+			for (dInt32 x = 0; x < size; x++)
+			{
+				const dVector jitter(ndTestRand(), ndTestRand(), ndTestRand(), dFloat32(0.0f));
+				const dVector point((dVector(dFloat32(x), dFloat32(y), dFloat32(z), dFloat32(0.0f)) + ((jitter - dVector::m_half) & dVector::m_triplexMask).Scale(dFloat32(0.2f))).Scale(spacing));
+				const dVector dist(point - dVector(center, center, center, dFloat32(0.0f)));
+				if ((sphereRadius <= dFloat32(0.0f)) || (dist.DotProduct(dist).GetScalar() < sphereRadius * sphereRadius))
+				{
+					points.PushBack(point | dVector::m_wOne);
+				}
+			}
+		}
+	}
+}
+
+static dInt32 CompareEdges(const dUnsigned64* const edge0, const dUnsigned64* const edge1, void* const)
+{
+	if (*edge0 < *edge1)
+	{
+		return -1;
+	}
+	return (*edge0 > *edge1) ? 1 : 0;
+}
+
+// every edge of a closed surface is shared by two triangles.
+static bool IsClosed(const dIsoSurface& isoSurface)
+{
+	const dInt32 vertexCount = isoSurface.GetVertexCount();
+	const dInt32 indexCount = isoSurface.GetIndexCount();
+	if (!vertexCount || !indexCount || (indexCount % 3))
+	{
+		return false;
+	}
+
+	dArray<dUnsigned64> edges;
+	const dUnsigned64* const indices = isoSurface.GetIndexList();
+	for (dInt32 i = 0; i < indexCount; i += 3)
+	{
+		for (dInt32 j = 0; j < 3; j++)
+		{
+			const dUnsigned64 i0 = indices[i + j];
+			const dUnsigned64 i1 = indices[i + (j + 1) % 3];
+			if ((i0 >= dUnsigned64(vertexCount)) || (i1 >= dUnsigned64(vertexCount)))
+			{
+				return false;
+			}
+			edges.PushBack(dMin(i0, i1) * vertexCount + dMax(i0, i1));
+		}
+	}
+	dSort(&edges[0], edges.GetCount(), CompareEdges);
+
+	bool closed = true;
+	for (dInt32 i = 0; i < edges.GetCount(); i += 2)
+	{
+		closed = closed && ((i + 1) < edges.GetCount()) && (edges[i] == edges[i + 1]);
+		closed = closed && (((i + 2) >= edges.GetCount()) || (edges[i + 2] != edges[i]));
+	}
+	return closed;
+}
+
+// every vertex of the surface of a solid sphere is near the sphere.
+static bool IsNearSphere(const dIsoSurface& isoSurface, const dVector& center, dFloat32 radius0, dFloat32 radius1)
+{
+	bool inside = true;
+	const dVector* const vertex = isoSurface.GetPoints();
+	for (dInt32 i = 0; i < isoSurface.GetVertexCount(); i++)
+	{
+		const dVector dist((vertex[i] - center) & dVector::m_triplexMask);
+		const dFloat32 radius = dSqrt(dist.DotProduct(dist).GetScalar());
+		inside = inside && (radius > radius0) && (radius < radius1);
+	}
+	return inside;
+}
+
+static void CheckPointCloud()
+{
+	dArray<dVector> points;
+	AddBlock(points, 40, dFloat32(1.0f), dFloat32(20.0f));
+
+	dIsoSurface isoSurface;
+	isoSurface.GenerateMesh(nullptr, &points[0], points.GetCount(), dFloat32(1.0f), dFloat32(0.5f));
+	D_TEST_CHECK(IsClosed(isoSurface));
+	D_TEST_CHECK(IsNearSphere(isoSurface, dVector(dFloat32(20.0f), dFloat32(20.0f), dFloat32(20.0f), dFloat32(0.0f)), dFloat32(18.0f), dFloat32(21.5f)));
+}
+
+static ndBodySphFluid* AddFluid(ndWorld& world, const dArray<dVector>& points)
+{
+	ndBodySphFluid* const fluid = new ndBodySphFluid();
+	fluid->SetNotifyCallback(new ndBodyNotify(dVector::m_zero));
+	fluid->SetParticleRadius(dFloat32(0.5f));
+	for (dInt32 i = 0; i < points.GetCount(); i++)
+	{
+		fluid->AddParticle(dFloat32(0.02f), points[i], dVector::m_zero);
+	}
+	world.AddBody(fluid);
+	return fluid;
+}
+
+// the fluid builds the surface from its own grid, once per update. The
+// particles are one smoothing length apart, as in a fluid at rest.
+static void CheckFluid()
+{
+	dArray<dVector> points;
+	AddBlock(points, 48, dFloat32(0.5f), dFloat32(12.0f));
+
+	ndWorld world;
+	world.SetThreadCount(1);
+	world.SetSubSteps(2);
+	ndBodySphFluid* const fluid = AddFluid(world, points);
+	D_TEST_CHECK(fluid->GetIsoSurface().GetVertexCount() == 0);
+	fluid->SetUpdateIsoSurface(true);
+	world.Update(dFloat32(1.0f / 60.0f));
+	world.Sync();
+
+	const dIsoSurface& isoSurface = fluid->GetIsoSurface();
+	D_TEST_CHECK(IsClosed(isoSurface));
+	D_TEST_CHECK(IsNearSphere(isoSurface, dVector(dFloat32(12.0f), dFloat32(12.0f), dFloat32(12.0f), dFloat32(0.0f)), dFloat32(10.0f), dFloat32(13.5f)));
+}
+
+static void Benchmark()
+{
+	dArray<dVector> points;
+	AddBlock(points, 80, dFloat32(1.0f), dFloat32(0.0f));
+
+	dIsoSurface isoSurface;
+	dFloat64 bestTime = dFloat64(1.0e10f);
+	for (dInt32 i = 0; i < 4; i++)
+	{
+		const dFloat64 time = ndTestTime();
+		isoSurface.GenerateMesh(nullptr, &points[0], points.GetCount(), dFloat32(1.0f), dFloat32(0.5f));
+		bestTime = dMin(bestTime, ndTestTime() - time);
+	}
+	printf("iso surface %d points, 1 thread: %.1f ms, %d vertices, %d triangles\n",
+		points.GetCount(), bestTime, isoSurface.GetVertexCount(), isoSurface.GetIndexCount() / 3);
+
+	// the cost of the surface in a fluid update, with two substeps
+	dArray<dVector> particles;
+	AddBlock(particles, 80, dFloat32(0.5f), dFloat32(0.0f));
+	ndWorld world;
+	world.SetThreadCount(1);
+	world.SetSubSteps(2);
+	ndBodySphFluid* const fluid = AddFluid(world, particles);
+	dFloat64 updateTime[2];
+	for (dInt32 i = 0; i < 2; i++)
+	{
+		fluid->SetUpdateIsoSurface(i ? true : false);
+		updateTime[i] = dFloat64(1.0e10f);
+		for (dInt32 j = 0; j < 2; j++)
+		{
+			const dFloat64 time = ndTestTime();
+			world.Update(dFloat32(1.0f / 60.0f));
+			world.Sync();
+			updateTime[i] = dMin(updateTime[i], ndTestTime() - time);
+		}
+	}
+	printf("sph fluid %d particles, 1 thread, 2 substeps: update %.1f ms, with iso surface %.1f ms\n",
+		particles.GetCount(), updateTime[0], updateTime[1]);
+}
+
+void TestIsoSurface(bool benchmark)
+{
+	CheckPointCloud();
+	CheckFluid();
+	if (benchmark)
+	{
+		Benchmark();
+	}
+}
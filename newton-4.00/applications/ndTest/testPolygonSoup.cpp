@@ -0,0 +1,398 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#include "testStdafx.h"
+#include "testCases.h"
+
+#define D_TEST_SOUP_FILE			"ndTestPolygonSoup.bin"
+#define D_TEST_SOUP_LEGACY_FILE		"ndTestPolygonSoupLegacy.bin"
+
+// height field of random heights, two triangles per cell
+static void BuildHeightField(dPolygonSoupBuilder& builder, dInt32 size)
+{
+	ndTestSetRandSeed(3);
+	dArray<dFloat32> heights;
+	heights.SetCount((size + 1) * (size + 1));
+	for (dInt32 i = 0; i < heights.GetCount(); i++)
+	{
+		heights[i] = ndTestRand();
+	}
+
+	builder.Begin();
+	for (dInt32 z = 0; z < size; z++)
+	{
+		for (dInt32 x = 0; x < size; x++)
+		{
+			const dVector p00(dFloat32(x), heights[z * (size + 1) + x], dFloat32(z), dFloat32(0.0f));
+			const dVector p01(dFloat32(x), heights[(z + 1) * (size + 1) + x], dFloat32(z + 1), dFloat32(0.0f));
+			const dVector p11(dFloat32(x + 1), heights[(z + 1) * (size + 1) + x + 1], dFloat32(z + 1), dFloat32(0.0f));
+			const dVector p10(dFloat32(x + 1), heights[z * (size + 1) + x + 1], dFloat32(z), dFloat32(0.0f));
+			const dVector face0[] = { p00, p01, p11 };
+			const dVector face1[] = { p00, p11, p10 };
+			builder.AddFace(&face0[0].m_x, sizeof(dVector), 3, 0);
+			builder.AddFace(&face1[0].m_x, sizeof(dVector), 3, 0);
+		}
+	}
+	builder.End(false);
+}
+
+class ndTestPolygonSoup: public dAabbPolygonSoup
+{
+	public:
+	class ndFace
+	{
+		public:
+		dVector m_normal;
+		dVector m_points[3];
+	};
+
+	class ndRayContext
+	{
+		public:
+		const dFastRayTest* m_ray;
+		dFloat32 m_param;
+		dInt32 m_callbacks;
+	};
+
+	class ndBoxContext
+	{
+		public:
+		dArray<ndFace>* m_faces;
+		dVector m_centroidSum;
+		dInt32 m_count;
+	};
+
+	ndTestPolygonSoup()
+		:dAabbPolygonSoup()
+	{
+	}
+
+	ndTestPolygonSoup(const dPolygonSoupBuilder& builder)
+		:dAabbPolygonSoup()
+	{
+		Create(builder);
+	}
+
+	dFloat32 CastRay(const dFastRayTest& ray) const
+	{
+		ndRayContext context;
+		context.m_ray = &ray;
+		context.m_param = dFloat32(1.2f);
+		context.m_callbacks = 0;
+		ForAllSectorsRayHit(ray, dFloat32(1.0f), RayHit, &context);
+		return context.m_param;
+	}
+
+	// the callback returns the final hit right away, so only the tree is traversed.
+	void VisitRay(const dFastRayTest& ray, dFloat32 param) const
+	{
+		ForAllSectorsRayHit(ray, dFloat32(1.0f), RayVisit, &param);
+	}
+
+	void CollideBox(const dVector& p0, const dVector& p1, ndBoxContext& context) const
+	{
+		dFastAabbInfo box(p0, p1);
+		context.m_centroidSum = dVector::m_zero;
+		context.m_count = 0;
+		ForAllSectors(box, dVector::m_zero, dFloat32(1.0f), BoxHit, &context);
+	}
+
+	// the brute force references use the faces stored in the soup
+	// so that they do the same arithmetic than the traversals.
+	void GetFaces(dArray<ndFace>& faces) const
+	{
+		dVector p0;
+		dVector p1;
+		GetAABB(p0, p1);
+		ndBoxContext context;
+		context.m_faces = &faces;
+		CollideBox(p0 - dVector::m_one, p1 + dVector::m_one, context);
+	}
+
+	private:
+	static dFloat32 RayHit(void* const context, const dFloat32* const polygon, dInt32 strideInBytes, const dInt32* const indexArray, dInt32 indexCount)
+	{
+		ndRayContext* const data = (ndRayContext*)context;
+		const dInt32 stride = strideInBytes / sizeof(dFloat32);
+		dVector normal(&polygon[indexArray[indexCount + 1] * stride]);
+		normal = normal & dVector::m_triplexMask;
+		const dFloat32 param = data->m_ray->PolygonIntersect(normal, dFloat32(1.0f), polygon, strideInBytes, indexArray, indexCount);
+		data->m_param = dMin(data->m_param, param);
+		data->m_callbacks++;
+		return param;
+	}
+
+	static dFloat32 RayVisit(void* const context, const dFloat32* const, dInt32, const dInt32* const, dInt32)
+	{
+		return *((dFloat32*)context);
+	}
+
+	static dIntersectStatus BoxHit(void* const context, const dFloat32* const polygon, dInt32 strideInBytes, const dInt32* const indexArray, dInt32 indexCount, dFloat32)
+	{
+		ndBoxContext* const data = (ndBoxContext*)context;
+		const dInt32 stride = strideInBytes / sizeof(dFloat32);
+		ndFace face;
+		face.m_normal = dVector(&polygon[indexArray[indexCount + 1] * stride]) & dVector::m_triplexMask;
+		for (dInt32 i = 0; i < 3; i++)
+		{
+			face.m_points[i] = dVector(&polygon[indexArray[i] * stride]) & dVector::m_triplexMask;
+			data->m_centroidSum += face.m_points[i];
+		}
+		if (data->m_faces)
+		{
+			data->m_faces->PushBack(face);
+		}
+		data->m_count++;
+		return t_ContinueSearh;
+	}
+};
+
+static dFloat32 BruteForceRay(const dArray<ndTestPolygonSoup::ndFace>& faces, const dFastRayTest& ray)
+{
+	const dInt32 indices[] = { 0, 1, 2 };
+	dFloat32 param = dFloat32(1.2f);
+	for (dInt32 i = 0; i < faces.GetCount(); i++)
+	{
+		const ndTestPolygonSoup::ndFace& face = faces[i];
+		param = dMin(param, ray.PolygonIntersect(face.m_normal, dFloat32(1.0f), &face.m_points[0].m_x, sizeof(dVector), indices, 3));
+	}
+	return param;
+}
+
+static dInt32 BruteForceBox(const dArray<ndTestPolygonSoup::ndFace>& faces, const dVector& p0, const dVector& p1, dVector& centroidSum)
+{
+	const dInt32 indices[] = { 0, 1, 2 };
+	const dFastAabbInfo box(p0, p1);
+	const dInt32 stride = sizeof(dVector) / sizeof(dFloat32);
+
+	dInt32 count = 0;
+	centroidSum = dVector::m_zero;
+	for (dInt32 i = 0; i < faces.GetCount(); i++)
+	{
+		const ndTestPolygonSoup::ndFace& face = faces[i];
+		if (box.PolygonBoxDistance(face.m_normal, 3, indices, stride, &face.m_points[0].m_x) > dFloat32(0.0f))
+		{
+			centroidSum += face.m_points[0] + face.m_points[1] + face.m_points[2];
+			count++;
+		}
+	}
+	return count;
+}
+
+static dFastRayTest RandomRay(const dVector& p0, const dVector& p1)
+{
+	const dFloat32 x = p0.m_x + (p1.m_x - p0.m_x) * ndTestRand();
+	const dFloat32 z = p0.m_z + (p1.m_z - p0.m_z) * ndTestRand();
+	const dFloat32 dx = dFloat32(20.0f) * (ndTestRand() - dFloat32(0.5f));
+	return dFastRayTest(dVector(x, dFloat32(50.0f), z, dFloat32(0.0f)), dVector(x + dx, dFloat32(-50.0f), z - dx, dFloat32(0.0f)));
+}
+
+static void RandomBox(const dVector& p0, const dVector& p1, dFloat32 size, dVector& boxP0, dVector& boxP1)
+{
+	const dFloat32 x = p0.m_x + (p1.m_x - p0.m_x) * ndTestRand();
+	const dFloat32 y = p0.m_y + (p1.m_y - p0.m_y) * ndTestRand();
+	const dFloat32 z = p0.m_z + (p1.m_z - p0.m_z) * ndTestRand();
+	boxP0 = dVector(x - size, y - size, z - size, dFloat32(0.0f));
+	boxP1 = dVector(x + size, y + size, z + size, dFloat32(0.0f));
+}
+
+// rewrites a serialized soup in the format used before the quantized
+// node boxes: no header and nodes of four 32 bit integers.
+static bool WriteLegacyFile(const char* const srcPath, const char* const dstPath)
+{
+	FILE* const src = fopen(srcPath, "rb");
+	FILE* const dst = fopen(dstPath, "wb");
+	bool ok = src && dst;
+	if (ok)
+	{
+		dInt32 header[6];
+		ok = fread(header, sizeof(header), 1, src) == 1;
+		const dInt32 nodeSize = header[2];
+		const dInt32 vertexCount = header[3];
+		const dInt32 indexCount = header[4];
+		const dInt32 nodeCount = header[5];
+		fwrite(&header[3], sizeof(dInt32), 3, dst);
+
+		dArray<char> buffer;
+		buffer.SetCount(dMax(dInt32(sizeof(dTriplex) * vertexCount), dInt32(sizeof(dInt32) * indexCount)) + nodeSize);
+		ok = ok && (fread(&buffer[0], sizeof(dTriplex) * vertexCount, 1, src) == 1);
+		fwrite(&buffer[0], sizeof(dTriplex) * vertexCount, 1, dst);
+		ok = ok && (fread(&buffer[0], sizeof(dInt32) * indexCount, 1, src) == 1);
+		fwrite(&buffer[0], sizeof(dInt32) * indexCount, 1, dst);
+		for (dInt32 i = 0; ok && (i < nodeCount); i++)
+		{
+			ok = fread(&buffer[0], size_t(nodeSize), 1, src) == 1;
+			fwrite(&buffer[0], sizeof(dInt32) * 4, 1, dst);
+		}
+	}
+	if (src)
+	{
+		fclose(src);
+	}
+	if (dst)
+	{
+		fclose(dst);
+	}
+	return ok;
+}
+
+static bool SameQueries(const ndTestPolygonSoup& soup0, const ndTestPolygonSoup& soup1, dInt32 count)
+{
+	dVector p0;
+	dVector p1;
+	soup0.GetAABB(p0, p1);
+	ndTestSetRandSeed(11);
+
+	bool same = true;
+	ndTestPolygonSoup::ndBoxContext context0;
+	ndTestPolygonSoup::ndBoxContext context1;
+	context0.m_faces = nullptr;
+	context1.m_faces = nullptr;
+	for (dInt32 i = 0; i < count; i++)
+	{
+		const dFastRayTest ray(RandomRay(p0, p1));
+		same = same && (soup0.CastRay(ray) == soup1.CastRay(ray));
+
+		dVector boxP0;
+		dVector boxP1;
+		RandomBox(p0, p1, dFloat32(1.0f), boxP0, boxP1);
+		soup0.CollideBox(boxP0, boxP1, context0);
+		soup1.CollideBox(boxP0, boxP1, context1);
+		same = same && (context0.m_count == context1.m_count);
+	}
+	return same;
+}
+
+static void CheckQueries()
+{
+	dPolygonSoupBuilder builder;
+	BuildHeightField(builder, 24);
+	ndTestPolygonSoup soup(builder);
+
+	dArray<ndTestPolygonSoup::ndFace> faces;
+	soup.GetFaces(faces);
+	D_TEST_CHECK(faces.GetCount() == 2 * 24 * 24);
+
+	dVector p0;
+	dVector p1;
+	soup.GetAABB(p0, p1);
+	ndTestSetRandSeed(7);
+
+	dInt32 rayMisses = 0;
+	dInt32 boxMisses = 0;
+	for (dInt32 i = 0; i < 500; i++)
+	{
+		const dFastRayTest ray(RandomRay(p0, p1));
+		if (soup.CastRay(ray) != BruteForceRay(faces, ray))
+		{
+			rayMisses++;
+		}
+
+		dVector boxP0;
+		dVector boxP1;
+		dVector centroidSum;
+		ndTestPolygonSoup::ndBoxContext context;
+		context.m_faces = nullptr;
+		RandomBox(p0, p1, dFloat32(0.25f) + dFloat32(2.0f) * ndTestRand(), boxP0, boxP1);
+		soup.CollideBox(boxP0, boxP1, context);
+		const dInt32 count = BruteForceBox(faces, boxP0, boxP1, centroidSum);
+		const dVector error((context.m_centroidSum - centroidSum).Abs());
+		if ((count != context.m_count) || (error.GetMax() > dFloat32(1.0e-2f)))
+		{
+			boxMisses++;
+		}
+	}
+	D_TEST_CHECK(rayMisses == 0);
+	D_TEST_CHECK(boxMisses == 0);
+}
+
+static void CheckSerialization()
+{
+	dPolygonSoupBuilder builder;
+	BuildHeightField(builder, 24);
+	ndTestPolygonSoup soup(builder);
+	soup.Serialize(D_TEST_SOUP_FILE);
+
+	ndTestPolygonSoup loaded;
+	loaded.Deserialize(D_TEST_SOUP_FILE);
+	D_TEST_CHECK(loaded.GetMemoryUsed() == soup.GetMemoryUsed());
+	D_TEST_CHECK(SameQueries(soup, loaded, 200));
+
+	// files from before the quantized boxes are converted when loaded
+	D_TEST_CHECK(WriteLegacyFile(D_TEST_SOUP_FILE, D_TEST_SOUP_LEGACY_FILE));
+	ndTestPolygonSoup legacy;
+	legacy.Deserialize(D_TEST_SOUP_LEGACY_FILE);
+	D_TEST_CHECK(legacy.GetMemoryUsed() == soup.GetMemoryUsed());
+	D_TEST_CHECK(SameQueries(soup, legacy, 200));
+
+	remove(D_TEST_SOUP_FILE);
+	remove(D_TEST_SOUP_LEGACY_FILE);
+}
+
+static void Benchmark()
+{
+	const dInt32 size = 512;
+	const dInt32 queries = 200000;
+
+	dPolygonSoupBuilder builder;
+	BuildHeightField(builder, size);
+	ndTestPolygonSoup soup(builder);
+
+	dVector p0;
+	dVector p1;
+	soup.GetAABB(p0, p1);
+
+	dArray<dFloat32> params;
+	params.SetCount(queries);
+	ndTestSetRandSeed(5);
+	dFloat64 time = ndTestTime();
+	for (dInt32 i = 0; i < queries; i++)
+	{
+		params[i] = soup.CastRay(RandomRay(p0, p1));
+	}
+	const dFloat64 rayTime = ndTestTime() - time;
+
+	ndTestSetRandSeed(5);
+	time = ndTestTime();
+	for (dInt32 i = 0; i < queries; i++)
+	{
+		soup.VisitRay(RandomRay(p0, p1), params[i]);
+	}
+	const dFloat64 traversalTime = ndTestTime() - time;
+
+	dInt32 faces = 0;
+	ndTestPolygonSoup::ndBoxContext context;
+	context.m_faces = nullptr;
+	ndTestSetRandSeed(5);
+	time = ndTestTime();
+	for (dInt32 i = 0; i < queries; i++)
+	{
+		dVector boxP0;
+		dVector boxP1;
+		RandomBox(p0, p1, dFloat32(1.0f), boxP0, boxP1);
+		soup.CollideBox(boxP0, boxP1, context);
+		faces += context.m_count;
+	}
+	const dFloat64 boxTime = ndTestTime() - time;
+
+	printf("polygon soup %d faces, node %d bytes: %d rays %.1f ms (tree only %.1f ms), %d boxes %.1f ms (%d faces)\n",
+		2 * size * size, dInt32(sizeof(dAabbPolygonSoup::dNode)), queries, rayTime, traversalTime, queries, boxTime, faces);
+}
+
+void TestPolygonSoup(bool benchmark)
+{
+	CheckQueries();
+	CheckSerialization();
+	if (benchmark)
+	{
+		Benchmark();
+	}
+}
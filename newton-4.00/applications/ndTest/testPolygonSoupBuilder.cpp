@@ -0,0 +1,194 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#include "testStdafx.h"
+#include "testCases.h"
+
+// streams a height field of random heights, two triangles
+// per cell, with the corners of every triangle duplicated.
+static void AddHeightField(dPolygonSoupBuilder& builder, dInt32 size)
+{
+	ndTestSetRandSeed(7);
+	dArray<dFloat32> heights;
+	heights.SetCount((size + 1) * (size + 1));
+	for (dInt32 i = 0; i < heights.GetCount(); i++)
+	{
+		heights[i] = ndTestRand();
+	}
+
+	for (dInt32 z = 0; z < size; z++)
+	{
+		for (dInt32 x = 0; x < size; x++)
+		{
+			const dVector p00(dFloat32(x), heights[z * (size + 1) + x], dFloat32(z), dFloat32(0.0f));
+			const dVector p01(dFloat32(x), heights[(z + 1) * (size + 1) + x], dFloat32(z + 1), dFloat32(0.0f));
+			const dVector p11(dFloat32(x + 1), heights[(z + 1) * (size + 1) + x + 1], dFloat32(z + 1), dFloat32(0.0f));
+			const dVector p10(dFloat32(x + 1), heights[z * (size + 1) + x + 1], dFloat32(z), dFloat32(0.0f));
+			const dVector face0[] = { p00, p01, p11 };
+			const dVector face1[] = { p00, p11, p10 };
+			builder.AddFace(&face0[0].m_x, sizeof(dVector), 3, (x + z) & 1);
+			builder.AddFace(&face1[0].m_x, sizeof(dVector), 3, (x + z) & 1);
+		}
+	}
+}
+
+class ndTestSoupFromBuilder: public dAabbPolygonSoup
+{
+	public:
+	ndTestSoupFromBuilder(const dPolygonSoupBuilder& builder)
+		:dAabbPolygonSoup()
+	{
+		Create(builder);
+	}
+};
+
+static bool SameBuilders(const dPolygonSoupBuilder& builder0, const dPolygonSoupBuilder& builder1)
+{
+	if ((builder0.m_faceVertexCount.GetCount() != builder1.m_faceVertexCount.GetCount()) ||
+		(builder0.m_vertexIndex.GetCount() != builder1.m_vertexIndex.GetCount()) ||
+		(builder0.m_vertexPoints.GetCount() != builder1.m_vertexPoints.GetCount()) ||
+		(builder0.m_normalPoints.GetCount() != builder1.m_normalPoints.GetCount()))
+	{
+		return false;
+	}
+
+	bool same = true;
+	for (dInt32 i = 0; i < builder0.m_faceVertexCount.GetCount(); i++)
+	{
+		same = same && (builder0.m_faceVertexCount[i] == builder1.m_faceVertexCount[i]);
+	}
+	for (dInt32 i = 0; i < builder0.m_vertexIndex.GetCount(); i++)
+	{
+		same = same && (builder0.m_vertexIndex[i] == builder1.m_vertexIndex[i]);
+	}
+	for (dInt32 i = 0; i < builder0.m_vertexPoints.GetCount(); i++)
+	{
+		const dBigVector diff(builder0.m_vertexPoints[i] - builder1.m_vertexPoints[i]);
+		same = same && (diff.DotProduct(diff).GetScalar() == dFloat64(0.0f));
+	}
+	return same;
+}
+
+// large enough for the streamed points to be packed while the faces are added,
+// and for the welds to be split into partitions that run in parallel.
+static void CheckStreaming()
+{
+	const dInt32 size = 400;
+
+	dPolygonSoupBuilder serialBuilder;
+	serialBuilder.SetThreadCount(1);
+	serialBuilder.Begin();
+	AddHeightField(serialBuilder, size);
+	D_TEST_CHECK(serialBuilder.m_vertexPoints.GetCount() < 6 * size * size);
+	serialBuilder.End(false);
+	D_TEST_CHECK(serialBuilder.GetThreadPool() == nullptr);
+	D_TEST_CHECK(serialBuilder.m_faceVertexCount.GetCount() == 2 * size * size);
+	D_TEST_CHECK(serialBuilder.m_vertexPoints.GetCount() == (size + 1) * (size + 1));
+
+	dPolygonSoupBuilder parallelBuilder;
+	parallelBuilder.SetThreadCount(4);
+	parallelBuilder.Begin();
+	AddHeightField(parallelBuilder, size);
+	parallelBuilder.End(false);
+	D_TEST_CHECK(parallelBuilder.GetThreadPool() != nullptr);
+	D_TEST_CHECK(SameBuilders(serialBuilder, parallelBuilder));
+}
+
+// the caller pool is shared by many builders and kept by a builder that is reused.
+static void CheckThreadPool()
+{
+	const dInt32 size = 48;
+
+	dPolygonSoupBuilder serialBuilder;
+	serialBuilder.SetThreadCount(1);
+	serialBuilder.Begin();
+	AddHeightField(serialBuilder, size);
+	serialBuilder.End(true);
+	ndTestSoupFromBuilder serialSoup(serialBuilder);
+
+	dThreadPoolBuilder threadPool("ndTestPool", 4);
+	for (dInt32 i = 0; i < 2; i++)
+	{
+		dPolygonSoupBuilder builder;
+		builder.SetThreadPool(&threadPool);
+		D_TEST_CHECK(builder.GetThreadCount() == 4);
+		builder.Begin();
+		AddHeightField(builder, size);
+		builder.End(true);
+		D_TEST_CHECK(builder.GetThreadPool() == &threadPool);
+		D_TEST_CHECK(SameBuilders(serialBuilder, builder));
+
+		ndTestSoupFromBuilder soup(builder);
+		D_TEST_CHECK(soup.GetVertexCount() == serialSoup.GetVertexCount());
+		D_TEST_CHECK(soup.GetMemoryUsed() == serialSoup.GetMemoryUsed());
+	}
+
+	dPolygonSoupBuilder builder;
+	builder.SetThreadCount(4);
+	builder.Begin();
+	AddHeightField(builder, size);
+	builder.End(true);
+	dThreadPoolBuilder* const ownPool = builder.GetThreadPool();
+	D_TEST_CHECK(ownPool != nullptr);
+	builder.Begin();
+	AddHeightField(builder, size);
+	builder.End(true);
+	D_TEST_CHECK(builder.GetThreadPool() == ownPool);
+	D_TEST_CHECK(SameBuilders(serialBuilder, builder));
+}
+
+static void Benchmark(dInt32 threadCount)
+{
+	const dInt32 size = 512;
+	const dInt32 faceCount = 2 * size * size;
+
+	const dUnsigned64 baseMemory = dMemory::GetMemoryUsed();
+	ndTestResetPeakMemory();
+	dFloat64 time = ndTestTime();
+	dPolygonSoupBuilder builder;
+	builder.SetThreadCount(threadCount);
+	builder.Begin();
+	AddHeightField(builder, size);
+	const dFloat64 streamTime = ndTestTime() - time;
+	const dUnsigned64 streamMemory = ndTestPeakMemory() - baseMemory;
+
+	time = ndTestTime();
+	builder.End(false);
+	const dFloat64 endTime = ndTestTime() - time;
+
+	time = ndTestTime();
+	ndTestSoupFromBuilder soup(builder);
+	const dFloat64 createTime = ndTestTime() - time;
+	const dUnsigned64 peakMemory = ndTestPeakMemory() - baseMemory;
+
+	dPolygonSoupBuilder optimizedBuilder;
+	optimizedBuilder.SetThreadCount(threadCount);
+	optimizedBuilder.Begin();
+	AddHeightField(optimizedBuilder, size / 4);
+	time = ndTestTime();
+	optimizedBuilder.End(true);
+	const dFloat64 optimizeTime = ndTestTime() - time;
+
+	printf("polygon soup builder %d faces, %d threads: stream %.1f ms (%.1f MB), end %.1f ms, create %.1f ms, peak %.1f MB; optimize %d faces %.1f ms\n",
+		faceCount, threadCount, streamTime, dFloat64(streamMemory) / (1024.0 * 1024.0), endTime, createTime,
+		dFloat64(peakMemory) / (1024.0 * 1024.0), faceCount / 16, optimizeTime);
+}
+
+void TestPolygonSoupBuilder(bool benchmark)
+{
+	CheckStreaming();
+	CheckThreadPool();
+	if (benchmark)
+	{
+		Benchmark(1);
+		Benchmark(4);
+	}
+}
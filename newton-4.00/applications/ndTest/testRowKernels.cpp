@@ -0,0 +1,229 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#include "testStdafx.h"
+#include "testCases.h"
+
+#define D_TEST_MAX_ROW	128
+
+static void RandomRow(dInt32 size, dFloat32* const row)
+{
+	for (dInt32 i = 0; i < size; i++)
+	{
+		row[i] = ndTestRand() - dFloat32(0.5f);
+	}
+}
+
+// the four wide version of dRowMulAdd that the benchmark measures against the scalar loop
+static void RowMulAddSimd(dInt32 size, dFloat32* const X, const dFloat32* const A, dFloat32 scale)
+{
+	const dInt32 blockSize = size & -4;
+	const dVector scale4(scale);
+	for (dInt32 i = 0; i < blockSize; i += 4)
+	{
+		const dVector x(dVector(&X[i]).MulAdd(dVector(&A[i]), scale4));
+		x.Store(&X[i]);
+	}
+	for (dInt32 i = blockSize; i < size; i++)
+	{
+		X[i] += A[i] * scale;
+	}
+}
+
+// both sides of the size threshold give the result of the scalar loop.
+static void CheckKernels()
+{
+	dFloat32 a[D_TEST_MAX_ROW];
+	dFloat32 b[D_TEST_MAX_ROW];
+	dFloat32 x0[D_TEST_MAX_ROW];
+	dFloat32 x1[D_TEST_MAX_ROW];
+	for (dInt32 size = 0; size < 2 * D_ROW_DOT_PRODUCT_SIMD_SIZE + 3; size++)
+	{
+		RandomRow(size, a);
+		RandomRow(size, b);
+		RandomRow(size, x0);
+		memcpy(x1, x0, size * sizeof(dFloat32));
+
+		dFloat64 dot = 0.0;
+		for (dInt32 i = 0; i < size; i++)
+		{
+			dot += dFloat64(a[i]) * b[i];
+			x0[i] += a[i] * dFloat32(0.25f);
+		}
+		dRowMulAdd(size, x1, a, dFloat32(0.25f));
+
+		D_TEST_CHECK(dAbs(dFloat64(dRowDotProduct(size, a, b)) - dot) < 1.0e-5);
+		D_TEST_CHECK(dAbs(dFloat64(dRowDotProductSimd(size, a, b)) - dot) < 1.0e-5);
+		for (dInt32 i = 0; i < size; i++)
+		{
+			D_TEST_CHECK(dAbs(x0[i] - x1[i]) < dFloat32(1.0e-6f));
+		}
+	}
+}
+
+// a diagonally dominant symmetric matrix, large enough to use both dot products.
+static void CheckCholesky()
+{
+	const dInt32 size = 3 * D_ROW_DOT_PRODUCT_SIMD_SIZE + 1;
+	dArray<dFloat32> matrix;
+	dArray<dFloat32> factor;
+	matrix.SetCount(size * size);
+	factor.SetCount(size * size);
+	for (dInt32 i = 0; i < size; i++)
+	{
+		for (dInt32 j = 0; j <= i; j++)
+		{
+			const dFloat32 value = (i == j) ? dFloat32(size) : ndTestRand() - dFloat32(0.5f);
+			matrix[i * size + j] = value;
+			matrix[j * size + i] = value;
+		}
+	}
+
+	dFloat32 b[size];
+	dFloat32 x[size];
+	RandomRow(size, b);
+	memcpy(&factor[0], &matrix[0], size * size * sizeof(dFloat32));
+	D_TEST_CHECK(dCholeskyFactorization(size, size, &factor[0]));
+	dSolveCholesky(size, size, &factor[0], x, b);
+
+	for (dInt32 i = 0; i < size; i++)
+	{
+		dFloat64 acc = 0.0;
+		for (dInt32 j = 0; j < size; j++)
+		{
+			acc += dFloat64(matrix[i * size + j]) * x[j];
+		}
+		D_TEST_CHECK(dAbs(acc - b[i]) < 1.0e-4);
+	}
+}
+
+// times the scalar loops against the four wide kernels over the rows of a 
+// matrix, the dot product crossover is the value of D_ROW_DOT_PRODUCT_SIMD_SIZE.
+static void Benchmark()
+{
+	dArray<dFloat32> matrix;
+	matrix.SetCount(D_TEST_MAX_ROW * D_TEST_MAX_ROW);
+	RandomRow(matrix.GetCount(), &matrix[0]);
+
+	dFloat32 x[D_TEST_MAX_ROW];
+	dFloat32 out[D_TEST_MAX_ROW];
+	RandomRow(D_TEST_MAX_ROW, x);
+
+	const dInt32 sizes[] = { 3, 4, 6, 8, 12, 16, 24, 32, 64, 128 };
+	const dInt32 elements = 20000000;
+	for (dInt32 s = 0; s < dInt32(sizeof(sizes) / sizeof(sizes[0])); s++)
+	{
+		const dInt32 size = sizes[s];
+		const dInt32 reps = elements / (size * size);
+
+		dFloat64 time = ndTestTime();
+		for (dInt32 i = 0; i < reps; i++)
+		{
+			for (dInt32 j = 0; j < size; j++)
+			{
+				out[j] = dDotProduct(size, &matrix[j * D_TEST_MAX_ROW], x);
+			}
+		}
+		const dFloat64 dotScalar = ndTestTime() - time;
+
+		time = ndTestTime();
+		for (dInt32 i = 0; i < reps; i++)
+		{
+			for (dInt32 j = 0; j < size; j++)
+			{
+				out[j] = dRowDotProductSimd(size, &matrix[j * D_TEST_MAX_ROW], x);
+			}
+		}
+		const dFloat64 dotSimd = ndTestTime() - time;
+
+		// alternating signs keep the values bounded
+		time = ndTestTime();
+		for (dInt32 i = 0; i < reps; i++)
+		{
+			for (dInt32 j = 0; j < size; j++)
+			{
+				const dFloat32* const row = &matrix[j * D_TEST_MAX_ROW];
+				const dFloat32 scale = (i & 1) ? dFloat32(1.0e-3f) : dFloat32(-1.0e-3f);
+				for (dInt32 k = 0; k < size; k++)
+				{
+					x[k] += row[k] * scale;
+				}
+			}
+		}
+		const dFloat64 mulAddScalar = ndTestTime() - time;
+
+		time = ndTestTime();
+		for (dInt32 i = 0; i < reps; i++)
+		{
+			for (dInt32 j = 0; j < size; j++)
+			{
+				const dFloat32 scale = (i & 1) ? dFloat32(1.0e-3f) : dFloat32(-1.0e-3f);
+				RowMulAddSimd(size, x, &matrix[j * D_TEST_MAX_ROW], scale);
+			}
+		}
+		const dFloat64 mulAddSimd = ndTestTime() - time;
+
+		dFloat32 check = dFloat32(0.0f);
+		for (dInt32 j = 0; j < size; j++)
+		{
+			check += out[j] + x[j];
+		}
+		const dFloat64 scale = 1.0e6 / (dFloat64(reps) * size);
+		printf("row kernels size %3d, ns per row: dot scalar %.2f four wide %.2f, muladd scalar %.2f four wide %.2f (%g)\n", size,
+			dotScalar * scale, dotSimd * scale, mulAddScalar * scale, mulAddSimd * scale, check);
+	}
+}
+
+static void BenchmarkCholesky()
+{
+	const dInt32 sizes[] = { 6, 12, 32, 64, 128 };
+	for (dInt32 s = 0; s < dInt32(sizeof(sizes) / sizeof(sizes[0])); s++)
+	{
+		const dInt32 size = sizes[s];
+		dArray<dFloat32> matrix;
+		dArray<dFloat32> factor;
+		matrix.SetCount(size * size);
+		factor.SetCount(size * size);
+		for (dInt32 i = 0; i < size; i++)
+		{
+			for (dInt32 j = 0; j <= i; j++)
+			{
+				const dFloat32 value = (i == j) ? dFloat32(size) : ndTestRand() - dFloat32(0.5f);
+				matrix[i * size + j] = value;
+				matrix[j * size + i] = value;
+			}
+		}
+
+		dFloat32 b[D_TEST_MAX_ROW];
+		dFloat32 x[D_TEST_MAX_ROW];
+		RandomRow(size, b);
+		const dInt32 reps = 20000000 / (size * size * size) + 1;
+		const dFloat64 time = ndTestTime();
+		for (dInt32 i = 0; i < reps; i++)
+		{
+			memcpy(&factor[0], &matrix[0], size * size * sizeof(dFloat32));
+			dCholeskyFactorization(size, size, &factor[0]);
+			dSolveCholesky(size, size, &factor[0], x, b);
+		}
+		printf("cholesky factor and solve %3d x %3d: %.2f us (%g)\n", size, size, (ndTestTime() - time) * 1.0e3 / reps, x[0]);
+	}
+}
+
+void TestRowKernels(bool benchmark)
+{
+	CheckKernels();
+	CheckCholesky();
+	if (benchmark)
+	{
+		Benchmark();
+		BenchmarkCholesky();
+	}
+}
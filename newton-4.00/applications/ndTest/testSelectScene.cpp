@@ -0,0 +1,94 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#include "testStdafx.h"
+#include "testCases.h"
+
+#define D_TEST_TIMESTEP	dFloat32(1.0f / 60.0f)
+
+// counts the pair overlaps the scene reports to the application
+class ndTestContactNotify: public ndContactNotify
+{
+	public:
+	ndTestContactNotify()
+		:ndContactNotify()
+		,m_overlaps(0)
+	{
+	}
+
+	virtual bool OnAaabbOverlap(const ndContact* const, dFloat32)
+	{
+		m_overlaps++;
+		return true;
+	}
+
+	ndScene* GetNotifyScene() const
+	{
+		return m_scene;
+	}
+
+	dInt32 m_overlaps;
+};
+
+// a sphere drops on a floor, and the world switches its scene in the middle
+// of the fall. the bodies and the application contact notify move to the new
+// scene, and the sphere still lands on the floor.
+static void CheckSelectScene(dInt32 sceneType)
+{
+	ndWorld world;
+	world.SetThreadCount(1);
+	ndTestContactNotify* const notify = new ndTestContactNotify();
+	world.SetContactNotify(notify);
+
+	ndBodyDynamic* const floor = new ndBodyDynamic();
+	floor->SetNotifyCallback(new ndBodyNotify(dVector::m_zero));
+	floor->SetMatrix(dGetIdentityMatrix());
+	floor->SetCollisionShape(ndShapeInstance(new ndShapeBox(dFloat32(20.0f), dFloat32(1.0f), dFloat32(20.0f))));
+	world.AddBody(floor);
+
+	dMatrix matrix(dGetIdentityMatrix());
+	matrix.m_posit = dVector(dFloat32(0.0f), dFloat32(3.0f), dFloat32(0.0f), dFloat32(1.0f));
+	ndBodyDynamic* const body = new ndBodyDynamic();
+	ndBodyNotify* const bodyNotify = new ndBodyNotify(dVector(dFloat32(0.0f), dFloat32(-10.0f), dFloat32(0.0f), dFloat32(0.0f)));
+	bodyNotify->SetDefaultExternalForce(true);
+	body->SetNotifyCallback(bodyNotify);
+	body->SetMatrix(matrix);
+	body->SetCollisionShape(ndShapeInstance(new ndShapeSphere(dFloat32(0.5f))));
+	body->SetMassMatrix(dFloat32(1.0f), body->GetCollisionShape());
+	world.AddBody(body);
+
+	for (dInt32 i = 0; i < 10; i++)
+	{
+		world.Update(D_TEST_TIMESTEP);
+		world.Sync();
+	}
+	const dInt32 bodyCount = world.GetBodyList().GetCount();
+	world.SelectScene(sceneType);
+
+	D_TEST_CHECK(world.GetContactNotify() == notify);
+	D_TEST_CHECK(notify->GetNotifyScene() == world.GetScene());
+	D_TEST_CHECK(world.GetBodyList().GetCount() == bodyCount);
+
+	const dInt32 overlaps = notify->m_overlaps;
+	for (dInt32 i = 0; i < 120; i++)
+	{
+		world.Update(D_TEST_TIMESTEP);
+		world.Sync();
+	}
+	D_TEST_CHECK(notify->m_overlaps > overlaps);
+	D_TEST_CHECK(dAbs(body->GetMatrix().m_posit.m_y - dFloat32(1.0f)) < dFloat32(0.05f));
+}
+
+void TestSelectScene(bool)
+{
+	CheckSelectScene(1);
+	CheckSelectScene(2);
+}
@@ -0,0 +1,127 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#include "testStdafx.h"
+#include "testCases.h"
+
+// a block of particles much smaller than the smoothing length,
+// every particle is a neighbor of all the others.
+static void CheckDenseBlock()
+{
+	const dInt32 size = 5;
+	const dFloat32 radius = dFloat32(1.0f);
+	const dFloat32 spacing = dFloat32(0.1f);
+	const dFloat32 mass = dFloat32(0.02f);
+
+	ndWorld world;
+	world.SetThreadCount(1);
+	ndBodySphFluid* const fluid = new ndBodySphFluid();
+	fluid->SetNotifyCallback(new ndBodyNotify(dVector::m_zero));
+	fluid->SetParticleRadius(radius);
+	for (dInt32 z = 0; z < size; z++)
+	{
+		for (dInt32 y = 0; y < size; y++)
+		{
+			for (dInt32 x = 0; x < size; x++)
+			{
+				const dVector posit(spacing * dFloat32(x), spacing * dFloat32(y), spacing * dFloat32(z), dFloat32(1.0f));
+				// only the mass of the first particle is used
+				fluid->AddParticle(x ? mass * dFloat32(1.0001f) : mass, posit, dVector::m_zero);
+			}
+		}
+	}
+	D_TEST_CHECK(fluid->GetParticleMass() == mass);
+
+	// the initial positions, the densities are calculated before the particles move
+	const dArray<dVector> positions(fluid->GetPositions());
+	world.AddBody(fluid);
+	world.Update(dFloat32(1.0f / 60.0f));
+	world.Sync();
+
+	const dInt32 count = size * size * size;
+	D_TEST_CHECK(fluid->GetNeighborCapacity() >= count - 1);
+
+	// poly6 kernel, with every pair of particles
+	const dFloat32 h2 = radius * radius;
+	const dFloat32 kernelMass = mass * dFloat32(315.0f) / (dFloat32(64.0f) * dPi * h2 * h2 * h2 * h2 * radius);
+	const dArray<dFloat32>& densities = fluid->GetDensities();
+	D_TEST_CHECK(densities.GetCount() == count);
+	for (dInt32 i = 0; i < densities.GetCount(); i++)
+	{
+		dFloat32 sum = dFloat32(0.0f);
+		for (dInt32 j = 0; j < positions.GetCount(); j++)
+		{
+			const dVector dist(positions[i] - positions[j]);
+			const dFloat32 q = h2 - dist.DotProduct(dist & dVector::m_triplexMask).GetScalar();
+			sum += q * q * q;
+		}
+		const dFloat32 density = kernelMass * sum;
+		D_TEST_CHECK(dAbs(densities[i] - density) < density * dFloat32(1.0e-4f));
+	}
+}
+
+// a layer of particles, too far apart to interact, falls on a rotated
+// box. The particles stop on top of the box and push the box down.
+static void CheckBodyCollision()
+{
+	const dInt32 size = 4;
+	const dFloat32 radius = dFloat32(0.1f);
+	const dFloat32 spacing = dFloat32(0.5f);
+
+	ndWorld world;
+	world.SetThreadCount(1);
+
+	dMatrix matrix(dYawMatrix(dFloat32(30.0f) * dDegreeToRad));
+	matrix.m_posit = dVector(dFloat32(0.0f), dFloat32(0.0f), dFloat32(0.0f), dFloat32(1.0f));
+	ndBodyDynamic* const box = new ndBodyDynamic();
+	box->SetNotifyCallback(new ndBodyNotify(dVector::m_zero));
+	box->SetMatrix(matrix);
+	box->SetCollisionShape(ndShapeInstance(new ndShapeBox(dFloat32(6.0f), dFloat32(1.0f), dFloat32(6.0f))));
+	box->SetMassMatrix(dFloat32(10.0f), box->GetCollisionShape());
+	world.AddBody(box);
+
+	ndBodySphFluid* const fluid = new ndBodySphFluid();
+	fluid->SetNotifyCallback(new ndBodyNotify(dVector::m_zero));
+	fluid->SetParticleRadius(radius);
+	const dVector veloc(dFloat32(0.0f), dFloat32(-10.0f), dFloat32(0.0f), dFloat32(0.0f));
+	for (dInt32 z = 0; z < size; z++)
+	{
+		for (dInt32 x = 0; x < size; x++)
+		{
+			const dVector posit(spacing * dFloat32(x - size / 2), dFloat32(0.6f), spacing * dFloat32(z - size / 2), dFloat32(1.0f));
+			fluid->AddParticle(dFloat32(0.02f), posit, veloc);
+		}
+	}
+	// one particle misses the box
+	fluid->AddParticle(dFloat32(0.02f), dVector(dFloat32(10.0f), dFloat32(0.6f), dFloat32(0.0f), dFloat32(1.0f)), veloc);
+	world.AddBody(fluid);
+
+	for (dInt32 i = 0; i < 2; i++)
+	{
+		world.Update(dFloat32(1.0f / 60.0f));
+		world.Sync();
+	}
+
+	const dArray<dVector>& positions = fluid->GetPositions();
+	const dFloat32 top = box->GetMatrix().m_posit.m_y + dFloat32(0.5f);
+	for (dInt32 i = 0; i < size * size; i++)
+	{
+		D_TEST_CHECK(positions[i].m_y > top);
+	}
+	D_TEST_CHECK(positions[size * size].m_y < dFloat32(0.3f));
+	D_TEST_CHECK(box->GetVelocity().m_y < dFloat32(0.0f));
+}
+
+void TestSphFluid(bool benchmark)
+{
+	CheckDenseBlock();
+	CheckBodyCollision();
+}
@@ -0,0 +1,137 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#include "testStdafx.h"
+#include "testCases.h"
+
+#define D_TEST_TILE_PATH	"."
+#define D_TEST_TILE_SIZE	dFloat32 (16.0f)
+#define D_TEST_TILE_COUNT	4
+
+// a flat tile, the height of each tile tells them apart
+static void SaveTiles(const ndStaticWorldStreamer& streamer)
+{
+	const dInt32 cells = 4;
+	const dFloat32 cellSize = D_TEST_TILE_SIZE / cells;
+	for (dInt32 i = 0; i < D_TEST_TILE_COUNT; i++)
+	{
+		dPolygonSoupBuilder builder;
+		builder.Begin();
+		const dFloat32 height = dFloat32(i + 1);
+		for (dInt32 z = 0; z < cells; z++)
+		{
+			for (dInt32 x = 0; x < cells; x++)
+			{
+				const dFloat32 x0 = D_TEST_TILE_SIZE * i + cellSize * x;
+				const dFloat32 z0 = cellSize * z;
+				const dVector p00(x0, height, z0, dFloat32(0.0f));
+				const dVector p01(x0, height, z0 + cellSize, dFloat32(0.0f));
+				const dVector p11(x0 + cellSize, height, z0 + cellSize, dFloat32(0.0f));
+				const dVector p10(x0 + cellSize, height, z0, dFloat32(0.0f));
+				const dVector face0[] = { p00, p01, p11 };
+				const dVector face1[] = { p00, p11, p10 };
+				builder.AddFace(&face0[0].m_x, sizeof(dVector), 3, 0);
+				builder.AddFace(&face1[0].m_x, sizeof(dVector), 3, 0);
+			}
+		}
+		builder.End(false);
+		streamer.SaveTile(builder, i, 0);
+	}
+}
+
+static void DeleteTiles()
+{
+	for (dInt32 i = 0; i < D_TEST_TILE_COUNT; i++)
+	{
+		char name[256];
+		snprintf(name, sizeof(name), "%s/tile_%d_0.bin", D_TEST_TILE_PATH, i);
+		remove(name);
+	}
+}
+
+static dFloat32 FloorHeight(ndWorld& world, dFloat32 x)
+{
+	ndRayCastClosestHitCallback rayCaster(world.GetScene());
+	const dVector p0(x, dFloat32(100.0f), dFloat32(2.0f), dFloat32(0.0f));
+	const dVector p1(x, dFloat32(-100.0f), dFloat32(2.0f), dFloat32(0.0f));
+	const dFloat32 param = rayCaster.TraceRay(p0, p1);
+	return (param < dFloat32(1.0f)) ? rayCaster.m_contact.m_point.m_y : dFloat32(-1000.0f);
+}
+
+// run updates until the background thread delivered the requested tiles
+static void UpdateUntil(ndWorld& world, const ndStaticWorldStreamer& streamer, dInt32 residentTiles)
+{
+	for (dInt32 i = 0; i < 1000; i++)
+	{
+		world.Update(dFloat32(1.0f / 60.0f));
+		world.Sync();
+		const ndStaticWorldStreamer::ndStatistics& stats = streamer.GetStatistics();
+		if (!stats.m_pendingTiles && (stats.m_residentTiles == residentTiles))
+		{
+			break;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+void TestStaticWorldStreamer(bool benchmark)
+{
+	ndWorld world;
+	world.SetThreadCount(1);
+
+	// a zero memory budget evicts every resident tile as soon as it goes out of range
+	ndStaticWorldStreamer* const streamer = new ndStaticWorldStreamer(D_TEST_TILE_PATH, D_TEST_TILE_SIZE, D_TEST_TILE_SIZE * dFloat32(0.5f), 0);
+	SaveTiles(*streamer);
+	world.SetStaticStreamer(streamer);
+
+	dMatrix matrix(dGetIdentityMatrix());
+	matrix.m_posit = dVector(D_TEST_TILE_SIZE * dFloat32(0.5f), dFloat32(10.0f), D_TEST_TILE_SIZE * dFloat32(0.5f), dFloat32(1.0f));
+	ndBodyDynamic* const observer = new ndBodyDynamic();
+	observer->SetMatrix(matrix);
+	observer->SetCollisionShape(ndShapeInstance(new ndShapeSphere(dFloat32(0.5f))));
+	world.AddBody(observer);
+	streamer->AddObserver(observer);
+	D_TEST_CHECK(streamer->GetObserverCount() == 1);
+
+	// tiles 0 and 1 are in range of the first tile center
+	UpdateUntil(world, *streamer, 2);
+	const ndStaticWorldStreamer::ndStatistics& stats = streamer->GetStatistics();
+	D_TEST_CHECK(stats.m_residentTiles == 2);
+	D_TEST_CHECK(stats.m_loadedTiles == 2);
+	D_TEST_CHECK(dAbs(FloorHeight(world, D_TEST_TILE_SIZE * dFloat32(0.5f)) - dFloat32(1.0f)) < dFloat32(1.0e-3f));
+	D_TEST_CHECK(FloorHeight(world, D_TEST_TILE_SIZE * dFloat32(3.5f)) < dFloat32(-100.0f));
+
+	// moving to the last tile pages in tiles 2 and 3, and pages out tiles 0 and 1
+	matrix.m_posit.m_x = D_TEST_TILE_SIZE * dFloat32(3.5f);
+	observer->SetMatrix(matrix);
+	UpdateUntil(world, *streamer, 2);
+	D_TEST_CHECK(stats.m_residentTiles == 2);
+	D_TEST_CHECK(stats.m_loadedTiles == 4);
+	D_TEST_CHECK(stats.m_evictedTiles == 2);
+	D_TEST_CHECK(FloorHeight(world, D_TEST_TILE_SIZE * dFloat32(0.5f)) < dFloat32(-100.0f));
+	D_TEST_CHECK(dAbs(FloorHeight(world, D_TEST_TILE_SIZE * dFloat32(3.5f)) - dFloat32(4.0f)) < dFloat32(1.0e-3f));
+
+	// deleting the observer unregisters it, without observers every tile is evicted
+	world.DeleteBody(observer);
+	D_TEST_CHECK(streamer->GetObserverCount() == 0);
+	UpdateUntil(world, *streamer, 0);
+	D_TEST_CHECK(stats.m_residentTiles == 0);
+	D_TEST_CHECK(stats.m_evictedTiles == 4);
+
+	if (benchmark)
+	{
+		printf("static world streamer: %d tiles loaded, %.2f ms average latency, %.2f ms max latency\n",
+			stats.m_loadedTiles, stats.m_averageLoadLatency * dFloat32(1000.0f), stats.m_maxLoadLatency * dFloat32(1000.0f));
+	}
+
+	world.Sync();
+	DeleteTiles();
+}
@@ -15,6 +15,7 @@
 #include <stdio.h>
 #include <conio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <crtdbg.h>
 #include <ndNewton.h>
 
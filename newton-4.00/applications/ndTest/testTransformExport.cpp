@@ -0,0 +1,148 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#include "testStdafx.h"
+#include "testCases.h"
+
+#define D_TEST_TIMESTEP	dFloat32(1.0f / 60.0f)
+
+// copies the matrix of the body, the way an application updates its own objects
+class ndTestTransformNotify: public ndBodyNotify
+{
+	public:
+	ndTestTransformNotify(const dVector& gravity)
+		:ndBodyNotify(gravity)
+		,m_matrix(dGetIdentityMatrix())
+		,m_calls(0)
+	{
+		SetDefaultExternalForce(true);
+	}
+
+	virtual void OnTranform(dInt32, const dMatrix& matrix)
+	{
+		m_matrix = matrix;
+		m_calls++;
+	}
+
+	dMatrix m_matrix;
+	dInt32 m_calls;
+};
+
+static void AddBodies(ndWorld& world, dInt32 size, dArray<ndBodyDynamic*>& bodies)
+{
+	const dVector gravity(dFloat32(0.0f), dFloat32(-10.0f), dFloat32(0.0f), dFloat32(0.0f));
+	for (dInt32 z = 0; z < size; z++)
+	{
+		for (dInt32 x = 0; x < size; x++)
+		{
+			dMatrix matrix(dGetIdentityMatrix());
+			matrix.m_posit = dVector(dFloat32(3 * x), dFloat32(0.0f), dFloat32(3 * z), dFloat32(1.0f));
+			ndBodyDynamic* const body = new ndBodyDynamic();
+			body->SetNotifyCallback(new ndTestTransformNotify(gravity));
+			body->SetMatrix(matrix);
+			body->SetCollisionShape(ndShapeInstance(new ndShapeSphere(dFloat32(0.5f))));
+			body->SetMassMatrix(dFloat32(1.0f), body->GetCollisionShape());
+			world.AddBody(body);
+			bodies.PushBack(body);
+		}
+	}
+}
+
+// with two threads the second half of the bodies is appended to the buffer of the first thread
+static void CheckExport()
+{
+	const dInt32 size = 10;
+	ndWorld world;
+	world.SetThreadCount(2);
+	dArray<ndBodyDynamic*> bodies;
+	AddBodies(world, size, bodies);
+
+	world.Update(D_TEST_TIMESTEP);
+	world.Sync();
+	for (dInt32 i = 0; i < bodies.GetCount(); i++)
+	{
+		D_TEST_CHECK(((ndTestTransformNotify*)bodies[i]->GetNotifyCallback())->m_calls == 1);
+	}
+
+	ndScene* const scene = world.GetScene();
+	scene->SetTransformExport(true);
+	world.Update(D_TEST_TIMESTEP);
+	world.Sync();
+
+	const dArray<ndScene::ndTransformEntry>& buffer = scene->GetTransformBuffer();
+	D_TEST_CHECK(buffer.GetCount() == bodies.GetCount());
+	dInt32 foundCount = 0;
+	for (dInt32 i = 0; i < buffer.GetCount(); i++)
+	{
+		const ndScene::ndTransformEntry& entry = buffer[i];
+		const ndBodyDynamic* const body = entry.m_body->GetAsBodyDynamic();
+		const dVector diff(entry.m_matrix.m_posit - body->GetMatrix().m_posit);
+		D_TEST_CHECK(entry.m_bodyId == body->GetId());
+		D_TEST_CHECK(diff.DotProduct(diff).GetScalar() == dFloat32(0.0f));
+		foundCount += (((ndTestTransformNotify*)entry.m_body->GetNotifyCallback())->m_calls == 1) ? 1 : 0;
+	}
+	// the notifications are not called while the transforms are exported
+	D_TEST_CHECK(foundCount == bodies.GetCount());
+}
+
+static void Benchmark(dInt32 size)
+{
+	ndWorld world;
+	world.SetThreadCount(1);
+	dArray<ndBodyDynamic*> bodies;
+	AddBodies(world, size, bodies);
+	world.Update(D_TEST_TIMESTEP);
+	world.Sync();
+
+	const dInt32 steps = 10;
+	dFloat64 time = ndTestTime();
+	for (dInt32 i = 0; i < steps; i++)
+	{
+		world.Update(D_TEST_TIMESTEP);
+		world.Sync();
+	}
+	const dFloat64 notifyTime = (ndTestTime() - time) / steps;
+
+	ndScene* const scene = world.GetScene();
+	scene->SetTransformExport(true);
+	world.Update(D_TEST_TIMESTEP);
+	world.Sync();
+	time = ndTestTime();
+	dFloat64 copyTime = 0.0;
+	for (dInt32 i = 0; i < steps; i++)
+	{
+		world.Update(D_TEST_TIMESTEP);
+		world.Sync();
+
+		// the application copies the exported matrices
+		const dFloat64 copyStart = ndTestTime();
+		const dArray<ndScene::ndTransformEntry>& buffer = scene->GetTransformBuffer();
+		for (dInt32 j = 0; j < buffer.GetCount(); j++)
+		{
+			ndTestTransformNotify* const notify = (ndTestTransformNotify*)buffer[j].m_body->GetNotifyCallback();
+			notify->m_matrix = buffer[j].m_matrix;
+		}
+		copyTime += ndTestTime() - copyStart;
+	}
+	const dFloat64 exportTime = (ndTestTime() - time - copyTime) / steps;
+
+	printf("transform export %d bodies, 1 thread: update with notifications %.2f ms, with export %.2f ms, copy %.2f ms\n",
+		size * size, notifyTime, exportTime, copyTime / steps);
+}
+
+void TestTransformExport(bool benchmark)
+{
+	CheckExport();
+	if (benchmark)
+	{
+		Benchmark(300);
+	}
+}
@@ -0,0 +1,125 @@
+/* Copyright (c) <2003-2019> <Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely
+*/
+
+#include "testStdafx.h"
+#include "testCases.h"
+
+#define D_TEST_TIMESTEP	dFloat32(1.0f / 60.0f)
+
+enum ndTestTriggerEvent
+{
+	m_triggerEnter,
+	m_trigger,
+	m_triggerExit,
+};
+
+// records the notifications of each frame in the order they are called
+class ndTestTriggerVolume: public ndBodyTriggerVolume
+{
+	public:
+	ndTestTriggerVolume()
+		:ndBodyTriggerVolume()
+		,m_frame(0)
+	{
+	}
+
+	virtual void OnTriggerEnter(ndBodyKinematic* const, dFloat32)
+	{
+		Record(m_triggerEnter);
+	}
+
+	virtual void OnTrigger(ndBodyKinematic* const, dFloat32)
+	{
+		Record(m_trigger);
+	}
+
+	virtual void OnTriggerExit(ndBodyKinematic* const, dFloat32)
+	{
+		Record(m_triggerExit);
+	}
+
+	void Record(ndTestTriggerEvent type)
+	{
+		m_events.PushBack(type);
+		m_frames.PushBack(m_frame);
+	}
+
+	dArray<ndTestTriggerEvent> m_events;
+	dArray<dInt32> m_frames;
+	dInt32 m_frame;
+};
+
+// a sphere flies through a trigger box, in every frame OnTrigger
+// comes before the enter or exit notification of that frame.
+static void CheckTriggerOrder()
+{
+	ndWorld world;
+	world.SetThreadCount(1);
+
+	ndTestTriggerVolume* const trigger = new ndTestTriggerVolume();
+	trigger->SetNotifyCallback(new ndBodyNotify(dVector::m_zero));
+	trigger->SetMatrix(dGetIdentityMatrix());
+	trigger->SetCollisionShape(ndShapeInstance(new ndShapeBox(dFloat32(2.0f), dFloat32(2.0f), dFloat32(2.0f))));
+	world.AddBody(trigger);
+
+	dMatrix matrix(dGetIdentityMatrix());
+	matrix.m_posit = dVector(dFloat32(-3.0f), dFloat32(0.0f), dFloat32(0.0f), dFloat32(1.0f));
+	ndBodyDynamic* const body = new ndBodyDynamic();
+	body->SetNotifyCallback(new ndBodyNotify(dVector::m_zero));
+	body->SetMatrix(matrix);
+	body->SetCollisionShape(ndShapeInstance(new ndShapeSphere(dFloat32(0.5f))));
+	body->SetMassMatrix(dFloat32(1.0f), body->GetCollisionShape());
+	body->SetAutoSleep(false);
+	body->SetVelocity(dVector(dFloat32(6.0f), dFloat32(0.0f), dFloat32(0.0f), dFloat32(0.0f)));
+	world.AddBody(body);
+
+	for (dInt32 i = 0; i < 90; i++)
+	{
+		trigger->m_frame = i;
+		world.Update(D_TEST_TIMESTEP);
+		world.Sync();
+	}
+
+	dInt32 enterCount = 0;
+	dInt32 exitCount = 0;
+	dInt32 triggerCount = 0;
+	dInt32 enterFrame = -1;
+	dInt32 exitFrame = -1;
+	for (dInt32 i = 0; i < trigger->m_events.GetCount(); i++)
+	{
+		const dInt32 frame = trigger->m_frames[i];
+		switch (trigger->m_events[i])
+		{
+			case m_triggerEnter:
+				enterCount++;
+				enterFrame = frame;
+				break;
+			case m_triggerExit:
+				exitCount++;
+				exitFrame = frame;
+				break;
+			case m_trigger:
+				triggerCount++;
+				// no enter or exit of the same frame was called yet
+				D_TEST_CHECK((frame != enterFrame) && (frame != exitFrame));
+				break;
+		}
+	}
+	D_TEST_CHECK(enterCount == 1);
+	D_TEST_CHECK(exitCount == 1);
+	D_TEST_CHECK(enterFrame < exitFrame);
+	D_TEST_CHECK(triggerCount >= (exitFrame - enterFrame));
+}
+
+void TestTriggerVolume(bool)
+{
+	CheckTriggerOrder();
+}
@@ -107,6 +107,8 @@ class ndBody: public dClassAlloc
 			dUnsigned32 m_bodyIsConstrained : 1;
 			dUnsigned32 m_equilibriumOverride : 1;
 			dUnsigned32 m_collideWithLinkedBodies : 1;
+			dUnsigned32 m_staticSceneNode : 1;
+			dUnsigned32 m_continueCollisionMode : 1;
 		};
 	};
 
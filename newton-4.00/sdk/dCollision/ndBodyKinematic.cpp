@@ -53,33 +53,105 @@ class ndDummyCollision: public ndShapeNull
 
 
 ndBodyKinematic::ndContactMap::ndContactMap()
-	:dTree<ndContact*, ndContactkey, dContainersFreeListAlloc<ndContact*>>()
+	:m_entries(nullptr)
+	,m_count(0)
+	,m_mask(-1)
 {
 }
 
+ndBodyKinematic::ndContactMap::~ndContactMap()
+{
+	dAssert(!m_count);
+	if (m_entries)
+	{
+		dMemory::Free(m_entries);
+	}
+}
+
+void ndBodyKinematic::ndContactMap::Resize(dInt32 capacity)
+{
+	dAssert(!(capacity & (capacity - 1)));
+	ndEntry* const oldEntries = m_entries;
+	const dInt32 oldCapacity = m_mask + 1;
+
+	m_mask = capacity - 1;
+	m_entries = (ndEntry*)dMemory::Malloc(capacity * sizeof(ndEntry));
+	memset(m_entries, 0, capacity * sizeof(ndEntry));
+	for (dInt32 i = 0; i < oldCapacity; i++)
+	{
+		const ndEntry& entry = oldEntries[i];
+		if (entry.m_contact)
+		{
+			dInt32 slot = GetSlot(entry.m_tag);
+			for (; m_entries[slot].m_contact; slot = (slot + 1) & m_mask);
+			m_entries[slot] = entry;
+		}
+	}
+
+	if (oldEntries)
+	{
+		dMemory::Free(oldEntries);
+	}
+}
+
 ndContact* ndBodyKinematic::ndContactMap::FindContact(const ndBody* const body0, const ndBody* const body1) const
 {
-	ndContactkey key(body0->GetId(), body1->GetId());
-	dTreeNode* const node = Find(key);
-	return node ? node->GetInfo() : nullptr;
+	if (m_count)
+	{
+		const dUnsigned64 tag = ndContactkey(body0->GetId(), body1->GetId()).GetTag();
+		for (dInt32 slot = GetSlot(tag); m_entries[slot].m_contact; slot = (slot + 1) & m_mask)
+		{
+			if (m_entries[slot].m_tag == tag)
+			{
+				return m_entries[slot].m_contact;
+			}
+		}
+	}
+	return nullptr;
 }
 
 void ndBodyKinematic::ndContactMap::AttachContact(ndContact* const contact)
 {
-	ndBody* const body0 = contact->GetBody0();
-	ndBody* const body1 = contact->GetBody1();
-	ndContactkey key(body0->GetId(), body1->GetId());
-	dAssert(!Find(key));
-	Insert(contact, key);
+	dAssert(!FindContact(contact->GetBody0(), contact->GetBody1()));
+	// keep the table at most half full, so that the probe sequences are short.
+	if ((m_count + 1) * 2 > (m_mask + 1))
+	{
+		Resize(dMax(2 * (m_mask + 1), 8));
+	}
+
+	const dUnsigned64 tag = ndContactkey(contact->GetBody0()->GetId(), contact->GetBody1()->GetId()).GetTag();
+	dInt32 slot = GetSlot(tag);
+	for (; m_entries[slot].m_contact; slot = (slot + 1) & m_mask);
+	m_entries[slot].m_tag = tag;
+	m_entries[slot].m_contact = contact;
+	m_count++;
 }
 
 void ndBodyKinematic::ndContactMap::DetachContact(ndContact* const contact)
 {
-	ndBody* const body0 = contact->GetBody0();
-	ndBody* const body1 = contact->GetBody1();
-	ndContactkey key(body0->GetId(), body1->GetId());
-	dAssert(Find(key));
-	Remove(key);
+	const dUnsigned64 tag = ndContactkey(contact->GetBody0()->GetId(), contact->GetBody1()->GetId()).GetTag();
+	dInt32 slot = GetSlot(tag);
+	for (; m_entries[slot].m_tag != tag; slot = (slot + 1) & m_mask)
+	{
+		dAssert(m_entries[slot].m_contact);
+	}
+	dAssert(m_entries[slot].m_contact == contact);
+
+	// shift back the entries of the probe sequence that can not be found 
+	// once the slot is empty.
+	for (dInt32 next = (slot + 1) & m_mask; m_entries[next].m_contact; next = (next + 1) & m_mask)
+	{
+		const dInt32 home = GetSlot(m_entries[next].m_tag);
+		const bool stays = (slot <= next) ? ((slot < home) && (home <= next)) : ((slot < home) || (home <= next));
+		if (!stays)
+		{
+			m_entries[slot] = m_entries[next];
+			slot = next;
+		}
+	}
+	m_entries[slot].m_tag = 0;
+	m_entries[slot].m_contact = nullptr;
+	m_count--;
 }
 
 ndBodyKinematic::ndBodyKinematic()
@@ -190,11 +262,6 @@ void ndBodyKinematic::SetSceneAggregate(ndSceneAggregate* const node)
 	m_sceneAggregateNode = node;
 }
 
-void ndBodyKinematic::ReleaseMemory()
-{
-	ndContactMap::FlushFreeList();
-}
-
 ndContact* ndBodyKinematic::FindContact(const ndBody* const otherBody) const
 {
 	return m_contactList.FindContact(this, otherBody);
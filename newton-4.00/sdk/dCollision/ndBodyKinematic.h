@@ -60,6 +60,11 @@ class ndBodyKinematic: public ndBody
 			return m_tag > key.m_tag;
 		}
 
+		dUnsigned64 GetTag() const
+		{
+			return m_tag;
+		}
+
 		private:
 		union
 		{
@@ -72,15 +77,49 @@ class ndBodyKinematic: public ndBody
 		};
 	};
 	public:
-	class ndContactMap: public dTree<ndContact*, ndContactkey, dContainersFreeListAlloc<ndContact*>>
+	// open addressing hash set of the body contacts, keyed by the ids of the 
+	// two bodies. Collisions are linearly probed, and a removal shifts back 
+	// the entries that follow it, so the table never has deleted markers.
+	class ndContactMap
 	{
+		class ndEntry
+		{
+			public:
+			dUnsigned64 m_tag;
+			ndContact* m_contact;
+		};
+
 		public:
+		class Iterator
+		{
+			public:
+			Iterator(const ndContactMap& map);
+
+			void Begin();
+			operator bool() const;
+			void operator++ (dInt32);
+			ndContact* operator*() const;
+
+			private:
+			const ndContactMap& m_map;
+			dInt32 m_index;
+		};
+
 		ndContactMap();
+		~ndContactMap();
+
+		dInt32 GetCount() const;
 		D_COLLISION_API ndContact* FindContact(const ndBody* const body0, const ndBody* const body1) const;
 
 		private:
+		dInt32 GetSlot(dUnsigned64 tag) const;
+		void Resize(dInt32 capacity);
 		void AttachContact(ndContact* const contact);
 		void DetachContact(ndContact* const contact);
+
+		ndEntry* m_entries;
+		dInt32 m_count;
+		dInt32 m_mask;
 		friend class ndBodyKinematic;
 	};
 
@@ -108,6 +147,11 @@ class ndBodyKinematic: public ndBody
 	bool GetGyroMode() const;
 	void SetGyroMode(bool state);
 
+	// fast bodies, like projectiles, can be set to collide continuously, so that
+	// they do not pass through thin bodies when they move more than their size in one step.
+	bool GetContinueCollisionMode() const;
+	void SetContinueCollisionMode(bool state);
+
 	D_COLLISION_API ndShapeInstance& GetCollisionShape();
 	D_COLLISION_API const ndShapeInstance& GetCollisionShape() const;
 	D_COLLISION_API virtual void SetCollisionShape(const ndShapeInstance& shapeInstance);
@@ -151,7 +195,6 @@ class ndBodyKinematic: public ndBody
 	D_COLLISION_API void SetMassMatrix(dFloat32 mass, const dMatrix& inertia);
 
 	protected:
-	D_COLLISION_API static void ReleaseMemory();
 	D_COLLISION_API virtual void AttachContact(ndContact* const contact);
 	D_COLLISION_API virtual void DetachContact(ndContact* const contact);
 
@@ -203,6 +246,8 @@ class ndBodyKinematic: public ndBody
 	friend class ndScene;
 	friend class ndContact;
 	friend class ndSceneMixed;
+	friend class ndSceneSegregated;
+	friend class ndSceneSweepAndPrune;
 	friend class ndSceneBodyNode;
 	friend class ndDynamicsUpdate;
 	friend class ndSkeletonContainer;
@@ -343,6 +388,45 @@ inline void ndBodyKinematic::PrepareStep(dInt32 index)
 	m_islandParent = this;
 }
 
+inline ndBodyKinematic::ndContactMap::Iterator::Iterator(const ndContactMap& map)
+	:m_map(map)
+	,m_index(0)
+{
+}
+
+inline void ndBodyKinematic::ndContactMap::Iterator::Begin()
+{
+	m_index = -1;
+	(*this)++;
+}
+
+inline ndBodyKinematic::ndContactMap::Iterator::operator bool() const
+{
+	return m_index <= m_map.m_mask;
+}
+
+inline void ndBodyKinematic::ndContactMap::Iterator::operator++ (dInt32)
+{
+	for (m_index++; (m_index <= m_map.m_mask) && !m_map.m_entries[m_index].m_contact; m_index++);
+}
+
+inline ndContact* ndBodyKinematic::ndContactMap::Iterator::operator*() const
+{
+	dAssert(m_map.m_entries[m_index].m_contact);
+	return m_map.m_entries[m_index].m_contact;
+}
+
+inline dInt32 ndBodyKinematic::ndContactMap::GetCount() const
+{
+	return m_count;
+}
+
+inline dInt32 ndBodyKinematic::ndContactMap::GetSlot(dUnsigned64 tag) const
+{
+	// fibonacci hashing, the high bits of the product are the best mixed.
+	return dInt32((tag * dUnsigned64(0x9e3779b97f4a7c15)) >> 40) & m_mask;
+}
+
 inline ndBodyKinematic::ndContactMap& ndBodyKinematic::GetContactMap()
 {
 	return m_contactList;
@@ -389,6 +473,16 @@ inline void ndBodyKinematic::SetGyroMode(bool state)
 	m_gyroTorqueOn = state ? 1 : 0;
 }
 
+inline bool ndBodyKinematic::GetContinueCollisionMode() const
+{
+	return m_continueCollisionMode ? true : false;
+}
+
+inline void ndBodyKinematic::SetContinueCollisionMode(bool state)
+{
+	m_continueCollisionMode = state ? 1 : 0;
+}
+
 inline ndSkeletonContainer* ndBodyKinematic::GetSkeleton() const
 { 
 	return m_skeletonContainer;
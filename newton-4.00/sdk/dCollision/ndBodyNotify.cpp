@@ -27,6 +27,7 @@
 ndBodyNotify::ndBodyNotify(const nd::TiXmlNode* const rootNode)
 	:dClassAlloc()
 	,m_body(nullptr)
+	,m_defaultExternalForce(false)
 {
 	m_defualtGravity = xmlGetVector3(rootNode, "gravity");
 }
@@ -42,11 +42,17 @@ class ndBodyNotify: public dClassAlloc
 	virtual void OnTranform(dInt32 threadIndex, const dMatrix& matrix);
 
 	D_COLLISION_API virtual void OnApplyExternalForce(dInt32 threadIndex, dFloat32 timestep);
+
+	// when set, bodies apply the default gravity directly and OnApplyExternalForce is not called.
+	// only for notifications that do not override it, it is off by default.
+	bool HasDefaultExternalForce() const;
+	void SetDefaultExternalForce(bool state);
 	D_COLLISION_API virtual void Save(nd::TiXmlElement* const rootNode, const char* const assetPath) const;
 
 	private:
 	dVector m_defualtGravity;
 	ndBody* m_body;
+	bool m_defaultExternalForce;
 	friend class ndBody;
 
 } D_GCC_NEWTON_ALIGN_32;
@@ -55,6 +61,7 @@ inline ndBodyNotify::ndBodyNotify(const dVector& defualtGravity)
 	:dClassAlloc()
 	,m_defualtGravity(defualtGravity & dVector::m_triplexMask)
 	,m_body(nullptr)
+	,m_defaultExternalForce(false)
 {
 }
 
@@ -78,6 +85,16 @@ inline void ndBodyNotify::SetGravity(const dVector& defualtGravity)
 }
 
 
+inline bool ndBodyNotify::HasDefaultExternalForce() const
+{
+	return m_defaultExternalForce;
+}
+
+inline void ndBodyNotify::SetDefaultExternalForce(bool state)
+{
+	m_defaultExternalForce = state;
+}
+
 inline void* ndBodyNotify::GetUserData() const
 {
 	return nullptr;
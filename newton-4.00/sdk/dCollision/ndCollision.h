@@ -52,6 +52,8 @@
 #include <ndContactNotify.h>
 #include <ndShapeStaticBVH.h>
 #include <ndContactOptions.h>
+#include <ndSceneSegregated.h>
+#include <ndSceneSweepAndPrune.h>
 #include <ndShapeConvexHull.h>
 #include <ndShapeStaticMesh.h>
 #include <ndBodyPlayerCapsule.h>
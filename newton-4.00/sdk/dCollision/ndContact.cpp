@@ -40,13 +40,14 @@ ndContact::ndContact()
 	,m_positAcc(dFloat32(10.0f))
 	,m_rotationAcc()
 	,m_separatingVector(m_initialSeparatingVector)
+	,m_impactStep(dVector::m_zero)
 	,m_contacPointsList()
 	,m_body0(nullptr)
 	,m_body1(nullptr)
-	,m_linkNode(nullptr)
 	,m_timeOfImpact(dFloat32(1.0e10f))
 	,m_separationDistance(dFloat32(0.0f))
 	,m_contactPruningTolereance(D_PRUNE_CONTACT_TOLERANCE)
+	,m_contactIndex(-1)
 	,m_maxDOF(0)
 	,m_sceneLru(0)
 	,m_active(0)
@@ -55,7 +56,13 @@ ndContact::ndContact()
 	,m_isIntersetionTestOnly(0)
 	,m_skeletonIntraCollision(1)
 	,m_skeletonSelftCollision(1)
+	,m_triggerEnter(0)
+	,m_triggerExit(0)
 {
+	m_supportVertexShape[0] = nullptr;
+	m_supportVertexShape[1] = nullptr;
+	m_supportVertexCache[0] = -1;
+	m_supportVertexCache[1] = -1;
 }
 
 ndContact::~ndContact()
@@ -129,8 +136,11 @@ void ndContact::CalculatePointDerivative(dInt32 index, ndConstraintDescritor& de
 
 void ndContact::JacobianContactDerivative(ndConstraintDescritor& desc, const ndContactMaterial& contact, dInt32 normalIndex, dInt32& frictionIndex)
 {
+	// the point of a speculative contact is on body1, the point 
+	// on body0 is behind it by the relative motion to the impact.
 	dgPointParam pointData;
-	InitPointParam(pointData, dFloat32(1.0f), contact.m_point, contact.m_point);
+	const dVector point0((contact.m_penetration >= dFloat32(0.0f)) ? contact.m_point : contact.m_point - m_impactStep);
+	InitPointParam(pointData, dFloat32(1.0f), point0, contact.m_point);
 	CalculatePointDerivative(normalIndex, desc, contact.m_normal, pointData);
 
 	const dVector omega0(m_body0->GetOmega());
@@ -156,14 +166,27 @@ void ndContact::JacobianContactDerivative(ndConstraintDescritor& desc, const ndC
 	desc.m_forceBounds[normalIndex].m_normalIndex = D_INDEPENDENT_ROW;
 	desc.m_forceBounds[normalIndex].m_jointForce = (ndForceImpactPair*)&contact.m_normal_Force;
 	
-	const dFloat32 restitutionVelocity = (relSpeed > D_REST_RELATIVE_VELOCITY) ? relSpeed * restitutionCoefficient : dFloat32(0.0f);
-	//m_impulseSpeed = dMax(m_impulseSpeed, restitutionVelocity);
-	
-	dFloat32 penetrationStiffness = D_MAX_PENETRATION_STIFFNESS * contact.m_material.m_softness;
-	dFloat32 penetrationVeloc = penetration * penetrationStiffness;
-	dAssert(dAbs(penetrationVeloc - D_MAX_PENETRATION_STIFFNESS * contact.m_material.m_softness * penetration) < dFloat32(1.0e-6f));
-	desc.m_penetrationStiffness[normalIndex] = penetrationStiffness;
-	relSpeed += dMax(restitutionVelocity, penetrationVeloc);
+	if (contact.m_penetration >= dFloat32(0.0f))
+	{
+		const dFloat32 restitutionVelocity = (relSpeed > D_REST_RELATIVE_VELOCITY) ? relSpeed * restitutionCoefficient : dFloat32(0.0f);
+		//m_impulseSpeed = dMax(m_impulseSpeed, restitutionVelocity);
+
+		dFloat32 penetrationStiffness = D_MAX_PENETRATION_STIFFNESS * contact.m_material.m_softness;
+		dFloat32 penetrationVeloc = penetration * penetrationStiffness;
+		dAssert(dAbs(penetrationVeloc - D_MAX_PENETRATION_STIFFNESS * contact.m_material.m_softness * penetration) < dFloat32(1.0e-6f));
+		desc.m_penetrationStiffness[normalIndex] = penetrationStiffness;
+		relSpeed += dMax(restitutionVelocity, penetrationVeloc);
+	}
+	else
+	{
+		// speculative contact, the bodies can close the gap in this step but not more. 
+		// the negative penetration and the inverse step are saved so that the gap 
+		// speed is added again when the accelerations are recalculated.
+		desc.m_penetration[normalIndex] = contact.m_penetration;
+		desc.m_penetrationStiffness[normalIndex] = impulseOrForceScale;
+		desc.m_restitution[normalIndex] = dFloat32(0.0f);
+		relSpeed += contact.m_penetration * impulseOrForceScale;
+	}
 	
 	const bool isHardContact = !(contact.m_material.m_flags & m_isSoftContact);
 	desc.m_diagonalRegularizer[normalIndex] = isHardContact ? D_DIAGONAL_REGULARIZER : dMax(D_DIAGONAL_REGULARIZER, contact.m_material.m_skinThickness);
@@ -311,7 +334,12 @@ void ndContact::JointAccelerations(ndJointAccelerationDecriptor* const desc)
 		
 				dFloat32 penetrationVeloc = dFloat32(0.0f);
 				dFloat32 restitution = (vRel <= dFloat32(0.0f)) ? (dFloat32(1.0f) + rhs->m_restitution) : dFloat32(1.0f);
-				if (rhs->m_penetration > D_RESTING_CONTACT_PENETRATION * dFloat32(0.125f)) 
+				if (rhs->m_penetration < dFloat32(0.0f))
+				{
+					// speculative contact
+					penetrationVeloc = -rhs->m_penetration * rhs->m_penetrationStiffness;
+				}
+				else if (rhs->m_penetration > D_RESTING_CONTACT_PENETRATION * dFloat32(0.125f)) 
 				{
 					if (vRel > dFloat32(0.0f)) 
 					{
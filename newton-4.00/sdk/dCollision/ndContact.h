@@ -136,13 +136,16 @@ class ndContact
 	dVector m_positAcc;
 	dQuaternion m_rotationAcc;
 	dVector m_separatingVector;
+	dVector m_impactStep;
 	ndContactPointList m_contacPointsList;
 	ndBodyKinematic* m_body0;
 	ndBodyKinematic* m_body1;
-	dList<ndContact, dContainersFreeListAlloc<ndContact>>::dListNode* m_linkNode;
 	dFloat32 m_timeOfImpact;
 	dFloat32 m_separationDistance;
 	dFloat32 m_contactPruningTolereance;
+	const ndShape* m_supportVertexShape[2];
+	dInt32 m_supportVertexCache[2];
+	dInt32 m_contactIndex;
 	dUnsigned32 m_maxDOF;
 	dUnsigned32 m_sceneLru;
 	dUnsigned32 m_active : 1;
@@ -151,6 +154,8 @@ class ndContact
 	dUnsigned32 m_isIntersetionTestOnly : 1;
 	dUnsigned32 m_skeletonIntraCollision : 1;
 	dUnsigned32 m_skeletonSelftCollision : 1;
+	dUnsigned32 m_triggerEnter : 1;
+	dUnsigned32 m_triggerExit : 1;
 	static dVector m_initialSeparatingVector;
 
 	friend class ndScene;
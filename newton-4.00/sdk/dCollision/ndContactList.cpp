@@ -26,12 +26,46 @@
 #include "ndContactList.h"
 #include "ndBodyKinematic.h"
 
+ndContactList::ndContactList()
+	:dClassAlloc()
+	,m_contacts()
+	,m_freeContacts()
+	,m_chunks()
+{
+}
+
+ndContactList::~ndContactList()
+{
+	dAssert(!m_contacts.GetCount());
+	for (dInt32 i = 0; i < m_chunks.GetCount(); i++)
+	{
+		dMemory::Free(m_chunks[i]);
+	}
+}
+
+void ndContactList::AddChunk()
+{
+	ndContact* const chunk = (ndContact*)dMemory::Malloc(D_CONTACT_POOL_CHUNK_SIZE * sizeof(ndContact));
+	m_chunks.PushBack(chunk);
+	for (dInt32 i = D_CONTACT_POOL_CHUNK_SIZE - 1; i >= 0; i--)
+	{
+		m_freeContacts.PushBack(&chunk[i]);
+	}
+}
+
 ndContact* ndContactList::CreateContact(ndBodyKinematic* const body0, ndBodyKinematic* const body1)
 {
-	dListNode* const node = Append();
-	ndContact* const contact = &node->GetInfo();
+	if (!m_freeContacts.GetCount())
+	{
+		AddChunk();
+	}
+	const dInt32 freeCount = m_freeContacts.GetCount() - 1;
+	ndContact* const contact = ::new (m_freeContacts[freeCount]) ndContact();
+	m_freeContacts.SetCount(freeCount);
+
 	contact->SetBodies(body0, body1);
-	contact->m_linkNode = node;
+	contact->m_contactIndex = m_contacts.GetCount();
+	m_contacts.PushBack(contact);
 	contact->AttachToBodies();
 	return contact;
 }
@@ -39,15 +73,23 @@ ndContact* ndContactList::CreateContact(ndBodyKinematic* const body0, ndBodyKine
 void ndContactList::DeleteContact(ndContact* const contact)
 {
 	dAssert(contact->m_isAttached);
+	dAssert(m_contacts[contact->m_contactIndex] == contact);
 	contact->DetachFromBodies();
-	Remove(contact->m_linkNode);
+
+	const dInt32 lastIndex = m_contacts.GetCount() - 1;
+	ndContact* const lastContact = m_contacts[lastIndex];
+	lastContact->m_contactIndex = contact->m_contactIndex;
+	m_contacts[contact->m_contactIndex] = lastContact;
+	m_contacts.SetCount(lastIndex);
+
+	contact->~ndContact();
+	m_freeContacts.PushBack(contact);
 }
 
 void ndContactList::DeleteAllContacts()
 {
-	while (GetFirst())
+	while (m_contacts.GetCount())
 	{
-		DeleteContact(&GetFirst()->GetInfo());
+		DeleteContact(m_contacts[m_contacts.GetCount() - 1]);
 	}
-	FlushFreeList();
 }
@@ -35,22 +35,41 @@ class ndConstraintArray: public dArray<ndConstraint*>
 	}
 };
 
-class ndContactList: public dList<ndContact, dContainersFreeListAlloc<ndContact>>
+#define D_CONTACT_POOL_CHUNK_SIZE	1024
+
+// contacts are allocated in chunks, so a contact does not move in memory while 
+// it is alive. The live contacts are also kept in a dense array and each contact 
+// knows its index in it, so they can be addressed by index and a deleted contact 
+// is replaced by the last one. 
+class ndContactList: public dClassAlloc
 {
 	public:
-	ndContactList()
-		:dList<ndContact, dContainersFreeListAlloc<ndContact>>()
-	{
-	}
+	D_COLLISION_API ndContactList();
+	D_COLLISION_API ~ndContactList();
 
-	~ndContactList()
-	{
-	}
+	dInt32 GetCount() const;
+	ndContact* GetContact(dInt32 index) const;
 
 	D_COLLISION_API void DeleteAllContacts();
 	D_COLLISION_API void DeleteContact(ndContact* const contact);
 	D_COLLISION_API ndContact* CreateContact(ndBodyKinematic* const body0, ndBodyKinematic* const body1);
+
+	private:
+	void AddChunk();
+
+	dArray<ndContact*> m_contacts;
+	dArray<ndContact*> m_freeContacts;
+	dArray<ndContact*> m_chunks;
 };
 
+inline dInt32 ndContactList::GetCount() const
+{
+	return m_contacts.GetCount();
+}
+
+inline ndContact* ndContactList::GetContact(dInt32 index) const
+{
+	return m_contacts[index];
+}
 
 #endif
\ No newline at end of file
@@ -93,6 +93,7 @@ class ndContactNotify: public dClassAlloc
 	protected:
 	ndScene* m_scene;
 	friend class ndScene;
+	friend class ndWorld;
 };
 
 #endif
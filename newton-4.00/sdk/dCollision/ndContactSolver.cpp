@@ -69,7 +69,11 @@ ndContactSolver::ndContactSolver(ndShapeInstance* const instance)
 	,m_separationDistance(dFloat32(0.0f))
 	,m_skinThickness(dFloat32(0.0f))
 	,m_maxCount(D_MAX_CONTATCS)
+	,m_maxContactsPerPair(D_MAX_CONTACTS_PER_PAIR)
+	,m_candidateCount(0)
 	,m_vertexIndex(0)
+	,m_supportVertexIndex0(-1)
+	,m_supportVertexIndex1(-1)
 	,m_ccdMode(false)
 	,m_intersectionTestOnly(false)
 {
@@ -88,10 +92,23 @@ ndContactSolver::ndContactSolver(ndContact* const contact)
 	,m_separationDistance(dFloat32(0.0f))
 	,m_skinThickness(dFloat32(0.0f))
 	,m_maxCount(D_MAX_CONTATCS)
+	,m_maxContactsPerPair(D_MAX_CONTACTS_PER_PAIR)
+	,m_candidateCount(0)
 	,m_vertexIndex(0)
+	,m_supportVertexIndex0(-1)
+	,m_supportVertexIndex1(-1)
 	,m_ccdMode(false)
 	,m_intersectionTestOnly(false)
 {
+	// a cached support vertex is only a hint for the shape that produced it
+	if (contact->m_supportVertexShape[0] == m_instance0.GetShape())
+	{
+		m_supportVertexIndex0 = contact->m_supportVertexCache[0];
+	}
+	if (contact->m_supportVertexShape[1] == m_instance1.GetShape())
+	{
+		m_supportVertexIndex1 = contact->m_supportVertexCache[1];
+	}
 }
 
 #if 0
@@ -137,93 +154,92 @@ D_INLINE void ndContactSolver::TranslateSimplex(const dVector& step)
 	}
 }
 
+#endif
+
 dInt32 ndContactSolver::CalculateConvexCastContacts()
 {
-	dAssert(0);
-	return 0;
-#if 0
-	dInt32 iter = 0;
-	dInt32 count = 0;
-	
-	dFloat32 tacc = dFloat32(0.0f);
-	dFloat32 timestep = m_proxy->m_timestep;
-	m_proxy->m_contactJoint->m_closestDistance = dFloat32(1.0e10f);
+	dInt32 count = ConvexToConvexContacts();
+	if (count || m_intersectionTestOnly || (m_separationDistance <= dFloat32(0.0f)))
+	{
+		return count;
+	}
 
-	dVector savedPosition1 (m_instance1->m_globalMatrix.m_posit);
+	// the shapes are apart, advance body0 along the relative linear motion until
+	// the shapes touch. each advance is the distance over the closing speed, so
+	// it never goes past the time of impact.
+	const ndBodyKinematic* const body0 = m_contact->GetBody0();
+	const ndBodyKinematic* const body1 = m_contact->GetBody1();
+	const dVector relVeloc((body0->GetVelocity() - body1->GetVelocity()) & dVector::m_triplexMask);
+	const dVector savedPosition1(m_instance1.m_globalMatrix.m_posit);
+	const dVector savedSeparatingVector(m_separatingVector);
+	const dVector savedClosestPoint0(m_closestPoint0);
+	const dVector savedClosestPoint1(m_closestPoint1);
 
-	dVector relVeloc (m_proxy->m_body0->GetVelocity() - m_proxy->m_body1->GetVelocity());
-	do {
-		bool state = CalculateClosestPoints();
-		if (!state) {
+	bool hit = false;
+	dFloat32 tacc = dFloat32(0.0f);
+	for (dInt32 i = 0; i < D_SEPARATION_PLANES_ITERATIONS; i++)
+	{
+		const dFloat32 den = m_separatingVector.DotProduct(relVeloc).GetScalar();
+		if (den <= dFloat32(1.0e-6f))
+		{
+			// the bodies are moving apart
 			break;
 		}
-		dAssert(m_normal.m_w == dFloat32(0.0f));
-		dFloat32 den = m_normal.DotProduct(relVeloc).GetScalar();
-		if (den <= dFloat32(1.0e-6f)) {
-			// bodies are residing from each other, even if they are touching they are not considered to be colliding because the motion will move them apart 
-			// get the closet point and the normal at contact point
-			m_proxy->m_timestep = dFloat32 (1.0e10f);
-			m_proxy->m_normal = m_normal.Scale(-1.0f);
-			m_proxy->m_closestPointBody0 = m_closestPoint0;
-			m_proxy->m_closestPointBody1 = m_closestPoint1;
+
+		const dFloat32 dist = m_separatingVector.DotProduct(m_closestPoint1 - m_closestPoint0).GetScalar() - m_skinThickness;
+		if (dist <= D_PENETRATION_TOL)
+		{
+			hit = true;
 			break;
 		}
 
-		dFloat32 num = m_normal.DotProduct(m_closestPoint1 - m_closestPoint0).GetScalar() - m_proxy->m_skinThickness;
-		if ((num <= dFloat32(1.0e-5f)) && (tacc <= timestep)) {
-			// bodies collide at time tacc, but we do not set it yet
-			dVector step(relVeloc.Scale(tacc));
-			m_proxy->m_timestep = tacc;
-			m_proxy->m_closestPointBody0 = m_closestPoint0 + step;
-			m_proxy->m_closestPointBody1 = m_closestPoint1 + step;
-			m_proxy->m_normal = m_normal.Scale (dFloat32 (-1.0f));
-			m_proxy->m_contactJoint->m_closestDistance = m_proxy->m_normal.DotProduct(m_closestPoint0 - m_closestPoint1).GetScalar();
-			dFloat32 penetration = dMax(num * dFloat32(-1.0f) + D_PENETRATION_TOL, dFloat32(0.0f));
-			m_proxy->m_contactJoint->m_closestDistance = penetration;
-			if (m_proxy->m_contacts && !m_proxy->m_intersectionTestOnly) {
-				if (m_proxy->m_instance0->GetCollisionMode() & m_proxy->m_instance1->GetCollisionMode()) {
-
-					m_normal = m_normal.Scale (dFloat32 (-1.0f));
-					m_proxy->m_contactJoint->m_isActive = 1;
-					count = CalculateContacts(m_closestPoint0, m_closestPoint1, m_normal);
-					if (count) {
-						count = dMin(m_proxy->m_maxContacts, count);
-						ntContactPoint* const contactOut = m_proxy->m_contacts;
-
-						for (dInt32 i = 0; i < count; i++) {
-							contactOut[i].m_point = m_hullDiff[i] + step;
-							contactOut[i].m_normal = m_normal;
-							contactOut[i].m_penetration = penetration;
-						}
-					}
-				}
-			}
+		tacc += dist / den;
+		if (tacc >= m_timestep)
+		{
 			break;
 		}
-
-		dAssert (den > dFloat32 (0.0f));
-		dFloat32 dt = num / den;
-		if ((tacc + dt) >= timestep) {
-			// object do not collide on this timestep
-			m_proxy->m_timestep = tacc + dt;
-			m_proxy->m_normal = m_normal.Scale (dFloat32 (-1.0f));
-			m_proxy->m_closestPointBody0 = m_closestPoint0;
-			m_proxy->m_closestPointBody1 = m_closestPoint1;
+		m_instance1.m_globalMatrix.m_posit = savedPosition1 - relVeloc.Scale(tacc);
+		if (!CalculateClosestPoints())
+		{
 			break;
 		}
+	}
 
-		tacc += dt;
-		dVector step(relVeloc.Scale(dt));
-		TranslateSimplex(step);
+	if (hit && (m_instance0.GetCollisionMode() & m_instance1.GetCollisionMode()))
+	{
+		// the contacts at the time of impact are speculative contacts, their negative
+		// penetration is the gap the bodies can close before the contacts push back.
+		const dVector normal(m_separatingVector * dVector::m_negOne);
+		count = CalculateContacts(m_closestPoint0, m_closestPoint1, normal);
+		count = dMin(m_maxCount, count);
 
-		iter++;
-	} while (iter < D_SEPARATION_PLANES_ITERATIONS);
+		// the points were calculated with body1 moved back by step, translate them 
+		// by step to put them on body1 where the bodies touch. the contact saves 
+		// the step, so that the jacobian puts the point on body0 behind by step.
+		const dVector step(relVeloc.Scale(tacc));
+		const dFloat32 gap = dMax(m_separatingVector.DotProduct(step).GetScalar(), D_PENETRATION_TOL);
+		m_contact->m_impactStep = step;
+		ndShapeInstance* const instance0 = &m_contact->GetBody0()->GetCollisionShape();
+		ndShapeInstance* const instance1 = &m_contact->GetBody1()->GetCollisionShape();
+		ndContactPoint* const contactOut = m_contactBuffer;
+		for (dInt32 i = count - 1; i >= 0; i--)
+		{
+			contactOut[i].m_point = m_buffer[i] + step;
+			contactOut[i].m_normal = normal;
+			contactOut[i].m_body0 = m_contact->GetBody0();
+			contactOut[i].m_body1 = m_contact->GetBody1();
+			contactOut[i].m_shapeInstance0 = instance0;
+			contactOut[i].m_shapeInstance1 = instance1;
+			contactOut[i].m_penetration = -gap;
+		}
+	}
 
-	m_instance1->m_globalMatrix.m_posit = savedPosition1;
+	m_instance1.m_globalMatrix.m_posit = savedPosition1;
+	m_separatingVector = savedSeparatingVector;
+	m_closestPoint0 = savedClosestPoint0;
+	m_closestPoint1 = savedClosestPoint1;
 	return count;
-#endif
 }
-#endif
 
 dInt32 ndContactSolver::CalculateConvexToConvexContacts()
 {
@@ -236,8 +252,7 @@ dInt32 ndContactSolver::CalculateConvexToConvexContacts()
 
 	if (m_ccdMode)
 	{
-		dAssert(0);
-		//count = contactSolver.CalculateConvexCastContacts();
+		count = CalculateConvexCastContacts();
 	}
 	else
 	{
@@ -254,15 +269,9 @@ dInt32 ndContactSolver::CalculateConvexToSaticMeshContacts()
 	dAssert(m_instance0.GetShape()->GetAsShapeConvex());
 	dAssert(m_instance1.GetShape()->GetAsShapeStaticMeshShape());
 
-	if (m_ccdMode)
-	{
-		dAssert(0);
-		//count = contactSolver.CalculateConvexCastContacts();
-	}
-	else
-	{
-		count = ConvexToStaticMeshContacts();
-	}
+	// there is not continuous collision against static meshes yet, the faces are tested at the current position.
+	m_ccdMode = 0;
+	count = ConvexToStaticMeshContacts();
 	return count;
 }
 
@@ -300,9 +309,10 @@ dInt32 ndContactSolver::ConvexContacts()
 		}
 	}
 
+	m_candidateCount = count;
 	if (count > 1)
 	{
-		count = PruneContacts(count, 16);
+		count = PruneContacts(count, m_maxContactsPerPair);
 	}
 
 	dVector offset = (origin0 & dVector::m_triplexMask);
@@ -387,6 +397,10 @@ dInt32 ndContactSolver::CalculatePairContacts(dInt32 threadIndex)
 	m_contact->m_timeOfImpact = m_timestep;
 	m_contact->m_separatingVector = m_separatingVector;
 	m_contact->m_separationDistance = m_separationDistance;
+	m_contact->m_supportVertexShape[0] = m_instance0.GetShape();
+	m_contact->m_supportVertexShape[1] = m_instance1.GetShape();
+	m_contact->m_supportVertexCache[0] = m_supportVertexIndex0;
+	m_contact->m_supportVertexCache[1] = m_supportVertexIndex1;
 
 	return count;
 }
@@ -511,8 +525,8 @@ D_INLINE void ndContactSolver::SupportVertex(const dVector& dir0, dInt32 vertexI
 	
 	const dMatrix& matrix0 = m_instance0.m_globalMatrix;
 	const dMatrix& matrix1 = m_instance1.m_globalMatrix;
-	dVector p(matrix0.TransformVector(m_instance0.SupportVertexSpecial(matrix0.UnrotateVector (dir0), nullptr)) & dVector::m_triplexMask);
-	dVector q(matrix1.TransformVector(m_instance1.SupportVertexSpecial(matrix1.UnrotateVector (dir1), nullptr)) & dVector::m_triplexMask);
+	dVector p(matrix0.TransformVector(m_instance0.SupportVertexSpecial(matrix0.UnrotateVector (dir0), &m_supportVertexIndex0)) & dVector::m_triplexMask);
+	dVector q(matrix1.TransformVector(m_instance1.SupportVertexSpecial(matrix1.UnrotateVector (dir1), &m_supportVertexIndex1)) & dVector::m_triplexMask);
 	m_hullDiff[vertexIndex] = p - q;
 	m_hullSum[vertexIndex] = p + q;
 }
@@ -1656,7 +1670,7 @@ dInt32 ndContactSolver::Prune3dContacts(const dMatrix& matrix, dInt32 count, ndC
 		}
 	} while (count > maxCount);
 
-	ndContactPoint tmpContact[16];
+	ndContactPoint tmpContact[D_MAX_CONTACTS_PER_PAIR];
 	for (dInt32 i = 0; i < count; i++) 
 	{
 		dInt32 index = dInt32(array[i].m_w);
@@ -2427,6 +2441,7 @@ dInt32 ndContactSolver::CalculatePolySoupToHullContactsDescrete(ndPolygonMeshDes
 		contactJoint->m_separatingVector = separatingVector;
 		m_maxCount = countleft;
 		m_vertexIndex = 0;
+		m_supportVertexIndex1 = -1;
 		m_contactBuffer = &contactOut[count];
 		dInt32 count1 = polygon.CalculateContactToConvexHullDescrete(&polySoupInstance, *this);
 		//closestDist = dMin(closestDist, contactJoint->m_closestDistance);
@@ -2511,6 +2526,7 @@ dInt32 ndContactSolver::CalculatePolySoupToHullContactsDescrete(ndPolygonMeshDes
 	m_contactBuffer = contactOut;
 	m_instance1.m_shape = polySoupInstance.m_shape;
 	m_instance1 = polySoupInstance;
+	m_supportVertexIndex1 = -1;
 
 	return count;
 }
\ No newline at end of file
@@ -47,6 +47,7 @@ class ndMinkFace
 #define D_CONVEX_MINK_MAX_FACES			512
 #define D_CONVEX_MINK_MAX_POINTS		256
 #define D_MAX_EDGE_COUNT				2048
+#define D_MAX_CONTACTS_PER_PAIR			16
 #define D_PENETRATION_TOL				dFloat32 (1.0f / 1024.0f)
 #define D_MINK_VERTEX_ERR				dFloat32 (1.0e-3f)
 #define D_MINK_VERTEX_ERR2				(D_MINK_VERTEX_ERR * D_MINK_VERTEX_ERR)
@@ -63,7 +64,6 @@ class ndContactSolver: public dDownHeap<ndMinkFace *, dFloat32>
 
 	//ndContactSolver(const ndShapeInstance& instance0, const ndShapeInstance& instance1);
 	//ndContactSolver(dCollisionParamProxy* const proxy);
-	//dInt32 CalculateConvexCastContacts();
 	//const dVector& GetNormal() const {return m_normal;}
 	//const dVector& GetPoint0() const {return m_closestPoint0;}
 	//const dVector& GetPoint1() const {return m_closestPoint1;}
@@ -104,6 +104,7 @@ class ndContactSolver: public dDownHeap<ndMinkFace *, dFloat32>
 
 	dInt32 CalculateClosestSimplex();
 	bool CalculateClosestPoints();
+	dInt32 CalculateConvexCastContacts();
 	dInt32 ConvexToConvexContacts();
 	dInt32 ConvexToStaticMeshContacts();
 
@@ -149,7 +150,11 @@ class ndContactSolver: public dDownHeap<ndMinkFace *, dFloat32>
 	dFloat32 m_skinThickness;
 
 	dInt32 m_maxCount;
+	dInt32 m_maxContactsPerPair;
+	dInt32 m_candidateCount;
 	dInt32 m_vertexIndex;
+	dInt32 m_supportVertexIndex0;
+	dInt32 m_supportVertexIndex1;
 	dUnsigned32 m_ccdMode : 1;
 	dUnsigned32 m_intersectionTestOnly : 1;
 	
@@ -675,6 +675,130 @@ void ndJointBilateralConstraint::AddAngularRowJacobian(ndConstraintDescritor& de
 	desc.m_rowsCount = index + 1;
 }
 
+void ndJointBilateralConstraint::AddLinearRowsJacobian(ndConstraintDescritor& desc, const dVector& pivot0, const dVector& pivot1, const dMatrix& dirs, dInt32 rowCount)
+{
+	// same rows as calling AddLinearRowJacobian with the first rowCount directions of dirs,
+	// but the terms that only depend on the pivots are calculated once, and the projection
+	// on each direction is done for all rows at the same time on the transposed directions.
+	dAssert(rowCount > 0);
+	dAssert(rowCount <= 3);
+	dAssert(desc.m_timestep > dFloat32(0.0f));
+	dAssert((desc.m_rowsCount + rowCount) <= dInt32(m_maxDof));
+
+	const dVector r0((pivot0 - m_body0->m_globalCentreOfMass) & dVector::m_triplexMask);
+	const dVector r1((pivot1 - m_body1->m_globalCentreOfMass) & dVector::m_triplexMask);
+
+	const dVector& veloc0 = m_body0->m_veloc;
+	const dVector& veloc1 = m_body1->m_veloc;
+	const dVector& omega0 = m_body0->m_omega;
+	const dVector& omega1 = m_body1->m_omega;
+	const dVector& gyroAlpha0 = m_body0->m_gyroAlpha;
+	const dVector& gyroAlpha1 = m_body1->m_gyroAlpha;
+	const dVector centripetal0(omega0.CrossProduct(omega0.CrossProduct(r0)));
+	const dVector centripetal1(omega1.CrossProduct(omega1.CrossProduct(r1)));
+
+	const dMatrix dirsTranspose(dirs.Transpose());
+	const dVector relPosit(dirsTranspose.RotateVector(pivot1 - pivot0));
+	const dVector relGyro(dirsTranspose.RotateVector(gyroAlpha0.CrossProduct(r0) + r1.CrossProduct(gyroAlpha1)));
+	const dVector relCentr(dirsTranspose.RotateVector(centripetal1 - centripetal0));
+	const dVector relVeloc(dirsTranspose.RotateVector(veloc1 - veloc0 + r0.CrossProduct(omega0) + omega1.CrossProduct(r1)));
+
+	//at =  [- ks (x2 - x1) - kd * (v2 - v1) - dt * ks * (v2 - v1)] / [1 + dt * kd + dt * dt * ks] 
+	const dFloat32 dt = desc.m_timestep;
+	const dFloat32 ks = DG_POS_DAMP;
+	const dFloat32 kd = DG_VEL_DAMP;
+	const dFloat32 ksd = dt * ks;
+	const dFloat32 den = dFloat32(1.0f) + dt * kd + dt * ksd;
+	const dVector num(relPosit.Scale(ks) + relVeloc.Scale(kd + ksd));
+	const dVector relAccel(num.Scale(dFloat32(1.0f) / den) + relCentr + relGyro);
+	const dVector zeroRowAccel(relVeloc.Scale(desc.m_invTimestep) + relGyro);
+
+	for (dInt32 i = 0; i < rowCount; i++)
+	{
+		const dInt32 index = desc.m_rowsCount + i;
+		const dVector& dir = dirs[i];
+		dAssert(dir.m_w == dFloat32(0.0f));
+
+		ndJacobian& jacobian0 = desc.m_jacobian[index].m_jacobianM0;
+		ndJacobian& jacobian1 = desc.m_jacobian[index].m_jacobianM1;
+		m_r0[index] = r0;
+		m_r1[index] = r1;
+		jacobian0.m_linear = dir;
+		jacobian0.m_angular = r0.CrossProduct(dir);
+		jacobian1.m_linear = dir * dVector::m_negOne;
+		jacobian1.m_angular = dir.CrossProduct(r1);
+
+		m_motorAcceleration[index] = dFloat32(0.0f);
+		desc.m_flags[index] = 0;
+		desc.m_penetration[index] = relPosit[i];
+		desc.m_diagonalRegularizer[index] = m_defualtDiagonalRegularizer;
+		desc.m_jointAccel[index] = relAccel[i];
+		desc.m_penetrationStiffness[index] = relAccel[i];
+		desc.m_restitution[index] = dFloat32(0.0f);
+		desc.m_forceBounds[index].m_jointForce = &m_jointForce[index];
+		desc.m_zeroRowAcceleration[index] = zeroRowAccel[i];
+	}
+	m_rowIsMotor &= ~(((1 << rowCount) - 1) << desc.m_rowsCount);
+	desc.m_rowsCount += rowCount;
+}
+
+void ndJointBilateralConstraint::AddAngularRowsJacobian(ndConstraintDescritor& desc, const dMatrix& dirs, const dVector& relAngles, dInt32 rowCount)
+{
+	// same rows as calling AddAngularRowJacobian with the first rowCount directions of dirs
+	// and the angles in relAngles, with all the rows calculated at the same time.
+	dAssert(rowCount > 0);
+	dAssert(rowCount <= 3);
+	dAssert(desc.m_timestep > dFloat32(0.0f));
+	dAssert((desc.m_rowsCount + rowCount) <= dInt32(m_maxDof));
+
+	const dVector& omega0 = m_body0->GetOmega();
+	const dVector& omega1 = m_body1->GetOmega();
+	const dVector& gyroAlpha0 = m_body0->m_gyroAlpha;
+	const dVector& gyroAlpha1 = m_body1->m_gyroAlpha;
+
+	const dMatrix dirsTranspose(dirs.Transpose());
+	const dVector relOmega(dirsTranspose.RotateVector(omega1 - omega0));
+	const dVector relGyro(dirsTranspose.RotateVector(gyroAlpha0 - gyroAlpha1));
+
+	//at =  [- ks (x2 - x1) - kd * (v2 - v1) - dt * ks * (v2 - v1)] / [1 + dt * kd + dt * dt * ks] 
+	const dFloat32 dt = desc.m_timestep;
+	const dFloat32 ks = DG_POS_DAMP;
+	const dFloat32 kd = DG_VEL_DAMP;
+	const dFloat32 ksd = dt * ks;
+	const dFloat32 den = dFloat32(1.0f) + dt * kd + dt * ksd;
+	const dVector num(relAngles.Scale(ks) + relOmega.Scale(kd + ksd));
+	const dVector relAlpha(num.Scale(dFloat32(1.0f) / den) + relGyro);
+	const dVector zeroRowAccel(relOmega.Scale(desc.m_invTimestep) + relGyro);
+
+	for (dInt32 i = 0; i < rowCount; i++)
+	{
+		const dInt32 index = desc.m_rowsCount + i;
+		const dVector& dir = dirs[i];
+		dAssert(dir.m_w == dFloat32(0.0f));
+
+		ndJacobian& jacobian0 = desc.m_jacobian[index].m_jacobianM0;
+		ndJacobian& jacobian1 = desc.m_jacobian[index].m_jacobianM1;
+		m_r0[index] = dVector::m_zero;
+		m_r1[index] = dVector::m_zero;
+		jacobian0.m_linear = dVector::m_zero;
+		jacobian0.m_angular = dir;
+		jacobian1.m_linear = dVector::m_zero;
+		jacobian1.m_angular = dir * dVector::m_negOne;
+
+		m_motorAcceleration[index] = dFloat32(0.0f);
+		desc.m_flags[index] = 0;
+		desc.m_penetration[index] = relAngles[i];
+		desc.m_diagonalRegularizer[index] = m_defualtDiagonalRegularizer;
+		desc.m_jointAccel[index] = relAlpha[i];
+		desc.m_penetrationStiffness[index] = relAlpha[i];
+		desc.m_restitution[index] = dFloat32(0.0f);
+		desc.m_forceBounds[index].m_jointForce = &m_jointForce[index];
+		desc.m_zeroRowAcceleration[index] = zeroRowAccel[i];
+	}
+	m_rowIsMotor &= ~(((1 << rowCount) - 1) << desc.m_rowsCount);
+	desc.m_rowsCount += rowCount;
+}
+
 void ndJointBilateralConstraint::SetMassSpringDamperAcceleration(ndConstraintDescritor& desc, dFloat32 spring, dFloat32 damper)
 {
 	const dInt32 index = desc.m_rowsCount - 1;
@@ -57,6 +57,8 @@ class ndJointBilateralConstraint: public ndConstraint, public dClassAlloc
 	D_COLLISION_API void CalculateLocalMatrix(const dMatrix& pinsAndPivotFrame, dMatrix& localMatrix0, dMatrix& localMatrix1) const;
 	D_COLLISION_API void AddAngularRowJacobian(ndConstraintDescritor& desc, const dVector& dir, dFloat32 relAngle);
 	D_COLLISION_API void AddLinearRowJacobian(ndConstraintDescritor& desc, const dVector& pivot0, const dVector& pivot1, const dVector& dir);
+	D_COLLISION_API void AddAngularRowsJacobian(ndConstraintDescritor& desc, const dMatrix& dirs, const dVector& relAngles, dInt32 rowCount);
+	D_COLLISION_API void AddLinearRowsJacobian(ndConstraintDescritor& desc, const dVector& pivot0, const dVector& pivot1, const dMatrix& dirs, dInt32 rowCount);
 
 	D_COLLISION_API virtual void DebugJoint(ndConstraintDebugCallback& debugCallback) const;
 	D_COLLISION_API dFloat32 CalculateSpringDamperAcceleration(dFloat32 dt, dFloat32 ks, dFloat32 x, dFloat32 kd, dFloat32 v) const;
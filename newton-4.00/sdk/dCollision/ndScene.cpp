@@ -190,12 +190,18 @@ ndScene::ndScene()
 	,m_contactList()
 	,m_activeBodyArray(1024)
 	,m_activeConstraintArray()
+	,m_scratchConstraintArray()
+	,m_triggerContacts()
 	,m_contactLock()
 	,m_rootNode(nullptr)
 	,m_contactNotifyCallback(new ndContactNotify())
 	,m_timestep(dFloat32 (0.0f))
 	,m_sleepBodies(0)
 	,m_lru(D_CONTACT_DELAY_FRAMES)
+	,m_transformBufferIndex(0)
+	,m_statistics()
+	,m_maxContactsPerPair(D_MAX_CONTACTS_PER_PAIR)
+	,m_exportTransforms(false)
 	,m_fullScan(true)
 {
 	m_contactNotifyCallback->m_scene = this;
@@ -206,7 +212,6 @@ ndScene::~ndScene()
 	Sync();
 	Finish();
 	delete m_contactNotifyCallback;
-	ndContactList::FlushFreeList();
 	ndContactPointList::FlushFreeList();
 }
 
@@ -265,6 +270,11 @@ void ndScene::SetContactNotify(ndContactNotify* const notify)
 	m_contactNotifyCallback->m_scene = this;
 }
 
+void ndScene::SetMaxContactsPerPair(dInt32 count)
+{
+	m_maxContactsPerPair = dClamp(count, dInt32(3), dInt32(D_MAX_CONTACTS_PER_PAIR));
+}
+
 bool ndScene::AddBody(ndBodyKinematic* const body)
 {
 	if ((body->m_scene == nullptr) && (body->m_sceneNode == nullptr))
@@ -280,10 +290,11 @@ bool ndScene::AddBody(ndBodyKinematic* const body)
 bool ndScene::RemoveBody(ndBodyKinematic* const body)
 {
 	ndBodyKinematic::ndContactMap& contactMap = body->GetContactMap();
-	while (contactMap.GetRoot())
+	while (contactMap.GetCount())
 	{
-		ndContact* const contact = contactMap.GetRoot()->GetInfo();
-		m_contactList.DeleteContact(contact);
+		ndBodyKinematic::ndContactMap::Iterator it(contactMap);
+		it.Begin();
+		m_contactList.DeleteContact(*it);
 	}
 
 	if (body->m_scene && body->m_sceneNode)
@@ -390,6 +401,59 @@ dFloat32 ndScene::RayCast(ndRayCastNotify& callback, const ndSceneNode** stackPo
 	return maxParam;
 }
 
+dInt32 ndScene::BodiesInAabb(const dVector& minBox, const dVector& maxBox, ndBodyKinematic** const bodyArray, dInt32 maxCount) const
+{
+	return BodiesInAabb(m_rootNode, minBox, maxBox, bodyArray, maxCount);
+}
+
+dInt32 ndScene::BodiesInAabb(const ndSceneNode* const root, const dVector& minBox, const dVector& maxBox, ndBodyKinematic** const bodyArray, dInt32 maxCount) const
+{
+	if (!root)
+	{
+		return 0;
+	}
+
+	dInt32 count = 0;
+	dInt32 stack = 1;
+	const ndSceneNode* stackPool[D_SCENE_MAX_STACK_DEPTH];
+	stackPool[0] = root;
+	while (stack && (count < maxCount))
+	{
+		stack--;
+		const ndSceneNode* const node = stackPool[stack];
+		if (dOverlapTest(node->m_minBox, node->m_maxBox, minBox, maxBox))
+		{
+			ndBodyKinematic* const body = node->GetBody();
+			if (body)
+			{
+				dVector box0;
+				dVector box1;
+				body->GetAABB(box0, box1);
+				if (dOverlapTest(box0, box1, minBox, maxBox))
+				{
+					bodyArray[count] = body;
+					count++;
+				}
+			}
+			else if (((ndSceneNode*)node)->GetAsSceneAggregate())
+			{
+				dAssert(0);
+			}
+			else
+			{
+				dAssert(node->GetLeft());
+				dAssert(node->GetRight());
+				stackPool[stack] = node->GetLeft();
+				stack++;
+				stackPool[stack] = node->GetRight();
+				stack++;
+				dAssert(stack < D_SCENE_MAX_STACK_DEPTH);
+			}
+		}
+	}
+	return count;
+}
+
 ndSceneTreeNode* ndScene::InsertNode(ndSceneNode* const root, ndSceneNode* const node)
 {
 	dVector p0;
@@ -624,7 +688,7 @@ void ndScene::ImproveNodeFitness(ndSceneTreeNode* const node, ndSceneNode** cons
 			RotateLeft(node, root);
 		}
 	}
-	dAssert(!m_rootNode->m_parent);
+	dAssert(!(*root)->m_parent);
 }
 
 dFloat64 ndScene::ReduceEntropy(ndFitnessList& fitness, ndSceneNode** const root)
@@ -650,23 +714,28 @@ dFloat64 ndScene::ReduceEntropy(ndFitnessList& fitness, ndSceneNode** const root
 	return fitness.m_currentCost;
 }
 
-dInt32 ndScene::CompareNodes(const ndSceneNode* const nodeA, const ndSceneNode* const nodeB, void* const)
+void ndScene::UpdateFitness(ndFitnessList& fitness, dFloat64& oldEntropy, ndSceneNode** const root)
 {
-	dFloat32 areaA = nodeA->m_surfaceArea;
-	dFloat32 areaB = nodeB->m_surfaceArea;
-	if (areaA < areaB) 
-	{
-		return 1;
-	}
-	if (areaA > areaB) 
+	// sort the leafs by decreasing surface area, non negative floats sort as integers
+	class ndNodeAreaKey
 	{
-		return -1;
-	}
-	return 0;
-}
+		public:
+		ndNodeAreaKey(void* const)
+		{
+		}
+
+		dUnsigned64 GetKey(const ndSceneNode* const node) const
+		{
+			union
+			{
+				float m_area;
+				dUnsigned32 m_key;
+			};
+			m_area = float (node->m_surfaceArea);
+			return ~m_key;
+		}
+	};
 
-void ndScene::UpdateFitness(ndFitnessList& fitness, dFloat64& oldEntropy, ndSceneNode** const root)
-{
 	if (*root) 
 	{
 		D_TRACKTIME();
@@ -718,7 +787,7 @@ void ndScene::UpdateFitness(ndFitnessList& fitness, dFloat64& oldEntropy, ndScen
 				}
 				
 				ndFitnessList::dListNode* nodePtr = fitness.GetFirst();
-				dSortIndirect(leafArray, leafNodesCount, CompareNodes);
+				dParallelRadixSort<ndSceneNode*, ndNodeAreaKey>(this, leafArray, &leafArray[leafNodesCount], leafNodesCount);
 				
 				*root = BuildTopDownBig(leafArray, 0, leafNodesCount - 1, &nodePtr);
 				dAssert(!(*root)->m_parent);
@@ -824,6 +893,14 @@ void ndScene::UpdateAabb(dInt32 threadIndex, ndBodyKinematic* const body)
 {
 	ndSceneBodyNode* const node = body->GetSceneBodyNode();
 	body->UpdateCollisionMatrix();
+	if (body->m_continueCollisionMode)
+	{
+		// the aabb of a continuous collision body covers the path of the
+		// body in this step, so that the pairs along that path are found.
+		const dVector step(body->m_veloc.Scale(m_timestep) & dVector::m_triplexMask);
+		body->m_minAABB = body->m_minAABB.GetMin(body->m_minAABB + step);
+		body->m_maxAABB = body->m_maxAABB.GetMax(body->m_maxAABB + step);
+	}
 		
 	dAssert(!node->GetLeft());
 	dAssert(!node->GetRight());
@@ -840,36 +917,39 @@ void ndScene::UpdateAabb(dInt32 threadIndex, ndBodyKinematic* const body)
 	if (!dBoxInclusionTest(body->m_minAABB, body->m_maxAABB, node->m_minBox, node->m_maxBox)) 
 	{
 		dAssert(!node->GetAsSceneAggregate());
-		node->SetAABB(body->m_minAABB, body->m_maxAABB);
-
-		if (!m_rootNode->GetAsSceneBodyNode()) 
+		// the node box is stretched along the body motion of the next few steps, 
+		// but no more than the body size, so that slow bodies stay inside their 
+		// node box for several updates, and resting bodies get a tight box.
+		const dVector size(body->m_maxAABB - body->m_minAABB);
+		const dVector step((body->m_veloc.Scale(m_timestep * D_SCENE_AABB_PREDICTION_STEPS) & dVector::m_triplexMask).GetMax(size * dVector::m_negOne).GetMin(size));
+		node->SetAABB(body->m_minAABB.GetMin(body->m_minAABB + step), body->m_maxAABB.GetMax(body->m_maxAABB + step));
+		m_threadStatistics[threadIndex].m_leafRefits++;
+
+		// the scene can have more than one tree, so walk up to the root of the node tree.
+		for (ndSceneNode* parent = node->m_parent; parent; parent = parent->m_parent) 
 		{
-			const ndSceneNode* const root = (m_rootNode->GetLeft() && m_rootNode->GetRight()) ? nullptr : m_rootNode;
-			dAssert(root == nullptr);
-			for (ndSceneNode* parent = node->m_parent; parent != root; parent = parent->m_parent) 
+			dScopeSpinLock lock(parent->m_lock);
+			if (!parent->GetAsSceneAggregate()) 
 			{
-				dScopeSpinLock lock(parent->m_lock);
-				if (!parent->GetAsSceneAggregate()) 
+				dVector minBox;
+				dVector maxBox;
+				dFloat32 area = CalculateSurfaceArea(parent->GetLeft(), parent->GetRight(), minBox, maxBox);
+				if (dBoxInclusionTest(minBox, maxBox, parent->m_minBox, parent->m_maxBox)) 
 				{
-					dVector minBox;
-					dVector maxBox;
-					dFloat32 area = CalculateSurfaceArea(parent->GetLeft(), parent->GetRight(), minBox, maxBox);
-					if (dBoxInclusionTest(minBox, maxBox, parent->m_minBox, parent->m_maxBox)) 
-					{
-						break;
-					}
-					parent->m_minBox = minBox;
-					parent->m_maxBox = maxBox;
-					parent->m_surfaceArea = area;
-				}
-				else 
-				{
-					dAssert(0);
-					//ndSceneAggregate* const aggregate = parent->GetAsSceneAggregate();
-					//aggregate->m_minBox = aggregate->m_root->m_minBox;
-					//aggregate->m_maxBox = aggregate->m_root->m_maxBox;
-					//aggregate->m_surfaceArea = aggregate->m_root->m_surfaceArea;
+					break;
 				}
+				parent->m_minBox = minBox;
+				parent->m_maxBox = maxBox;
+				parent->m_surfaceArea = area;
+				m_threadStatistics[threadIndex].m_nodeRefits++;
+			}
+			else 
+			{
+				dAssert(0);
+				//ndSceneAggregate* const aggregate = parent->GetAsSceneAggregate();
+				//aggregate->m_minBox = aggregate->m_root->m_minBox;
+				//aggregate->m_maxBox = aggregate->m_root->m_maxBox;
+				//aggregate->m_surfaceArea = aggregate->m_root->m_surfaceArea;
 			}
 		}
 	}
@@ -935,22 +1015,20 @@ void ndScene::CalculateJointContacts(dInt32 threadIndex, ndContact* const contac
 		ndContactSolver contactSolver(contact);
 		contactSolver.m_separatingVector = contact->m_separatingVector;
 		contactSolver.m_timestep = m_timestep;
-		contactSolver.m_ccdMode = 0;
+		contactSolver.m_ccdMode = body0->m_continueCollisionMode | body1->m_continueCollisionMode;
 		contactSolver.m_contactBuffer = contactBuffer;
 		contactSolver.m_intersectionTestOnly = body0->m_contactTestOnly | body1->m_contactTestOnly;
+		contactSolver.m_maxContactsPerPair = m_maxContactsPerPair;
 		
 		dInt32 count = contactSolver.CalculatePairContacts(threadIndex);
 		if (count)
 		{
 			if (contactSolver.m_intersectionTestOnly)
 			{
-				if (!contact->m_isIntersetionTestOnly)
+				if (!contact->m_isIntersetionTestOnly && body1->GetAsBodyTriggerVolume())
 				{
-					ndBodyTriggerVolume* const trigger = body1->GetAsBodyTriggerVolume();
-					if (trigger)
-					{
-						trigger->OnTriggerEnter(body0, m_timestep);
-					}
+					// trigger notifications are called after all contacts are calculated
+					contact->m_triggerEnter = 1;
 				}
 				contact->m_isIntersetionTestOnly = 1;
 			}
@@ -960,16 +1038,17 @@ void ndScene::CalculateJointContacts(dInt32 threadIndex, ndContact* const contac
 				ProcessContacts(threadIndex, count, &contactSolver);
 				dAssert(contact->m_maxDOF);
 				contact->m_isIntersetionTestOnly = 0;
+				m_threadStatistics[threadIndex].m_candidatePoints += contactSolver.m_candidateCount;
+				m_threadStatistics[threadIndex].m_contactPoints += count;
 			}
 		}
 		else
 		{
 			if (contact->m_isIntersetionTestOnly)
 			{
-				ndBodyTriggerVolume* const trigger = body1->GetAsBodyTriggerVolume();
-				if (trigger)
+				if (body1->GetAsBodyTriggerVolume())
 				{
-					body1->GetAsBodyTriggerVolume()->OnTriggerExit(body0, m_timestep);
+					contact->m_triggerExit = 1;
 				}
 				contact->m_isIntersetionTestOnly = 0;
 			}
@@ -1201,7 +1280,7 @@ void ndScene::ProcessContacts(dInt32 threadIndex, dInt32 contactCount, ndContact
 	m_contactNotifyCallback->OnContactCallback(threadIndex, contact, m_timestep);
 }
 
-void ndScene::SubmitPairs(ndSceneNode* const leafNode, ndSceneNode* const node)
+void ndScene::SubmitPairs(dInt32 threadIndex, ndSceneNode* const leafNode, ndSceneNode* const node)
 {
 	ndSceneNode* pool[D_SCENE_MAX_STACK_DEPTH];
 	pool[0] = node;
@@ -1232,7 +1311,7 @@ void ndScene::SubmitPairs(ndSceneNode* const leafNode, ndSceneNode* const node)
 							const bool test = TestOverlaping(body0, body1);
 							if (test)
 							{
-								AddPair(body0, body1);
+								AddPair(threadIndex, body0, body1);
 							}
 						}
 					}
@@ -1379,10 +1458,12 @@ ndContact* ndScene::FindContactJoint(ndBodyKinematic* const body0, ndBodyKinemat
 	return contact;
 }
 
-void ndScene::AddPair(ndBodyKinematic* const body0, ndBodyKinematic* const body1)
+void ndScene::AddPair(dInt32 threadIndex, ndBodyKinematic* const body0, ndBodyKinematic* const body1)
 {
-	dScopeSpinLock lock(m_contactLock);
-	ndContact* const contact = FindContactJoint(body0, body1);
+	// contacts are not created or destroyed while the pairs are found, so the 
+	// contact and joint lists can be read without a lock. New pairs go to the
+	// thread buffer and the contacts are created after all threads are done.
+	const ndContact* const contact = FindContactJoint(body0, body1);
 	if (!contact) 
 	{
 		const ndJointBilateralConstraint* const bilateral = FindBilateralJoint(body0, body1);
@@ -1430,7 +1511,67 @@ void ndScene::AddPair(ndBodyKinematic* const body0, ndBodyKinematic* const body1
 			//	}
 			//}
 
-			m_contactList.CreateContact(body0, body1);
+			const dUnsigned32 id0 = body0->GetId();
+			const dUnsigned32 id1 = body1->GetId();
+			const dUnsigned64 key = (id0 < id1) ? ((dUnsigned64(id0) << 32) | id1) : ((dUnsigned64(id1) << 32) | id0);
+			m_pairBuffers[threadIndex].PushBack(ndContactPair(body0, body1, key));
+		}
+	}
+}
+
+void ndScene::CreateNewContacts()
+{
+	D_TRACKTIME();
+	class ndContactPairKey
+	{
+		public:
+		ndContactPairKey(void* const)
+		{
+		}
+
+		dUnsigned64 GetKey(const ndContactPair& pair) const
+		{
+			return pair.m_key;
+		}
+	};
+
+	const dInt32 threadCount = GetThreadCount();
+	dInt32 pairCount = 0;
+	for (dInt32 i = 0; i < threadCount; i++)
+	{
+		pairCount += m_pairBuffers[i].GetCount();
+	}
+	m_statistics.m_newContacts = 0;
+	if (!pairCount)
+	{
+		return;
+	}
+
+	m_newPairs.SetCount(pairCount);
+	m_newPairsScratchBuffer.SetCount(pairCount);
+	dInt32 index = 0;
+	for (dInt32 i = 0; i < threadCount; i++)
+	{
+		const dArray<ndContactPair>& buffer = m_pairBuffers[i];
+		if (buffer.GetCount())
+		{
+			memcpy(&m_newPairs[index], &buffer[0], buffer.GetCount() * sizeof(ndContactPair));
+			index += buffer.GetCount();
+		}
+	}
+
+	// when both bodies are awake the same pair can be found from each of them,
+	// the sort is stable so the first one found is the one that is kept. 
+	dParallelRadixSort<ndContactPair, ndContactPairKey>(this, &m_newPairs[0], &m_newPairsScratchBuffer[0], pairCount);
+	dUnsigned64 lastKey = m_newPairs[0].m_key + 1;
+	for (dInt32 i = 0; i < pairCount; i++)
+	{
+		const ndContactPair& pair = m_newPairs[i];
+		if (pair.m_key != lastKey)
+		{
+			lastKey = pair.m_key;
+			m_contactList.CreateContact(pair.m_body0, pair.m_body1);
+			m_statistics.m_newContacts++;
 		}
 	}
 }
@@ -1543,7 +1684,21 @@ void ndScene::CalculateContacts()
 		}
 	};
 
+	for (dInt32 i = 0; i < GetThreadCount(); i++)
+	{
+		m_threadStatistics[i].m_candidatePoints = 0;
+		m_threadStatistics[i].m_contactPoints = 0;
+	}
 	SubmitJobs<ndCalculateContacts>();
+
+	m_statistics.m_candidatePoints = 0;
+	m_statistics.m_contactPoints = 0;
+	for (dInt32 i = 0; i < GetThreadCount(); i++)
+	{
+		m_statistics.m_candidatePoints += m_threadStatistics[i].m_candidatePoints;
+		m_statistics.m_contactPoints += m_threadStatistics[i].m_contactPoints;
+	}
+	ProcessTriggers();
 }
 
 void ndScene::UpdateAabb()
@@ -1581,12 +1736,21 @@ void ndScene::UpdateAabb()
 
 	dUnsigned32 sleepBodiesLane[D_MAX_THREADS_COUNT];
 	memset(sleepBodiesLane, 0, sizeof(sleepBodiesLane));
+	for (dInt32 i = 0; i < GetThreadCount(); i++)
+	{
+		m_threadStatistics[i].m_leafRefits = 0;
+		m_threadStatistics[i].m_nodeRefits = 0;
+	}
 	SubmitJobs<ndUpdateAabbJob>(sleepBodiesLane);
 
 	m_sleepBodies = 0;
+	m_statistics.m_leafRefits = 0;
+	m_statistics.m_nodeRefits = 0;
 	for (dInt32 i = 0; i < GetThreadCount(); i++)
 	{
 		m_sleepBodies += sleepBodiesLane[i];
+		m_statistics.m_leafRefits += m_threadStatistics[i].m_leafRefits;
+		m_statistics.m_nodeRefits += m_threadStatistics[i].m_nodeRefits;
 	}
 }
 
@@ -1641,6 +1805,11 @@ void ndScene::FindCollidingPairs()
 		}
 	};
 
+	for (dInt32 i = 0; i < GetThreadCount(); i++)
+	{
+		m_pairBuffers[i].SetCount(0);
+	}
+
 	m_fullScan = (3 * m_sleepBodies) < (2 * dUnsigned32(m_activeBodyArray.GetCount()));
 	if (m_fullScan)
 	{
@@ -1650,11 +1819,20 @@ void ndScene::FindCollidingPairs()
 	{
 		SubmitJobs<ndFindCollidindPairsTwoWays>();
 	}
+
+	CreateNewContacts();
 }
 
 void ndScene::UpdateTransform()
 {
 	D_TRACKTIME();
+	class ndContext
+	{
+		public:
+		dArray<ndTransformEntry>* m_buffers[D_MAX_THREADS_COUNT];
+		dInt32 m_offset[D_MAX_THREADS_COUNT];
+	};
+
 	class ndTransformUpdate : public ndBaseJob
 	{
 		public:
@@ -1677,7 +1855,92 @@ void ndScene::UpdateTransform()
 		}
 	};
 
-	SubmitJobs<ndTransformUpdate>();
+	// the bodies that moved are written in one pass, without calling the notifications.
+	// thread zero writes to the back buffer, the other threads to their own buffers.
+	class ndExportTransforms : public ndBaseJob
+	{
+		public:
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			ndContext* const context = (ndContext*)m_context;
+			const dArray<ndBodyKinematic*>& bodyArray = m_owner->GetActiveBodyArray();
+			const dInt32 threadIndex = GetThredId();
+			const dInt32 threadCount = m_owner->GetThreadCount();
+			const dInt32 bodyCount = bodyArray.GetCount() - 1;
+			const dInt32 step = bodyCount / threadCount;
+			const dInt32 start = threadIndex * step;
+			const dInt32 count = ((threadIndex + 1) < threadCount) ? step : bodyCount - start;
+
+			dArray<ndTransformEntry>& buffer = *context->m_buffers[threadIndex];
+			buffer.SetCount(count);
+			dInt32 movedCount = 0;
+			for (dInt32 i = 0; i < count; i++)
+			{
+				ndBodyKinematic* const body = bodyArray[start + i];
+				if (body->m_transformIsDirty)
+				{
+					body->m_transformIsDirty = 0;
+					ndTransformEntry& entry = buffer[movedCount];
+					entry.m_matrix = body->GetMatrix();
+					entry.m_body = body;
+					entry.m_bodyId = body->GetId();
+					movedCount++;
+				}
+			}
+			buffer.SetCount(movedCount);
+		}
+	};
+
+	class ndAppendTransforms : public ndBaseJob
+	{
+		public:
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			ndContext* const context = (ndContext*)m_context;
+			const dInt32 threadIndex = GetThredId();
+			if (threadIndex)
+			{
+				const dArray<ndTransformEntry>& src = *context->m_buffers[threadIndex];
+				ndTransformEntry* const dst = &(*context->m_buffers[0])[context->m_offset[threadIndex]];
+				for (dInt32 i = 0; i < src.GetCount(); i++)
+				{
+					dst[i] = src[i];
+				}
+			}
+		}
+	};
+
+	if (!m_exportTransforms)
+	{
+		SubmitJobs<ndTransformUpdate>();
+		return;
+	}
+
+	ndContext context;
+	const dInt32 threadCount = GetThreadCount();
+	context.m_buffers[0] = &m_transformBuffer[m_transformBufferIndex ^ 1];
+	for (dInt32 i = 1; i < threadCount; i++)
+	{
+		context.m_buffers[i] = &m_threadTransformBuffers[i];
+	}
+	SubmitJobs<ndExportTransforms>(&context);
+
+	dInt32 movedCount = 0;
+	for (dInt32 i = 0; i < threadCount; i++)
+	{
+		context.m_offset[i] = movedCount;
+		movedCount += context.m_buffers[i]->GetCount();
+	}
+	if (movedCount > context.m_buffers[0]->GetCount())
+	{
+		context.m_buffers[0]->SetCount(movedCount);
+		SubmitJobs<ndAppendTransforms>(&context);
+	}
+
+	// the back buffer becomes the front one
+	m_transformBufferIndex = m_transformBufferIndex ^ 1;
 }
 
 void ndScene::CalculateContacts(dInt32 threadIndex, ndContact* const contact)
@@ -1693,7 +1956,9 @@ void ndScene::CalculateContacts(dInt32 threadIndex, ndContact* const contact)
 	if (!(body0->m_equilibrium & body1->m_equilibrium))
 	{
 		dUnsigned32 active = contact->m_active;
-		if (ValidateContactCache(contact, deltaTime))
+		// continuous collision contacts can be speculative, so they are never reused.
+		const bool continueCollision = (body0->m_continueCollisionMode | body1->m_continueCollisionMode) ? true : false;
+		if (!continueCollision && ValidateContactCache(contact, deltaTime))
 		{
 			contact->m_sceneLru = m_lru;
 			contact->m_timeOfImpact = dFloat32(1.0e10f);
@@ -1780,42 +2045,206 @@ void ndScene::CalculateContacts(dInt32 threadIndex, ndContact* const contact)
 void ndScene::BuildContactArray()
 {
 	D_TRACKTIME();
-	dInt32 count = 0;
-	m_activeConstraintArray.SetCount(m_contactList.GetCount());
-	for (ndContactList::dListNode* node = m_contactList.GetFirst(); node; node = node->GetNext())
+	class ndBuildContactArray : public ndBaseJob
 	{
-		ndContact* const contact = &node->GetInfo();
-		dAssert(contact->m_isAttached);
-		m_activeConstraintArray[count] = contact;
-		count++;
+		public:
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			const ndContactList& contactList = m_owner->m_contactList;
+			ndConstraintArray& activeConstraints = m_owner->m_activeConstraintArray;
+			const dInt32 threadIndex = GetThredId();
+			const dInt32 threadCount = m_owner->GetThreadCount();
+			const dInt32 contactCount = contactList.GetCount();
+			const dInt32 step = contactCount / threadCount;
+			const dInt32 start = threadIndex * step;
+			const dInt32 count = ((threadIndex + 1) < threadCount) ? step : contactCount - start;
+
+			dAtomic<dInt32>& triggerCount = *((dAtomic<dInt32>*)m_context);
+			for (dInt32 i = 0; i < count; i++)
+			{
+				ndContact* const contact = contactList.GetContact(start + i);
+				dAssert(contact->m_isAttached);
+				activeConstraints[start + i] = contact;
+				if (contact->GetBody1()->GetAsBodyTriggerVolume())
+				{
+					const dInt32 index = triggerCount.fetch_add(1);
+					m_owner->m_triggerContacts[index] = contact;
+				}
+			}
+		}
+	};
+
+	const dInt32 contactCount = m_contactList.GetCount();
+	dAtomic<dInt32> triggerCount(0);
+	m_activeConstraintArray.SetCount(contactCount);
+	m_triggerContacts.SetCount(contactCount);
+	SubmitJobs<ndBuildContactArray>(&triggerCount);
+
+	// trigger contacts are collected out of order, sort them so that
+	// the notifications are called in the same order every update.
+	m_triggerContacts.SetCount(triggerCount.load());
+	if (m_triggerContacts.GetCount() > 1)
+	{
+		dSort(&m_triggerContacts[0], m_triggerContacts.GetCount(), CompareTriggerContacts);
+	}
+
+	// OnTrigger is called before the contacts are calculated, as it always was
+	for (dInt32 i = 0; i < m_triggerContacts.GetCount(); i++)
+	{
+		ndContact* const contact = m_triggerContacts[i];
 		ndBodyTriggerVolume* const trigger = contact->GetBody1()->GetAsBodyTriggerVolume();
-		if (trigger)
+		trigger->OnTrigger(contact->GetBody0(), m_timestep);
+	}
+}
+
+dInt32 ndScene::CompareTriggerContacts(ndContact* const* const contactA, ndContact* const* const contactB, void* const)
+{
+	const dInt32 indexA = (*contactA)->m_contactIndex;
+	const dInt32 indexB = (*contactB)->m_contactIndex;
+	if (indexA < indexB)
+	{
+		return -1;
+	}
+	else if (indexA > indexB)
+	{
+		return 1;
+	}
+	return 0;
+}
+
+void ndScene::ProcessTriggers()
+{
+	D_TRACKTIME();
+	for (dInt32 i = 0; i < m_triggerContacts.GetCount(); i++)
+	{
+		ndContact* const contact = m_triggerContacts[i];
+		ndBodyKinematic* const body0 = contact->GetBody0();
+		ndBodyTriggerVolume* const trigger = contact->GetBody1()->GetAsBodyTriggerVolume();
+		dAssert(trigger);
+		if (contact->m_triggerEnter)
+		{
+			trigger->OnTriggerEnter(body0, m_timestep);
+		}
+		if (contact->m_triggerExit)
 		{
-			trigger->OnTrigger(contact->GetBody0(), m_timestep);
+			trigger->OnTriggerExit(body0, m_timestep);
 		}
+		contact->m_triggerEnter = 0;
+		contact->m_triggerExit = 0;
 	}
-	m_activeConstraintArray.SetCount(count);
 }
 
 void ndScene::DeleteDeadContact()
 {
 	D_TRACKTIME();
-	dInt32 activeCount = m_activeConstraintArray.GetCount();
-	for (dInt32 i = activeCount - 1; i >= 0; i--)
+	class ndCompactContext
+	{
+		public:
+		dInt32 m_activeStart[D_MAX_THREADS_COUNT];
+		dInt32 m_deadStart[D_MAX_THREADS_COUNT];
+	};
+
+	class ndCountContacts : public ndBaseJob
 	{
-		ndContact* const contact = m_activeConstraintArray[i]->GetAsContact();
-		dAssert(contact);
-		if (contact->m_isDead)
+		public:
+		virtual void Execute()
 		{
-			activeCount--;
-			m_contactList.DeleteContact(contact);
-			m_activeConstraintArray[i] = m_activeConstraintArray[activeCount];
+			D_TRACKTIME();
+			const ndConstraintArray& activeConstraints = m_owner->m_activeConstraintArray;
+			const dInt32 threadIndex = GetThredId();
+			const dInt32 threadCount = m_owner->GetThreadCount();
+			const dInt32 contactCount = activeConstraints.GetCount();
+			const dInt32 step = contactCount / threadCount;
+			const dInt32 start = threadIndex * step;
+			const dInt32 count = ((threadIndex + 1) < threadCount) ? step : contactCount - start;
+
+			dInt32 activeCount = 0;
+			dInt32 deadCount = 0;
+			for (dInt32 i = 0; i < count; i++)
+			{
+				const ndContact* const contact = activeConstraints[start + i]->GetAsContact();
+				dAssert(contact);
+				if (contact->m_isDead)
+				{
+					deadCount++;
+				}
+				else if (contact->m_active && contact->m_maxDOF)
+				{
+					activeCount++;
+				}
+			}
+			ndCompactContext* const context = (ndCompactContext*)m_context;
+			context->m_activeStart[threadIndex] = activeCount;
+			context->m_deadStart[threadIndex] = deadCount;
 		}
-		else if (!contact->m_active || !contact->m_maxDOF)
+	};
+
+	class ndCompactContacts : public ndBaseJob
+	{
+		public:
+		virtual void Execute()
 		{
-			activeCount--;
-			m_activeConstraintArray[i] = m_activeConstraintArray[activeCount];
+			D_TRACKTIME();
+			const ndConstraintArray& activeConstraints = m_owner->m_activeConstraintArray;
+			ndConstraintArray& compactConstraints = m_owner->m_scratchConstraintArray;
+			const dInt32 threadIndex = GetThredId();
+			const dInt32 threadCount = m_owner->GetThreadCount();
+			const dInt32 contactCount = activeConstraints.GetCount();
+			const dInt32 step = contactCount / threadCount;
+			const dInt32 start = threadIndex * step;
+			const dInt32 count = ((threadIndex + 1) < threadCount) ? step : contactCount - start;
+
+			const ndCompactContext* const context = (ndCompactContext*)m_context;
+			dInt32 activeIndex = context->m_activeStart[threadIndex];
+			dInt32 deadIndex = context->m_deadStart[threadIndex];
+			for (dInt32 i = 0; i < count; i++)
+			{
+				ndContact* const contact = activeConstraints[start + i]->GetAsContact();
+				if (contact->m_isDead)
+				{
+					compactConstraints[deadIndex] = contact;
+					deadIndex++;
+				}
+				else if (contact->m_active && contact->m_maxDOF)
+				{
+					compactConstraints[activeIndex] = contact;
+					activeIndex++;
+				}
+			}
 		}
+	};
+
+	// active contacts are compacted in order to the front of the
+	// scratch array, and the dead contacts are placed after them.
+	ndCompactContext context;
+	SubmitJobs<ndCountContacts>(&context);
+
+	dInt32 activeCount = 0;
+	dInt32 deadCount = 0;
+	const dInt32 threadCount = GetThreadCount();
+	for (dInt32 i = 0; i < threadCount; i++)
+	{
+		const dInt32 threadActiveCount = context.m_activeStart[i];
+		context.m_activeStart[i] = activeCount;
+		activeCount += threadActiveCount;
+	}
+	for (dInt32 i = 0; i < threadCount; i++)
+	{
+		const dInt32 threadDeadCount = context.m_deadStart[i];
+		context.m_deadStart[i] = activeCount + deadCount;
+		deadCount += threadDeadCount;
+	}
+
+	m_scratchConstraintArray.SetCount(activeCount + deadCount);
+	SubmitJobs<ndCompactContacts>(&context);
+	m_activeConstraintArray.Swap(m_scratchConstraintArray);
+
+	for (dInt32 i = 0; i < deadCount; i++)
+	{
+		ndContact* const contact = m_activeConstraintArray[activeCount + i]->GetAsContact();
+		m_contactList.DeleteContact(contact);
 	}
 	m_activeConstraintArray.SetCount(activeCount);
+	m_statistics.m_deadContacts = deadCount;
 }
\ No newline at end of file
@@ -29,6 +29,7 @@
 
 #define D_SCENE_MAX_STACK_DEPTH	256
 #define D_PRUNE_CONTACT_TOLERANCE		dFloat32 (5.0e-2f)
+#define D_SCENE_AABB_PREDICTION_STEPS	dFloat32 (2.0f)
 
 class ndWorld;
 class ndScene;
@@ -67,8 +68,66 @@ class ndScene
 		void* m_context;
 	};
 
+	// the matrix of a body that moved during the last update
+	D_MSV_NEWTON_ALIGN_32
+	class ndTransformEntry
+	{
+		public:
+		dMatrix m_matrix;
+		ndBodyKinematic* m_body;
+		dUnsigned32 m_bodyId;
+	} D_GCC_NEWTON_ALIGN_32;
+
+	// collision counts of the last update. m_leafRefits are the bodies that
+	// moved out of their node box, and m_nodeRefits the tree nodes that grew
+	// because of them. m_newContacts and m_deadContacts are the contacts 
+	// created by the pair search and the ones deleted at the end of the update.
+	// m_candidatePoints are the contact points generated by the narrow phase, 
+	// and m_contactPoints the ones left after they are pruned to the pair budget.
+	class ndStatistics
+	{
+		public:
+		ndStatistics()
+			:m_leafRefits(0)
+			,m_nodeRefits(0)
+			,m_newContacts(0)
+			,m_deadContacts(0)
+			,m_candidatePoints(0)
+			,m_contactPoints(0)
+		{
+		}
+
+		dInt32 m_leafRefits;
+		dInt32 m_nodeRefits;
+		dInt32 m_newContacts;
+		dInt32 m_deadContacts;
+		dInt32 m_candidatePoints;
+		dInt32 m_contactPoints;
+	};
+
 	protected:
 	class ndSpliteInfo;
+
+	// a pair of overlapping bodies that do not have a contact yet
+	class ndContactPair
+	{
+		public:
+		ndContactPair()
+		{
+		}
+
+		ndContactPair(ndBodyKinematic* const body0, ndBodyKinematic* const body1, dUnsigned64 key)
+			:m_body0(body0)
+			,m_body1(body1)
+			,m_key(key)
+		{
+		}
+
+		ndBodyKinematic* m_body0;
+		ndBodyKinematic* m_body1;
+		dUnsigned64 m_key;
+	};
+
 	class ndFitnessList: public dList <ndSceneTreeNode*, dContainersFreeListAlloc<ndSceneTreeNode*>>
 	{
 		public:
@@ -104,6 +163,21 @@ class ndScene
 	dFloat32 GetTimestep() const;
 	void SetTimestep(dFloat32 timestep);
 
+	// when enabled, the transform update writes the bodies that moved to a contiguous
+	// buffer instead of calling OnTranform for each of them. The buffers are double buffered,
+	// the one returned by GetTransformBuffer is valid after Sync and until the end of the next update.
+	bool GetTransformExport() const;
+	void SetTransformExport(bool state);
+	const dArray<ndTransformEntry>& GetTransformBuffer() const;
+
+	// only valid while the world is synchronized.
+	const ndStatistics& GetStatistics() const;
+
+	// the contact points of a pair are pruned to at most this many points, 
+	// keeping the ones that span the largest area.
+	dInt32 GetMaxContactsPerPair() const;
+	D_COLLISION_API void SetMaxContactsPerPair(dInt32 count);
+
 	D_COLLISION_API virtual bool AddBody(ndBodyKinematic* const body);
 	D_COLLISION_API virtual bool RemoveBody(ndBodyKinematic* const body);
 
@@ -113,6 +187,10 @@ class ndScene
 	D_COLLISION_API ndContactNotify* GetContactNotify() const;
 	D_COLLISION_API void SetContactNotify(ndContactNotify* const notify);
 
+	// collects the bodies whose aabb overlaps the box, and returns how many were found.
+	// it only reads the scene tree, so it can be called from the jobs of the update.
+	D_COLLISION_API virtual dInt32 BodiesInAabb(const dVector& minBox, const dVector& maxBox, ndBodyKinematic** const bodyArray, dInt32 maxCount) const;
+
 	virtual void DebugScene(ndSceneTreeNotiFy* const notify) = 0;
 
 	private:
@@ -132,7 +210,6 @@ class ndScene
 	void RotateRight(ndSceneTreeNode* const node, ndSceneNode** const root);
 	dFloat64 ReduceEntropy(ndFitnessList& fitness, ndSceneNode** const root);
 	void ImproveNodeFitness(ndSceneTreeNode* const node, ndSceneNode** const root);
-	static dInt32 CompareNodes(const ndSceneNode* const nodeA, const ndSceneNode* const nodeB, void* const);
 	ndSceneNode* BuildTopDown(ndSceneNode** const leafArray, dInt32 firstBox, dInt32 lastBox, ndFitnessList::dListNode** const nextNode);
 	ndSceneNode* BuildTopDownBig(ndSceneNode** const leafArray, dInt32 firstBox, dInt32 lastBox, ndFitnessList::dListNode** const nextNode);
 
@@ -148,22 +225,29 @@ class ndScene
 	D_COLLISION_API void UpdateTransform();
 	D_COLLISION_API void CalculateContacts();
 	D_COLLISION_API void DeleteDeadContact();
-	D_COLLISION_API void FindCollidingPairs();
+	D_COLLISION_API virtual void FindCollidingPairs();
 
 	D_COLLISION_API virtual void ThreadFunction();
 	virtual void BalanceScene() = 0;
 
 	D_COLLISION_API ndSceneTreeNode* InsertNode(ndSceneNode* const root, ndSceneNode* const node);
+	D_COLLISION_API dInt32 BodiesInAabb(const ndSceneNode* const root, const dVector& minBox, const dVector& maxBox, ndBodyKinematic** const bodyArray, dInt32 maxCount) const;
 	void UpdateFitness(ndFitnessList& fitness, dFloat64& oldEntropy, ndSceneNode** const root);
 
 	ndContact* FindContactJoint(ndBodyKinematic* const body0, ndBodyKinematic* const body1) const;
 	ndJointBilateralConstraint* FindBilateralJoint(ndBodyKinematic* const body0, ndBodyKinematic* const body1) const;
 
-	void AddPair(ndBodyKinematic* const body0, ndBodyKinematic* const body1);
+	void CreateNewContacts();
+	void AddPair(dInt32 threadIndex, ndBodyKinematic* const body0, ndBodyKinematic* const body1);
 	bool TestOverlaping(const ndBodyKinematic* const body0, const ndBodyKinematic* const body1) const;
-	void SubmitPairs(ndSceneNode* const leaftNode, ndSceneNode* const node);
+	void SubmitPairs(dInt32 threadIndex, ndSceneNode* const leaftNode, ndSceneNode* const node);
 
+	// OnTrigger is called from BuildContactArray, before the contacts are calculated. 
+	// OnTriggerEnter and OnTriggerExit are called from ProcessTriggers once all contacts 
+	// are calculated, serially and in contact order instead of from the contact jobs.
 	D_COLLISION_API void BuildContactArray();
+	void ProcessTriggers();
+	static dInt32 CompareTriggerContacts(ndContact* const* const contactA, ndContact* const* const contactB, void* const context);
 	D_COLLISION_API virtual dFloat32 RayCast(ndRayCastNotify& callback, const dVector& p0, const dVector& p1) const = 0;
 	dFloat32 RayCast(ndRayCastNotify& callback, const ndSceneNode** stackPool, dFloat32* const distance, dInt32 stack, const dFastRayTest& ray) const;
 	
@@ -171,6 +255,13 @@ class ndScene
 	ndContactList m_contactList;
 	dArray<ndBodyKinematic*> m_activeBodyArray;
 	ndConstraintArray m_activeConstraintArray;
+	ndConstraintArray m_scratchConstraintArray;
+	dArray<ndContact*> m_triggerContacts;
+	dArray<ndTransformEntry> m_transformBuffer[2];
+	dArray<ndTransformEntry> m_threadTransformBuffers[D_MAX_THREADS_COUNT];
+	dArray<ndContactPair> m_pairBuffers[D_MAX_THREADS_COUNT];
+	dArray<ndContactPair> m_newPairs;
+	dArray<ndContactPair> m_newPairsScratchBuffer;
 	dSpinLock m_contactLock;
 	ndSceneNode* m_rootNode;
 	ndContactNotify* m_contactNotifyCallback;
@@ -178,6 +269,11 @@ class ndScene
 	dUnsigned32 m_sleepBodies;
 	//dUnsigned32 m_sleepBodiesLane[D_MAX_THREADS_COUNT];
 	dUnsigned32 m_lru;
+	dInt32 m_transformBufferIndex;
+	ndStatistics m_statistics;
+	ndStatistics m_threadStatistics[D_MAX_THREADS_COUNT];
+	dInt32 m_maxContactsPerPair;
+	bool m_exportTransforms;
 	bool m_fullScan;
 
 	static dVector m_velocTol;
@@ -252,6 +348,16 @@ void ndScene::SubmitJobs(void* const context)
 	ExecuteJobs(extJobPtr);
 }
 
+inline const ndScene::ndStatistics& ndScene::GetStatistics() const
+{
+	return m_statistics;
+}
+
+inline dInt32 ndScene::GetMaxContactsPerPair() const
+{
+	return m_maxContactsPerPair;
+}
+
 inline dFloat32 ndScene::GetTimestep() const
 {
 	return m_timestep;
@@ -262,6 +368,26 @@ inline void ndScene::SetTimestep(dFloat32 timestep)
 	m_timestep = timestep;
 }
 
+inline bool ndScene::GetTransformExport() const
+{
+	return m_exportTransforms;
+}
+
+inline void ndScene::SetTransformExport(bool state)
+{
+	m_exportTransforms = state;
+	if (!state)
+	{
+		m_transformBuffer[0].SetCount(0);
+		m_transformBuffer[1].SetCount(0);
+	}
+}
+
+inline const dArray<ndScene::ndTransformEntry>& ndScene::GetTransformBuffer() const
+{
+	return m_transformBuffer[m_transformBufferIndex];
+}
+
 D_INLINE dFloat32 ndScene::CalculateSurfaceArea(const ndSceneNode* const node0, const ndSceneNode* const node1, dVector& minBox, dVector& maxBox) const
 {
 	minBox = node0->m_minBox.GetMin(node1->m_minBox);
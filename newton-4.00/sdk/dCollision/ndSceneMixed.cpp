@@ -206,7 +206,6 @@ void ndSceneMixed::Cleanup()
 	ndContact::FlushFreeList();
 	ndBodyList::FlushFreeList();
 	ndFitnessList::FlushFreeList();
-	ndBodyKinematic::ReleaseMemory();
 	m_activeBodyArray.Resize(256);
 	m_activeConstraintArray.Resize(256);
 }
@@ -249,7 +248,7 @@ void ndSceneMixed::FindCollidinPairs(dInt32 threadIndex, ndBodyKinematic* const
 			ndSceneNode* const sibling = parent->m_right;
 			if (sibling != ptr)
 			{
-				SubmitPairs(leafNode, sibling);
+				SubmitPairs(threadIndex, leafNode, sibling);
 			}
 		}
 	}
@@ -263,11 +262,11 @@ void ndSceneMixed::FindCollidinPairs(dInt32 threadIndex, ndBodyKinematic* const
 			ndSceneNode* const rightSibling = parent->m_right;
 			if (rightSibling != ptr)
 			{
-				SubmitPairs(leafNode, rightSibling);
+				SubmitPairs(threadIndex, leafNode, rightSibling);
 			}
 			else 
 			{
-				SubmitPairs(leafNode, parent->m_left);
+				SubmitPairs(threadIndex, leafNode, parent->m_left);
 			}
 		}
 	}
@@ -0,0 +1,463 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dCoreStdafx.h"
+#include "ndCollisionStdafx.h"
+#include "ndBodyKinematic.h"
+#include "ndSceneNode.h"
+#include "ndSceneSegregated.h"
+
+ndSceneSegregated::ndSceneSegregated()
+	:ndScene()
+	,m_staticRoot(nullptr)
+	,m_dynamicRoot(nullptr)
+	,m_staticFitness()
+	,m_dynamicFitness()
+	,m_dynamicEntropy(dFloat32(0.0f))
+	,m_staticTreeIsDirty(false)
+{
+}
+
+ndSceneSegregated::~ndSceneSegregated()
+{
+	Cleanup();
+}
+
+void ndSceneSegregated::AddNode(ndSceneNode* const newNode, ndFitnessList& fitness, ndSceneNode** const root)
+{
+	if (*root)
+	{
+		ndSceneTreeNode* const node = InsertNode(*root, newNode);
+		fitness.AddNode(node);
+		if (!node->m_parent)
+		{
+			*root = node;
+		}
+	}
+	else
+	{
+		*root = newNode;
+	}
+}
+
+void ndSceneSegregated::RemoveNode(ndSceneNode* const node, ndFitnessList& fitness, ndSceneNode** const root)
+{
+	ndSceneTreeNode* const parent = node->m_parent ? node->m_parent->GetAsSceneTreeNode() : nullptr;
+	if (parent)
+	{
+		dAssert(!parent->GetAsSceneAggregate());
+		ndSceneNode* const sibling = (parent->m_left == node) ? parent->m_right : parent->m_left;
+		ndSceneTreeNode* const grandParent = parent->m_parent ? parent->m_parent->GetAsSceneTreeNode() : nullptr;
+		sibling->m_parent = grandParent;
+		if (grandParent)
+		{
+			if (grandParent->m_left == parent)
+			{
+				grandParent->m_left = sibling;
+			}
+			else
+			{
+				dAssert(grandParent->m_right == parent);
+				grandParent->m_right = sibling;
+			}
+		}
+		else
+		{
+			*root = sibling;
+		}
+
+		if (parent->m_fitnessNode)
+		{
+			fitness.RemoveNode(parent);
+		}
+		parent->m_left = nullptr;
+		parent->m_right = nullptr;
+		parent->m_parent = nullptr;
+		delete parent;
+	}
+	else
+	{
+		dAssert(*root == node);
+		*root = nullptr;
+	}
+	delete node;
+}
+
+bool ndSceneSegregated::AddBody(ndBodyKinematic* const body)
+{
+	if (ndScene::AddBody(body))
+	{
+		body->UpdateCollisionMatrix();
+		ndSceneBodyNode* const bodyNode = new ndSceneBodyNode(body);
+		if (body->m_invMass.m_w == dFloat32(0.0f))
+		{
+			body->m_staticSceneNode = 1;
+			AddNode(bodyNode, m_staticFitness, &m_staticRoot);
+			m_staticTreeIsDirty = true;
+		}
+		else
+		{
+			body->m_staticSceneNode = 0;
+			AddNode(bodyNode, m_dynamicFitness, &m_dynamicRoot);
+		}
+		return true;
+	}
+	return false;
+}
+
+bool ndSceneSegregated::RemoveBody(ndBodyKinematic* const body)
+{
+	ndSceneBodyNode* const node = body->GetSceneBodyNode();
+	if (node)
+	{
+		if (body->m_staticSceneNode)
+		{
+			RemoveNode(node, m_staticFitness, &m_staticRoot);
+			m_staticTreeIsDirty = true;
+		}
+		else
+		{
+			RemoveNode(node, m_dynamicFitness, &m_dynamicRoot);
+		}
+		body->m_staticSceneNode = 0;
+	}
+	return ndScene::RemoveBody(body);
+}
+
+void ndSceneSegregated::Cleanup()
+{
+	Sync();
+	m_contactList.DeleteAllContacts();
+	while (m_bodyList.GetFirst())
+	{
+		ndBodyKinematic* const body = m_bodyList.GetFirst()->GetInfo();
+		RemoveBody(body);
+		delete body;
+	}
+	dAssert(!m_staticRoot);
+	dAssert(!m_dynamicRoot);
+	ndContact::FlushFreeList();
+	ndBodyList::FlushFreeList();
+	ndFitnessList::FlushFreeList();
+	m_activeBodyArray.Resize(256);
+	m_activeConstraintArray.Resize(256);
+}
+
+void ndSceneSegregated::BalanceScene()
+{
+	D_TRACKTIME();
+	if (m_staticTreeIsDirty)
+	{
+		BuildStaticTree();
+	}
+	UpdateFitness(m_dynamicFitness, m_dynamicEntropy, &m_dynamicRoot);
+}
+
+void ndSceneSegregated::BuildStaticTree()
+{
+	D_TRACKTIME();
+	m_staticTreeIsDirty = false;
+	if (m_staticRoot && m_staticRoot->GetAsSceneTreeNode())
+	{
+		// the tree nodes are recycled, a tree with n leafs has n - 1 tree nodes.
+		dArray<ndSceneNode*> leafArray;
+		leafArray.SetCount(m_staticFitness.GetCount() + 1);
+
+		dInt32 leafCount = 0;
+		for (ndFitnessList::dListNode* node = m_staticFitness.GetFirst(); node; node = node->GetNext())
+		{
+			ndSceneTreeNode* const treeNode = node->GetInfo();
+			if (treeNode->m_left->GetAsSceneBodyNode())
+			{
+				leafArray[leafCount] = treeNode->m_left;
+				leafCount++;
+			}
+			if (treeNode->m_right->GetAsSceneBodyNode())
+			{
+				leafArray[leafCount] = treeNode->m_right;
+				leafCount++;
+			}
+		}
+		dAssert(leafCount == leafArray.GetCount());
+
+		ndFitnessList::dListNode* nextNode = m_staticFitness.GetFirst();
+		m_staticRoot = BuildStaticTree(&leafArray[0], leafCount, &nextNode);
+		m_staticRoot->m_parent = nullptr;
+		dAssert(!nextNode);
+	}
+}
+
+ndSceneNode* ndSceneSegregated::BuildStaticTree(ndSceneNode** const leafArray, dInt32 count, ndFitnessList::dListNode** const nextNode)
+{
+	class ndBin
+	{
+		public:
+		dVector m_minBox;
+		dVector m_maxBox;
+		dInt32 m_count;
+	};
+
+	if (count == 1)
+	{
+		return leafArray[0];
+	}
+
+	dVector minBox(dFloat32(1.0e15f));
+	dVector maxBox(dFloat32(-1.0e15f));
+	dVector minCenter(dFloat32(1.0e15f));
+	dVector maxCenter(dFloat32(-1.0e15f));
+	for (dInt32 i = 0; i < count; i++)
+	{
+		const ndSceneNode* const node = leafArray[i];
+		const dVector center(dVector::m_half * (node->m_minBox + node->m_maxBox));
+		minBox = minBox.GetMin(node->m_minBox);
+		maxBox = maxBox.GetMax(node->m_maxBox);
+		minCenter = minCenter.GetMin(center);
+		maxCenter = maxCenter.GetMax(center);
+	}
+
+	// bin the leaf centers along each axis, and select the split plane with
+	// the lowest left area * left count + right area * right count.
+	dInt32 bestAxis = -1;
+	dInt32 bestPlane = 0;
+	dFloat32 bestCost = dFloat32(1.0e30f);
+	dFloat32 binScale[3];
+	const dVector extent(maxCenter - minCenter);
+	for (dInt32 axis = 0; axis < 3; axis++)
+	{
+		binScale[axis] = dFloat32(0.0f);
+		if (extent[axis] > dFloat32(1.0e-3f))
+		{
+			ndBin bins[D_STATIC_TREE_BUILD_BINS];
+			for (dInt32 i = 0; i < D_STATIC_TREE_BUILD_BINS; i++)
+			{
+				bins[i].m_minBox = dVector(dFloat32(1.0e15f));
+				bins[i].m_maxBox = dVector(dFloat32(-1.0e15f));
+				bins[i].m_count = 0;
+			}
+
+			binScale[axis] = dFloat32(D_STATIC_TREE_BUILD_BINS) * dFloat32(0.999f) / extent[axis];
+			for (dInt32 i = 0; i < count; i++)
+			{
+				const ndSceneNode* const node = leafArray[i];
+				const dFloat32 center = dFloat32(0.5f) * (node->m_minBox[axis] + node->m_maxBox[axis]);
+				ndBin& bin = bins[dInt32((center - minCenter[axis]) * binScale[axis])];
+				bin.m_minBox = bin.m_minBox.GetMin(node->m_minBox);
+				bin.m_maxBox = bin.m_maxBox.GetMax(node->m_maxBox);
+				bin.m_count++;
+			}
+
+			dInt32 rightCount[D_STATIC_TREE_BUILD_BINS];
+			dFloat32 rightArea[D_STATIC_TREE_BUILD_BINS];
+			dVector p0(dFloat32(1.0e15f));
+			dVector p1(dFloat32(-1.0e15f));
+			dInt32 sideCount = 0;
+			for (dInt32 i = D_STATIC_TREE_BUILD_BINS - 1; i > 0; i--)
+			{
+				p0 = p0.GetMin(bins[i].m_minBox);
+				p1 = p1.GetMax(bins[i].m_maxBox);
+				sideCount += bins[i].m_count;
+				const dVector side(p1 - p0);
+				rightCount[i] = sideCount;
+				rightArea[i] = sideCount ? side.DotProduct(side.ShiftTripleRight()).GetScalar() : dFloat32(0.0f);
+			}
+
+			p0 = dVector(dFloat32(1.0e15f));
+			p1 = dVector(dFloat32(-1.0e15f));
+			sideCount = 0;
+			for (dInt32 i = 0; i < D_STATIC_TREE_BUILD_BINS - 1; i++)
+			{
+				p0 = p0.GetMin(bins[i].m_minBox);
+				p1 = p1.GetMax(bins[i].m_maxBox);
+				sideCount += bins[i].m_count;
+				if (sideCount && rightCount[i + 1])
+				{
+					const dVector side(p1 - p0);
+					const dFloat32 leftArea = side.DotProduct(side.ShiftTripleRight()).GetScalar();
+					const dFloat32 cost = leftArea * dFloat32(sideCount) + rightArea[i + 1] * dFloat32(rightCount[i + 1]);
+					if (cost < bestCost)
+					{
+						bestCost = cost;
+						bestAxis = axis;
+						bestPlane = i;
+					}
+				}
+			}
+		}
+	}
+
+	dInt32 split = count / 2;
+	if (bestAxis >= 0)
+	{
+		dInt32 i0 = 0;
+		dInt32 i1 = count - 1;
+		while (i0 <= i1)
+		{
+			const ndSceneNode* const node = leafArray[i0];
+			const dFloat32 center = dFloat32(0.5f) * (node->m_minBox[bestAxis] + node->m_maxBox[bestAxis]);
+			if (dInt32((center - minCenter[bestAxis]) * binScale[bestAxis]) <= bestPlane)
+			{
+				i0++;
+			}
+			else
+			{
+				dSwap(leafArray[i0], leafArray[i1]);
+				i1--;
+			}
+		}
+		split = i0;
+	}
+	dAssert(split > 0);
+	dAssert(split < count);
+
+	ndSceneTreeNode* const parent = (*nextNode)->GetInfo();
+	*nextNode = (*nextNode)->GetNext();
+	parent->m_parent = nullptr;
+
+	parent->m_left = BuildStaticTree(leafArray, split, nextNode);
+	parent->m_left->m_parent = parent;
+
+	parent->m_right = BuildStaticTree(&leafArray[split], count - split, nextNode);
+	parent->m_right->m_parent = parent;
+
+	parent->SetAABB(minBox, maxBox);
+	return parent;
+}
+
+void ndSceneSegregated::FindCollidinPairs(dInt32 threadIndex, ndBodyKinematic* const body, bool oneWay)
+{
+	ndSceneNode* const leafNode = body->GetSceneBodyNode();
+	if (body->m_staticSceneNode)
+	{
+		// the dynamic bodies find the static ones, unless they are at rest.
+		if (!oneWay && m_dynamicRoot)
+		{
+			SubmitPairs(threadIndex, leafNode, m_dynamicRoot);
+		}
+		return;
+	}
+
+	if (oneWay)
+	{
+		for (ndSceneNode* ptr = leafNode; ptr->m_parent; ptr = ptr->m_parent)
+		{
+			ndSceneTreeNode* const parent = ptr->m_parent->GetAsSceneTreeNode();
+			dAssert(!parent->GetAsSceneBodyNode());
+			dAssert(!parent->GetAsSceneAggregate());
+			ndSceneNode* const sibling = parent->m_right;
+			if (sibling != ptr)
+			{
+				SubmitPairs(threadIndex, leafNode, sibling);
+			}
+		}
+	}
+	else
+	{
+		for (ndSceneNode* ptr = leafNode; ptr->m_parent; ptr = ptr->m_parent)
+		{
+			ndSceneTreeNode* const parent = ptr->m_parent->GetAsSceneTreeNode();
+			dAssert(!parent->GetAsSceneBodyNode());
+			dAssert(!parent->GetAsSceneAggregate());
+			ndSceneNode* const rightSibling = parent->m_right;
+			if (rightSibling != ptr)
+			{
+				SubmitPairs(threadIndex, leafNode, rightSibling);
+			}
+			else
+			{
+				SubmitPairs(threadIndex, leafNode, parent->m_left);
+			}
+		}
+	}
+
+	if (m_staticRoot)
+	{
+		SubmitPairs(threadIndex, leafNode, m_staticRoot);
+	}
+}
+
+dFloat32 ndSceneSegregated::RayCast(ndRayCastNotify& callback, const dVector& q0, const dVector& q1) const
+{
+	dVector p0(q0 & dVector::m_triplexMask);
+	dVector p1(q1 & dVector::m_triplexMask);
+
+	dFloat32 param = dFloat32(1.2f);
+	if (m_staticRoot || m_dynamicRoot)
+	{
+		dVector segment(p1 - p0);
+		dAssert(segment.m_w == dFloat32(0.0f));
+		dFloat32 dist2 = segment.DotProduct(segment).GetScalar();
+		if (dist2 > dFloat32(1.0e-8f))
+		{
+			dFloat32 distance[D_SCENE_MAX_STACK_DEPTH];
+			const ndSceneNode* stackPool[D_SCENE_MAX_STACK_DEPTH];
+
+			dFastRayTest ray(p0, p1);
+
+			dInt32 stack = 0;
+			const ndSceneNode* const roots[] = { m_staticRoot, m_dynamicRoot };
+			for (dInt32 i = 0; i < 2; i++)
+			{
+				if (roots[i])
+				{
+					dFloat32 dist = ray.BoxIntersect(roots[i]->m_minBox, roots[i]->m_maxBox);
+					dInt32 j = stack;
+					for (; j && (dist > distance[j - 1]); j--)
+					{
+						stackPool[j] = stackPool[j - 1];
+						distance[j] = distance[j - 1];
+					}
+					stackPool[j] = roots[i];
+					distance[j] = dist;
+					stack++;
+				}
+			}
+			param = ndScene::RayCast(callback, stackPool, distance, stack, ray);
+		}
+	}
+	return param;
+}
+
+dInt32 ndSceneSegregated::BodiesInAabb(const dVector& minBox, const dVector& maxBox, ndBodyKinematic** const bodyArray, dInt32 maxCount) const
+{
+	dInt32 count = ndScene::BodiesInAabb(m_dynamicRoot, minBox, maxBox, bodyArray, maxCount);
+	count += ndScene::BodiesInAabb(m_staticRoot, minBox, maxBox, &bodyArray[count], maxCount - count);
+	return count;
+}
+
+void ndSceneSegregated::DebugScene(ndSceneTreeNotiFy* const notify)
+{
+	const ndFitnessList* const fitnessLists[] = { &m_staticFitness, &m_dynamicFitness };
+	for (dInt32 i = 0; i < 2; i++)
+	{
+		for (ndFitnessList::dListNode* node = fitnessLists[i]->GetFirst(); node; node = node->GetNext())
+		{
+			if (node->GetInfo()->GetLeft()->GetAsSceneBodyNode())
+			{
+				notify->OnDebugNode(node->GetInfo()->GetLeft());
+			}
+			if (node->GetInfo()->GetRight()->GetAsSceneBodyNode())
+			{
+				notify->OnDebugNode(node->GetInfo()->GetRight());
+			}
+		}
+	}
+}
@@ -0,0 +1,72 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __D_SCENE_SEGREGATED_H__
+#define __D_SCENE_SEGREGATED_H__
+
+#include "ndCollisionStdafx.h"
+#include "ndScene.h"
+
+#define D_STATIC_TREE_BUILD_BINS	16
+
+class ndRayCastNotify;
+
+// keeps the static and the dynamic bodies in two separate trees.
+// the static tree is only rebuilt, with a binned surface area heuristic,
+// after static bodies are added or removed. The dynamic tree is refit and
+// balanced every update like the mixed scene. Static bodies never look for
+// pairs, so static vs static pairs are never tested.
+// a body goes to the static tree if it has no mass when it is added to the scene.
+D_MSV_NEWTON_ALIGN_32
+class ndSceneSegregated : public ndScene
+{
+	public:
+	D_COLLISION_API ndSceneSegregated();
+	D_COLLISION_API virtual ~ndSceneSegregated();
+
+	D_COLLISION_API virtual dInt32 BodiesInAabb(const dVector& minBox, const dVector& maxBox, ndBodyKinematic** const bodyArray, dInt32 maxCount) const;
+
+	protected:
+	D_COLLISION_API virtual bool AddBody(ndBodyKinematic* const body);
+	D_COLLISION_API virtual bool RemoveBody(ndBodyKinematic* const body);
+	D_COLLISION_API virtual dFloat32 RayCast(ndRayCastNotify& callback, const dVector& p0, const dVector& p1) const;
+	D_COLLISION_API virtual void Cleanup();
+	D_COLLISION_API void BalanceScene();
+
+	D_COLLISION_API virtual void DebugScene(ndSceneTreeNotiFy* const notify);
+
+	private:
+	void AddNode(ndSceneNode* const newNode, ndFitnessList& fitness, ndSceneNode** const root);
+	void RemoveNode(ndSceneNode* const node, ndFitnessList& fitness, ndSceneNode** const root);
+	void BuildStaticTree();
+	ndSceneNode* BuildStaticTree(ndSceneNode** const leafArray, dInt32 count, ndFitnessList::dListNode** const nextNode);
+	D_COLLISION_API void FindCollidinPairs(dInt32 threadIndex, ndBodyKinematic* const body, bool oneWay);
+
+	ndSceneNode* m_staticRoot;
+	ndSceneNode* m_dynamicRoot;
+	ndFitnessList m_staticFitness;
+	ndFitnessList m_dynamicFitness;
+	dFloat64 m_dynamicEntropy;
+	bool m_staticTreeIsDirty;
+
+} D_GCC_NEWTON_ALIGN_32 ;
+
+#endif
@@ -0,0 +1,489 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dCoreStdafx.h"
+#include "ndCollisionStdafx.h"
+#include "ndBodyKinematic.h"
+#include "ndSceneNode.h"
+#include "ndSceneSweepAndPrune.h"
+
+ndSceneSweepAndPrune::ndSceneSweepAndPrune()
+	:ndScene()
+	,m_sortEntries()
+	,m_sortScratchBuffer()
+	,m_sortedBodies()
+	,m_maxExtent(dFloat32(0.0f))
+	,m_sortIsValid(false)
+{
+	m_axis[0] = 0;
+	m_axis[1] = 1;
+	m_axis[2] = 2;
+}
+
+ndSceneSweepAndPrune::~ndSceneSweepAndPrune()
+{
+	Cleanup();
+}
+
+bool ndSceneSweepAndPrune::AddBody(ndBodyKinematic* const body)
+{
+	if (ndScene::AddBody(body))
+	{
+		body->UpdateCollisionMatrix();
+		new ndSceneBodyNode(body);
+		m_sortIsValid = false;
+		return true;
+	}
+	return false;
+}
+
+bool ndSceneSweepAndPrune::RemoveBody(ndBodyKinematic* const body)
+{
+	ndSceneBodyNode* const node = body->GetSceneBodyNode();
+	if (node)
+	{
+		dAssert(!node->m_parent);
+		delete node;
+	}
+	m_sortIsValid = false;
+	return ndScene::RemoveBody(body);
+}
+
+void ndSceneSweepAndPrune::Cleanup()
+{
+	Sync();
+	m_contactList.DeleteAllContacts();
+	while (m_bodyList.GetFirst())
+	{
+		ndBodyKinematic* const body = m_bodyList.GetFirst()->GetInfo();
+		RemoveBody(body);
+		delete body;
+	}
+	ndContact::FlushFreeList();
+	ndBodyList::FlushFreeList();
+	m_activeBodyArray.Resize(256);
+	m_activeConstraintArray.Resize(256);
+	m_sortEntries.Resize(256);
+	m_sortScratchBuffer.Resize(256);
+	m_sortedBodies.Resize(256);
+	for (dInt32 i = 0; i < 3; i++)
+	{
+		m_minBox[i].Resize(256);
+		m_maxBox[i].Resize(256);
+	}
+}
+
+void ndSceneSweepAndPrune::BalanceScene()
+{
+	// there is no tree to balance.
+}
+
+void ndSceneSweepAndPrune::FindCollidinPairs(dInt32, ndBodyKinematic* const, bool)
+{
+	// pairs are found by sweeping all bodies at once.
+	dAssert(0);
+}
+
+void ndSceneSweepAndPrune::FindCollidingPairs()
+{
+	D_TRACKTIME();
+	for (dInt32 i = 0; i < GetThreadCount(); i++)
+	{
+		m_pairBuffers[i].SetCount(0);
+	}
+
+	// like the tree scenes, pairs of two resting bodies are only skipped when many bodies are resting.
+	m_fullScan = (3 * m_sleepBodies) < (2 * dUnsigned32(m_activeBodyArray.GetCount()));
+	SortBoxes();
+	SweepBoxes();
+	CreateNewContacts();
+}
+
+void ndSceneSweepAndPrune::SortBoxes()
+{
+	D_TRACKTIME();
+	class ndSpread
+	{
+		public:
+		dVector m_sum[D_MAX_THREADS_COUNT];
+		dVector m_sum2[D_MAX_THREADS_COUNT];
+		dFloat32 m_maxExtent[D_MAX_THREADS_COUNT];
+	};
+
+	class ndCalculateSpread : public ndBaseJob
+	{
+		public:
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			const dArray<ndBodyKinematic*>& bodyArray = m_owner->GetActiveBodyArray();
+			const dInt32 threadIndex = GetThredId();
+			const dInt32 threadCount = m_owner->GetThreadCount();
+			const dInt32 bodyCount = bodyArray.GetCount() - 1;
+			const dInt32 step = bodyCount / threadCount;
+			const dInt32 start = threadIndex * step;
+			const dInt32 count = ((threadIndex + 1) < threadCount) ? step : bodyCount - start;
+
+			dVector sum(dVector::m_zero);
+			dVector sum2(dVector::m_zero);
+			for (dInt32 i = 0; i < count; i++)
+			{
+				const ndBodyKinematic* const body = bodyArray[start + i];
+				const dVector center(dVector::m_half * (body->m_minAABB + body->m_maxAABB));
+				sum += center;
+				sum2 += center * center;
+			}
+			ndSpread* const spread = (ndSpread*)m_context;
+			spread->m_sum[threadIndex] = sum;
+			spread->m_sum2[threadIndex] = sum2;
+		}
+	};
+
+	class ndFillEntries : public ndBaseJob
+	{
+		public:
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			ndSceneSweepAndPrune* const scene = (ndSceneSweepAndPrune*)m_owner;
+			const dArray<ndBodyKinematic*>& bodyArray = scene->GetActiveBodyArray();
+			const dInt32 threadIndex = GetThredId();
+			const dInt32 threadCount = scene->GetThreadCount();
+			const dInt32 bodyCount = bodyArray.GetCount() - 1;
+			const dInt32 step = bodyCount / threadCount;
+			const dInt32 start = threadIndex * step;
+			const dInt32 count = ((threadIndex + 1) < threadCount) ? step : bodyCount - start;
+
+			// flip the bits of the floats so that they sort as unsigned integers
+			const dInt32 axis = scene->m_axis[0];
+			ndSortEntry* const entries = &scene->m_sortEntries[0];
+			for (dInt32 i = 0; i < count; i++)
+			{
+				union
+				{
+					dFloat32 m_value;
+					dUnsigned32 m_bits;
+				};
+				const ndBodyKinematic* const body = bodyArray[start + i];
+				m_value = body->m_minAABB[axis];
+				entries[start + i].m_key = (m_bits & 0x80000000) ? ~m_bits : (m_bits | 0x80000000);
+				entries[start + i].m_index = start + i;
+			}
+		}
+	};
+
+	class ndScatterBoxes : public ndBaseJob
+	{
+		public:
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			ndSceneSweepAndPrune* const scene = (ndSceneSweepAndPrune*)m_owner;
+			const dArray<ndBodyKinematic*>& bodyArray = scene->GetActiveBodyArray();
+			const dInt32 threadIndex = GetThredId();
+			const dInt32 threadCount = scene->GetThreadCount();
+			const dInt32 bodyCount = bodyArray.GetCount() - 1;
+			const dInt32 step = bodyCount / threadCount;
+			const dInt32 start = threadIndex * step;
+			const dInt32 count = ((threadIndex + 1) < threadCount) ? step : bodyCount - start;
+
+			const dInt32 axis0 = scene->m_axis[0];
+			const dInt32 axis1 = scene->m_axis[1];
+			const dInt32 axis2 = scene->m_axis[2];
+			const ndSortEntry* const entries = &scene->m_sortEntries[0];
+			dFloat32 maxExtent = dFloat32(0.0f);
+			for (dInt32 i = start; i < start + count; i++)
+			{
+				ndBodyKinematic* const body = bodyArray[entries[i].m_index];
+				scene->m_sortedBodies[i] = body;
+				scene->m_minBox[0][i] = body->m_minAABB[axis0];
+				scene->m_maxBox[0][i] = body->m_maxAABB[axis0];
+				scene->m_minBox[1][i] = body->m_minAABB[axis1];
+				scene->m_maxBox[1][i] = body->m_maxAABB[axis1];
+				scene->m_minBox[2][i] = body->m_minAABB[axis2];
+				scene->m_maxBox[2][i] = body->m_maxAABB[axis2];
+				maxExtent = dMax(maxExtent, body->m_maxAABB[axis0] - body->m_minAABB[axis0]);
+			}
+			ndSpread* const spread = (ndSpread*)m_context;
+			spread->m_maxExtent[threadIndex] = maxExtent;
+		}
+	};
+
+	class ndEvaluateKey
+	{
+		public:
+		ndEvaluateKey(void* const)
+		{
+		}
+
+		dUnsigned64 GetKey(const ndSortEntry& entry) const
+		{
+			return entry.m_key;
+		}
+	};
+
+	const dInt32 bodyCount = m_activeBodyArray.GetCount() - 1;
+	const dInt32 threadCount = GetThreadCount();
+
+	// sort along the axis where the body centers are more spread out.
+	ndSpread spread;
+	SubmitJobs<ndCalculateSpread>(&spread);
+	dVector sum(dVector::m_zero);
+	dVector sum2(dVector::m_zero);
+	for (dInt32 i = 0; i < threadCount; i++)
+	{
+		sum += spread.m_sum[i];
+		sum2 += spread.m_sum2[i];
+	}
+	const dVector variance(sum2.Scale(dFloat32(dMax(bodyCount, 1))) - sum * sum);
+	const dInt32 axis = (variance.m_x >= variance.m_y) ? ((variance.m_x >= variance.m_z) ? 0 : 2) : ((variance.m_y >= variance.m_z) ? 1 : 2);
+	m_axis[0] = axis;
+	m_axis[1] = (axis + 1) % 3;
+	m_axis[2] = (axis + 2) % 3;
+
+	m_sortEntries.SetCount(bodyCount);
+	m_sortScratchBuffer.SetCount(bodyCount);
+	SubmitJobs<ndFillEntries>();
+	if (bodyCount)
+	{
+		dParallelRadixSort<ndSortEntry, ndEvaluateKey>(this, &m_sortEntries[0], &m_sortScratchBuffer[0], bodyCount);
+	}
+
+	// the arrays are padded, so that the sweep can read four boxes past the last one.
+	m_sortedBodies.SetCount(bodyCount);
+	for (dInt32 i = 0; i < 3; i++)
+	{
+		m_minBox[i].SetCount(bodyCount + D_SWEEP_AND_PRUNE_PADDING);
+		m_maxBox[i].SetCount(bodyCount + D_SWEEP_AND_PRUNE_PADDING);
+		for (dInt32 j = 0; j < D_SWEEP_AND_PRUNE_PADDING; j++)
+		{
+			m_minBox[i][bodyCount + j] = dFloat32(1.0e30f);
+			m_maxBox[i][bodyCount + j] = dFloat32(-1.0e30f);
+		}
+	}
+	SubmitJobs<ndScatterBoxes>(&spread);
+
+	m_maxExtent = dFloat32(0.0f);
+	for (dInt32 i = 0; i < threadCount; i++)
+	{
+		m_maxExtent = dMax(m_maxExtent, spread.m_maxExtent[i]);
+	}
+	m_sortIsValid = true;
+}
+
+void ndSceneSweepAndPrune::SweepBoxes()
+{
+	D_TRACKTIME();
+	class ndSweepBoxes : public ndBaseJob
+	{
+		public:
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			ndSceneSweepAndPrune* const scene = (ndSceneSweepAndPrune*)m_owner;
+			const dInt32 threadIndex = GetThredId();
+			const dInt32 count = scene->m_sortedBodies.GetCount();
+			const bool fullScan = scene->m_fullScan;
+			ndBodyKinematic** const bodies = &scene->m_sortedBodies[0];
+			const dFloat32* const minBox0 = &scene->m_minBox[0][0];
+			const dFloat32* const maxBox0 = &scene->m_maxBox[0][0];
+			const dFloat32* const minBox1 = &scene->m_minBox[1][0];
+			const dFloat32* const maxBox1 = &scene->m_maxBox[1][0];
+			const dFloat32* const minBox2 = &scene->m_minBox[2][0];
+			const dFloat32* const maxBox2 = &scene->m_maxBox[2][0];
+
+			// boxes are handed out in batches, a box sweep cost depends on its size.
+			dAtomic<dInt32>& iterator = *((dAtomic<dInt32>*)m_context);
+			for (dInt32 base = iterator.fetch_add(D_SWEEP_AND_PRUNE_BATCH_SIZE); base < count; base = iterator.fetch_add(D_SWEEP_AND_PRUNE_BATCH_SIZE))
+			{
+				const dInt32 batchEnd = dMin(base + D_SWEEP_AND_PRUNE_BATCH_SIZE, count);
+				for (dInt32 i = base; i < batchEnd; i++)
+				{
+					ndBodyKinematic* const body0 = bodies[i];
+					const bool test0 = body0->m_invMass.m_w != dFloat32(0.0f);
+					const dFloat32 sweepEnd = maxBox0[i];
+					const dVector max0(sweepEnd);
+					const dVector min1(minBox1[i]);
+					const dVector max1(maxBox1[i]);
+					const dVector min2(minBox2[i]);
+					const dVector max2(maxBox2[i]);
+					for (dInt32 j = i + 1; minBox0[j] < sweepEnd; j += 4)
+					{
+						const dVector test(
+							(dVector(&minBox0[j]) < max0) &
+							(dVector(&minBox1[j]) < max1) & (dVector(&maxBox1[j]) > min1) &
+							(dVector(&minBox2[j]) < max2) & (dVector(&maxBox2[j]) > min2));
+						for (dInt32 mask = test.GetSignMask(), k = j; mask; mask >>= 1, k++)
+						{
+							if (mask & 1)
+							{
+								ndBodyKinematic* const body1 = bodies[k];
+								const bool test1 = body1->m_invMass.m_w != dFloat32(0.0f);
+								if ((test0 || test1) && (fullScan || !(body0->m_equilibrium & body1->m_equilibrium)))
+								{
+									scene->AddPair(threadIndex, body0, body1);
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+	};
+
+	dAtomic<dInt32> iterator(0);
+	SubmitJobs<ndSweepBoxes>(&iterator);
+}
+
+void ndSceneSweepAndPrune::GetSweepRange(const dVector& minBox, const dVector& maxBox, dInt32& start, dInt32& end) const
+{
+	// a box can only overlap the query if it starts before the query ends,
+	// and no earlier than the largest box extent before the query starts.
+	const dInt32 axis = m_axis[0];
+	const dFloat32 sweepStart = minBox[axis] - m_maxExtent;
+	const dFloat32 sweepEnd = maxBox[axis];
+	const dFloat32* const minBox0 = &m_minBox[0][0];
+
+	dInt32 i0 = 0;
+	dInt32 i1 = m_sortedBodies.GetCount();
+	while (i0 < i1)
+	{
+		const dInt32 mid = (i0 + i1) >> 1;
+		if (minBox0[mid] < sweepStart)
+		{
+			i0 = mid + 1;
+		}
+		else
+		{
+			i1 = mid;
+		}
+	}
+	start = i0;
+
+	i1 = m_sortedBodies.GetCount();
+	while (i0 < i1)
+	{
+		const dInt32 mid = (i0 + i1) >> 1;
+		if (minBox0[mid] < sweepEnd)
+		{
+			i0 = mid + 1;
+		}
+		else
+		{
+			i1 = mid;
+		}
+	}
+	end = i0;
+}
+
+dInt32 ndSceneSweepAndPrune::BodiesInAabb(const dVector& minBox, const dVector& maxBox, ndBodyKinematic** const bodyArray, dInt32 maxCount) const
+{
+	dInt32 count = 0;
+	if (m_sortIsValid)
+	{
+		dInt32 start;
+		dInt32 end;
+		GetSweepRange(minBox, maxBox, start, end);
+		for (dInt32 i = start; (i < end) && (count < maxCount); i++)
+		{
+			ndBodyKinematic* const body = m_sortedBodies[i];
+			if (dOverlapTest(body->m_minAABB, body->m_maxAABB, minBox, maxBox))
+			{
+				bodyArray[count] = body;
+				count++;
+			}
+		}
+	}
+	else
+	{
+		for (ndBodyList::dListNode* node = m_bodyList.GetFirst(); node && (count < maxCount); node = node->GetNext())
+		{
+			ndBodyKinematic* const body = node->GetInfo();
+			if (body->GetSceneBodyNode() && dOverlapTest(body->m_minAABB, body->m_maxAABB, minBox, maxBox))
+			{
+				bodyArray[count] = body;
+				count++;
+			}
+		}
+	}
+	return count;
+}
+
+dFloat32 ndSceneSweepAndPrune::RayCast(ndRayCastNotify& callback, const dVector& q0, const dVector& q1) const
+{
+	dVector p0(q0 & dVector::m_triplexMask);
+	dVector p1(q1 & dVector::m_triplexMask);
+
+	dFloat32 maxParam = dFloat32(1.2f);
+	dVector segment(p1 - p0);
+	dAssert(segment.m_w == dFloat32(0.0f));
+	dFloat32 dist2 = segment.DotProduct(segment).GetScalar();
+	if (dist2 > dFloat32(1.0e-8f))
+	{
+		dFastRayTest ray(p0, p1);
+		if (m_sortIsValid)
+		{
+			dInt32 start;
+			dInt32 end;
+			GetSweepRange(p0.GetMin(p1), p0.GetMax(p1), start, end);
+			for (dInt32 i = start; i < end; i++)
+			{
+				ndBodyKinematic* const body = m_sortedBodies[i];
+				if (ray.BoxIntersect(body->m_minAABB, body->m_maxAABB) < maxParam)
+				{
+					maxParam = dMin(maxParam, body->RayCast(callback, ray, maxParam));
+					if (maxParam < dFloat32(1.0e-8f))
+					{
+						break;
+					}
+				}
+			}
+		}
+		else
+		{
+			for (ndBodyList::dListNode* node = m_bodyList.GetFirst(); node; node = node->GetNext())
+			{
+				ndBodyKinematic* const body = node->GetInfo();
+				if (body->GetSceneBodyNode() && (ray.BoxIntersect(body->m_minAABB, body->m_maxAABB) < maxParam))
+				{
+					maxParam = dMin(maxParam, body->RayCast(callback, ray, maxParam));
+					if (maxParam < dFloat32(1.0e-8f))
+					{
+						break;
+					}
+				}
+			}
+		}
+	}
+	return maxParam;
+}
+
+void ndSceneSweepAndPrune::DebugScene(ndSceneTreeNotiFy* const notify)
+{
+	for (ndBodyList::dListNode* node = m_bodyList.GetFirst(); node; node = node->GetNext())
+	{
+		const ndSceneBodyNode* const bodyNode = node->GetInfo()->GetSceneBodyNode();
+		if (bodyNode)
+		{
+			notify->OnDebugNode(bodyNode);
+		}
+	}
+}
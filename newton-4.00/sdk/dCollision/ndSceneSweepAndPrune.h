@@ -0,0 +1,82 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __D_SCENE_SWEEP_AND_PRUNE_H__
+#define __D_SCENE_SWEEP_AND_PRUNE_H__
+
+#include "ndCollisionStdafx.h"
+#include "ndScene.h"
+
+#define D_SWEEP_AND_PRUNE_BATCH_SIZE	64
+#define D_SWEEP_AND_PRUNE_PADDING		4
+
+class ndRayCastNotify;
+
+// broad phase without a tree. Each update the aabb of all bodies are sorted
+// by their min value along the axis with the largest spread, and written to
+// structure of arrays buffers. The pairs are found by sweeping each box over
+// the boxes that start before it ends, four boxes at a time.
+// it does well in dense scenes of bodies of similar size, but a few very large
+// bodies, like a floor, are swept against every box that starts inside them.
+D_MSV_NEWTON_ALIGN_32
+class ndSceneSweepAndPrune : public ndScene
+{
+	public:
+	D_COLLISION_API ndSceneSweepAndPrune();
+	D_COLLISION_API virtual ~ndSceneSweepAndPrune();
+
+	D_COLLISION_API virtual dInt32 BodiesInAabb(const dVector& minBox, const dVector& maxBox, ndBodyKinematic** const bodyArray, dInt32 maxCount) const;
+
+	protected:
+	D_COLLISION_API virtual bool AddBody(ndBodyKinematic* const body);
+	D_COLLISION_API virtual bool RemoveBody(ndBodyKinematic* const body);
+	D_COLLISION_API virtual dFloat32 RayCast(ndRayCastNotify& callback, const dVector& p0, const dVector& p1) const;
+	D_COLLISION_API virtual void Cleanup();
+	D_COLLISION_API virtual void FindCollidingPairs();
+	D_COLLISION_API void BalanceScene();
+
+	D_COLLISION_API virtual void DebugScene(ndSceneTreeNotiFy* const notify);
+
+	private:
+	class ndSortEntry
+	{
+		public:
+		dUnsigned32 m_key;
+		dInt32 m_index;
+	};
+
+	void SortBoxes();
+	void SweepBoxes();
+	void GetSweepRange(const dVector& minBox, const dVector& maxBox, dInt32& start, dInt32& end) const;
+	D_COLLISION_API void FindCollidinPairs(dInt32 threadIndex, ndBodyKinematic* const body, bool oneWay);
+
+	dArray<ndSortEntry> m_sortEntries;
+	dArray<ndSortEntry> m_sortScratchBuffer;
+	dArray<ndBodyKinematic*> m_sortedBodies;
+	dArray<dFloat32> m_minBox[3];
+	dArray<dFloat32> m_maxBox[3];
+	dFloat32 m_maxExtent;
+	dInt32 m_axis[3];
+	bool m_sortIsValid;
+
+} D_GCC_NEWTON_ALIGN_32 ;
+
+#endif
@@ -657,7 +657,7 @@ dInt32 ndShapeConvex::CalculatePlaneIntersection(const dVector& normal, const dV
 	dAssert(normal.m_w == dFloat32(0.0f));
 	if (vertToEdgeMapping) 
 	{
-		dInt32 edgeIndex;
+		dInt32 edgeIndex = -1;
 		featureCount = 1;
 		support[0] = SupportVertex(normal, &edgeIndex);
 		edge = vertToEdgeMapping[edgeIndex];
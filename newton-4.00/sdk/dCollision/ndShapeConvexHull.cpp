@@ -110,6 +110,7 @@ ndShapeConvexHull::ndShapeConvexHull (dInt32 count, dInt32 strideInBytes, dFloat
 	,m_faceCount(0)
 	,m_soaVertexCount(0)
 	,m_supportTreeCount(0)
+	,m_supportHillClimbing(false)
 {
 	m_edgeCount = 0;
 	m_vertexCount = 0;
@@ -130,6 +131,7 @@ ndShapeConvexHull::ndShapeConvexHull(const nd::TiXmlNode* const xmlNode)
 	,m_faceCount(0)
 	,m_soaVertexCount(0)
 	,m_supportTreeCount(0)
+	,m_supportHillClimbing(false)
 {
 	m_edgeCount = 0;
 	m_vertexCount = 0;
@@ -167,6 +169,54 @@ ndShapeConvexHull::~ndShapeConvexHull()
 	}
 }
 
+void ndShapeConvexHull::CreateBatch(const ndDescriptor* const descriptors, ndShapeConvexHull** const hullsOut, dInt32 count, dInt32 threadCount)
+{
+	class ndBatchContext
+	{
+		public:
+		const ndDescriptor* m_descriptors;
+		ndShapeConvexHull** m_hulls;
+		dInt32 m_count;
+		dAtomic<dInt32> m_index;
+	};
+
+	class ndBuildHulls: public dThreadPoolJob
+	{
+		public:
+		virtual void Execute()
+		{
+			ndBatchContext* const context = (ndBatchContext*)m_context;
+			for (dInt32 i = context->m_index.fetch_add(1); i < context->m_count; i = context->m_index.fetch_add(1))
+			{
+				const ndDescriptor& descriptor = context->m_descriptors[i];
+				context->m_hulls[i] = new ndShapeConvexHull(descriptor.m_count, descriptor.m_strideInBytes, descriptor.m_tolerance, descriptor.m_vertexArray);
+			}
+		}
+
+		void* m_context;
+	};
+
+	threadCount = threadCount ? dClamp(threadCount, 1, D_MAX_THREADS_COUNT) : dThreadPoolBuilder::GetDefaultThreadCount();
+	threadCount = dMin(threadCount, count);
+	if (threadCount <= 1)
+	{
+		for (dInt32 i = 0; i < count; i++)
+		{
+			hullsOut[i] = new ndShapeConvexHull(descriptors[i].m_count, descriptors[i].m_strideInBytes, descriptors[i].m_tolerance, descriptors[i].m_vertexArray);
+		}
+		return;
+	}
+
+	ndBatchContext context;
+	context.m_descriptors = descriptors;
+	context.m_hulls = hullsOut;
+	context.m_count = count;
+	context.m_index.store(0);
+
+	dThreadPoolBuilder threadPool("ndShapeConvexHull", threadCount);
+	threadPool.SubmitJobs<ndBuildHulls>(&context);
+}
+
 bool ndShapeConvexHull::Create(dInt32 count, dInt32 strideInBytes, const dFloat32* const vertexArray, dFloat32 tolerance)
 {
 	dInt32 stride = strideInBytes / sizeof(dFloat32);
@@ -967,10 +1017,51 @@ inline dVector ndShapeConvexHull::SupportVertexhierarchical(const dVector& dir,
 	return m_vertex[index];
 }
 
+// walk the hull edges from the vertex found in the previous call, moving to the
+// neighbor with the largest projection until no neighbor improves. On a convex
+// hull the local maximum is also the global maximum, and for coherent directions
+// the walk usually takes zero or one step.
+inline dVector ndShapeConvexHull::SupportVertexHillClimbing(const dVector& dir, dInt32* const vertexIndex) const
+{
+	dInt32 index = *vertexIndex;
+	dFloat32 maxProjection = dir.DotProduct(m_vertex[index]).GetScalar();
+	for (dInt32 i = 0; i < m_vertexCount; i++)
+	{
+		dInt32 bestIndex = index;
+		const ndConvexSimplexEdge* const edge = m_vertexToEdgeMapping[index];
+		const ndConvexSimplexEdge* ptr = edge;
+		do
+		{
+			const dInt32 neighbor = ptr->m_twin->m_vertex;
+			const dFloat32 projection = dir.DotProduct(m_vertex[neighbor]).GetScalar();
+			if (projection > maxProjection)
+			{
+				bestIndex = neighbor;
+				maxProjection = projection;
+			}
+			ptr = ptr->m_twin->m_next;
+		} while (ptr != edge);
+
+		if (bestIndex == index)
+		{
+			break;
+		}
+		index = bestIndex;
+	}
+
+	*vertexIndex = index;
+	return m_vertex[index];
+}
+
 dVector ndShapeConvexHull::SupportVertex(const dVector& dir, dInt32* const vertexIndex) const
 {
 	dAssert(dir.m_w == dFloat32(0.0f));
-	if (m_vertexCount > D_CONVEX_VERTEX_SPLITE_SIZE) 
+	if (m_supportHillClimbing && vertexIndex && (*vertexIndex >= 0) && (*vertexIndex < m_vertexCount))
+	{
+		// the caller passed the support vertex of a previous call as a hint
+		return SupportVertexHillClimbing(dir, vertexIndex);
+	}
+	else if (m_vertexCount > D_CONVEX_VERTEX_SPLITE_SIZE) 
 	{
 		return SupportVertexhierarchical(dir, vertexIndex);
 	}
@@ -32,10 +32,29 @@ class ndShapeConvexHull : public ndShapeConvex
 	class ndConvexBox;
 
 	public:
+	class ndDescriptor
+	{
+		public:
+		const dFloat32* m_vertexArray;
+		dInt32 m_count;
+		dInt32 m_strideInBytes;
+		dFloat32 m_tolerance;
+	};
+
 	D_COLLISION_API ndShapeConvexHull(const nd::TiXmlNode* const xmlNode);
 	D_COLLISION_API ndShapeConvexHull(dInt32 count, dInt32 strideInBytes, dFloat32 tolerance, const dFloat32* const vertexArray);
 	D_COLLISION_API virtual ~ndShapeConvexHull();
 
+	// build the hulls of many point clouds on a temporary thread pool, 
+	// hullsOut[i] is the hull of descriptors[i]. threadCount zero means all cores.
+	D_COLLISION_API static void CreateBatch(const ndDescriptor* const descriptors, ndShapeConvexHull** const hullsOut, dInt32 count, dInt32 threadCount = 0);
+
+	// when enabled, the vertex index passed to the support function is used as the start of
+	// a walk over the hull edges. It is faster for directions that change little between calls
+	// and slower for uncorrelated ones, therefore it is off by default.
+	bool GetSupportHillClimbing() const;
+	void SetSupportHillClimbing(bool state);
+
 	protected:
 	ndShapeInfo GetShapeInfo() const;
 	dBigVector FaceNormal(const dEdge *face, const dBigVector* const pool) const;
@@ -48,6 +67,7 @@ class ndShapeConvexHull : public ndShapeConvex
 	private:
 	dVector SupportVertexBruteForce(const dVector& dir, dInt32* const vertexIndex) const;
 	dVector SupportVertexhierarchical(const dVector& dir, dInt32* const vertexIndex) const;
+	dVector SupportVertexHillClimbing(const dVector& dir, dInt32* const vertexIndex) const;
 	
 	void DebugShape(const dMatrix& matrix, ndShapeDebugCallback& debugCallback) const;
 
@@ -65,7 +85,18 @@ class ndShapeConvexHull : public ndShapeConvex
 	dInt32 m_faceCount;
 	dInt32 m_soaVertexCount;
 	dInt32 m_supportTreeCount;
+	bool m_supportHillClimbing;
 } D_GCC_NEWTON_ALIGN_32;
 
+inline bool ndShapeConvexHull::GetSupportHillClimbing() const
+{
+	return m_supportHillClimbing;
+}
+
+inline void ndShapeConvexHull::SetSupportHillClimbing(bool state)
+{
+	m_supportHillClimbing = state;
+}
+
 #endif 
 
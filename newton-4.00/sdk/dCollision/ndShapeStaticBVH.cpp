@@ -137,21 +137,7 @@ ndShapeStaticBVH::ndShapeStaticBVH(const dPolygonSoupBuilder& builder)
 	Create(builder);
 	CalculateAdjacendy();
 
-	dVector p0;
-	dVector p1;
-	GetAABB(p0, p1);
-	m_boxSize = (p1 - p0) * dVector::m_half;
-	m_boxOrigin = (p1 + p0) * dVector::m_half;
-
-	ndMeshVertexListIndexList data;
-	data.m_indexList = nullptr;
-	data.m_userDataList = nullptr;
-	data.m_maxIndexCount = 1000000000;
-	data.m_triangleCount = 0;
-	dVector zero(dVector::m_zero);
-	dFastAabbInfo box(dGetIdentityMatrix(), dVector(dFloat32(1.0e15f)));
-	ForAllSectors(box, zero, dFloat32(1.0f), GetTriangleCount, &data);
-	m_trianglesCount = data.m_triangleCount;
+	CalculateTriangleCount();
 }
 
 ndShapeStaticBVH::ndShapeStaticBVH(const nd::TiXmlNode* const xmlNode, const char* const assetPath)
@@ -165,6 +151,24 @@ ndShapeStaticBVH::ndShapeStaticBVH(const nd::TiXmlNode* const xmlNode, const cha
 	sprintf(pathCopy, "%s/%s", assetPath, assetName);
 	Deserialize(pathCopy);
 
+	CalculateTriangleCount();
+}
+
+ndShapeStaticBVH::ndShapeStaticBVH(const char* const binaryFileName)
+	:ndShapeStaticMesh(m_boundingBoxHierachy)
+	,dAabbPolygonSoup()
+	,m_trianglesCount(0)
+{
+	Deserialize(binaryFileName);
+	CalculateTriangleCount();
+}
+
+ndShapeStaticBVH::~ndShapeStaticBVH(void)
+{
+}
+
+void ndShapeStaticBVH::CalculateTriangleCount()
+{
 	dVector p0;
 	dVector p1;
 	GetAABB(p0, p1);
@@ -182,10 +186,6 @@ ndShapeStaticBVH::ndShapeStaticBVH(const nd::TiXmlNode* const xmlNode, const cha
 	m_trianglesCount = data.m_triangleCount;
 }
 
-ndShapeStaticBVH::~ndShapeStaticBVH(void)
-{
-}
-
 D_COLLISION_API void ndShapeStaticBVH::Save(nd::TiXmlElement* const xmlNode, const char* const assetPath, dInt32 nodeid) const
 {
 	nd::TiXmlElement* const paramNode = new nd::TiXmlElement("ndShapeStaticBVH");
@@ -34,6 +34,7 @@ class ndShapeStaticBVH : public ndShapeStaticMesh, public dAabbPolygonSoup
 	public:
 	D_COLLISION_API ndShapeStaticBVH(const dPolygonSoupBuilder& builder);
 	D_COLLISION_API ndShapeStaticBVH(const nd::TiXmlNode* const xmlNode, const char* const assetPath);
+	D_COLLISION_API ndShapeStaticBVH(const char* const binaryFileName);
 	D_COLLISION_API virtual ~ndShapeStaticBVH();
 
 	protected:
@@ -85,6 +86,7 @@ class ndShapeStaticBVH : public ndShapeStaticMesh, public dAabbPolygonSoup
 #endif
 
 	private: 
+	void CalculateTriangleCount();
 	D_COLLISION_API virtual void Save(nd::TiXmlElement* const xmlNode, const char* const assetPath, dInt32 nodeid) const;
 	dInt32 m_trianglesCount;
 };
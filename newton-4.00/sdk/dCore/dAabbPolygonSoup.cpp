@@ -26,10 +26,13 @@
 #include "dList.h"
 #include "dMatrix.h"
 #include "dPolyhedra.h"
+#include "dThreadPool.h"
 #include "dAabbPolygonSoup.h"
 #include "dPolygonSoupBuilder.h"
 
 #define DG_STACK_DEPTH 512
+#define DG_SPLIT_BINS 16
+#define DG_PARALLEL_BUILD_MIN_SIZE (1024 * 4)
 
 D_MSV_NEWTON_ALIGN_32
 class dAabbPolygonSoup::dgNodeBuilder: public dAabbPolygonSoup::dNode
@@ -138,114 +141,260 @@ class dAabbPolygonSoup::dgNodeBuilder: public dAabbPolygonSoup::dNode
 class dAabbPolygonSoup::dgSpliteInfo
 {
 	public:
+	class dgBin
+	{
+		public:
+		dVector m_p0;
+		dVector m_p1;
+		dInt32 m_count;
+	};
+
 	dgSpliteInfo (dgNodeBuilder* const boxArray, dInt32 boxCount)
 	{
-		dVector minP ( dFloat32 (1.0e15f)); 
-		dVector maxP (-dFloat32 (1.0e15f)); 
+		dVector minP ( dFloat32 (1.0e15f));
+		dVector maxP (-dFloat32 (1.0e15f));
 
-		if (boxCount == 2) 
+		if (boxCount == 2)
 		{
 			m_axis = 1;
-			for (dInt32 i = 0; i < boxCount; i ++) 
+			for (dInt32 i = 0; i < boxCount; i ++)
 			{
 				const dgNodeBuilder& box = boxArray[i];
 				const dVector& p0 = box.m_p0;
 				const dVector& p1 = box.m_p1;
-				minP = minP.GetMin (p0); 
-				maxP = maxP.GetMax (p1); 
+				minP = minP.GetMin (p0);
+				maxP = maxP.GetMax (p1);
 			}
-
-		} 
-		else 
+		}
+		else
 		{
-			dVector median (dVector::m_zero);
-			dVector varian (dVector::m_zero);
-			for (dInt32 i = 0; i < boxCount; i ++) 
+			dVector centerMinP ( dFloat32 (1.0e15f));
+			dVector centerMaxP (-dFloat32 (1.0e15f));
+			for (dInt32 i = 0; i < boxCount; i ++)
 			{
 				const dgNodeBuilder& box = boxArray[i];
+				minP = minP.GetMin (box.m_p0);
+				maxP = maxP.GetMax (box.m_p1);
+				centerMinP = centerMinP.GetMin (box.m_origin);
+				centerMaxP = centerMaxP.GetMax (box.m_origin);
+			}
 
-				const dVector& p0 = box.m_p0;
-				const dVector& p1 = box.m_p1;
+			m_axis = BinnedSurfaceAreaSplit (boxArray, boxCount, centerMinP, centerMaxP);
+			if (!m_axis)
+			{
+				m_axis = MedianSplit (boxArray, boxCount);
+			}
+		}
 
-				minP = minP.GetMin (p0); 
-				maxP = maxP.GetMax (p1); 
-				dVector p (dVector::m_half * (p0 + p1));
+		dAssert (maxP.m_x - minP.m_x >= dFloat32 (0.0f));
+		dAssert (maxP.m_y - minP.m_y >= dFloat32 (0.0f));
+		dAssert (maxP.m_z - minP.m_z >= dFloat32 (0.0f));
+		m_p0 = minP;
+		m_p1 = maxP;
+	}
+
+	private:
+	static dFloat32 Area (const dVector& p0, const dVector& p1)
+	{
+		dVector size ((p1 - p0) & dVector::m_triplexMask);
+		return size.DotProduct(size.ShiftTripleRight()).GetScalar();
+	}
 
-				median += p;
-				varian += p * p;
+	// sort the box centers into DG_SPLIT_BINS buckets along each axis and pick the plane
+	// with the lowest surface area heuristic cost. returns the number of boxes on the
+	// left side, or zero if all the centers are coincident.
+	static dInt32 BinnedSurfaceAreaSplit (dgNodeBuilder* const boxArray, dInt32 boxCount, const dVector& centerMinP, const dVector& centerMaxP)
+	{
+		dgBin bins[3][DG_SPLIT_BINS];
+		const dVector extent (centerMaxP - centerMinP);
+		for (dInt32 axis = 0; axis < 3; axis ++)
+		{
+			for (dInt32 i = 0; i < DG_SPLIT_BINS; i ++)
+			{
+				bins[axis][i].m_p0 = dVector (dFloat32 (1.0e15f));
+				bins[axis][i].m_p1 = dVector (-dFloat32 (1.0e15f));
+				bins[axis][i].m_count = 0;
 			}
+		}
 
-			varian = varian.Scale (dFloat32 (boxCount)) - median * median;
+		dFloat32 scale[3];
+		for (dInt32 axis = 0; axis < 3; axis ++)
+		{
+			scale[axis] = (extent[axis] > dFloat32 (1.0e-6f)) ? dFloat32 (DG_SPLIT_BINS) * dFloat32 (0.9999f) / extent[axis] : dFloat32 (0.0f);
+		}
 
-			dInt32 index = 0;
-			dFloat32 maxVarian = dFloat32 (-1.0e10f);
-			for (dInt32 i = 0; i < 3; i ++) 
+		for (dInt32 i = 0; i < boxCount; i ++)
+		{
+			const dgNodeBuilder& box = boxArray[i];
+			for (dInt32 axis = 0; axis < 3; axis ++)
 			{
-				if (varian[i] > maxVarian) 
-				{
-					index = i;
-					maxVarian = varian[i];
-				}
+				const dInt32 index = dInt32 ((box.m_origin[axis] - centerMinP[axis]) * scale[axis]);
+				dgBin& bin = bins[axis][dClamp (index, 0, DG_SPLIT_BINS - 1)];
+				bin.m_p0 = bin.m_p0.GetMin (box.m_p0);
+				bin.m_p1 = bin.m_p1.GetMax (box.m_p1);
+				bin.m_count ++;
 			}
+		}
 
-			dVector center = median.Scale (dFloat32 (1.0f) / dFloat32 (boxCount));
-			dFloat32 test = center[index];
-			dInt32 i0 = 0;
-			dInt32 i1 = boxCount - 1;
-			do 
-			{    
-				for (; i0 <= i1; i0 ++) 
-				{
-					const dgNodeBuilder& box = boxArray[i0];
-					dFloat32 val = (box.m_p0[index] + box.m_p1[index]) * dFloat32 (0.5f);
-					if (val > test) 
-					{
-						break;
-					}
-				}
+		dInt32 bestAxis = -1;
+		dInt32 bestSplit = 0;
+		dFloat32 bestCost = dFloat32 (1.0e30f);
+		for (dInt32 axis = 0; axis < 3; axis ++)
+		{
+			if (scale[axis] == dFloat32 (0.0f))
+			{
+				continue;
+			}
 
-				for (; i1 >= i0; i1 --) 
+			dFloat32 rightCost[DG_SPLIT_BINS];
+			dVector p0 (dFloat32 (1.0e15f));
+			dVector p1 (-dFloat32 (1.0e15f));
+			dInt32 count = 0;
+			for (dInt32 i = DG_SPLIT_BINS - 1; i > 0; i --)
+			{
+				const dgBin& bin = bins[axis][i];
+				p0 = p0.GetMin (bin.m_p0);
+				p1 = p1.GetMax (bin.m_p1);
+				count += bin.m_count;
+				rightCost[i] = count ? Area (p0, p1) * dFloat32 (count) : dFloat32 (0.0f);
+			}
+
+			p0 = dVector (dFloat32 (1.0e15f));
+			p1 = dVector (-dFloat32 (1.0e15f));
+			count = 0;
+			for (dInt32 i = 0; i < DG_SPLIT_BINS - 1; i ++)
+			{
+				const dgBin& bin = bins[axis][i];
+				p0 = p0.GetMin (bin.m_p0);
+				p1 = p1.GetMax (bin.m_p1);
+				count += bin.m_count;
+				if (count && (count < boxCount))
 				{
-					const dgNodeBuilder& box = boxArray[i1];
-					dFloat32 val = (box.m_p0[index] + box.m_p1[index]) * dFloat32 (0.5f);
-					if (val < test) 
+					const dFloat32 cost = Area (p0, p1) * dFloat32 (count) + rightCost[i + 1];
+					if (cost < bestCost)
 					{
-						break;
+						bestCost = cost;
+						bestAxis = axis;
+						bestSplit = i + 1;
 					}
 				}
+			}
+		}
+
+		if (bestAxis < 0)
+		{
+			return 0;
+		}
+
+		dInt32 i0 = 0;
+		dInt32 i1 = boxCount - 1;
+		const dFloat32 origin = centerMinP[bestAxis];
+		const dFloat32 axisScale = scale[bestAxis];
+		while (i0 <= i1)
+		{
+			const dInt32 index = dClamp (dInt32 ((boxArray[i0].m_origin[bestAxis] - origin) * axisScale), 0, DG_SPLIT_BINS - 1);
+			if (index < bestSplit)
+			{
+				i0 ++;
+			}
+			else
+			{
+				dSwap (boxArray[i0], boxArray[i1]);
+				i1 --;
+			}
+		}
+		dAssert (i0 > 0);
+		dAssert (i0 < boxCount);
+		return i0;
+	}
 
-				if (i0 < i1)
+	static dInt32 MedianSplit (dgNodeBuilder* const boxArray, dInt32 boxCount)
+	{
+		dVector median (dVector::m_zero);
+		dVector varian (dVector::m_zero);
+		for (dInt32 i = 0; i < boxCount; i ++)
+		{
+			const dgNodeBuilder& box = boxArray[i];
+			dVector p (dVector::m_half * (box.m_p0 + box.m_p1));
+			median += p;
+			varian += p * p;
+		}
+
+		varian = varian.Scale (dFloat32 (boxCount)) - median * median;
+
+		dInt32 index = 0;
+		dFloat32 maxVarian = dFloat32 (-1.0e10f);
+		for (dInt32 i = 0; i < 3; i ++)
+		{
+			if (varian[i] > maxVarian)
+			{
+				index = i;
+				maxVarian = varian[i];
+			}
+		}
+
+		dVector center = median.Scale (dFloat32 (1.0f) / dFloat32 (boxCount));
+		dFloat32 test = center[index];
+		dInt32 i0 = 0;
+		dInt32 i1 = boxCount - 1;
+		do
+		{
+			for (; i0 <= i1; i0 ++)
+			{
+				const dgNodeBuilder& box = boxArray[i0];
+				dFloat32 val = (box.m_p0[index] + box.m_p1[index]) * dFloat32 (0.5f);
+				if (val > test)
 				{
-					dSwap(boxArray[i0], boxArray[i1]);
-					i0++; 
-					i1--;
+					break;
 				}
-			} while (i0 <= i1);
+			}
 
-			if (i0 > 0)
+			for (; i1 >= i0; i1 --)
 			{
-				i0 --;
+				const dgNodeBuilder& box = boxArray[i1];
+				dFloat32 val = (box.m_p0[index] + box.m_p1[index]) * dFloat32 (0.5f);
+				if (val < test)
+				{
+					break;
+				}
 			}
-			if ((i0 + 1) >= boxCount) 
+
+			if (i0 < i1)
 			{
-				i0 = boxCount - 2;
+				dSwap(boxArray[i0], boxArray[i1]);
+				i0++;
+				i1--;
 			}
+		} while (i0 <= i1);
 
-			m_axis = i0 + 1;
+		if (i0 > 0)
+		{
+			i0 --;
+		}
+		if ((i0 + 1) >= boxCount)
+		{
+			i0 = boxCount - 2;
 		}
 
-		dAssert (maxP.m_x - minP.m_x >= dFloat32 (0.0f));
-		dAssert (maxP.m_y - minP.m_y >= dFloat32 (0.0f));
-		dAssert (maxP.m_z - minP.m_z >= dFloat32 (0.0f));
-		m_p0 = minP;
-		m_p1 = maxP;
+		return i0 + 1;
 	}
 
+	public:
 	dInt32 m_axis;
 	dVector m_p0;
 	dVector m_p1;
 };
 
+class dAabbPolygonSoup::dgSubtreeTask
+{
+	public:
+	dgNodeBuilder* m_parent;
+	dgNodeBuilder* m_allocator;
+	dInt32 m_firstBox;
+	dInt32 m_lastBox;
+	bool m_isLeft;
+};
+
 dAabbPolygonSoup::dAabbPolygonSoup ()
 	:dPolygonSoupDatabase()
 	,m_nodesCount(0)
@@ -959,6 +1108,140 @@ dAabbPolygonSoup::dgNodeBuilder* dAabbPolygonSoup::BuildTopDown (dgNodeBuilder*
 	}
 }
 
+dAabbPolygonSoup::dgNodeBuilder* dAabbPolygonSoup::BuildTopDownParallel (dgNodeBuilder* const leafArray, dInt32 firstBox, dInt32 lastBox, dgNodeBuilder** const allocator, dThreadPoolBuilder* const threadPool) const
+{
+	class dgBuildContext
+	{
+		public:
+		const dAabbPolygonSoup* m_me;
+		dgNodeBuilder* m_leafArray;
+		dgNodeBuilder* m_root;
+		const dgSubtreeTask* m_tasks;
+		dInt32 m_count;
+		dAtomic<dInt32> m_index;
+	};
+
+	class dgBuildSubtrees: public dThreadPoolJob
+	{
+		public:
+		virtual void Execute()
+		{
+			dgBuildContext* const context = (dgBuildContext*)m_context;
+			for (dInt32 i = context->m_index.fetch_add(1); i < context->m_count; i = context->m_index.fetch_add(1))
+			{
+				const dgSubtreeTask& task = context->m_tasks[i];
+				dgNodeBuilder* nodeAllocator = task.m_allocator;
+				dgNodeBuilder* const node = context->m_me->BuildTopDown (context->m_leafArray, task.m_firstBox, task.m_lastBox, &nodeAllocator);
+				dAssert ((nodeAllocator - task.m_allocator) == (task.m_lastBox - task.m_firstBox));
+				if (task.m_parent)
+				{
+					node->m_parent = task.m_parent;
+					if (task.m_isLeft)
+					{
+						task.m_parent->m_left = node;
+					}
+					else
+					{
+						task.m_parent->m_right = node;
+					}
+				}
+				else
+				{
+					context->m_root = node;
+				}
+			}
+		}
+
+		void* m_context;
+	};
+
+	const dInt32 boxCount = lastBox - firstBox + 1;
+	const dInt32 threadCount = threadPool ? threadPool->GetCount() : 1;
+	if ((threadCount <= 1) || (boxCount < DG_PARALLEL_BUILD_MIN_SIZE))
+	{
+		return BuildTopDown (leafArray, firstBox, lastBox, allocator);
+	}
+
+	// a subtree over n leafs always takes n - 1 nodes from the allocator, parent first,
+	// then the right subtree and then the left subtree. Split the top of the tree
+	// serially, until there are enough subtrees to keep all threads busy, giving each
+	// subtree its own allocator range. The resulting tree is identical to BuildTopDown.
+	const dInt32 subtreeSize = dMax (boxCount / (threadCount * 8), DG_PARALLEL_BUILD_MIN_SIZE / 4);
+
+	dArray<dgSubtreeTask> tasks;
+	dArray<dgSubtreeTask> stack;
+	dgSubtreeTask rootTask;
+	rootTask.m_parent = nullptr;
+	rootTask.m_allocator = *allocator;
+	rootTask.m_firstBox = firstBox;
+	rootTask.m_lastBox = lastBox;
+	rootTask.m_isLeft = false;
+	stack.PushBack(rootTask);
+
+	dgNodeBuilder* root = nullptr;
+	while (stack.GetCount())
+	{
+		const dgSubtreeTask task (stack[stack.GetCount() - 1]);
+		stack.SetCount(stack.GetCount() - 1);
+
+		if ((task.m_lastBox - task.m_firstBox + 1) <= subtreeSize)
+		{
+			tasks.PushBack(task);
+		}
+		else
+		{
+			dgSpliteInfo info (&leafArray[task.m_firstBox], task.m_lastBox - task.m_firstBox + 1);
+			dgNodeBuilder* const parent = new (task.m_allocator) dgNodeBuilder (info.m_p0, info.m_p1);
+			if (task.m_parent)
+			{
+				parent->m_parent = task.m_parent;
+				if (task.m_isLeft)
+				{
+					task.m_parent->m_left = parent;
+				}
+				else
+				{
+					task.m_parent->m_right = parent;
+				}
+			}
+			else
+			{
+				root = parent;
+			}
+
+			dgSubtreeTask right;
+			right.m_parent = parent;
+			right.m_allocator = task.m_allocator + 1;
+			right.m_firstBox = task.m_firstBox + info.m_axis;
+			right.m_lastBox = task.m_lastBox;
+			right.m_isLeft = false;
+
+			dgSubtreeTask left;
+			left.m_parent = parent;
+			left.m_allocator = right.m_allocator + (right.m_lastBox - right.m_firstBox);
+			left.m_firstBox = task.m_firstBox;
+			left.m_lastBox = task.m_firstBox + info.m_axis - 1;
+			left.m_isLeft = true;
+
+			stack.PushBack(left);
+			stack.PushBack(right);
+		}
+	}
+
+	dgBuildContext context;
+	context.m_me = this;
+	context.m_leafArray = leafArray;
+	context.m_root = root;
+	context.m_tasks = &tasks[0];
+	context.m_count = tasks.GetCount();
+	context.m_index.store(0);
+
+	threadPool->SubmitJobs<dgBuildSubtrees>(&context);
+
+	*allocator = *allocator + (lastBox - firstBox);
+	return context.m_root;
+}
+
 void dAabbPolygonSoup::Create (const dPolygonSoupBuilder& builder)
 {
 	if (builder.m_faceVertexCount.GetCount() == 0) 
@@ -1009,27 +1292,26 @@ void dAabbPolygonSoup::Create (const dPolygonSoupBuilder& builder)
 	}
 
 	dgNodeBuilder* contructorAllocator = &constructor[allocatorIndex];
-	dgNodeBuilder* root = BuildTopDown (&constructor[0], 0, allocatorIndex - 1, &contructorAllocator);
+	dgNodeBuilder* root = BuildTopDownParallel (&constructor[0], 0, allocatorIndex - 1, &contructorAllocator, builder.GetThreadPool());
 
 	dAssert (root);
 	if (root->m_left) 
 	{
 		dAssert (root->m_right);
-		dList<dgNodeBuilder*> list;
-		dList<dgNodeBuilder*> stack;
-		stack.Append(root);
+		dArray<dgNodeBuilder*> list;
+		dArray<dgNodeBuilder*> stack;
+		stack.PushBack(root);
 		while (stack.GetCount()) 
 		{
-			dList<dgNodeBuilder*>::dListNode* const stackNode = stack.GetLast();
-			dgNodeBuilder* const node = stackNode->GetInfo();
-			stack.Remove(stackNode);
+			dgNodeBuilder* const node = stack[stack.GetCount() - 1];
+			stack.SetCount(stack.GetCount() - 1);
 
 			if (node->m_left) 
 			{
 				dAssert (node->m_right);
-				list.Append(node);
-				stack.Append(node->m_right);
-				stack.Append(node->m_left);
+				list.PushBack(node);
+				stack.PushBack(node->m_right);
+				stack.PushBack(node->m_left);
 			} 
 		}
 
@@ -1038,45 +1320,41 @@ void dAabbPolygonSoup::Create (const dPolygonSoupBuilder& builder)
 		do 
 		{
 			prevCost = newCost;
-			for (dList<dgNodeBuilder*>::dListNode* listNode = list.GetFirst(); listNode; listNode = listNode->GetNext()) 
+			for (dInt32 i = 0; i < list.GetCount(); i ++) 
 			{
-				dgNodeBuilder* const node = listNode->GetInfo();
-				ImproveNodeFitness (node);
+				ImproveNodeFitness (list[i]);
 			}
 
 			newCost = dFloat32 (0.0f);
-			for (dList<dgNodeBuilder*>::dListNode* listNode = list.GetFirst(); listNode; listNode = listNode->GetNext()) 
+			for (dInt32 i = 0; i < list.GetCount(); i ++) 
 			{
-				dgNodeBuilder* const node = listNode->GetInfo();
-				newCost += node->m_area;
+				newCost += list[i]->m_area;
 			}
 		} while (newCost < (prevCost * dFloat32 (0.9999f)));
 
-		root = list.GetLast()->GetInfo();
+		root = list[list.GetCount() - 1];
 		while (root->m_parent) 
 		{
 			root = root->m_parent;
 		}
 	}
 
-	dList<dgNodeBuilder*> list;
-	list.Append(root);
+	// breadth first enumeration, the queue is an array with a read cursor
+	dArray<dgNodeBuilder*> queue;
+	queue.PushBack(root);
 	dInt32 nodeIndex = 0;
-	while (list.GetCount())
+	for (dInt32 i = 0; i < queue.GetCount(); i ++)
 	{
-		dgNodeBuilder* const node = list.GetFirst()->GetInfo();
-		list.Remove(list.GetFirst());
-
+		dgNodeBuilder* const node = queue[i];
 		if (node->m_left) 
 		{
 			node->m_enumeration = nodeIndex;
 			nodeIndex ++;
 			dAssert (node->m_right);
-			list.Append(node->m_left);
-			list.Append(node->m_right);
+			queue.PushBack(node->m_left);
+			queue.PushBack(node->m_right);
 		}
 	}
-	dAssert(!list.GetCount());
 
 	dInt32 aabbBase = builder.m_vertexPoints.GetCount() + builder.m_normalPoints.GetCount();
 
@@ -1084,12 +1362,10 @@ void dAabbPolygonSoup::Create (const dPolygonSoupBuilder& builder)
 
 	dInt32 vertexIndex = 0;
 	dInt32 aabbNodeIndex = 0;
-	list.Append(root);
 	dInt32 indexMap = 0;
-	while (list.GetCount())
+	for (dInt32 i = 0; i < queue.GetCount(); i ++)
 	{
-		dgNodeBuilder* const node = list.GetFirst()->GetInfo();
-		list.Remove(list.GetFirst());
+		dgNodeBuilder* const node = queue[i];
 
 		if (node->m_enumeration >= 0)
 		{
@@ -1155,13 +1431,6 @@ void dAabbPolygonSoup::Create (const dPolygonSoupBuilder& builder)
 
 			indexMap += node->m_indexCount * 2 + 3;
 		}
-
-		if (node->m_left) 
-		{
-			dAssert (node->m_right);
-			list.Append(node->m_left);
-			list.Append(node->m_right);
-		}
 	}
 
 	dStack<dInt32> indexArray (vertexIndex);
@@ -1193,6 +1462,81 @@ void dAabbPolygonSoup::Create (const dPolygonSoupBuilder& builder)
 	{
 		m_aabb[0].m_right = dNode::dgLeafNodePtr (0, 0);
 	}
+
+	QuantizeNodes();
+}
+
+void dAabbPolygonSoup::QuantizeNodes()
+{
+	if (!m_aabb)
+	{
+		return;
+	}
+
+	dVector parentBox0[DG_STACK_DEPTH];
+	dVector parentBox1[DG_STACK_DEPTH];
+	dNode* stackPool[DG_STACK_DEPTH];
+	const dTriplex* const vertexArray = (dTriplex*)m_localVertex;
+
+	// the root box is read in full precision by the traversals
+	dInt32 stack = 1;
+	stackPool[0] = m_aabb;
+	GetNodeAABB(m_aabb, parentBox0[0], parentBox1[0]);
+	while (stack)
+	{
+		stack--;
+		const dNode* const me = stackPool[stack];
+		const dVector boxP0 (parentBox0[stack]);
+		const dVector boxP1 (parentBox1[stack]);
+		const dNode::dgLeafNodePtr children[] = { me->m_left, me->m_right };
+		for (dInt32 i = 0; i < 2; i++)
+		{
+			if (!children[i].IsLeaf())
+			{
+				dNode* const node = children[i].GetNode(m_aabb);
+				dVector p0 (&vertexArray[node->m_indexBox0].m_x);
+				dVector p1 (&vertexArray[node->m_indexBox1].m_x);
+				p0 = p0 & dVector::m_triplexMask;
+				p1 = p1 & dVector::m_triplexMask;
+
+				const dVector step (dNode::QuantizedStep(boxP0, boxP1));
+				for (dInt32 j = 0; j < 3; j++)
+				{
+					dInt32 q0 = 0;
+					dInt32 q1 = D_AABB_QUANTIZED_MAX;
+					if (step[j] > dFloat32 (0.0f))
+					{
+						q0 = dClamp(dInt32 (dFloor((p0[j] - boxP0[j]) / step[j])), 0, D_AABB_QUANTIZED_MAX);
+						q1 = dClamp(dInt32 (dCeil((p1[j] - boxP0[j]) / step[j])), 0, D_AABB_QUANTIZED_MAX);
+					}
+					node->m_quantizedBox[j] = dUnsigned16(q0);
+					node->m_quantizedBox[j + 3] = dUnsigned16(q1);
+				}
+
+				// the dequantized box must always enclose the original box, 
+				// nudge the bounds by one step to absorb rounding errors.
+				dVector q0;
+				dVector q1;
+				node->GetQuantizedBox(boxP0, boxP1, q0, q1);
+				for (dInt32 j = 0; j < 3; j++)
+				{
+					if ((q0[j] > p0[j]) && node->m_quantizedBox[j])
+					{
+						node->m_quantizedBox[j] --;
+					}
+					if ((q1[j] < p1[j]) && (node->m_quantizedBox[j + 3] < D_AABB_QUANTIZED_MAX))
+					{
+						node->m_quantizedBox[j + 3] ++;
+					}
+				}
+
+				dAssert(stack < DG_STACK_DEPTH);
+				stackPool[stack] = node;
+				node->GetQuantizedBox(boxP0, boxP1, parentBox0[stack], parentBox1[stack]);
+				stack++;
+			}
+		}
+	}
 }
 
 void dAabbPolygonSoup::Serialize (const char* const path) const
@@ -1200,6 +1544,13 @@ void dAabbPolygonSoup::Serialize (const char* const path) const
 	FILE* const file = fopen(path, "wb");
 	if (file)
 	{
+		const dUnsigned32 tag = D_AABB_POLYGON_SOUP_FILE_TAG;
+		const dInt32 version = D_AABB_POLYGON_SOUP_FILE_VERSION;
+		const dInt32 nodeSize = sizeof(dNode);
+		fwrite(&tag, sizeof(dUnsigned32), 1, file);
+		fwrite(&version, sizeof(dInt32), 1, file);
+		fwrite(&nodeSize, sizeof(dInt32), 1, file);
+
 		fwrite(&m_vertexCount, sizeof(dInt32), 1, file);
 		fwrite(&m_indexCount, sizeof(dInt32), 1, file);
 		fwrite(&m_nodesCount, sizeof(dInt32), 1, file);
@@ -1215,14 +1566,42 @@ void dAabbPolygonSoup::Serialize (const char* const path) const
 
 void dAabbPolygonSoup::Deserialize (const char* const path)
 {
+	m_vertexCount = 0;
+	m_indexCount = 0;
+	m_nodesCount = 0;
+	m_localVertex = nullptr;
+	m_indices = nullptr;
+	m_aabb = nullptr;
+
 	FILE* const file = fopen(path, "rb");
 	if (file)
 	{
 		m_strideInBytes = sizeof(dTriplex);
-		//callback(userData, &m_vertexCount, sizeof(dInt32));
-		//callback(userData, &m_indexCount, sizeof(dInt32));
-		//callback(userData, &m_nodesCount, sizeof(dInt32));
-		fread(&m_vertexCount, sizeof(dInt32), 1, file);
+
+		bool legacyNodes = false;
+		dUnsigned32 tag = 0;
+		fread(&tag, sizeof(dUnsigned32), 1, file);
+		if (tag == D_AABB_POLYGON_SOUP_FILE_TAG)
+		{
+			dInt32 version = 0;
+			dInt32 nodeSize = 0;
+			fread(&version, sizeof(dInt32), 1, file);
+			fread(&nodeSize, sizeof(dInt32), 1, file);
+			if ((version != D_AABB_POLYGON_SOUP_FILE_VERSION) || (nodeSize != sizeof(dNode)))
+			{
+				dTrace(("%s: unsupported polygon soup file version %d, node size %d\n", path, version, nodeSize));
+				dAssert(0);
+				fclose(file);
+				return;
+			}
+			fread(&m_vertexCount, sizeof(dInt32), 1, file);
+		}
+		else
+		{
+			// the old format has no header, the tag is the vertex count.
+			legacyNodes = true;
+			m_vertexCount = dInt32(tag);
+		}
 		fread(&m_indexCount, sizeof(dInt32), 1, file);
 		fread(&m_nodesCount, sizeof(dInt32), 1, file);
 
@@ -1232,18 +1611,33 @@ void dAabbPolygonSoup::Deserialize (const char* const path)
 			m_indices = (dInt32*)dMemory::Malloc(sizeof(dInt32) * m_indexCount);
 			m_aabb = (dNode*)dMemory::Malloc(sizeof(dNode) * m_nodesCount);
 
-			//callback(userData, m_localVertex, dInt32(sizeof(dTriplex) * m_vertexCount));
-			//callback(userData, m_indices, dInt32(sizeof(dInt32) * m_indexCount));
-			//callback(userData, m_aabb, dInt32(sizeof(dNode) * m_nodesCount));
 			fread(m_localVertex, sizeof(dTriplex) * m_vertexCount, 1, file);
 			fread(m_indices, sizeof(dInt32) * m_indexCount, 1, file);
-			fread(m_aabb, sizeof(dNode) * m_nodesCount, 1, file);
+			if (legacyNodes)
+			{
+				// old nodes only have the box indices and the children, 
+				// the quantized boxes are built from the vertex pool.
+				for (dInt32 i = 0; i < m_nodesCount; i++)
+				{
+					dInt32 node[4];
+					fread(node, sizeof(node), 1, file);
+					dNode* const aabbNode = new (&m_aabb[i]) dNode();
+					aabbNode->m_indexBox0 = node[0];
+					aabbNode->m_indexBox1 = node[1];
+					aabbNode->m_left.m_node = dUnsigned32(node[2]);
+					aabbNode->m_right.m_node = dUnsigned32(node[3]);
+				}
+				QuantizeNodes();
+			}
+			else
+			{
+				fread(m_aabb, sizeof(dNode) * m_nodesCount, 1, file);
+			}
 		}
 		else 
 		{
-			m_localVertex = nullptr;
-			m_indices = nullptr;
-			m_aabb = nullptr;
+			m_indexCount = 0;
+			m_nodesCount = 0;
 		}
 
 		fclose(file);
@@ -1402,13 +1796,16 @@ void dAabbPolygonSoup::ForAllSectorsRayHit (const dFastRayTest& raySrc, dFloat32
 {
 	const dNode *stackPool[DG_STACK_DEPTH];
 	dFloat32 distance[DG_STACK_DEPTH];
+	dVector boxPool0[DG_STACK_DEPTH];
+	dVector boxPool1[DG_STACK_DEPTH];
 	dFastRayTest ray (raySrc);
 
 	dInt32 stack = 1;
 	const dTriplex* const vertexArray = (dTriplex*) m_localVertex;
 
 	stackPool[0] = m_aabb;
-	distance[0] = m_aabb->RayDistance(ray, vertexArray);
+	GetNodeAABB(m_aabb, boxPool0[0], boxPool1[0]);
+	distance[0] = ray.BoxIntersect(boxPool0[0], boxPool1[0]);
 	while (stack) 
 	{
 		stack --;
@@ -1420,6 +1817,8 @@ void dAabbPolygonSoup::ForAllSectorsRayHit (const dFastRayTest& raySrc, dFloat32
 		else 
 		{
 			const dNode *const me = stackPool[stack];
+			const dVector boxP0 (boxPool0[stack]);
+			const dVector boxP1 (boxPool1[stack]);
 			if (me->m_left.IsLeaf()) 
 			{
 				dInt32 vCount = dInt32 (me->m_left.GetCount());
@@ -1441,8 +1840,11 @@ void dAabbPolygonSoup::ForAllSectorsRayHit (const dFastRayTest& raySrc, dFloat32
 			} 
 			else 
 			{
+				dVector p0;
+				dVector p1;
 				const dNode* const node = me->m_left.GetNode(m_aabb);
-				dFloat32 dist1 = node->RayDistance(ray, vertexArray);
+				node->GetQuantizedBox(boxP0, boxP1, p0, p1);
+				dFloat32 dist1 = ray.BoxIntersect(p0, p1);
 				if (dist1 < maxParam) 
 				{
 					dInt32 j = stack;
@@ -1450,10 +1852,14 @@ void dAabbPolygonSoup::ForAllSectorsRayHit (const dFastRayTest& raySrc, dFloat32
 					{
 						stackPool[j] = stackPool[j - 1];
 						distance[j] = distance[j - 1];
+						boxPool0[j] = boxPool0[j - 1];
+						boxPool1[j] = boxPool1[j - 1];
 					}
 					dAssert (stack < DG_STACK_DEPTH);
 					stackPool[j] = node;
 					distance[j] = dist1;
+					boxPool0[j] = p0;
+					boxPool1[j] = p1;
 					stack++;
 				}
 			}
@@ -1478,8 +1884,11 @@ void dAabbPolygonSoup::ForAllSectorsRayHit (const dFastRayTest& raySrc, dFloat32
 			} 
 			else 
 			{
+				dVector p0;
+				dVector p1;
 				const dNode* const node = me->m_right.GetNode(m_aabb);
-				dFloat32 dist1 = node->RayDistance(ray, vertexArray);
+				node->GetQuantizedBox(boxP0, boxP1, p0, p1);
+				dFloat32 dist1 = ray.BoxIntersect(p0, p1);
 				if (dist1 < maxParam) 
 				{
 					dInt32 j = stack;
@@ -1487,10 +1896,14 @@ void dAabbPolygonSoup::ForAllSectorsRayHit (const dFastRayTest& raySrc, dFloat32
 					{
 						stackPool[j] = stackPool[j - 1];
 						distance[j] = distance[j - 1];
+						boxPool0[j] = boxPool0[j - 1];
+						boxPool1[j] = boxPool1[j - 1];
 					}
 					dAssert (stack < DG_STACK_DEPTH);
 					stackPool[j] = node;
 					distance[j] = dist1;
+					boxPool0[j] = p0;
+					boxPool1[j] = p1;
 					stack++;
 				}
 			}
@@ -1512,6 +1925,8 @@ void dAabbPolygonSoup::ForAllSectors (const dFastAabbInfo& obbAabbInfo, const dV
 	{
 		dFloat32 distance[DG_STACK_DEPTH];
 		const dNode* stackPool[DG_STACK_DEPTH];
+		dVector boxPool0[DG_STACK_DEPTH];
+		dVector boxPool1[DG_STACK_DEPTH];
 
 		const dInt32 stride = sizeof (dTriplex) / sizeof (dFloat32);
 		const dTriplex* const vertexArray = (dTriplex*) m_localVertex;
@@ -1521,7 +1936,8 @@ void dAabbPolygonSoup::ForAllSectors (const dFastAabbInfo& obbAabbInfo, const dV
 		{
 			dInt32 stack = 1;
 			stackPool[0] = m_aabb;
-			distance[0] = m_aabb->BoxPenetration(obbAabbInfo, vertexArray);
+			GetNodeAABB(m_aabb, boxPool0[0], boxPool1[0]);
+			distance[0] = m_aabb->BoxPenetration(obbAabbInfo, boxPool0[0], boxPool1[0]);
 			if (distance[0] <= dFloat32(0.0f)) 
 			{
 				obbAabbInfo.m_separationDistance = dMin(obbAabbInfo.m_separationDistance[0], -distance[0]);
@@ -1533,6 +1949,8 @@ void dAabbPolygonSoup::ForAllSectors (const dFastAabbInfo& obbAabbInfo, const dV
 				if (dist > dFloat32 (0.0f)) 
 				{
 					const dNode* const me = stackPool[stack];
+					const dVector boxP0 (boxPool0[stack]);
+					const dVector boxP1 (boxPool1[stack]);
 					if (me->m_left.IsLeaf()) 
 					{
 						dInt32 index = dInt32 (me->m_left.GetIndex());
@@ -1561,8 +1979,11 @@ void dAabbPolygonSoup::ForAllSectors (const dFastAabbInfo& obbAabbInfo, const dV
 					} 
 					else 
 					{
+						dVector p0;
+						dVector p1;
 						const dNode* const node = me->m_left.GetNode(m_aabb);
-						dFloat32 dist1 = node->BoxPenetration(obbAabbInfo, vertexArray);
+						node->GetQuantizedBox(boxP0, boxP1, p0, p1);
+						dFloat32 dist1 = node->BoxPenetration(obbAabbInfo, p0, p1);
 						if (dist1 > dFloat32 (0.0f)) 
 						{
 							dInt32 j = stack;
@@ -1570,10 +1991,14 @@ void dAabbPolygonSoup::ForAllSectors (const dFastAabbInfo& obbAabbInfo, const dV
 							{
 								stackPool[j] = stackPool[j - 1];
 								distance[j] = distance[j - 1];
+								boxPool0[j] = boxPool0[j - 1];
+								boxPool1[j] = boxPool1[j - 1];
 							}
 							dAssert (stack < DG_STACK_DEPTH);
 							stackPool[j] = node;
 							distance[j] = dist1;
+							boxPool0[j] = p0;
+							boxPool1[j] = p1;
 							stack++;
 						} 
 						else 
@@ -1610,8 +2035,11 @@ void dAabbPolygonSoup::ForAllSectors (const dFastAabbInfo& obbAabbInfo, const dV
 					} 
 					else 
 					{
+						dVector p0;
+						dVector p1;
 						const dNode* const node = me->m_right.GetNode(m_aabb);
-						dFloat32 dist1 = node->BoxPenetration(obbAabbInfo, vertexArray);
+						node->GetQuantizedBox(boxP0, boxP1, p0, p1);
+						dFloat32 dist1 = node->BoxPenetration(obbAabbInfo, p0, p1);
 						if (dist1 > dFloat32 (0.0f)) 
 						{
 							dInt32 j = stack;
@@ -1619,10 +2047,14 @@ void dAabbPolygonSoup::ForAllSectors (const dFastAabbInfo& obbAabbInfo, const dV
 							{
 								stackPool[j] = stackPool[j - 1];
 								distance[j] = distance[j - 1];
+								boxPool0[j] = boxPool0[j - 1];
+								boxPool1[j] = boxPool1[j - 1];
 							}
 							dAssert (stack < DG_STACK_DEPTH);
 							stackPool[j] = node;
 							distance[j] = dist1;
+							boxPool0[j] = p0;
+							boxPool1[j] = p1;
 							stack++;
 						} 
 						else 
@@ -1639,7 +2071,8 @@ void dAabbPolygonSoup::ForAllSectors (const dFastAabbInfo& obbAabbInfo, const dV
 			dFastRayTest obbRay (dVector (dFloat32 (0.0f)), obbAabbInfo.UnrotateVector(boxDistanceTravel));
 			dInt32 stack = 1;
 			stackPool[0] = m_aabb;
-			distance [0] = m_aabb->BoxIntersect (ray, obbRay, obbAabbInfo, vertexArray);
+			GetNodeAABB(m_aabb, boxPool0[0], boxPool1[0]);
+			distance [0] = m_aabb->BoxIntersect (ray, obbRay, obbAabbInfo, boxPool0[0], boxPool1[0]);
 
 			while (stack) 
 			{
@@ -1648,6 +2081,8 @@ void dAabbPolygonSoup::ForAllSectors (const dFastAabbInfo& obbAabbInfo, const dV
 				const dNode* const me = stackPool[stack];
 				if (dist < dFloat32 (1.0f)) 
 				{
+					const dVector boxP0 (boxPool0[stack]);
+					const dVector boxP1 (boxPool1[stack]);
 					if (me->m_left.IsLeaf()) 
 					{
 						dInt32 index = dInt32 (me->m_left.GetIndex());
@@ -1671,8 +2106,11 @@ void dAabbPolygonSoup::ForAllSectors (const dFastAabbInfo& obbAabbInfo, const dV
 					} 
 					else 
 					{
+						dVector p0;
+						dVector p1;
 						const dNode* const node = me->m_left.GetNode(m_aabb);
-						dFloat32 dist1 = node->BoxIntersect (ray, obbRay, obbAabbInfo, vertexArray);
+						node->GetQuantizedBox(boxP0, boxP1, p0, p1);
+						dFloat32 dist1 = node->BoxIntersect (ray, obbRay, obbAabbInfo, p0, p1);
 						if (dist1 < dFloat32 (1.0f)) 
 						{
 							dInt32 j = stack;
@@ -1680,10 +2118,14 @@ void dAabbPolygonSoup::ForAllSectors (const dFastAabbInfo& obbAabbInfo, const dV
 							{
 								stackPool[j] = stackPool[j - 1];
 								distance[j] = distance[j - 1];
+								boxPool0[j] = boxPool0[j - 1];
+								boxPool1[j] = boxPool1[j - 1];
 							}
 							dAssert (stack < DG_STACK_DEPTH);
 							stackPool[j] = node;
 							distance[j] = dist1;
+							boxPool0[j] = p0;
+							boxPool1[j] = p1;
 							stack++;
 						}
 					}
@@ -1710,8 +2152,11 @@ void dAabbPolygonSoup::ForAllSectors (const dFastAabbInfo& obbAabbInfo, const dV
 					} 
 					else 
 					{
+						dVector p0;
+						dVector p1;
 						const dNode* const node = me->m_right.GetNode(m_aabb);
-						dFloat32 dist1 = node->BoxIntersect (ray, obbRay, obbAabbInfo, vertexArray);
+						node->GetQuantizedBox(boxP0, boxP1, p0, p1);
+						dFloat32 dist1 = node->BoxIntersect (ray, obbRay, obbAabbInfo, p0, p1);
 						if (dist1 < dFloat32 (1.0f)) 
 						{
 							dInt32 j = stack;
@@ -1719,10 +2164,14 @@ void dAabbPolygonSoup::ForAllSectors (const dFastAabbInfo& obbAabbInfo, const dV
 							{
 								stackPool[j] = stackPool[j - 1];
 								distance[j] = distance[j - 1];
+								boxPool0[j] = boxPool0[j - 1];
+								boxPool1[j] = boxPool1[j - 1];
 							}
 							dAssert (stack < DG_STACK_DEPTH);
 							stackPool[j] = node;
 							distance[j] = dist1;
+							boxPool0[j] = p0;
+							boxPool1[j] = p1;
 							stack ++;
 						}
 					}
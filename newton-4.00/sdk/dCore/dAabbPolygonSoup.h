@@ -28,6 +28,14 @@
 #include "dPolygonSoupDatabase.h"
 
 class dPolygonSoupBuilder;
+class dThreadPoolBuilder;
+
+#define D_AABB_QUANTIZED_MAX	0xffff
+
+// serialized files start with this tag, a version and the size of a node.
+// files written before the quantized boxes start with the vertex count instead.
+#define D_AABB_POLYGON_SOUP_FILE_TAG		0xdaab5001
+#define D_AABB_POLYGON_SOUP_FILE_VERSION	1
 
 class dAabbPolygonSoup: public dPolygonSoupDatabase
 {
@@ -97,6 +105,28 @@ class dAabbPolygonSoup: public dPolygonSoupDatabase
 			,m_left(0)
 			,m_right(0)
 		{
+			m_quantizedBox[0] = 0;
+			m_quantizedBox[1] = 0;
+			m_quantizedBox[2] = 0;
+			m_quantizedBox[3] = D_AABB_QUANTIZED_MAX;
+			m_quantizedBox[4] = D_AABB_QUANTIZED_MAX;
+			m_quantizedBox[5] = D_AABB_QUANTIZED_MAX;
+		}
+
+		// the box of each node is quantized relative to the box of its parent, 
+		// traversals carry the parent box in the stack so no vertex pool fetch is needed.
+		inline static dVector QuantizedStep (const dVector& parentP0, const dVector& parentP1)
+		{
+			return (parentP1 - parentP0) * dVector (dFloat32 (1.0f) / dFloat32 (D_AABB_QUANTIZED_MAX - 1));
+		}
+
+		inline void GetQuantizedBox (const dVector& parentP0, const dVector& parentP1, dVector& p0, dVector& p1) const
+		{
+			const dVector step (QuantizedStep (parentP0, parentP1));
+			const dVector q0 ((dFloat32)m_quantizedBox[0], (dFloat32)m_quantizedBox[1], (dFloat32)m_quantizedBox[2], dFloat32 (0.0f));
+			const dVector q1 ((dFloat32)m_quantizedBox[3], (dFloat32)m_quantizedBox[4], (dFloat32)m_quantizedBox[5], dFloat32 (0.0f));
+			p0 = (parentP0 + q0 * step) & dVector::m_triplexMask;
+			p1 = (parentP0 + q1 * step) & dVector::m_triplexMask;
 		}
 
 		inline dFloat32 RayDistance (const dFastRayTest& ray, const dTriplex* const vertexArray) const
@@ -114,6 +144,11 @@ class dAabbPolygonSoup: public dPolygonSoupDatabase
 			dVector p1 (&vertexArray[m_indexBox1].m_x);
 			p0 = p0 & dVector::m_triplexMask;
 			p1 = p1 & dVector::m_triplexMask;
+			return BoxPenetration (obb, p0, p1);
+		}
+
+		inline dFloat32 BoxPenetration (const dFastAabbInfo& obb, const dVector& p0, const dVector& p1) const
+		{
 			dVector minBox (p0 - obb.m_p1);
 			dVector maxBox (p1 - obb.m_p0);
 			dAssert(maxBox.m_x >= minBox.m_x);
@@ -160,7 +195,11 @@ class dAabbPolygonSoup: public dPolygonSoupDatabase
 			dVector p1 (&vertexArray[m_indexBox1].m_x);
 			p0 = p0 & dVector::m_triplexMask;
 			p1 = p1 & dVector::m_triplexMask;
+			return BoxIntersect (ray, obbRay, obb, p0, p1);
+		}
 
+		inline dFloat32 BoxIntersect (const dFastRayTest& ray, const dFastRayTest& obbRay, const dFastAabbInfo& obb, const dVector& p0, const dVector& p1) const
+		{
 			dVector minBox (p0 - obb.m_p1);
 			dVector maxBox (p1 - obb.m_p0);
 			dFloat32 dist = ray.BoxIntersect(minBox, maxBox);
@@ -186,15 +225,22 @@ class dAabbPolygonSoup: public dPolygonSoupDatabase
 		dInt32 m_indexBox1;
 		dgLeafNodePtr m_left;
 		dgLeafNodePtr m_right;
+		dUnsigned16 m_quantizedBox[6];
 	};
 
 	class dgSpliteInfo;
 	class dgNodeBuilder;
+	class dgSubtreeTask;
 
 	D_CORE_API virtual void GetAABB (dVector& p0, dVector& p1) const;
 	D_CORE_API virtual void Serialize (const char* const path) const;
 	D_CORE_API virtual void Deserialize (const char* const path);
 
+	dUnsigned64 GetMemoryUsed() const
+	{
+		return sizeof (dTriplex) * m_vertexCount + sizeof (dInt32) * m_indexCount + sizeof (dNode) * m_nodesCount;
+	}
+
 	protected:
 	D_CORE_API dAabbPolygonSoup ();
 	D_CORE_API virtual ~dAabbPolygonSoup ();
@@ -235,12 +281,14 @@ class dAabbPolygonSoup: public dPolygonSoupDatabase
 
 	private:
 	dgNodeBuilder* BuildTopDown (dgNodeBuilder* const leafArray, dInt32 firstBox, dInt32 lastBox, dgNodeBuilder** const allocator) const;
+	dgNodeBuilder* BuildTopDownParallel (dgNodeBuilder* const leafArray, dInt32 firstBox, dInt32 lastBox, dgNodeBuilder** const allocator, dThreadPoolBuilder* const threadPool) const;
 	dFloat32 CalculateFaceMaxSize (const dVector* const vertex, dInt32 indexCount, const dInt32* const indexArray) const;
 //	static dIntersectStatus CalculateManifoldFaceEdgeNormals (void* const context, const dFloat32* const polygon, dInt32 strideInBytes, const dInt32* const indexArray, dInt32 indexCount);
 	static dIntersectStatus CalculateDisjointedFaceEdgeNormals (void* const context, const dFloat32* const polygon, dInt32 strideInBytes, const dInt32* const indexArray, dInt32 indexCount, dFloat32 hitDistance);
 	static dIntersectStatus CalculateAllFaceEdgeNormalsOld (void* const context, const dFloat32* const polygon, dInt32 strideInBytes, const dInt32* const indexArray, dInt32 indexCount, dFloat32 hitDistance);
 	static dIntersectStatus CalculateAllFaceEdgeNormals(void* const context, const dFloat32* const polygon, dInt32 strideInBytes, const dInt32* const indexArray, dInt32 indexCount, dFloat32 hitDistance);
 	void ImproveNodeFitness (dgNodeBuilder* const node) const;
+	void QuantizeNodes ();
 
 	dInt32 m_nodesCount;
 	dInt32 m_indexCount;
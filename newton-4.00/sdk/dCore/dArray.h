@@ -173,7 +173,7 @@ void dArray<T>::Resize(dInt32 size)
 		{
 			for (dInt32 i = 0; i < m_capacity; i++)
 			{
-				memcpy(&newArray[i], &m_array[i], sizeof(T));
+				memcpy((void*)&newArray[i], &m_array[i], sizeof(T));
 			}
 			dMemory::Free(m_array);
 		}
@@ -188,7 +188,7 @@ void dArray<T>::Resize(dInt32 size)
 		{
 			for (dInt32 i = 0; i < size; i++) 
 			{
-				memcpy(&newArray[i], &m_array[i], sizeof(T));
+				memcpy((void*)&newArray[i], &m_array[i], sizeof(T));
 			}
 			dMemory::Free(m_array);
 		}
@@ -126,6 +126,7 @@ class dgConvexHull3dPointCluster: public dConvexHull3dAABBTreeNode
 dConvexHull3dFace::dConvexHull3dFace()
 {
 	m_mark = 0;
+	m_serial = 0;
 	m_twin[0] = nullptr;
 	m_twin[1] = nullptr;
 	m_twin[2] = nullptr;
@@ -186,6 +187,8 @@ dConvexHull3d::dConvexHull3d ()
 	,m_aabbP0(dBigVector (dFloat64 (0.0f)))
 	,m_aabbP1(dBigVector (dFloat64 (0.0f)))
 	,m_points()
+	,m_freeFaces()
+	,m_faceSerial(0)
 {
 }
 
@@ -196,6 +199,8 @@ dConvexHull3d::dConvexHull3d(const dConvexHull3d& source)
 	,m_aabbP0 (source.m_aabbP0)
 	,m_aabbP1 (source.m_aabbP1)
 	,m_points(source.m_count)
+	,m_freeFaces()
+	,m_faceSerial(0)
 {
 	m_points.SetCount(source.m_count);
 	m_points[m_count-1].m_w = dFloat64 (0.0f);
@@ -229,6 +234,8 @@ dConvexHull3d::dConvexHull3d(const dFloat64* const vertexCloud, dInt32 strideInB
 	,m_aabbP0 (dBigVector::m_zero)
 	,m_aabbP1 (dBigVector::m_zero)
 	,m_points()
+	,m_freeFaces()
+	,m_faceSerial(0)
 {
 	BuildHull (vertexCloud, strideInBytes, count, distTol, maxVertexCount);
 }
@@ -783,9 +790,22 @@ dInt32 dConvexHull3d::SupportVertex (dConvexHull3dAABBTreeNode** const treePoint
 
 dConvexHull3d::dListNode* dConvexHull3d::AddFace (dInt32 i0, dInt32 i1, dInt32 i2)
 {
-	dListNode* const node = Append();
+	// recycle the nodes of deleted faces, quick hull deletes most of the faces it makes
+	dListNode* node = m_freeFaces.GetLast();
+	if (node)
+	{
+		m_freeFaces.Unlink(node);
+		Append(node);
+	}
+	else
+	{
+		node = Append();
+	}
 	dConvexHull3dFace& face = node->GetInfo();
 
+	face.m_mark = 0;
+	face.m_serial = m_faceSerial;
+	m_faceSerial ++;
 	face.m_index[0] = i0;
 	face.m_index[1] = i1;
 	face.m_index[2] = i2;
@@ -794,7 +814,8 @@ dConvexHull3d::dListNode* dConvexHull3d::AddFace (dInt32 i0, dInt32 i1, dInt32 i
 
 void dConvexHull3d::DeleteFace (dListNode* const node)
 {
-	Remove (node);
+	Unlink (node);
+	m_freeFaces.Append (node);
 }
 
 bool dConvexHull3d::Sanity() const
@@ -899,12 +920,31 @@ void dConvexHull3d::CalculateConvexHull3d (dConvexHull3dAABBTreeNode* vertexTree
 	f3->m_twin[1] = (dList<dConvexHull3dFace>::dListNode*)f1Node;
 	f3->m_twin[2] = (dList<dConvexHull3dFace>::dListNode*)f2Node;
 
-	dList<dListNode*> boundaryFaces;
-
-	boundaryFaces.Append(f0Node);
-	boundaryFaces.Append(f1Node);
-	boundaryFaces.Append(f2Node);
-	boundaryFaces.Append(f3Node);
+	// the boundary faces are a queue in a flat array, deleted faces are not removed,
+	// instead they are skipped when they reach the front because they are marked, or 
+	// because the node was recycled by a new face with a different serial number.
+	class dgBoundaryFace
+	{
+		public:
+		dListNode* m_node;
+		dInt32 m_serial;
+	};
+	dArray<dgBoundaryFace> boundaryFaces(1024 + m_count);
+	dInt32 boundaryStart = 0;
+
+	dgBoundaryFace boundaryFace;
+	boundaryFace.m_node = f3Node;
+	boundaryFace.m_serial = f3->m_serial;
+	boundaryFaces.PushBack(boundaryFace);
+	boundaryFace.m_node = f2Node;
+	boundaryFace.m_serial = f2->m_serial;
+	boundaryFaces.PushBack(boundaryFace);
+	boundaryFace.m_node = f1Node;
+	boundaryFace.m_serial = f1->m_serial;
+	boundaryFaces.PushBack(boundaryFace);
+	boundaryFace.m_node = f0Node;
+	boundaryFace.m_serial = f0->m_serial;
+	boundaryFaces.PushBack(boundaryFace);
 	count -= 4;
 	maxVertexCount -= 4;
 	dInt32 currentIndex = 4;
@@ -917,7 +957,7 @@ void dConvexHull3d::CalculateConvexHull3d (dConvexHull3dAABBTreeNode* vertexTree
 	dListNode** const coneList = &stackPool[0];
 	dListNode** const deleteList = &deleteListPool[0];
 
-	while (boundaryFaces.GetCount() && count && (maxVertexCount > 0)) 
+	while ((boundaryStart < boundaryFaces.GetCount()) && count && (maxVertexCount > 0)) 
 	{
 		// my definition of the optimal convex hull of a given vertex count,
 		// is the convex hull formed by a subset of the input vertex that minimizes the volume difference
@@ -933,15 +973,14 @@ void dConvexHull3d::CalculateConvexHull3d (dConvexHull3dAABBTreeNode* vertexTree
 		// yes that is correct, it does not makes a difference if you build a N point hull from 100 vertex
 		// or from 100000 vertex input array.
 
-		#if 0
-			// using stack (faster)
-			dListNode* const faceNode = boundaryFaces.GetFirst()->GetInfo();
-		#else
-			// using a queue (some what slower by better hull when reduced vertex count is desired)
-			dListNode* const faceNode = boundaryFaces.GetLast()->GetInfo();
-		#endif
-
+		// using a queue (some what slower by better hull when reduced vertex count is desired)
+		dListNode* const faceNode = boundaryFaces[boundaryStart].m_node;
 		dConvexHull3dFace* const face = &faceNode->GetInfo();
+		if (face->m_mark || (face->m_serial != boundaryFaces[boundaryStart].m_serial))
+		{
+			boundaryStart ++;
+			continue;
+		}
 		dBigPlane planeEquation (face->GetPlaneEquation (&m_points[0]));
 
 		dInt32 index = SupportVertex (&vertexTree, points, planeEquation);
@@ -1009,9 +1048,11 @@ void dConvexHull3d::CalculateConvexHull3d (dConvexHull3dAABBTreeNode* vertexTree
 					{
 						dInt32 j1 = (j0 == 2) ? 0 : j0 + 1;
 						dListNode* const newNode = AddFace (currentIndex, face1->m_index[j0], face1->m_index[j1]);
-						boundaryFaces.Addtop(newNode);
-
 						dConvexHull3dFace* const newFace = &newNode->GetInfo();
+						boundaryFace.m_node = newNode;
+						boundaryFace.m_serial = newFace->m_serial;
+						boundaryFaces.PushBack(boundaryFace);
+
 						newFace->m_twin[1] = twinNode;
 						for (dInt32 k = 0; k < 3; k ++) 
 						{
@@ -1060,9 +1101,7 @@ void dConvexHull3d::CalculateConvexHull3d (dConvexHull3dAABBTreeNode* vertexTree
 
 			for (dInt32 i = 0; i < deletedCount; i ++) 
 			{
-				dListNode* const node = deleteList[i];
-				boundaryFaces.Remove (node);
-				DeleteFace (node);
+				DeleteFace (deleteList[i]);
 			}
 
 			maxVertexCount --;
@@ -1071,10 +1110,22 @@ void dConvexHull3d::CalculateConvexHull3d (dConvexHull3dAABBTreeNode* vertexTree
 		} 
 		else 
 		{
-			boundaryFaces.Remove (faceNode);
+			boundaryStart ++;
+		}
+
+		if ((boundaryStart > 1024) && (boundaryStart > (boundaryFaces.GetCount() >> 1)))
+		{
+			const dInt32 liveCount = boundaryFaces.GetCount() - boundaryStart;
+			for (dInt32 i = 0; i < liveCount; i ++)
+			{
+				boundaryFaces[i] = boundaryFaces[boundaryStart + i];
+			}
+			boundaryFaces.SetCount(liveCount);
+			boundaryStart = 0;
 		}
 	}
 	m_count = currentIndex;
+	m_freeFaces.RemoveAll();
 }
 
 
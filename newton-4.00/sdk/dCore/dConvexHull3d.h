@@ -52,6 +52,7 @@ class dConvexHull3dFace
 	dInt32 m_index[3]; 
 	private:
 	dInt32 m_mark;
+	dInt32 m_serial;
 	dList<dConvexHull3dFace>::dListNode* m_twin[3];
 	friend class dConvexHull3d;
 };
@@ -103,6 +104,8 @@ class dConvexHull3d: public dClassAlloc, public dList<dConvexHull3dFace>
 	dBigVector m_aabbP0;
 	dBigVector m_aabbP1;
 	dArray<dBigVector> m_points;
+	dList<dConvexHull3dFace> m_freeFaces;
+	dInt32 m_faceSerial;
 } D_GCC_NEWTON_ALIGN_32;
 
 inline dInt32 dConvexHull3d::GetVertexCount() const
@@ -28,6 +28,7 @@
 #include <dTree.h>
 #include <dHeap.h>
 #include <dSort.h>
+#include <dRadixSort.h>
 #include <dTypes.h>
 #include <dArray.h>
 #include <dStack.h>
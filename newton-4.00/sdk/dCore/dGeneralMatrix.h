@@ -25,10 +25,60 @@
 
 #include "dCoreStdafx.h"
 #include "dTypes.h"
+#include "dVector.h"
 #include "dGeneralVector.h"
 
 #define D_LCP_MAX_VALUE dFloat32 (1.0e10f)
 
+// row kernels of the dense factorizations and solvers below.
+// the dFloat32 dot product processes four entries at a time for rows of 
+// D_ROW_DOT_PRODUCT_SIMD_SIZE or more entries, shorter rows run the scalar loop.
+// the compiler already vectorizes the scalar dRowMulAdd loop, a four wide 
+// dVector version was slower at every size (see ndTest -bench).
+#define D_ROW_DOT_PRODUCT_SIMD_SIZE	8
+
+template<class T>
+T dRowDotProduct(dInt32 size, const T* const A, const T* const B)
+{
+	return dDotProduct(size, A, B);
+}
+
+// X += A * scale
+template<class T>
+void dRowMulAdd(dInt32 size, T* const X, const T* const A, T scale)
+{
+	for (dInt32 i = 0; i < size; i++)
+	{
+		X[i] = X[i] + A[i] * scale;
+	}
+}
+
+inline dFloat32 dRowDotProductSimd(dInt32 size, const dFloat32* const A, const dFloat32* const B)
+{
+	const dInt32 blockSize = size & -4;
+	dVector acc(dVector::m_zero);
+	for (dInt32 i = 0; i < blockSize; i += 4)
+	{
+		acc = acc.MulAdd(dVector(&A[i]), dVector(&B[i]));
+	}
+
+	dFloat32 val = acc.AddHorizontal().GetScalar();
+	for (dInt32 i = blockSize; i < size; i++)
+	{
+		val += A[i] * B[i];
+	}
+	return val;
+}
+
+template<>
+inline dFloat32 dRowDotProduct(dInt32 size, const dFloat32* const A, const dFloat32* const B)
+{
+	if (size < D_ROW_DOT_PRODUCT_SIMD_SIZE)
+	{
+		return dDotProduct(size, A, B);
+	}
+	return dRowDotProductSimd(size, A, B);
+}
 
 template<class T>
 class dSymmetricConjugateGradientSolver
@@ -213,12 +263,8 @@ bool dCholeskyFactorizationAddRow(dInt32 size, dInt32 stride, dInt32 n, T* const
 	dInt32 base = 0;
 	for (dInt32 j = 0; j <= n; j++) 
 	{
-		T s(0.0f);
 		T* const rowJ = &matrix[base];
-		for (dInt32 k = 0; k < j; k++) 
-		{
-			s += rowN[k] * rowJ[k];
-		}
+		const T s(dRowDotProduct(j, rowN, rowJ));
 
 		if (n == j) 
 		{
@@ -295,24 +341,19 @@ void dSolveCholesky(dInt32 size, dInt32 stride, const T* const choleskyMatrix, T
 	dInt32 rowStart = 0;
 	for (dInt32 i = 0; i < size; i++) 
 	{
-		T acc(0.0f);
 		const T* const row = &choleskyMatrix[rowStart];
-		for (dInt32 j = 0; j < i; j++) 
-		{
-			acc = acc + row[j] * x[j];
-		}
+		const T acc(dRowDotProduct(i, row, x));
 		x[i] = (b[i] - acc) / row[i];
 		rowStart += stride;
 	}
 
+	// the back substitution goes by rows of the lower triangle, so that it reads contiguous memory
 	for (dInt32 i = size - 1; i >= 0; i--) 
 	{
-		T acc = 0.0f;
-		for (dInt32 j = i + 1; j < size; j++) 
-		{
-			acc = acc + choleskyMatrix[stride * j + i] * x[j];
-		}
-		x[i] = (x[i] - acc) / choleskyMatrix[stride * i + i];
+		rowStart -= stride;
+		const T* const row = &choleskyMatrix[rowStart];
+		x[i] = x[i] / row[i];
+		dRowMulAdd(i, x, row, -x[i]);
 	}
 }
 
@@ -23,6 +23,7 @@
 #include "dDebug.h"
 #include "dVector.h"
 #include "dMatrix.h"
+#include "dRadixSort.h"
 #include "dIsoSurface.h"
 
 const dInt32 dIsoSurface::m_edgeTable[256] =
@@ -321,17 +322,296 @@ const dInt32 dIsoSurface::m_triangleTable[256][16] =
 	{ -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 }
 };
 
+// corner offset and axis of the twelve cell edges, edges are indexed
+// by the corner with the smaller coordinates.
+const dInt32 dIsoSurface::m_edgeCorner[12][4] =
+{
+	{ 0, 0, 0, 1 }, { 0, 1, 0, 0 }, { 1, 0, 0, 1 }, { 0, 0, 0, 0 },
+	{ 0, 0, 1, 1 }, { 0, 1, 1, 0 }, { 1, 0, 1, 1 }, { 0, 0, 1, 0 },
+	{ 0, 0, 0, 2 }, { 0, 1, 0, 2 }, { 1, 1, 0, 2 }, { 1, 0, 0, 2 },
+};
+
+class dIsoSurface::dPointEntryKey
+{
+	public:
+	dPointEntryKey(void* const)
+	{
+	}
+
+	dUnsigned64 GetKey(const dPointEntry& entry) const
+	{
+		return entry.m_key;
+	}
+};
+
+class dIsoSurface::dBlockKey
+{
+	public:
+	dBlockKey(void* const)
+	{
+	}
+
+	dUnsigned64 GetKey(const dUnsigned64& key) const
+	{
+		return key;
+	}
+};
+
+class dIsoSurface::dBoundaryVertexKey
+{
+	public:
+	dBoundaryVertexKey(void* const)
+	{
+	}
+
+	dUnsigned64 GetKey(const dBoundaryVertex& entry) const
+	{
+		return entry.m_edgeKey;
+	}
+};
+
+class dIsoSurface::dIsoSurfaceJob: public dThreadPoolJob
+{
+	public:
+	dIsoSurfaceJob()
+		:dThreadPoolJob()
+		,m_owner(nullptr)
+		,m_index(0)
+		,m_threadCount(1)
+	{
+	}
+
+	void GetRange(dInt32 count, dInt32& start, dInt32& batchSize) const
+	{
+		const dInt32 step = count / m_threadCount;
+		start = m_index * step;
+		batchSize = ((m_index + 1) < m_threadCount) ? step : count - start;
+	}
+
+	dIsoSurface* m_owner;
+	dInt32 m_index;
+	dInt32 m_threadCount;
+};
+
+class dIsoSurface::dPolygonizeBlock: public dIsoSurface::dIsoSurfaceJob
+{
+	public:
+	virtual void Execute()
+	{
+		D_TRACKTIME();
+		dIsoSurface* const me = m_owner;
+		dThreadBuffer& buffer = me->m_threadBuffers[m_index];
+		buffer.m_points.SetCount(0);
+		buffer.m_indices.SetCount(0);
+		buffer.m_boundary.SetCount(0);
+
+		const dInt32 blockCount = me->m_blocks.GetCount();
+		for (dInt32 i = me->m_blockIterator.fetch_add(1); i < blockCount; i = me->m_blockIterator.fetch_add(1))
+		{
+			Polygonize(me->m_blocks[i], buffer);
+		}
+	}
+
+	// first cell at or after z, y, x
+	static dInt32 LowerBound(const dGridCell* const cells, dInt32 start, dInt32 end, dInt32 z, dInt32 y, dInt32 x)
+	{
+		while (start < end)
+		{
+			const dInt32 middle = (start + end) >> 1;
+			const dGridCell& cell = cells[middle];
+			const bool less = (cell.m_z < z) || ((cell.m_z == z) && ((cell.m_y < y) || ((cell.m_y == y) && (cell.m_x < x))));
+			if (less)
+			{
+				start = middle + 1;
+			}
+			else
+			{
+				end = middle;
+			}
+		}
+		return start;
+	}
+
+	void Polygonize(const dBlock& block, dThreadBuffer& buffer) const
+	{
+		const dInt32 size = D_ISO_BLOCK_SIZE + 1;
+		dFloat32 values[size][size][size];
+		dInt32 vertexIndex[size][size][size][3];
+		memset(values, 0, sizeof(values));
+		memset(vertexIndex, -1, sizeof(vertexIndex));
+
+		const dIsoSurface* const me = m_owner;
+		const dInt32 x0 = block.m_x * D_ISO_BLOCK_SIZE;
+		const dInt32 y0 = block.m_y * D_ISO_BLOCK_SIZE;
+		const dInt32 z0 = block.m_z * D_ISO_BLOCK_SIZE;
+		const dVector origin(me->m_origin);
+		const dVector invGridSize(dFloat32(1.0f) / me->m_gridSize);
+
+		// sample the field at the block corners, each point only reaches the corners of its cell,
+		// so the cells from one before the first to one past the last of the block are visited.
+		// The cells of each row along x are consecutive in the grid, and the rows are in grid order.
+		const dGridCell* const cells = me->m_cells;
+		const dInt32 cellCount = me->m_cellCount;
+		const char* const pointIndex = (const char*)me->m_pointIndex;
+		const dInt32 stride = me->m_pointIndexStride;
+		dInt32 rowStart = 0;
+		for (dInt32 iz = dMax(z0 - 1, 0); iz <= (z0 + D_ISO_BLOCK_SIZE); iz++)
+		{
+			for (dInt32 iy = dMax(y0 - 1, 0); iy <= (y0 + D_ISO_BLOCK_SIZE); iy++)
+			{
+				rowStart = LowerBound(cells, rowStart, cellCount, iz, iy, dMax(x0 - 1, 0));
+				for (dInt32 j = rowStart; (j < cellCount) && (cells[j].m_z == iz) && (cells[j].m_y == iy) && (cells[j].m_x <= (x0 + D_ISO_BLOCK_SIZE)); j++)
+				{
+					const dGridCell& cell = cells[j];
+					const dInt32 ix = cell.m_x - x0;
+					const dInt32 iy0 = iy - y0;
+					const dInt32 iz0 = iz - z0;
+					const bool inside = (dUnsigned32(ix) < D_ISO_BLOCK_SIZE) && (dUnsigned32(iy0) < D_ISO_BLOCK_SIZE) && (dUnsigned32(iz0) < D_ISO_BLOCK_SIZE);
+					for (dInt32 k = 0; k < cell.m_count; k++)
+					{
+						const dInt32 index = *((const dInt32*)&pointIndex[(cell.m_start + k) * stride]);
+						const dVector r((me->m_cloud[index] - origin) * invGridSize);
+						if (inside)
+						{
+							// all eight corners are in the block, splat the four corners of each face at once
+							const dVector corner(dFloat32(x0 + ix), dFloat32(y0 + iy0), dFloat32(z0 + iz0), dFloat32(0.0f));
+							const dVector dist(r - corner);
+							const dVector dx(dist.m_x, dist.m_x - dFloat32(1.0f), dist.m_x, dist.m_x - dFloat32(1.0f));
+							const dVector dy(dist.m_y, dist.m_y, dist.m_y - dFloat32(1.0f), dist.m_y - dFloat32(1.0f));
+							const dVector dist2(dx * dx + dy * dy);
+							const dFloat32 dz0 = dist.m_z;
+							const dFloat32 dz1 = dist.m_z - dFloat32(1.0f);
+							const dVector weight0((dVector::m_one - dist2 - dVector(dz0 * dz0)).GetMax(dVector::m_zero));
+							const dVector weight1((dVector::m_one - dist2 - dVector(dz1 * dz1)).GetMax(dVector::m_zero));
+							const dVector w0(weight0 * weight0 * weight0);
+							const dVector w1(weight1 * weight1 * weight1);
+							values[iz0 + 0][iy0 + 0][ix + 0] += w0.m_x;
+							values[iz0 + 0][iy0 + 0][ix + 1] += w0.m_y;
+							values[iz0 + 0][iy0 + 1][ix + 0] += w0.m_z;
+							values[iz0 + 0][iy0 + 1][ix + 1] += w0.m_w;
+							values[iz0 + 1][iy0 + 0][ix + 0] += w1.m_x;
+							values[iz0 + 1][iy0 + 0][ix + 1] += w1.m_y;
+							values[iz0 + 1][iy0 + 1][ix + 0] += w1.m_z;
+							values[iz0 + 1][iy0 + 1][ix + 1] += w1.m_w;
+							continue;
+						}
+						for (dInt32 z = dMax(iz0, 0); (z <= (iz0 + 1)) && (z < size); z++)
+						{
+							const dFloat32 dz = r.m_z - dFloat32(z0 + z);
+							for (dInt32 y = dMax(iy0, 0); (y <= (iy0 + 1)) && (y < size); y++)
+							{
+								const dFloat32 dy = r.m_y - dFloat32(y0 + y);
+								for (dInt32 x = dMax(ix, 0); (x <= (ix + 1)) && (x < size); x++)
+								{
+									const dFloat32 dx = r.m_x - dFloat32(x0 + x);
+									const dFloat32 weight = dFloat32(1.0f) - (dx * dx + dy * dy + dz * dz);
+									if (weight > dFloat32(0.0f))
+									{
+										values[z][y][x] += weight * weight * weight;
+									}
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+
+		const dFloat32 isoValue = me->m_isoValue;
+		const dFloat32 gridSize = me->m_gridSize;
+		for (dInt32 z = 0; z < D_ISO_BLOCK_SIZE; z++)
+		{
+			for (dInt32 y = 0; y < D_ISO_BLOCK_SIZE; y++)
+			{
+				for (dInt32 x = 0; x < D_ISO_BLOCK_SIZE; x++)
+				{
+					dInt32 tableIndex = 0;
+					tableIndex |= (values[z + 0][y + 0][x + 0] > isoValue) ? 1 : 0;
+					tableIndex |= (values[z + 0][y + 1][x + 0] > isoValue) ? 2 : 0;
+					tableIndex |= (values[z + 0][y + 1][x + 1] > isoValue) ? 4 : 0;
+					tableIndex |= (values[z + 0][y + 0][x + 1] > isoValue) ? 8 : 0;
+					tableIndex |= (values[z + 1][y + 0][x + 0] > isoValue) ? 16 : 0;
+					tableIndex |= (values[z + 1][y + 1][x + 0] > isoValue) ? 32 : 0;
+					tableIndex |= (values[z + 1][y + 1][x + 1] > isoValue) ? 64 : 0;
+					tableIndex |= (values[z + 1][y + 0][x + 1] > isoValue) ? 128 : 0;
+					if (!m_edgeTable[tableIndex])
+					{
+						continue;
+					}
+
+					const dInt32* const triangles = m_triangleTable[tableIndex];
+					for (dInt32 i = 0; triangles[i] != -1; i++)
+					{
+						const dInt32* const edge = m_edgeCorner[triangles[i]];
+						const dInt32 cx = x + edge[0];
+						const dInt32 cy = y + edge[1];
+						const dInt32 cz = z + edge[2];
+						const dInt32 axis = edge[3];
+						dInt32& vertex = vertexIndex[cz][cy][cx][axis];
+						if (vertex < 0)
+						{
+							const dFloat32 value0 = values[cz][cy][cx];
+							const dFloat32 value1 = values[cz + (axis == 2)][cy + (axis == 1)][cx + (axis == 0)];
+							const dFloat32 t = (isoValue - value0) / (value1 - value0);
+							const dFloat32 px = dFloat32(x0 + cx) + ((axis == 0) ? t : dFloat32(0.0f));
+							const dFloat32 py = dFloat32(y0 + cy) + ((axis == 1) ? t : dFloat32(0.0f));
+							const dFloat32 pz = dFloat32(z0 + cz) + ((axis == 2) ? t : dFloat32(0.0f));
+							const dVector point(origin + dVector(px, py, pz, dFloat32(0.0f)).Scale(gridSize));
+
+							vertex = buffer.m_points.GetCount();
+							buffer.m_points.PushBack(point & dVector::m_triplexMask);
+
+							const bool onFaceX = (axis != 0) && ((cx == 0) || (cx == D_ISO_BLOCK_SIZE));
+							const bool onFaceY = (axis != 1) && ((cy == 0) || (cy == D_ISO_BLOCK_SIZE));
+							const bool onFaceZ = (axis != 2) && ((cz == 0) || (cz == D_ISO_BLOCK_SIZE));
+							if (onFaceX || onFaceY || onFaceZ)
+							{
+								// blocks start one block before the grid, the corners are offset to be positive.
+								dBoundaryVertex boundary;
+								const dUnsigned64 cornerX = dUnsigned64(x0 + cx + D_ISO_BLOCK_SIZE);
+								const dUnsigned64 cornerY = dUnsigned64(y0 + cy + D_ISO_BLOCK_SIZE);
+								const dUnsigned64 cornerZ = dUnsigned64(z0 + cz + D_ISO_BLOCK_SIZE);
+								const dUnsigned64 corner = (cornerZ * me->m_cornersY + cornerY) * me->m_cornersX + cornerX;
+								boundary.m_edgeKey = corner * 3 + dUnsigned64(axis);
+								boundary.m_vertex = vertex;
+								buffer.m_boundary.PushBack(boundary);
+							}
+						}
+						buffer.m_indices.PushBack(vertex);
+					}
+				}
+			}
+		}
+	}
+};
+
 dIsoSurface::dIsoSurface()
 	:m_origin(dVector::m_zero)
 	,m_points(1024)
 	,m_normals(1024)
 	,m_trianglesList(1024)
-	,m_vertexMap()
-	,m_xCellSize(0)
-	,m_yCellSize(0)
-	,m_zCellSize(0)
+	,m_pointEntries()
+	,m_pointEntriesScratch()
+	,m_gridCells()
+	,m_blocks()
+	,m_blockKeys()
+	,m_blockKeysScratch()
+	,m_boundary()
+	,m_boundaryScratch()
+	,m_remap()
+	,m_cloud(nullptr)
+	,m_cells(nullptr)
+	,m_pointIndex(nullptr)
+	,m_pointIndexStride(0)
+	,m_cloudCount(0)
+	,m_cellCount(0)
 	,m_gridSize(dFloat32 (0.0f))
 	,m_isoValue(dFloat32(0.0f))
+	,m_cellsX(0)
+	,m_cellsY(0)
+	,m_cornersX(0)
+	,m_cornersY(0)
+	,m_blockIterator(0)
 {
 }
 
@@ -339,258 +619,405 @@ dIsoSurface::~dIsoSurface()
 {
 }
 
-void dIsoSurface::Begin(const dVector& origin, dFloat32 isovalue, dFloat32 gridSize, dInt32 sizex, dInt32 sizey, dInt32 sizez)
+template <class dJob>
+void dIsoSurface::SubmitJobs(dThreadPool* const threadPool, dInt32 threadCount)
 {
-	m_origin = origin & dVector::m_triplexMask;
-	m_xCellSize = sizex;
-	m_yCellSize = sizey;
-	m_zCellSize = sizez;
-	m_gridSize = gridSize;
-	m_isoValue = isovalue;
+	dJob jobs[D_MAX_THREADS_COUNT];
+	dThreadPoolJob* jobsPtr[D_MAX_THREADS_COUNT];
+	for (dInt32 i = 0; i < threadCount; i++)
+	{
+		jobs[i].m_owner = this;
+		jobs[i].m_index = i;
+		jobs[i].m_threadCount = threadCount;
+		jobsPtr[i] = &jobs[i];
+	}
 
+	if (threadCount > 1)
+	{
+		threadPool->ExecuteJobs(jobsPtr);
+	}
+	else
+	{
+		jobs[0].Execute();
+	}
+}
+
+void dIsoSurface::GenerateMesh(dThreadPool* const threadPool, const dVector* const points, dInt32 pointCount, dFloat32 gridSize, dFloat32 isoValue)
+{
+	D_TRACKTIME();
+	dAssert(gridSize > dFloat32(0.0f));
 	m_points.SetCount(0);
+	m_normals.SetCount(0);
 	m_trianglesList.SetCount(0);
+	if (!pointCount)
+	{
+		return;
+	}
+
+	m_cloud = points;
+	m_cloudCount = pointCount;
+	m_gridSize = gridSize;
+
+	const dInt32 threadCount = threadPool ? threadPool->GetCount() : 1;
+	CalculateBounds(threadPool, threadCount);
+	BinPoints(threadPool, threadCount);
+	GenerateMesh(threadPool, points, &m_gridCells[0], m_gridCells.GetCount(), &m_pointEntries[0].m_point, sizeof(dPointEntry), m_origin, gridSize, isoValue);
 }
 
-void dIsoSurface::End()
+void dIsoSurface::GenerateMesh(dThreadPool* const threadPool, const dVector* const points, const dGridCell* const cells, dInt32 cellCount,
+	const dInt32* const pointIndex, dInt32 strideInBytes, const dVector& origin, dFloat32 gridSize, dFloat32 isoValue)
 {
-	RemapIndexList();
+	D_TRACKTIME();
+	dAssert(gridSize > dFloat32(0.0f));
+	dAssert(isoValue > dFloat32(0.0f));
+
+	m_points.SetCount(0);
+	m_normals.SetCount(0);
+	m_trianglesList.SetCount(0);
+	if (!cellCount)
+	{
+		return;
+	}
+
+	m_cloud = points;
+	m_cells = cells;
+	m_cellCount = cellCount;
+	m_pointIndex = pointIndex;
+	m_pointIndexStride = strideInBytes;
+	m_origin = origin & dVector::m_triplexMask;
+	m_gridSize = gridSize;
+	m_isoValue = isoValue;
+
+	const dInt32 threadCount = threadPool ? threadPool->GetCount() : 1;
+	FindBlocks(threadPool, threadCount);
+	PolygonizeBlocks(threadPool, threadCount);
+	WeldVertices(threadPool, threadCount);
 	CalculateNormals();
 }
 
-dUnsigned64 dIsoSurface::GetVertexID(dInt32 gridX, dInt32 gridY, dInt32 gridZ)
+void dIsoSurface::CalculateBounds(dThreadPool* const threadPool, dInt32 threadCount)
 {
-	//return 3 * (gridZ*(m_nCellsY + 1)*(m_nCellsX + 1) + gridY*(m_nCellsX + 1) + gridX);
-	return 3 * (m_xCellSize * dUnsigned64(gridZ * m_yCellSize + gridY) + gridX);
-}
+	D_TRACKTIME();
+	class dCalculateBounds: public dIsoSurfaceJob
+	{
+		public:
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			dInt32 start;
+			dInt32 count;
+			dIsoSurface* const me = m_owner;
+			GetRange(me->m_cloudCount, start, count);
 
-dUnsigned64 dIsoSurface::GetEdgeID(const dIsoCell& cell, dInt32 edgeCode)
-{
-	const dInt32 gridX = cell.m_x;
-	const dInt32 gridY = cell.m_y;
-	const dInt32 gridZ = cell.m_z;
-	switch (edgeCode)
-	{
-		case 0:
-			return GetVertexID(gridX, gridY, gridZ) + 1;
-		case 1:
-			return GetVertexID(gridX, gridY + 1, gridZ);
-		case 2:
-			return GetVertexID(gridX + 1, gridY, gridZ) + 1;
-		case 3:
-			return GetVertexID(gridX, gridY, gridZ);
-		case 4:
-			return GetVertexID(gridX, gridY, gridZ + 1) + 1;
-		case 5:
-			return GetVertexID(gridX, gridY + 1, gridZ + 1);
-		case 6:
-			return GetVertexID(gridX + 1, gridY, gridZ + 1) + 1;
-		case 7:
-			return GetVertexID(gridX, gridY, gridZ + 1);
-		case 8:
-			return GetVertexID(gridX, gridY, gridZ) + 2;
-		case 9:
-			return GetVertexID(gridX, gridY + 1, gridZ) + 2;
-		case 10:
-			return GetVertexID(gridX + 1, gridY + 1, gridZ) + 2;
-		case 11:
-			return GetVertexID(gridX + 1, gridY, gridZ) + 2;
-		default:
-			// Invalid edge no.
-			return dUnsigned64 (-1);
+			dVector box0(dFloat32(1.0e15f));
+			dVector box1(dFloat32(-1.0e15f));
+			const dVector* const points = &me->m_cloud[start];
+			for (dInt32 i = 0; i < count; i++)
+			{
+				box0 = box0.GetMin(points[i]);
+				box1 = box1.GetMax(points[i]);
+			}
+			me->m_threadBox[m_index][0] = box0;
+			me->m_threadBox[m_index][1] = box1;
+		}
+	};
+
+	SubmitJobs<dCalculateBounds>(threadPool, threadCount);
+	dVector box0(m_threadBox[0][0]);
+	dVector box1(m_threadBox[0][1]);
+	for (dInt32 i = 1; i < threadCount; i++)
+	{
+		box0 = box0.GetMin(m_threadBox[i][0]);
+		box1 = box1.GetMax(m_threadBox[i][1]);
 	}
-}
 
-dVector dIsoSurface::InterpolateEdge(dFloat32 fX1, dFloat32 fY1, dFloat32 fZ1, dFloat32 fX2, dFloat32 fY2, dFloat32 fZ2, dFloat32 tVal1, dFloat32 tVal2)
-{
-	dFloat32 mu = (m_isoValue - tVal1) / (tVal2 - tVal1);
-	dFloat32 x = fX1 + mu*(fX2 - fX1);
-	dFloat32 y = fY1 + mu*(fY2 - fY1);
-	dFloat32 z = fZ1 + mu*(fZ2 - fZ1);
-	return dVector(x, y, z, dFloat32 (0.0f));
+	// the cell keys are linear indices in the bounding box, so that the sort only sees the bits in use.
+	m_origin = box0 & dVector::m_triplexMask;
+	const dVector cells((((box1 - m_origin) & dVector::m_triplexMask).Scale(dFloat32(1.0f) / m_gridSize)).GetInt());
+	dAssert(cells.m_ix < (1 << 20));
+	dAssert(cells.m_iy < (1 << 20));
+	dAssert(cells.m_iz < (1 << 20));
+	m_cellsX = dInt32(cells.m_ix) + 1;
+	m_cellsY = dInt32(cells.m_iy) + 1;
 }
 
-dVector dIsoSurface::CalculateIntersection(const dIsoCell& cell, dInt32 edgeCode)
+void dIsoSurface::BinPoints(dThreadPool* const threadPool, dInt32 threadCount)
 {
-	dInt32 v1x = cell.m_x;
-	dInt32 v1y = cell.m_y;
-	dInt32 v1z = cell.m_z;
-	dInt32 v2x = cell.m_x;
-	dInt32 v2y = cell.m_y;
-	dInt32 v2z = cell.m_z;
-
-	switch (edgeCode)
-	{
-		case 0:
-			v2y += 1;
-			break;
-		case 1:
-			v1y += 1;
-			v2x += 1;
-			v2y += 1;
-			break;
-		case 2:
-			v1x += 1;
-			v1y += 1;
-			v2x += 1;
-			break;
-		case 3:
-			v1x += 1;
-			break;
-		case 4:
-			v1z += 1;
-			v2y += 1;
-			v2z += 1;
-			break;
-		case 5:
-			v1y += 1;
-			v1z += 1;
-			v2x += 1;
-			v2y += 1;
-			v2z += 1;
-			break;
-		case 6:
-			v1x += 1;
-			v1y += 1;
-			v1z += 1;
-			v2x += 1;
-			v2z += 1;
-			break;
-		case 7:
-			v1x += 1;
-			v1z += 1;
-			v2z += 1;
-			break;
-		case 8:
-			v2z += 1;
-			break;
-		case 9:
-			v1y += 1;
-			v2y += 1;
-			v2z += 1;
-			break;
-		case 10:
-			v1x += 1;
-			v1y += 1;
-			v2x += 1;
-			v2y += 1;
-			v2z += 1;
-			break;
-		case 11:
-			v1x += 1;
-			v2x += 1;
-			v2z += 1;
-			break;
-	}
+	D_TRACKTIME();
+	class dAddPointEntries: public dIsoSurfaceJob
+	{
+		public:
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			dInt32 start;
+			dInt32 count;
+			dIsoSurface* const me = m_owner;
+			GetRange(me->m_cloudCount, start, count);
+
+			const dVector origin(me->m_origin);
+			const dVector invGridSize(dFloat32(1.0f) / me->m_gridSize);
+			const dVector* const points = &me->m_cloud[start];
+			dPointEntry* const entries = &me->m_pointEntries[start];
+			for (dInt32 i = 0; i < count; i++)
+			{
+				const dVector cell(((points[i] - origin) * invGridSize).GetInt());
+				entries[i].m_key = (dUnsigned64(cell.m_iz) * me->m_cellsY + dUnsigned64(cell.m_iy)) * me->m_cellsX + dUnsigned64(cell.m_ix);
+				entries[i].m_point = start + i;
+			}
+		}
+	};
 
-	dFloat32 x1 = v1x * m_gridSize;
-	dFloat32 y1 = v1y * m_gridSize;
-	dFloat32 z1 = v1z * m_gridSize;
-	dFloat32 x2 = v2x * m_gridSize;
-	dFloat32 y2 = v2y * m_gridSize;
-	dFloat32 z2 = v2z * m_gridSize;
+	m_pointEntries.SetCount(m_cloudCount);
+	m_pointEntriesScratch.SetCount(m_cloudCount);
+	SubmitJobs<dAddPointEntries>(threadPool, threadCount);
+	dParallelRadixSort<dPointEntry, dPointEntryKey>((threadCount > 1) ? threadPool : nullptr, &m_pointEntries[0], &m_pointEntriesScratch[0], m_cloudCount);
 
-	dFloat32 val1 = cell.m_isoValues[v1z-cell.m_z][v1y-cell.m_y][v1x-cell.m_x];
-	dFloat32 val2 = cell.m_isoValues[v2z - cell.m_z][v2y - cell.m_y][v2x - cell.m_x];
-	return InterpolateEdge(x1, y1, z1, x2, y2, z2, val1, val2);
+	m_gridCells.SetCount(0);
+	for (dInt32 i = 0; i < m_cloudCount;)
+	{
+		const dUnsigned64 key = m_pointEntries[i].m_key;
+		dGridCell cell;
+		cell.m_x = dInt32(key % m_cellsX);
+		cell.m_y = dInt32((key / m_cellsX) % m_cellsY);
+		cell.m_z = dInt32(key / (dUnsigned64(m_cellsX) * m_cellsY));
+		cell.m_start = i;
+		for (i++; (i < m_cloudCount) && (m_pointEntries[i].m_key == key); i++);
+		cell.m_count = i - cell.m_start;
+		m_gridCells.PushBack(cell);
+	}
 }
 
-void dIsoSurface::ProcessCell(const dIsoCell& cell)
+void dIsoSurface::FindBlocks(dThreadPool* const threadPool, dInt32 threadCount)
 {
-	dAssert(cell.m_x < m_xCellSize - 1);
-	dAssert(cell.m_y < m_yCellSize - 1);
-	dAssert(cell.m_z < m_zCellSize - 1);
-
-	dInt32 tableIndex = 0;
-	if (cell.m_isoValues[0][0][0] > m_isoValue)
-		tableIndex |= 1;
-	if (cell.m_isoValues[0][1][0] > m_isoValue)
-		tableIndex |= 2;
-	if (cell.m_isoValues[0][1][1] > m_isoValue)
-		tableIndex |= 4;
-	if (cell.m_isoValues[0][0][1] > m_isoValue)
-		tableIndex |= 8;
-	if (cell.m_isoValues[1][0][0] > m_isoValue)
-		tableIndex |= 16;
-	if (cell.m_isoValues[1][1][0] > m_isoValue)
-		tableIndex |= 32;
-	if (cell.m_isoValues[1][1][1] > m_isoValue)
-		tableIndex |= 64;
-	if (cell.m_isoValues[1][0][1] > m_isoValue)
-		tableIndex |= 128;
-
-	// Now create a triangulation of the iso surface in this cell.
-	dInt32 edgeBits = m_edgeTable[tableIndex];
-	if (edgeBits != 0)
-	{
-		if (edgeBits & 8)
-		{
-			dVector pt (CalculateIntersection(cell, 3));
-			dUnsigned64 id = GetEdgeID(cell, 3);
-			dAssert(!m_vertexMap.Find(id));
-			m_vertexMap.Insert(pt, id);
-		}
-		if (edgeBits & 1)
+	D_TRACKTIME();
+	// the cells of a block need the corners from the first to one past the last cell,
+	// so a cell also adds the adjacent block when it is the first or the last cell of
+	// its block along any axis. Block coordinates start at -1, so they are offset by
+	// one in the keys.
+	class dAddBlockKeys: public dIsoSurfaceJob
+	{
+		public:
+		virtual void Execute()
 		{
-			dVector pt (CalculateIntersection(cell, 0));
-			dUnsigned64 id = GetEdgeID(cell, 0);
-			dAssert(!m_vertexMap.Find(id));
-			m_vertexMap.Insert(pt, id);
+			D_TRACKTIME();
+			dInt32 start;
+			dInt32 count;
+			dIsoSurface* const me = m_owner;
+			GetRange(me->m_cellCount, start, count);
+
+			dArray<dUnsigned64>& blockKeys = me->m_threadBuffers[m_index].m_blockKeys;
+			blockKeys.SetCount(0);
+
+			dInt32 maxX = 0;
+			dInt32 maxY = 0;
+			dInt32 rowY = -1;
+			dInt32 rowZ = -1;
+			dInt32 lastX = 0;
+			const dInt32 mask = D_ISO_BLOCK_SIZE - 1;
+			const dGridCell* const cells = &me->m_cells[start];
+			for (dInt32 i = 0; i < count; i++)
+			{
+				const dGridCell& cell = cells[i];
+				dAssert((cell.m_x >= 0) && (cell.m_y >= 0) && (cell.m_z >= 0));
+				dAssert((cell.m_x < (1 << 20)) && (cell.m_y < (1 << 20)) && (cell.m_z < (1 << 20)));
+				if (!cell.m_count)
+				{
+					continue;
+				}
+				maxX = dMax(maxX, cell.m_x);
+				maxY = dMax(maxY, cell.m_y);
+
+				// the cells of a row are sorted along x, so a row only
+				// adds the blocks past the last one it already added.
+				if ((cell.m_y != rowY) || (cell.m_z != rowZ))
+				{
+					rowY = cell.m_y;
+					rowZ = cell.m_z;
+					lastX = -1;
+				}
+
+				const dInt32 x = cell.m_x / D_ISO_BLOCK_SIZE + 1;
+				const dInt32 y = cell.m_y / D_ISO_BLOCK_SIZE + 1;
+				const dInt32 z = cell.m_z / D_ISO_BLOCK_SIZE + 1;
+				const dInt32 x0 = dMax((cell.m_x & mask) ? x : x - 1, lastX + 1);
+				const dInt32 y0 = (cell.m_y & mask) ? y : y - 1;
+				const dInt32 z0 = (cell.m_z & mask) ? z : z - 1;
+				const dInt32 x1 = ((cell.m_x & mask) == mask) ? x + 1 : x;
+				const dInt32 y1 = ((cell.m_y & mask) == mask) ? y + 1 : y;
+				const dInt32 z1 = ((cell.m_z & mask) == mask) ? z + 1 : z;
+				for (dInt32 ix = x0; ix <= x1; ix++)
+				{
+					for (dInt32 iz = z0; iz <= z1; iz++)
+					{
+						for (dInt32 iy = y0; iy <= y1; iy++)
+						{
+							const dUnsigned64 key = (dUnsigned64(iz) << 40) | (dUnsigned64(iy) << 20) | dUnsigned64(ix);
+							blockKeys.PushBack(key);
+						}
+					}
+				}
+				lastX = dMax(lastX, x1);
+			}
+			me->m_threadBuffers[m_index].m_maxX = maxX;
+			me->m_threadBuffers[m_index].m_maxY = maxY;
 		}
-		if (edgeBits & 256)
+	};
+
+	SubmitJobs<dAddBlockKeys>(threadPool, threadCount);
+
+	dInt32 maxX = 0;
+	dInt32 maxY = 0;
+	dInt32 keyCount = 0;
+	for (dInt32 i = 0; i < threadCount; i++)
+	{
+		maxX = dMax(maxX, m_threadBuffers[i].m_maxX);
+		maxY = dMax(maxY, m_threadBuffers[i].m_maxY);
+		keyCount += m_threadBuffers[i].m_blockKeys.GetCount();
+	}
+
+	// corners of the blocks, from one block before the grid to one block past the last cell
+	m_cornersX = maxX + 3 * D_ISO_BLOCK_SIZE + 1;
+	m_cornersY = maxY + 3 * D_ISO_BLOCK_SIZE + 1;
+
+	m_blockKeys.SetCount(keyCount);
+	m_blockKeysScratch.SetCount(keyCount);
+	keyCount = 0;
+	for (dInt32 i = 0; i < threadCount; i++)
+	{
+		const dArray<dUnsigned64>& blockKeys = m_threadBuffers[i].m_blockKeys;
+		for (dInt32 j = 0; j < blockKeys.GetCount(); j++)
 		{
-			dVector pt (CalculateIntersection(cell, 8));
-			dUnsigned64 id = GetEdgeID(cell, 8);
-			dAssert(!m_vertexMap.Find(id));
-			m_vertexMap.Insert(pt, id);
+			m_blockKeys[keyCount] = blockKeys[j];
+			keyCount++;
 		}
-	
-		for (dInt32 i = 0; m_triangleTable[tableIndex][i] != -1; i += 3)
+	}
+	dParallelRadixSort<dUnsigned64, dBlockKey>((threadCount > 1) ? threadPool : nullptr, &m_blockKeys[0], &m_blockKeysScratch[0], keyCount);
+
+	m_blocks.SetCount(0);
+	const dUnsigned64 mask = (dUnsigned64(1) << 20) - 1;
+	for (dInt32 i = 0; i < keyCount; i++)
+	{
+		if (!i || (m_blockKeys[i] != m_blockKeys[i - 1]))
 		{
-			dIsoTriangle triangle;
-			dUnsigned64 pointID0 = GetEdgeID(cell, m_triangleTable[tableIndex][i + 0]);
-			dUnsigned64 pointID1 = GetEdgeID(cell, m_triangleTable[tableIndex][i + 1]);
-			dUnsigned64 pointID2 = GetEdgeID(cell, m_triangleTable[tableIndex][i + 2]);
-			triangle.m_pointId[0] = pointID0;
-			triangle.m_pointId[1] = pointID1;
-			triangle.m_pointId[2] = pointID2;
-			m_trianglesList.PushBack(triangle);
+			const dUnsigned64 key = m_blockKeys[i];
+			dBlock block;
+			block.m_x = dInt32(key & mask) - 1;
+			block.m_y = dInt32((key >> 20) & mask) - 1;
+			block.m_z = dInt32(key >> 40) - 1;
+			m_blocks.PushBack(block);
 		}
 	}
 }
 
-void dIsoSurface::RemapIndexList()
+void dIsoSurface::PolygonizeBlocks(dThreadPool* const threadPool, dInt32 threadCount)
 {
-	dInt32 nextID = 0;
-
-	// calculate monotonic index list
-	m_points.SetCount(m_vertexMap.GetCount());
-	dIsoVertexMap::Iterator iter(m_vertexMap);
-	for (iter.Begin(); iter; iter++)
-	{
-		dVector& point = iter.GetNode()->GetInfo();
-		m_points[nextID] = point + m_origin;
-		dAssert(m_points[nextID].m_w == dFloat32(0.0f));
-		point.m_w = dFloat32(nextID);
-		nextID ++;
+	D_TRACKTIME();
+	m_blockIterator.store(0);
+	SubmitJobs<dPolygonizeBlock>(threadPool, threadCount);
+}
+
+void dIsoSurface::WeldVertices(dThreadPool* const threadPool, dInt32 threadCount)
+{
+	D_TRACKTIME();
+	class dCopyBuffers: public dIsoSurfaceJob
+	{
+		public:
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			dIsoSurface* const me = m_owner;
+			const dThreadBuffer& buffer = me->m_threadBuffers[m_index];
+			const dInt32* const remap = &me->m_remap[me->m_threadVertexBase[m_index]];
+
+			// welded copies are negative, and are written by the thread that owns the vertex
+			const dInt32 vertexCount = buffer.m_points.GetCount();
+			for (dInt32 i = 0; i < vertexCount; i++)
+			{
+				if (remap[i] >= 0)
+				{
+					me->m_points[remap[i]] = buffer.m_points[i];
+				}
+			}
+
+			const dInt32 indexCount = buffer.m_indices.GetCount();
+			dUnsigned64* const indices = indexCount ? &me->m_trianglesList[me->m_threadTriangleBase[m_index]].m_pointId[0] : nullptr;
+			for (dInt32 i = 0; i < indexCount; i++)
+			{
+				const dInt32 index = remap[buffer.m_indices[i]];
+				indices[i] = dUnsigned64((index >= 0) ? index : -index - 1);
+			}
+		}
+	};
+
+	dInt32 vertexCount = 0;
+	dInt32 triangleCount = 0;
+	dInt32 boundaryCount = 0;
+	for (dInt32 i = 0; i < threadCount; i++)
+	{
+		const dThreadBuffer& buffer = m_threadBuffers[i];
+		m_threadVertexBase[i] = vertexCount;
+		m_threadTriangleBase[i] = triangleCount;
+		vertexCount += buffer.m_points.GetCount();
+		triangleCount += buffer.m_indices.GetCount() / 3;
+		boundaryCount += buffer.m_boundary.GetCount();
+	}
+	if (!vertexCount)
+	{
+		return;
+	}
+
+	// the same vertex is generated by all the blocks that share its edge, 
+	// sort them by edge and map all copies to the first one.
+	m_boundary.SetCount(boundaryCount);
+	m_boundaryScratch.SetCount(boundaryCount);
+	boundaryCount = 0;
+	for (dInt32 i = 0; i < threadCount; i++)
+	{
+		const dThreadBuffer& buffer = m_threadBuffers[i];
+		const dInt32 base = m_threadVertexBase[i];
+		for (dInt32 j = 0; j < buffer.m_boundary.GetCount(); j++)
+		{
+			m_boundary[boundaryCount] = buffer.m_boundary[j];
+			m_boundary[boundaryCount].m_vertex += base;
+			boundaryCount++;
+		}
+	}
+	if (boundaryCount)
+	{
+		dParallelRadixSort<dBoundaryVertex, dBoundaryVertexKey>((threadCount > 1) ? threadPool : nullptr, &m_boundary[0], &m_boundaryScratch[0], boundaryCount);
 	}
 
-	// Now remap triangles.
-	for (dInt32 k = 0; k < m_trianglesList.GetCount(); k++)
+	m_remap.SetCount(vertexCount);
+	for (dInt32 i = 0; i < vertexCount; i++)
 	{
-		for (dInt32 i = 0; i < 3; i++)
+		m_remap[i] = i;
+	}
+	for (dInt32 i = 0; i < boundaryCount;)
+	{
+		const dBoundaryVertex& first = m_boundary[i];
+		for (i++; (i < boundaryCount) && (m_boundary[i].m_edgeKey == first.m_edgeKey); i++)
 		{
-			dIsoVertexMap::dTreeNode* const node = m_vertexMap.Find(m_trianglesList[k].m_pointId[i]);
-			dAssert(node);
-			dInt32 id = dInt32 (node->GetInfo().m_w);
-			m_trianglesList[k].m_pointId[i] = id;
+			dAssert(m_boundary[i].m_vertex > first.m_vertex);
+			m_remap[m_boundary[i].m_vertex] = first.m_vertex;
 		}
 	}
-	m_vertexMap.RemoveAll();
+
+	dInt32 uniqueCount = 0;
+	for (dInt32 i = 0; i < vertexCount; i++)
+	{
+		const dInt32 index = m_remap[i];
+		m_remap[i] = (index == i) ? uniqueCount++ : -m_remap[index] - 1;
+	}
+
+	m_points.SetCount(uniqueCount);
+	m_trianglesList.SetCount(triangleCount);
+	SubmitJobs<dCopyBuffers>(threadPool, threadCount);
 }
 
 void dIsoSurface::CalculateNormals()
 {
+	D_TRACKTIME();
 	m_normals.SetCount(m_points.GetCount());
 
 	// Set all normals to 0.
@@ -618,4 +1045,4 @@ void dIsoSurface::CalculateNormals()
 			m_normals[i] = m_normals[i] * m_normals[i].InvMagSqrt();
 		}
 	}
-}
\ No newline at end of file
+}
@@ -28,37 +28,50 @@
 #include "dCoreStdafx.h"
 #include "dTypes.h"
 #include "dArray.h"
-#include "dTree.h"
+#include "dVector.h"
+#include "dThreadPool.h"
 
+#define D_ISO_BLOCK_SIZE	8
+
+// marching cubes of the density field made by a smooth kernel centered at each
+// point of a cloud. The points are binned in the cells of a grid, and the cells
+// into blocks of D_ISO_BLOCK_SIZE cubed cells. Only the blocks that have points
+// are visited, and each block is sampled and polygonized by one thread. Vertices
+// on the faces shared by two blocks are welded by sorting their edge keys.
 class dIsoSurface: public dClassAlloc
 {
 	public:
-	class dIsoCell
-	{
-		public:
-		dFloat32 m_isoValues[2][2][2];
-		dInt32 m_x;
-		dInt32 m_y;
-		dInt32 m_z;
-	};
-
 	class dIsoTriangle
 	{
 		public:
 		dUnsigned64 m_pointId[3];
 	};
 
-	class dIsoVertexMap: public dTree<dVector, dUnsigned64, dContainersFreeListAlloc<dVector>>
+	// a cell of the grid and its points
+	class dGridCell
 	{
-		public: 
+		public:
+		dInt32 m_x;
+		dInt32 m_y;
+		dInt32 m_z;
+		dInt32 m_start;
+		dInt32 m_count;
 	};
 
 	D_CORE_API dIsoSurface();
 	D_CORE_API ~dIsoSurface();
 
-	D_CORE_API void Begin(const dVector& origin, dFloat32 isovalue, dFloat32 gridSize, dInt32 sizex, dInt32 sizey, dInt32 sizez);
-	D_CORE_API void ProcessCell(const dIsoCell& cell);
-	D_CORE_API void End();
+	// the kernel radius is gridSize and its value at the center is one.
+	// with a null thread pool the mesh is build in the calling thread, otherwise
+	// the pool must be between Begin and End, and be called from the thread that owns it. 
+	D_CORE_API void GenerateMesh(dThreadPool* const threadPool, const dVector* const points, dInt32 pointCount, dFloat32 gridSize, dFloat32 isoValue);
+
+	// same as above, from points that are already binned in a grid of cells of size gridSize
+	// starting at origin. The cells are sorted by z, y and x, their coordinates are not negative,
+	// and each point is inside its cell. The points of a cell are the entries m_start to
+	// m_start + m_count - 1 of an array of point indices, strideInBytes apart.
+	D_CORE_API void GenerateMesh(dThreadPool* const threadPool, const dVector* const points, const dGridCell* const cells, dInt32 cellCount,
+		const dInt32* const pointIndex, dInt32 strideInBytes, const dVector& origin, dFloat32 gridSize, dFloat32 isoValue);
 
 	const dInt32 GetIndexCount() const;
 	const dInt32 GetVertexCount() const;
@@ -67,12 +80,53 @@ class dIsoSurface: public dClassAlloc
 	const dUnsigned64* GetIndexList() const;
 
 	private:
-	dUnsigned64 GetVertexID(dInt32 x, dInt32 y, dInt32 z);
-	dUnsigned64 GetEdgeID(const dIsoCell& cell, dInt32 edgeCode);
-	dVector CalculateIntersection(const dIsoCell& cell, dInt32 edgeCode);
-	dVector InterpolateEdge(dFloat32 fX1, dFloat32 fY1, dFloat32 fZ1, dFloat32 fX2, dFloat32 fY2, dFloat32 fZ2, dFloat32 tVal1, dFloat32 tVal2);
+	class dPointEntry
+	{
+		public:
+		dUnsigned64 m_key;
+		dInt32 m_point;
+	};
+
+	class dBoundaryVertex
+	{
+		public:
+		dUnsigned64 m_edgeKey;
+		dInt32 m_vertex;
+	};
+
+	class dBlock
+	{
+		public:
+		dInt32 m_x;
+		dInt32 m_y;
+		dInt32 m_z;
+	};
+
+	class dThreadBuffer
+	{
+		public:
+		dArray<dVector> m_points;
+		dArray<dInt32> m_indices;
+		dArray<dBoundaryVertex> m_boundary;
+		dArray<dUnsigned64> m_blockKeys;
+		dInt32 m_maxX;
+		dInt32 m_maxY;
+	};
+
+	class dPointEntryKey;
+	class dBlockKey;
+	class dBoundaryVertexKey;
+	class dIsoSurfaceJob;
+	class dPolygonizeBlock;
+
+	template <class dJob>
+	void SubmitJobs(dThreadPool* const threadPool, dInt32 threadCount);
 
-	void RemapIndexList();
+	void CalculateBounds(dThreadPool* const threadPool, dInt32 threadCount);
+	void BinPoints(dThreadPool* const threadPool, dInt32 threadCount);
+	void FindBlocks(dThreadPool* const threadPool, dInt32 threadCount);
+	void PolygonizeBlocks(dThreadPool* const threadPool, dInt32 threadCount);
+	void WeldVertices(dThreadPool* const threadPool, dInt32 threadCount);
 	void CalculateNormals();
 
 	dVector m_origin;
@@ -80,15 +134,37 @@ class dIsoSurface: public dClassAlloc
 	dArray<dVector> m_normals;
 	dArray<dIsoTriangle> m_trianglesList;
 
-	dIsoVertexMap m_vertexMap;
-	dInt32 m_xCellSize;
-	dInt32 m_yCellSize;
-	dInt32 m_zCellSize;
+	dArray<dPointEntry> m_pointEntries;
+	dArray<dPointEntry> m_pointEntriesScratch;
+	dArray<dGridCell> m_gridCells;
+	dArray<dBlock> m_blocks;
+	dArray<dUnsigned64> m_blockKeys;
+	dArray<dUnsigned64> m_blockKeysScratch;
+	dArray<dBoundaryVertex> m_boundary;
+	dArray<dBoundaryVertex> m_boundaryScratch;
+	dArray<dInt32> m_remap;
+	dThreadBuffer m_threadBuffers[D_MAX_THREADS_COUNT];
+	dVector m_threadBox[D_MAX_THREADS_COUNT][2];
+	dInt32 m_threadVertexBase[D_MAX_THREADS_COUNT];
+	dInt32 m_threadTriangleBase[D_MAX_THREADS_COUNT];
+
+	const dVector* m_cloud;
+	const dGridCell* m_cells;
+	const dInt32* m_pointIndex;
+	dInt32 m_pointIndexStride;
+	dInt32 m_cloudCount;
+	dInt32 m_cellCount;
 	dFloat32 m_gridSize;
 	dFloat32 m_isoValue;
+	dInt32 m_cellsX;
+	dInt32 m_cellsY;
+	dInt32 m_cornersX;
+	dInt32 m_cornersY;
+	dAtomic<dInt32> m_blockIterator;
 
 	static const dInt32 m_edgeTable[];
 	static const dInt32 m_triangleTable[][16];
+	static const dInt32 m_edgeCorner[][4];
 };
 
 inline const dInt32 dIsoSurface::GetIndexCount() const
@@ -36,8 +36,8 @@ class dList
 		dListNode (dListNode* const prev, dListNode* const next) 
 			:allocator()
 			,m_info () 
-			,m_prev(prev)
 			,m_next(next)
+			,m_prev(prev)
 		{
 			if (m_prev) 
 			{
@@ -52,8 +52,8 @@ class dList
 		dListNode (const T &info, dListNode* const prev, dListNode* const next) 
 			:allocator()
 			,m_info (info) 
-			,m_prev(prev)
 			,m_next(next)
+			,m_prev(prev)
 		{
 			if (m_prev) 
 			{
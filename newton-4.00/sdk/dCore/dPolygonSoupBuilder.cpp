@@ -28,8 +28,10 @@
 #include "dTypes.h"
 #include "dList.h"
 #include "dTree.h"
+#include "dSort.h"
 #include "dStack.h"
 #include "dPolyhedra.h"
+#include "dThreadPool.h"
 #include "dPolygonSoupBuilder.h"
 
 //#include "dMatrix.h"
@@ -38,53 +40,50 @@
 
 #define DG_POINTS_RUN (512 * 1024)
 
+#define DG_MESH_PARTITION_SIZE (1024 * 4)
+
+// same partition size used by dVertexListToIndexList
+#define DG_WELD_PARTITION_SIZE (1024 * 256)
+
 class dPolygonSoupBuilder::dgFaceInfo
 {
 	public:
 	dInt32 indexCount;
 	dInt32 indexStart;
+	dInt32 faceId;
 };
 
-class dPolygonSoupBuilder::dgFaceBucket: public dList<dgFaceInfo>
+class dPolygonSoupBuilder::dgFaceChunk
 {
-	public: 
-	dgFaceBucket ()
-		:dList<dgFaceInfo>()
-	{
-	}
+	public:
+	dInt32 m_start;
+	dInt32 m_count;
+	dInt32 m_faceId;
 };
 
-class dPolygonSoupBuilder::dgFaceMap: public dTree<dgFaceBucket, dInt32>
+class dPolygonSoupBuilder::dgWeldPartition
 {
 	public:
-	dgFaceMap (dPolygonSoupBuilder& builder)
-		:dTree<dgFaceBucket, dInt32>()
-	{
-		dInt32 polygonIndex = 0;
-		//dInt32 faceCount = builder.m_faceCount;
-		dInt32 faceCount = builder.m_faceVertexCount.GetCount();
-		const dInt32* const faceVertexCounts = &builder.m_faceVertexCount[0];
-		const dInt32* const faceVertexIndex = &builder.m_vertexIndex[0];
-		for (dInt32 i = 0; i < faceCount; i ++) 
-		{
-			dInt32 count = faceVertexCounts[i];
-			dInt32 attribute = faceVertexIndex[polygonIndex + count - 1];
-			
-			dTreeNode* node = Find(attribute);
-			if (!node) 
-			{
-				dgFaceBucket tmp;
-				node = Insert(tmp, attribute);
-			}
+	dInt32 m_start;
+	dInt32 m_count;
+	dInt32 m_base;
+	dInt32 m_uniqueCount;
+};
 
-			dgFaceBucket& bucket = node->GetInfo();
-			dgFaceInfo& face = bucket.Append()->GetInfo();
-			face.indexCount = count;
-			face.indexStart = polygonIndex;
-			polygonIndex += count;
-		}
+template <class T>
+static void dSubmitJobs(dThreadPoolBuilder* const threadPool, void* const context)
+{
+	if (threadPool)
+	{
+		threadPool->SubmitJobs<T>(context);
 	}
-};
+	else
+	{
+		T job;
+		job.m_context = context;
+		job.Execute();
+	}
+}
 
 class dPolygonSoupBuilder::dgPolySoupFilterAllocator: public dPolyhedra
 {
@@ -138,8 +137,14 @@ dPolygonSoupBuilder::dPolygonSoupBuilder ()
 	,m_normalIndex()
 	,m_vertexPoints()
 	,m_normalPoints()
+	,m_threadPool(nullptr)
+	,m_run(DG_POINTS_RUN)
+	,m_packedPoints(0)
+	,m_packedFaces(0)
+	,m_packedIndices(0)
+	,m_threadCount(dThreadPoolBuilder::GetDefaultThreadCount())
+	,m_ownThreadPool(false)
 {
-	m_run = DG_POINTS_RUN;
 }
 
 dPolygonSoupBuilder::dPolygonSoupBuilder (const dPolygonSoupBuilder& source)
@@ -148,8 +153,14 @@ dPolygonSoupBuilder::dPolygonSoupBuilder (const dPolygonSoupBuilder& source)
 	,m_normalIndex()
 	,m_vertexPoints(source.m_vertexPoints.GetCount())
 	,m_normalPoints()
+	,m_threadPool(nullptr)
+	,m_run(DG_POINTS_RUN)
+	,m_packedPoints(0)
+	,m_packedFaces(0)
+	,m_packedIndices(0)
+	,m_threadCount(source.m_threadCount)
+	,m_ownThreadPool(false)
 {
-	m_run = DG_POINTS_RUN;
 	m_faceVertexCount.SetCount(source.m_faceVertexCount.GetCount());
 	m_vertexIndex.SetCount(source.m_vertexIndex.GetCount());
 	m_vertexPoints.SetCount(source.m_vertexPoints.GetCount());
@@ -172,11 +183,237 @@ dPolygonSoupBuilder::dPolygonSoupBuilder (const dPolygonSoupBuilder& source)
 
 dPolygonSoupBuilder::~dPolygonSoupBuilder ()
 {
+	ReleaseThreadPool();
+}
+
+dInt32 dPolygonSoupBuilder::GetThreadCount() const
+{
+	return m_threadCount;
+}
+
+void dPolygonSoupBuilder::SetThreadCount(dInt32 threadCount)
+{
+	threadCount = dClamp(threadCount, 1, D_MAX_THREADS_COUNT);
+	if (threadCount != m_threadCount)
+	{
+		ReleaseThreadPool();
+		m_threadCount = threadCount;
+	}
+}
+
+dThreadPoolBuilder* dPolygonSoupBuilder::GetThreadPool() const
+{
+	return m_threadPool;
+}
+
+void dPolygonSoupBuilder::SetThreadPool(dThreadPoolBuilder* const threadPool)
+{
+	ReleaseThreadPool();
+	m_threadPool = threadPool;
+	if (threadPool)
+	{
+		m_threadCount = threadPool->GetCount();
+	}
+}
+
+void dPolygonSoupBuilder::CreateThreadPool()
+{
+	if (!m_threadPool && (m_threadCount > 1))
+	{
+		m_threadPool = new dThreadPoolBuilder("dPolygonSoupBuilder", m_threadCount);
+		m_ownThreadPool = true;
+	}
+}
+
+void dPolygonSoupBuilder::ReleaseThreadPool()
+{
+	if (m_ownThreadPool)
+	{
+		delete m_threadPool;
+	}
+	m_threadPool = nullptr;
+	m_ownThreadPool = false;
+}
+
+dInt32 dPolygonSoupBuilder::WeldPoints(dBigVector* const points, dInt32 pointCount, dInt32* const indexMap, dFloat64 tolerance) const
+{
+	class dgWeldContext
+	{
+		public:
+		dBigVector* m_points;
+		dBigVector* m_welded;
+		const dInt32* m_order;
+		dInt32* m_weldMap;
+		dInt32* m_indexMap;
+		dgWeldPartition* m_partitions;
+		dFloat64 m_tolerance;
+		dInt32 m_count;
+		dAtomic<dInt32> m_index;
+	};
+
+	class dgWeldPartitions: public dThreadPoolJob
+	{
+		public:
+		virtual void Execute()
+		{
+			dgWeldContext* const context = (dgWeldContext*)m_context;
+			for (dInt32 i = context->m_index.fetch_add(1); i < context->m_count; i = context->m_index.fetch_add(1))
+			{
+				dgWeldPartition& partition = context->m_partitions[i];
+				dBigVector* const welded = &context->m_welded[partition.m_start];
+				const dInt32* const order = &context->m_order[partition.m_start];
+				for (dInt32 j = 0; j < partition.m_count; j++)
+				{
+					welded[j] = context->m_points[order[j]];
+				}
+				partition.m_uniqueCount = dVertexListToIndexList(&welded[0].m_x, sizeof(dBigVector), 3, partition.m_count, &context->m_weldMap[partition.m_start], context->m_tolerance);
+			}
+		}
+		void* m_context;
+	};
+
+	class dgScatterPartitions: public dThreadPoolJob
+	{
+		public:
+		virtual void Execute()
+		{
+			dgWeldContext* const context = (dgWeldContext*)m_context;
+			for (dInt32 i = context->m_index.fetch_add(1); i < context->m_count; i = context->m_index.fetch_add(1))
+			{
+				const dgWeldPartition& partition = context->m_partitions[i];
+				const dBigVector* const welded = &context->m_welded[partition.m_start];
+				for (dInt32 j = 0; j < partition.m_uniqueCount; j++)
+				{
+					context->m_points[partition.m_base + j] = welded[j];
+				}
+				const dInt32* const order = &context->m_order[partition.m_start];
+				const dInt32* const weldMap = &context->m_weldMap[partition.m_start];
+				for (dInt32 j = 0; j < partition.m_count; j++)
+				{
+					context->m_indexMap[order[j]] = partition.m_base + weldMap[j];
+				}
+			}
+		}
+		void* m_context;
+	};
+
+	if (!m_threadPool || (pointCount <= DG_WELD_PARTITION_SIZE))
+	{
+		return dVertexListToIndexList(&points[0].m_x, sizeof(dBigVector), 3, pointCount, indexMap, tolerance);
+	}
+
+	// split the points exactly like dVertexListToIndexList does and weld the 
+	// partitions in parallel, so the result is the same as the serial weld.
+	dArray<dInt32> order(pointCount);
+	order.SetCount(pointCount);
+	for (dInt32 i = 0; i < pointCount; i++)
+	{
+		order[i] = i;
+	}
+
+	dArray<dgWeldPartition> stack;
+	dArray<dgWeldPartition> partitions;
+	dgWeldPartition root;
+	root.m_start = 0;
+	root.m_count = pointCount;
+	stack.PushBack(root);
+	while (stack.GetCount())
+	{
+		const dgWeldPartition partition(stack[stack.GetCount() - 1]);
+		stack.SetCount(stack.GetCount() - 1);
+		if (partition.m_count <= DG_WELD_PARTITION_SIZE)
+		{
+			partitions.PushBack(partition);
+			continue;
+		}
+
+		dInt32* const segment = &order[partition.m_start];
+		const dInt32 count = partition.m_count;
+		dBigVector sum(dBigVector::m_zero);
+		dBigVector sum2(dBigVector::m_zero);
+		for (dInt32 i = 0; i < count; i++)
+		{
+			const dBigVector& p = points[segment[i]];
+			sum += p;
+			sum2 += p * p;
+		}
+
+		const dFloat64 xd = count * sum2.m_x - sum.m_x * sum.m_x;
+		const dFloat64 yd = count * sum2.m_y - sum.m_y * sum.m_y;
+		const dFloat64 zd = count * sum2.m_z - sum.m_z * sum.m_z;
+
+		dInt32 axis = 0;
+		dFloat64 axisVal = sum.m_x / count;
+		if ((yd > xd) && (yd > zd))
+		{
+			axis = 1;
+			axisVal = sum.m_y / count;
+		}
+		if ((zd > xd) && (zd > yd))
+		{
+			axis = 2;
+			axisVal = sum.m_z / count;
+		}
+
+		dInt32 i0 = 0;
+		dInt32 i1 = count - 1;
+		do
+		{
+			for (; points[segment[i0]][axis] < axisVal; i0++);
+			for (; points[segment[i1]][axis] > axisVal; i1--);
+			if (i0 <= i1)
+			{
+				dSwap(segment[i0], segment[i1]);
+				i0++;
+				i1--;
+			}
+		} while (i0 <= i1);
+		dAssert(i0 < count);
+
+		dgWeldPartition left(partition);
+		left.m_count = i0;
+		dgWeldPartition right(partition);
+		right.m_start = partition.m_start + i0;
+		right.m_count = count - i0;
+		stack.PushBack(right);
+		stack.PushBack(left);
+	}
+
+	dArray<dBigVector> welded(pointCount);
+	dArray<dInt32> weldMap(pointCount);
+	welded.SetCount(pointCount);
+	weldMap.SetCount(pointCount);
+
+	dgWeldContext context;
+	context.m_points = points;
+	context.m_welded = &welded[0];
+	context.m_order = &order[0];
+	context.m_weldMap = &weldMap[0];
+	context.m_indexMap = indexMap;
+	context.m_partitions = &partitions[0];
+	context.m_tolerance = tolerance;
+	context.m_count = partitions.GetCount();
+	context.m_index.store(0);
+	dSubmitJobs<dgWeldPartitions>(m_threadPool, &context);
+
+	dInt32 uniqueCount = 0;
+	for (dInt32 i = 0; i < partitions.GetCount(); i++)
+	{
+		partitions[i].m_base = uniqueCount;
+		uniqueCount += partitions[i].m_uniqueCount;
+	}
+
+	context.m_index.store(0);
+	dSubmitJobs<dgScatterPartitions>(m_threadPool, &context);
+	return uniqueCount;
 }
 
 void dPolygonSoupBuilder::Begin()
 {
 	m_run = DG_POINTS_RUN;
+	m_packedPoints = 0;
+	m_packedFaces = 0;
+	m_packedIndices = 0;
 	m_vertexIndex.SetCount(0);
 	m_normalIndex.SetCount(0);
 	m_vertexPoints.SetCount(0);
@@ -311,27 +548,34 @@ void dPolygonSoupBuilder::AddFace(const dFloat32* const vertex, dInt32 strideInB
 
 void dPolygonSoupBuilder::PackArray()
 {
-	dAssert(0);
-	dStack<dInt32> indexMapPool (m_vertexPoints.GetCount());
+	// only weld the points of the faces added since the last pack. Points shared 
+	// with earlier runs are merged by Finalize, so packing stays linear in the input 
+	// and for spatially coherent input only the run is stored beside the welded points.
+	CreateThreadPool();
+	const dInt32 pointBase = m_packedPoints;
+	const dInt32 pointCount = m_vertexPoints.GetCount() - pointBase;
+	dStack<dInt32> indexMapPool (pointCount);
 	dInt32* const indexMap = &indexMapPool[0];
-	dInt32 vertexCount = dVertexListToIndexList (&m_vertexPoints[0].m_x, sizeof (dBigVector), 3, m_vertexPoints.GetCount(), &indexMap[0], dFloat32 (1.0e-6f));
+	dInt32 vertexCount = WeldPoints (&m_vertexPoints[pointBase], pointCount, &indexMap[0], dFloat32 (1.0e-6f));
 
-	dInt32 k = 0;
-	for (dInt32 i = 0; i < m_faceVertexCount.GetCount(); i ++)
+	dInt32 k = m_packedIndices;
+	for (dInt32 i = m_packedFaces; i < m_faceVertexCount.GetCount(); i ++)
 	{
 		dInt32 count = m_faceVertexCount[i] - 1;
 		for (dInt32 j = 0; j < count; j ++) 
 		{
 			dInt32 index = m_vertexIndex[k];
-			index = indexMap[index];
+			index = pointBase + indexMap[index - pointBase];
 			m_vertexIndex[k] = index;
 			k ++;
 		}
 		k ++;
 	}
 
-	m_vertexPoints.Resize(vertexCount);
-	m_vertexPoints.SetCount(vertexCount);
+	m_vertexPoints.SetCount(pointBase + vertexCount);
+	m_packedPoints = m_vertexPoints.GetCount();
+	m_packedFaces = m_faceVertexCount.GetCount();
+	m_packedIndices = m_vertexIndex.GetCount();
 	m_run = DG_POINTS_RUN;
 }
 
@@ -341,10 +585,10 @@ void dPolygonSoupBuilder::Finalize()
 	if (faceCount)
 	{
 		//dStack<dInt32> indexMapPool (m_indexCount + m_vertexCount);
-		dStack<dInt32> indexMapPool(m_vertexIndex.GetCount());
+		dStack<dInt32> indexMapPool(m_vertexPoints.GetCount());
 
 		dInt32* const indexMap = &indexMapPool[0];
-		dInt32 vertexCount = dVertexListToIndexList (&m_vertexPoints[0].m_x, sizeof (dBigVector), 3, m_vertexPoints.GetCount(), &indexMap[0], dFloat32 (1.0e-4f));
+		dInt32 vertexCount = WeldPoints (&m_vertexPoints[0], m_vertexPoints.GetCount(), &indexMap[0], dFloat32 (1.0e-4f));
 		dAssert(vertexCount <= m_vertexPoints.GetCount());
 		m_vertexPoints.SetCount(vertexCount);
 
@@ -538,18 +782,18 @@ void dPolygonSoupBuilder::OptimizeByIndividualFaces()
 
 void dPolygonSoupBuilder::End(bool optimize)
 {
+	CreateThreadPool();
 	if (optimize) 
 	{
-		dPolygonSoupBuilder copy (*this);
-		dgFaceMap faceMap (copy);
+		// move the faces to a source builder, there is no need to copy them
+		dPolygonSoupBuilder source;
+		source.m_threadCount = m_threadCount;
+		source.m_faceVertexCount.Swap(m_faceVertexCount);
+		source.m_vertexIndex.Swap(m_vertexIndex);
+		source.m_vertexPoints.Swap(m_vertexPoints);
 
 		Begin();
-		dgFaceMap::Iterator iter (faceMap);
-		for (iter.Begin(); iter; iter ++) 
-		{
-			const dgFaceBucket& bucket = iter.GetNode()->GetInfo();
-			Optimize(iter.GetNode()->GetKey(), bucket, copy);
-		}
+		Optimize(source);
 	}
 	Finalize();
 
@@ -590,202 +834,269 @@ void dPolygonSoupBuilder::End(bool optimize)
 
 		m_normalIndex.Resize(faceCount);;
 		m_normalIndex.SetCount(faceCount);
-		dInt32 normalCount = dVertexListToIndexList(&m_normalPoints[0].m_x, sizeof(dBigVector), 3, faceCount, &m_normalIndex[0], dFloat32(1.0e-6f));
+		dInt32 normalCount = WeldPoints(&m_normalPoints[0], faceCount, &m_normalIndex[0], dFloat32(1.0e-6f));
 		dAssert(normalCount <= m_normalPoints.GetCount());
 		m_normalPoints.SetCount(normalCount);
 	}
 }
 
-void dPolygonSoupBuilder::Optimize(dInt32 faceId, const dgFaceBucket& faceBucket, const dPolygonSoupBuilder& source)
+void dPolygonSoupBuilder::SplitFaces(dArray<dgFaceInfo>& faceArray, dInt32 start, dInt32 count, dArray<dgFaceChunk>& chunks, const dPolygonSoupBuilder& source) const
 {
-	#define DG_MESH_PARTITION_SIZE (1024 * 4)
-
 	const dInt32* const indexArray = &source.m_vertexIndex[0];
 	const dBigVector* const points = &source.m_vertexPoints[0];
+	dgFaceInfo* const array = &faceArray[0];
+
+	dArray<dgFaceChunk> stack;
+	dgFaceChunk root;
+	root.m_start = start;
+	root.m_count = count;
+	root.m_faceId = array[start].faceId;
+	stack.PushBack(root);
 
-	dVector face[256];
-	dInt32 faceIndex[256];
-	if (faceBucket.GetCount() >= DG_MESH_PARTITION_SIZE) 
+	while (stack.GetCount())
 	{
-		dStack<dgFaceBucket::dListNode*> array(faceBucket.GetCount());
-		dInt32 count = 0;
-		for (dgFaceBucket::dListNode* node = faceBucket.GetFirst(); node; node = node->GetNext()) 
+		const dgFaceChunk segment(stack[stack.GetCount() - 1]);
+		stack.SetCount(stack.GetCount() - 1);
+
+		const dInt32 faceStart = segment.m_start;
+		const dInt32 faceCount = segment.m_count;
+		if (faceCount <= DG_MESH_PARTITION_SIZE)
 		{
-			array[count] = node;
-			count ++;
+			chunks.PushBack(segment);
 		}
-
-		dInt32 stack = 1;
-		dInt32 segments[32][2];
-			
-		segments[0][0] = 0;
-		segments[0][1] = count;
-	
-		while (stack) 
+		else
 		{
-			stack --;
-			dInt32 faceStart = segments[stack][0];
-			dInt32 faceCount = segments[stack][1];
-
-			if (faceCount <= DG_MESH_PARTITION_SIZE) 
+			dBigVector median (dBigVector::m_zero);
+			dBigVector varian (dBigVector::m_zero);
+			for (dInt32 i = 0; i < faceCount; i ++)
 			{
-				dPolygonSoupBuilder tmpBuilder;
-				for (dInt32 i = 0; i < faceCount; i ++) 
+				const dgFaceInfo& faceInfo = array[faceStart + i];
+				dInt32 count1 = faceInfo.indexCount - 1;
+				dInt32 start1 = faceInfo.indexStart;
+				dBigVector p0 (dFloat32 ( 1.0e10f), dFloat32 ( 1.0e10f), dFloat32 ( 1.0e10f), dFloat32 (0.0f));
+				dBigVector p1 (dFloat32 (-1.0e10f), dFloat32 (-1.0e10f), dFloat32 (-1.0e10f), dFloat32 (0.0f));
+				for (dInt32 j = 0; j < count1; j ++)
 				{
-					const dgFaceInfo& faceInfo = array[faceStart + i]->GetInfo();
-
-					dInt32 count1 = faceInfo.indexCount - 1;
-					dInt32 start1 = faceInfo.indexStart;
-					dAssert (faceId == indexArray[start1 + count1]);
-					for (dInt32 j = 0; j < count1; j ++) 
-					{
-						dInt32 index = indexArray[start1 + j];
-						face[j] = points[index];
-						faceIndex[j] = j;
-					}
-					//dInt32 faceIndexCount = count1;
-					//tmpBuilder.AddMesh (&face[0].m_x, count1, sizeof (dVector), 1, &faceIndexCount, &faceIndex[0], &faceId, dGetIdentityMatrix()); 
-					tmpBuilder.AddFaceIndirect(&face[0].m_x, sizeof(dVector), faceId, faceIndex, count1);
+					dInt32 index = indexArray[start1 + j];
+					const dBigVector& p = points[index];
+					dAssert(p.m_w == dFloat32(0.0f));
+					p0 = p0.GetMin(p);
+					p1 = p1.GetMax(p);
 				}
-				tmpBuilder.FinalizeAndOptimize (faceId);
+				dBigVector p ((p0 + p1).Scale (0.5f));
+				median += p;
+				varian += p * p;
+			}
+
+			varian = varian.Scale (dFloat32 (faceCount)) - median * median;
 
-				dInt32 faceIndexNumber = 0;
-				for (dInt32 i = 0; i < tmpBuilder.m_faceVertexCount.GetCount(); i ++)
+			dInt32 axis = 0;
+			dFloat32 maxVarian = dFloat32 (-1.0e10f);
+			for (dInt32 i = 0; i < 3; i ++)
+			{
+				if (varian[i] > maxVarian)
 				{
-					dInt32 indexCount = tmpBuilder.m_faceVertexCount[i] - 1;
-					for (dInt32 j = 0; j < indexCount; j ++) 
-					{
-						dInt32 index = tmpBuilder.m_vertexIndex[faceIndexNumber + j];
-						face[j] = tmpBuilder.m_vertexPoints[index];
-						faceIndex[j] = j;
-					}
-					//dInt32 faceArray = indexCount;
-					//AddMesh (&face[0].m_x, indexCount, sizeof (dVector), 1, &faceArray, faceIndex, &faceId, dGetIdentityMatrix());
-					AddFaceIndirect(&face[0].m_x, sizeof(dVector), faceId, faceIndex, indexCount);
-					faceIndexNumber += (indexCount + 1); 
+					axis = i;
+					maxVarian = dFloat32 (varian[i]);
 				}
-			} 
-			else 
+			}
+			dBigVector center = median.Scale (dFloat32 (1.0f) / dFloat32 (faceCount));
+			dFloat64 axisVal = center[axis];
+
+			dInt32 leftCount = 0;
+			dInt32 lastFace = faceCount;
+			for (dInt32 i = 0; i < lastFace; i ++)
 			{
-				dBigVector median (dBigVector::m_zero);
-				dBigVector varian (dBigVector::m_zero);
-				for (dInt32 i = 0; i < faceCount; i ++) 
+				dInt32 side = 0;
+				const dgFaceInfo& faceInfo = array[faceStart + i];
+
+				dInt32 start1 = faceInfo.indexStart;
+				dInt32 count1 = faceInfo.indexCount - 1;
+				for (dInt32 j = 0; j < count1; j ++)
 				{
-					const dgFaceInfo& faceInfo = array[faceStart + i]->GetInfo();
-					dInt32 count1 = faceInfo.indexCount - 1;
-					dInt32 start1 = faceInfo.indexStart;
-					dBigVector p0 (dFloat32 ( 1.0e10f), dFloat32 ( 1.0e10f), dFloat32 ( 1.0e10f), dFloat32 (0.0f));
-					dBigVector p1 (dFloat32 (-1.0e10f), dFloat32 (-1.0e10f), dFloat32 (-1.0e10f), dFloat32 (0.0f));
-					for (dInt32 j = 0; j < count1; j ++) 
+					dInt32 index = indexArray[start1 + j];
+					const dBigVector& p = points[index];
+					if (p[axis] > axisVal)
 					{
-						dInt32 index = indexArray[start1 + j];
-						const dBigVector& p = points[index];
-						dAssert(p.m_w == dFloat32(0.0f));
-						p0 = p0.GetMin(p);
-						p1 = p1.GetMax(p);
+						side = 1;
+						break;
 					}
-					dBigVector p ((p0 + p1).Scale (0.5f));
-					median += p;
-					varian += p * p;
 				}
 
-				varian = varian.Scale (dFloat32 (faceCount)) - median * median;
-
-				dInt32 axis = 0;
-				dFloat32 maxVarian = dFloat32 (-1.0e10f);
-				for (dInt32 i = 0; i < 3; i ++) 
+				if (side)
 				{
-					if (varian[i] > maxVarian) 
-					{
-						axis = i;
-						maxVarian = dFloat32 (varian[i]);
-					}
+					dSwap (array[faceStart + i], array[faceStart + lastFace - 1]);
+					lastFace --;
+					i --;
+				}
+				else
+				{
+					leftCount ++;
 				}
-				dBigVector center = median.Scale (dFloat32 (1.0f) / dFloat32 (faceCount));
-				dFloat64 axisVal = center[axis];
+			}
 
-				dInt32 leftCount = 0;
-				dInt32 lastFace = faceCount;
+			if ((leftCount == 0) || (leftCount == faceCount))
+			{
+				// all faces straddle the split plane, just cut the run in half
+				leftCount = faceCount / 2;
+			}
 
-				for (dInt32 i = 0; i < lastFace; i ++) 
-				{
-					dInt32 side = 0;
-					const dgFaceInfo& faceInfo = array[faceStart + i]->GetInfo();
+			dgFaceChunk left(segment);
+			left.m_count = leftCount;
+			stack.PushBack(left);
 
-					dInt32 start1 = faceInfo.indexStart;
-					dInt32 count1 = faceInfo.indexCount - 1;
-					for (dInt32 j = 0; j < count1; j ++) 
-					{
-						dInt32 index = indexArray[start1 + j];
-						const dBigVector& p = points[index];
-						if (p[axis] > axisVal) 
-						{
-							side = 1;
-							break;
-						}
-					}
+			dgFaceChunk right(segment);
+			right.m_start = faceStart + leftCount;
+			right.m_count = faceCount - leftCount;
+			stack.PushBack(right);
+		}
+	}
+}
 
-					if (side) 
-					{
-						dSwap (array[faceStart + i], array[faceStart + lastFace - 1]);
-						lastFace --;
-						i --;
-					} 
-					else 
-					{
-						leftCount ++;
-					}
-				}
-				dAssert (leftCount);
-				dAssert (leftCount < faceCount);
+void dPolygonSoupBuilder::AppendFaces(const dPolygonSoupBuilder& source)
+{
+	// faces coming from an optimized builder are already convex and filtered,
+	// they can be copied without going through AddFaceIndirect
+	const dInt32 vertexBase = m_vertexPoints.GetCount();
+	for (dInt32 i = 0; i < source.m_vertexPoints.GetCount(); i++)
+	{
+		m_vertexPoints.PushBack(source.m_vertexPoints[i]);
+	}
 
-				segments[stack][0] = faceStart;
-				segments[stack][1] = leftCount;
-				stack ++;
+	dInt32 index = 0;
+	for (dInt32 i = 0; i < source.m_faceVertexCount.GetCount(); i++)
+	{
+		const dInt32 count = source.m_faceVertexCount[i];
+		for (dInt32 j = 0; j < count - 1; j++)
+		{
+			m_vertexIndex.PushBack(source.m_vertexIndex[index + j] + vertexBase);
+		}
+		m_vertexIndex.PushBack(source.m_vertexIndex[index + count - 1]);
+		m_faceVertexCount.PushBack(count);
+		index += count;
+	}
+}
 
-				segments[stack][0] = faceStart + leftCount;
-				segments[stack][1] = faceCount - leftCount;
-				stack ++;
+void dPolygonSoupBuilder::Optimize(const dPolygonSoupBuilder& source)
+{
+	class dgCompareFaces
+	{
+		public:
+		static dInt32 Compare(const dgFaceInfo* const faceA, const dgFaceInfo* const faceB, void* const)
+		{
+			if (faceA->faceId < faceB->faceId)
+			{
+				return -1;
 			}
+			else if (faceA->faceId > faceB->faceId)
+			{
+				return 1;
+			}
+			return (faceA->indexStart < faceB->indexStart) ? -1 : ((faceA->indexStart > faceB->indexStart) ? 1 : 0);
 		}
-	} 
-	else 
+	};
+
+	class dgOptimizeContext
+	{
+		public:
+		const dPolygonSoupBuilder* m_source;
+		const dgFaceInfo* m_faces;
+		const dgFaceChunk* m_chunks;
+		dPolygonSoupBuilder** m_result;
+		dInt32 m_count;
+		dAtomic<dInt32> m_index;
+	};
+
+	class dgOptimizeChunks: public dThreadPoolJob
 	{
-		dPolygonSoupBuilder tmpBuilder;
-		for (dgFaceBucket::dListNode* node = faceBucket.GetFirst(); node; node = node->GetNext()) 
+		public:
+		virtual void Execute()
 		{
-			const dgFaceInfo& faceInfo = node->GetInfo();
+			dgOptimizeContext* const context = (dgOptimizeContext*)m_context;
+			const dInt32* const indexArray = &context->m_source->m_vertexIndex[0];
+			const dBigVector* const points = &context->m_source->m_vertexPoints[0];
 
-			dInt32 count = faceInfo.indexCount - 1;
-			dInt32 start = faceInfo.indexStart;
-			dAssert (faceId == indexArray[start + count]);
-			for (dInt32 j = 0; j < count; j ++) 
+			dVector face[256];
+			dInt32 faceIndex[256];
+			for (dInt32 i = context->m_index.fetch_add(1); i < context->m_count; i = context->m_index.fetch_add(1))
 			{
-				dInt32 index = indexArray[start + j];
-				face[j] = points[index];
-				faceIndex[j] = j;
+				const dgFaceChunk& chunk = context->m_chunks[i];
+				dPolygonSoupBuilder* const tmpBuilder = new dPolygonSoupBuilder();
+				tmpBuilder->SetThreadCount(1);
+				for (dInt32 j = 0; j < chunk.m_count; j++)
+				{
+					const dgFaceInfo& faceInfo = context->m_faces[chunk.m_start + j];
+					const dInt32 count = faceInfo.indexCount - 1;
+					const dInt32 start = faceInfo.indexStart;
+					dAssert(chunk.m_faceId == indexArray[start + count]);
+					for (dInt32 k = 0; k < count; k++)
+					{
+						face[k] = points[indexArray[start + k]];
+						faceIndex[k] = k;
+					}
+					tmpBuilder->AddFaceIndirect(&face[0].m_x, sizeof(dVector), chunk.m_faceId, faceIndex, count);
+				}
+				tmpBuilder->FinalizeAndOptimize(chunk.m_faceId);
+				context->m_result[i] = tmpBuilder;
 			}
-			//dInt32 faceIndexCount = count;
-			//tmpBuilder.AddMesh (&face[0].m_x, count, sizeof (dVector), 1, &faceIndexCount, &faceIndex[0], &faceId, dGetIdentityMatrix()); 
-			tmpBuilder.AddFaceIndirect(&face[0].m_x, sizeof(dVector), faceId, faceIndex, count);
 		}
-		tmpBuilder.FinalizeAndOptimize (faceId);
 
-		dInt32 faceIndexNumber = 0;
-		for (dInt32 i = 0; i < tmpBuilder.m_faceVertexCount.GetCount(); i ++)
+		void* m_context;
+	};
+
+	const dInt32 faceCount = source.m_faceVertexCount.GetCount();
+	if (!faceCount)
+	{
+		return;
+	}
+
+	const dInt32* const indexArray = &source.m_vertexIndex[0];
+	dArray<dgFaceInfo> faceArray(faceCount);
+	faceArray.SetCount(faceCount);
+	dInt32 polygonIndex = 0;
+	for (dInt32 i = 0; i < faceCount; i++)
+	{
+		const dInt32 count = source.m_faceVertexCount[i];
+		faceArray[i].indexCount = count;
+		faceArray[i].indexStart = polygonIndex;
+		faceArray[i].faceId = indexArray[polygonIndex + count - 1];
+		polygonIndex += count;
+	}
+	dSort(&faceArray[0], faceCount, dgCompareFaces::Compare);
+
+	// split the faces of each material into spatially coherent chunks
+	dArray<dgFaceChunk> chunks;
+	for (dInt32 i = 0; i < faceCount; )
+	{
+		dInt32 j = i + 1;
+		for (; (j < faceCount) && (faceArray[j].faceId == faceArray[i].faceId); j++);
+		SplitFaces(faceArray, i, j - i, chunks, source);
+		i = j;
+	}
+
+	// optimize the chunks in parallel, a batch at the time so that only a bounded
+	// number of temporary builders are alive. Results are appended in chunk order,
+	// therefore the output does not depend on the number of threads.
+	const dInt32 batchSize = m_threadCount * 4;
+	dArray<dPolygonSoupBuilder*> result(batchSize);
+	result.SetCount(batchSize);
+
+	dgOptimizeContext context;
+	context.m_source = &source;
+	context.m_faces = &faceArray[0];
+	context.m_result = &result[0];
+
+	for (dInt32 i = 0; i < chunks.GetCount(); i += batchSize)
+	{
+		context.m_chunks = &chunks[i];
+		context.m_count = dMin(batchSize, chunks.GetCount() - i);
+		context.m_index.store(0);
+		dSubmitJobs<dgOptimizeChunks>(m_threadPool, &context);
+
+		for (dInt32 j = 0; j < context.m_count; j++)
 		{
-			dInt32 indexCount = tmpBuilder.m_faceVertexCount[i] - 1;
-			for (dInt32 j = 0; j < indexCount; j ++) 
-			{
-				dInt32 index = tmpBuilder.m_vertexIndex[faceIndexNumber + j];
-				face[j] = tmpBuilder.m_vertexPoints[index];
-				faceIndex[j] = j;
-			}
-			//dInt32 faceArray = indexCount;
-			//AddMesh (&face[0].m_x, indexCount, sizeof (dVector), 1, &faceArray, faceIndex, &faceId, dGetIdentityMatrix());
-			AddFaceIndirect(&face[0].m_x, sizeof(dVector), faceId, faceIndex, indexCount);
-		
-			faceIndexNumber += (indexCount + 1); 
+			AppendFaces(*result[j]);
+			delete result[j];
 		}
 	}
 }
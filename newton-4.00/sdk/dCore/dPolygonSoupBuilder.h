@@ -43,12 +43,14 @@ class AdjacentdFace
 	dInt64 m_edgeMap[256];
 };
 
+class dThreadPoolBuilder;
+
 class dPolygonSoupBuilder: public dClassAlloc 
 {
-	class dgFaceMap;
 	class dgFaceInfo;
-	class dgFaceBucket;
+	class dgFaceChunk;
 	class dgPolySoupFilterAllocator;
+	class dgWeldPartition;
 	public:
 
 	D_CORE_API dPolygonSoupBuilder ();
@@ -62,8 +64,18 @@ class dPolygonSoupBuilder: public dClassAlloc
 
 	D_CORE_API void SavePLY(const char* const fileName) const;
 
+	D_CORE_API dInt32 GetThreadCount() const;
+	D_CORE_API void SetThreadCount(dInt32 threadCount);
+
+	// the pool is owned by the caller and can be shared by many builders,
+	// otherwise the builder creates its own pool the first time it is needed.
+	D_CORE_API dThreadPoolBuilder* GetThreadPool() const;
+	D_CORE_API void SetThreadPool(dThreadPoolBuilder* const threadPool);
+
 	private:
-	void Optimize(dInt32 faceId, const dgFaceBucket& faceBucket, const dPolygonSoupBuilder& source);
+	void Optimize(const dPolygonSoupBuilder& source);
+	void SplitFaces(dArray<dgFaceInfo>& faceArray, dInt32 start, dInt32 count, dArray<dgFaceChunk>& chunks, const dPolygonSoupBuilder& source) const;
+	void AppendFaces(const dPolygonSoupBuilder& source);
 
 	void Finalize();
 	void OptimizeByIndividualFaces();
@@ -71,6 +83,9 @@ class dPolygonSoupBuilder: public dClassAlloc
 	dInt32 FilterFace (dInt32 count, dInt32* const indexArray);
 	dInt32 AddConvexFace (dInt32 count, dInt32* const indexArray, dInt32* const  facesArray);
 	void PackArray();
+	void CreateThreadPool();
+	void ReleaseThreadPool();
+	dInt32 WeldPoints(dBigVector* const points, dInt32 pointCount, dInt32* const indexMap, dFloat64 tolerance) const;
 
 	public:
 	class dgVertexArray: public dArray<dBigVector>
@@ -108,7 +123,13 @@ class dPolygonSoupBuilder: public dClassAlloc
 	dgIndexArray m_normalIndex;
 	dgVertexArray m_vertexPoints;
 	dgVertexArray m_normalPoints;
+	dThreadPoolBuilder* m_threadPool;
 	dInt32 m_run;
+	dInt32 m_packedPoints;
+	dInt32 m_packedFaces;
+	dInt32 m_packedIndices;
+	dInt32 m_threadCount;
+	bool m_ownThreadPool;
 };
 
 #endif
@@ -0,0 +1,261 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __D_RADIX_SORT_H__
+#define __D_RADIX_SORT_H__
+
+#include "dCoreStdafx.h"
+#include "dTypes.h"
+#include "dArray.h"
+#include "dProfiler.h"
+#include "dThreadPool.h"
+
+#define D_RADIX_SORT_DIGIT_BITS		8
+#define D_RADIX_SORT_BUCKET_COUNT	(1 << D_RADIX_SORT_DIGIT_BITS)
+#define D_RADIX_SORT_PARALLEL_SIZE	(1024 * 4)
+
+// stable least significant digit radix sort of an array of T by a 64 bit key.
+// dEvaluateKey is constructed from the context and must provide
+// dUnsigned64 GetKey(const T& entry) const.
+// a first pass finds the key bits that are not the same for all entries, and only
+// digits covering those bits are sorted, so small keys and keys with constant
+// upper bits cost fewer passes. Each pass is split in contiguous per thread
+// batches, with a histogram per thread. The sorted result is always left in array,
+// scratchBuffer must have at least count entries.
+// with a null threadPool the sort runs in the calling thread, otherwise the pool
+// must be between Begin and End, and be called from the thread that owns it.
+template <class T, class dEvaluateKey>
+void dParallelRadixSort(dThreadPool* const threadPool, T* const array, T* const scratchBuffer, dInt32 count, void* const context = nullptr)
+{
+	D_TRACKTIME();
+	enum dStage
+	{
+		m_keyRange,
+		m_countDigits,
+		m_scatter,
+		m_copy,
+	};
+
+	class dSortContext
+	{
+		public:
+		const T* m_src;
+		T* m_dst;
+		void* m_context;
+		dInt32* m_histogram;
+		dUnsigned64* m_keyMasks;
+		dInt32 m_count;
+		dInt32 m_threadCount;
+		dInt32 m_shift;
+		dStage m_stage;
+	};
+
+	class dSortJob: public dThreadPoolJob
+	{
+		public:
+		dSortJob()
+			:dThreadPoolJob()
+			,m_sortContext(nullptr)
+			,m_index(0)
+		{
+		}
+
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			const dSortContext& sortContext = *m_sortContext;
+			const dInt32 step = sortContext.m_count / sortContext.m_threadCount;
+			const dInt32 start = m_index * step;
+			const dInt32 count = ((m_index + 1) < sortContext.m_threadCount) ? step : sortContext.m_count - start;
+
+			const dEvaluateKey evaluator(sortContext.m_context);
+			const T* const src = &sortContext.m_src[start];
+			dInt32* const histogram = &sortContext.m_histogram[m_index * D_RADIX_SORT_BUCKET_COUNT];
+			const dInt32 shift = sortContext.m_shift;
+			switch (sortContext.m_stage)
+			{
+				case m_keyRange:
+				{
+					dUnsigned64 andMask = ~dUnsigned64(0);
+					dUnsigned64 orMask = 0;
+					for (dInt32 i = 0; i < count; i++)
+					{
+						const dUnsigned64 key = evaluator.GetKey(src[i]);
+						andMask &= key;
+						orMask |= key;
+					}
+					sortContext.m_keyMasks[m_index * 2 + 0] = andMask;
+					sortContext.m_keyMasks[m_index * 2 + 1] = orMask;
+					break;
+				}
+
+				case m_countDigits:
+				{
+					memset(histogram, 0, D_RADIX_SORT_BUCKET_COUNT * sizeof(dInt32));
+					for (dInt32 i = 0; i < count; i++)
+					{
+						const dInt32 digit = dInt32((evaluator.GetKey(src[i]) >> shift) & (D_RADIX_SORT_BUCKET_COUNT - 1));
+						histogram[digit] ++;
+					}
+					break;
+				}
+
+				case m_scatter:
+				{
+					T* const dst = sortContext.m_dst;
+					for (dInt32 i = 0; i < count; i++)
+					{
+						const dInt32 digit = dInt32((evaluator.GetKey(src[i]) >> shift) & (D_RADIX_SORT_BUCKET_COUNT - 1));
+						const dInt32 index = histogram[digit];
+						dst[index] = src[i];
+						histogram[digit] = index + 1;
+					}
+					break;
+				}
+
+				case m_copy:
+				{
+					T* const dst = &sortContext.m_dst[start];
+					for (dInt32 i = 0; i < count; i++)
+					{
+						dst[i] = src[i];
+					}
+					break;
+				}
+			}
+		}
+
+		dSortContext* m_sortContext;
+		dInt32 m_index;
+	};
+
+	class dSortDispatcher
+	{
+		public:
+		dSortDispatcher(dThreadPool* const threadPool, dSortContext* const sortContext)
+			:m_threadPool(threadPool)
+			,m_sortContext(sortContext)
+		{
+			for (dInt32 i = 0; i < sortContext->m_threadCount; i++)
+			{
+				m_jobs[i].m_sortContext = sortContext;
+				m_jobs[i].m_index = i;
+				m_jobsPtr[i] = &m_jobs[i];
+			}
+		}
+
+		void Submit(dStage stage)
+		{
+			m_sortContext->m_stage = stage;
+			if (m_sortContext->m_threadCount > 1)
+			{
+				m_threadPool->ExecuteJobs(m_jobsPtr);
+			}
+			else
+			{
+				m_jobs[0].Execute();
+			}
+		}
+
+		dSortJob m_jobs[D_MAX_THREADS_COUNT];
+		dThreadPoolJob* m_jobsPtr[D_MAX_THREADS_COUNT];
+		dThreadPool* m_threadPool;
+		dSortContext* m_sortContext;
+	};
+
+	if (count <= 1)
+	{
+		return;
+	}
+
+	const dInt32 threadCount = (threadPool && (count >= D_RADIX_SORT_PARALLEL_SIZE)) ? threadPool->GetCount() : 1;
+
+	dArray<dInt32> histogram;
+	dArray<dUnsigned64> keyMasks;
+	histogram.SetCount(threadCount * D_RADIX_SORT_BUCKET_COUNT);
+	keyMasks.SetCount(threadCount * 2);
+
+	dSortContext sortContext;
+	sortContext.m_src = array;
+	sortContext.m_dst = scratchBuffer;
+	sortContext.m_context = context;
+	sortContext.m_histogram = &histogram[0];
+	sortContext.m_keyMasks = &keyMasks[0];
+	sortContext.m_count = count;
+	sortContext.m_threadCount = threadCount;
+	sortContext.m_shift = 0;
+	sortContext.m_stage = m_keyRange;
+
+	dSortDispatcher dispatcher(threadPool, &sortContext);
+	dispatcher.Submit(m_keyRange);
+	dUnsigned64 andMask = ~dUnsigned64(0);
+	dUnsigned64 orMask = 0;
+	for (dInt32 i = 0; i < threadCount; i++)
+	{
+		andMask &= keyMasks[i * 2 + 0];
+		orMask |= keyMasks[i * 2 + 1];
+	}
+
+	dUnsigned64 changingBits = andMask ^ orMask;
+	while (changingBits)
+	{
+		dInt32 shift = 0;
+		for (; !(changingBits & (dUnsigned64(1) << shift)); shift++);
+		sortContext.m_shift = shift;
+		dispatcher.Submit(m_countDigits);
+
+		// buckets in digit order, and inside each bucket in thread order, keeps the pass stable
+		dInt32 sum = 0;
+		for (dInt32 digit = 0; digit < D_RADIX_SORT_BUCKET_COUNT; digit++)
+		{
+			for (dInt32 i = 0; i < threadCount; i++)
+			{
+				dInt32& entry = histogram[i * D_RADIX_SORT_BUCKET_COUNT + digit];
+				const dInt32 n = entry;
+				entry = sum;
+				sum += n;
+			}
+		}
+		dAssert(sum == count);
+
+		dispatcher.Submit(m_scatter);
+		T* const src = sortContext.m_dst;
+		sortContext.m_dst = (T*)sortContext.m_src;
+		sortContext.m_src = src;
+		changingBits &= ~(dUnsigned64(D_RADIX_SORT_BUCKET_COUNT - 1) << shift);
+	}
+
+	if (sortContext.m_src != array)
+	{
+		sortContext.m_dst = array;
+		dispatcher.Submit(m_copy);
+	}
+
+	#ifdef _DEBUG
+	const dEvaluateKey evaluator(context);
+	for (dInt32 i = 0; i < (count - 1); i++)
+	{
+		dAssert(evaluator.GetKey(array[i]) <= evaluator.GetKey(array[i + 1]));
+	}
+	#endif
+}
+
+#endif
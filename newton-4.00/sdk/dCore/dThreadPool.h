@@ -124,4 +124,51 @@ class dThreadPool: public dSyncMutex, public dThread
 #endif
 };
 
+// a thread pool for offline builders (polygon soups, convex hulls) 
+// that run outside of a world update.
+class dThreadPoolBuilder: public dThreadPool
+{
+	public:
+	dThreadPoolBuilder(const char* const baseName, dInt32 threadCount)
+		:dThreadPool(baseName)
+	{
+		SetCount(threadCount);
+	}
+
+	~dThreadPoolBuilder()
+	{
+		Finish();
+	}
+
+	// the workers only spin while jobs are being submitted, 
+	// so a builder pool can be kept alive and reused.
+	template <class T>
+	void SubmitJobs(void* const context)
+	{
+		T extJob[D_MAX_THREADS_COUNT];
+		dThreadPoolJob* extJobPtr[D_MAX_THREADS_COUNT];
+
+		const dInt32 threadCount = GetCount();
+		for (dInt32 i = 0; i < threadCount; i++)
+		{
+			extJob[i].m_context = context;
+			extJobPtr[i] = &extJob[i];
+		}
+		Begin();
+		ExecuteJobs(extJobPtr);
+		End();
+	}
+
+	static dInt32 GetDefaultThreadCount()
+	{
+		return dClamp(dInt32(std::thread::hardware_concurrency()), 1, D_MAX_THREADS_COUNT);
+	}
+
+	private:
+	virtual void ThreadFunction()
+	{
+		dAssert(0);
+	}
+};
+
 #endif
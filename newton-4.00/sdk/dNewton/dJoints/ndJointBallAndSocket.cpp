@@ -374,9 +374,7 @@ void ndJointBallAndSocket::JacobianDerivative(ndConstraintDescritor& desc)
 	dMatrix matrix1;
 	CalculateGlobalMatrix(matrix0, matrix1);
 
-	AddLinearRowJacobian(desc, matrix0.m_posit, matrix1.m_posit, matrix1[0]);
-	AddLinearRowJacobian(desc, matrix0.m_posit, matrix1.m_posit, matrix1[1]);
-	AddLinearRowJacobian(desc, matrix0.m_posit, matrix1.m_posit, matrix1[2]);
+	AddLinearRowsJacobian(desc, matrix0.m_posit, matrix1.m_posit, matrix1, 3);
 }
 
 
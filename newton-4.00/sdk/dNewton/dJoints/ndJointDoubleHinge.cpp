@@ -32,9 +32,7 @@ void ndJointDoubleHinge::JacobianDerivative(ndConstraintDescritor& desc)
 	dMatrix matrix1;
 	CalculateGlobalMatrix(matrix0, matrix1);
 
-	AddLinearRowJacobian(desc, matrix0.m_posit, matrix1.m_posit, matrix1[0]);
-	AddLinearRowJacobian(desc, matrix0.m_posit, matrix1.m_posit, matrix1[1]);
-	AddLinearRowJacobian(desc, matrix0.m_posit, matrix1.m_posit, matrix1[2]);
+	AddLinearRowsJacobian(desc, matrix0.m_posit, matrix1.m_posit, matrix1, 3);
 
 	// save the current joint Omega
 	dVector omega0(m_body0->GetOmega());
@@ -48,7 +46,9 @@ void ndJointDoubleHinge::JacobianDerivative(ndConstraintDescritor& desc)
 	// two rows to restrict rotation around around the parent coordinate system
 	const dFloat32 angleError = m_maxAngleError;
 	const dFloat32 angle0 = CalculateAngle(matrix0.m_front, matrix1.m_front, matrix1.m_up);
-	AddAngularRowJacobian(desc, matrix1.m_up, angle0);
+	const dFloat32 angle1 = CalculateAngle(matrix0.m_front, matrix1.m_front, matrix1.m_right);
+	const dMatrix pins(matrix1.m_up, matrix1.m_right, dVector::m_zero, dVector::m_wOne);
+	AddAngularRowsJacobian(desc, pins, dVector(angle0, angle1, dFloat32(0.0f), dFloat32(0.0f)), 2);
 	if (dAbs(angle0) > angleError)
 	{
 		dAssert(0);
@@ -56,8 +56,6 @@ void ndJointDoubleHinge::JacobianDerivative(ndConstraintDescritor& desc)
 		//NewtonUserJointSetRowAcceleration(m_joint, alpha);
 	}
 
-	const dFloat32 angle1 = CalculateAngle(matrix0.m_front, matrix1.m_front, matrix1.m_right);
-	AddAngularRowJacobian(desc, matrix1.m_right, angle1);
 	if (dAbs(angle1) > angleError)
 	{
 		dAssert(0);
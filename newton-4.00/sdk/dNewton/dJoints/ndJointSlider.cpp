@@ -140,12 +140,14 @@ void ndJointSlider::JacobianDerivative(ndConstraintDescritor& desc)
 	m_posit = prel.DotProduct(matrix1.m_front).GetScalar();
 	const dVector projectedPoint = p1 + pin.Scale(pin.DotProduct(prel).GetScalar());
 
-	AddLinearRowJacobian(desc, p0, projectedPoint, matrix1[1]);
-	AddLinearRowJacobian(desc, p0, projectedPoint, matrix1[2]);
+	const dMatrix linearPins(matrix1.m_up, matrix1.m_right, dVector::m_zero, dVector::m_wOne);
+	AddLinearRowsJacobian(desc, p0, projectedPoint, linearPins, 2);
 
 	const dFloat32 angleError = m_maxAngleError;
 	const dFloat32 angle0 = CalculateAngle(matrix0.m_up, matrix1.m_up, matrix1.m_front);
-	AddAngularRowJacobian(desc, matrix1.m_front, angle0);
+	const dFloat32 angle1 = CalculateAngle(matrix0.m_front, matrix1.m_front, matrix1.m_up);
+	const dFloat32 angle2 = CalculateAngle(matrix0.m_front, matrix1.m_front, matrix1.m_right);
+	AddAngularRowsJacobian(desc, matrix1, dVector(angle0, angle1, angle2, dFloat32(0.0f)), 3);
 	if (dAbs(angle0) > angleError) 
 	{
 		dAssert(0);
@@ -153,8 +155,6 @@ void ndJointSlider::JacobianDerivative(ndConstraintDescritor& desc)
 	//	NewtonUserJointSetRowAcceleration(m_joint, alpha);
 	}
 	
-	const dFloat32 angle1 = CalculateAngle(matrix0.m_front, matrix1.m_front, matrix1.m_up);
-	AddAngularRowJacobian(desc, matrix1.m_up, angle1);
 	if (dAbs(angle1) > angleError) 
 	{
 		dAssert(0);
@@ -162,8 +162,6 @@ void ndJointSlider::JacobianDerivative(ndConstraintDescritor& desc)
 	//	NewtonUserJointSetRowAcceleration(m_joint, alpha);
 	}
 	
-	const dFloat32 angle2 = CalculateAngle(matrix0.m_front, matrix1.m_front, matrix1.m_right);
-	AddAngularRowJacobian(desc, matrix1.m_right, angle2);
 	//NewtonUserJointSetRowStiffness(m_joint, m_stiffness);
 	if (dAbs(angle2) > angleError) 
 	{
@@ -108,14 +108,13 @@ void ndJointWheel::JacobianDerivative(ndConstraintDescritor& desc)
 	m_posit = prel.DotProduct(matrix1.m_up).GetScalar();
 	const dVector projectedPoint = p1 + pin.Scale(pin.DotProduct(prel).GetScalar());
 
-	AddLinearRowJacobian(desc, p0, projectedPoint, matrix1[0]);
-	AddLinearRowJacobian(desc, p0, projectedPoint, matrix1[2]);
+	const dMatrix linearPins(matrix1.m_front, matrix1.m_right, dVector::m_zero, dVector::m_wOne);
+	AddLinearRowsJacobian(desc, p0, projectedPoint, linearPins, 2);
 
 	const dFloat32 angle0 = CalculateAngle(matrix0.m_front, matrix1.m_front, matrix1.m_up);
-	AddAngularRowJacobian(desc, matrix1.m_up, angle0);
-
 	const dFloat32 angle1 = CalculateAngle(matrix0.m_front, matrix1.m_front, matrix1.m_right);
-	AddAngularRowJacobian(desc, matrix1.m_right, angle1);
+	const dMatrix angularPins(matrix1.m_up, matrix1.m_right, dVector::m_zero, dVector::m_wOne);
+	AddAngularRowsJacobian(desc, angularPins, dVector(angle0, angle1, dFloat32(0.0f), dFloat32(0.0f)), 2);
 	
 	SubmitConstraintLimitSpringDamper(desc, matrix0, matrix1);
 
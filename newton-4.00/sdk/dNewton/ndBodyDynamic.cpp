@@ -98,7 +98,19 @@ void ndBodyDynamic::ApplyExternalForces(dInt32 threadIndex, dFloat32 timestep)
 	m_externalTorque = dVector::m_zero;
 	if (m_notifyCallback)
 	{
-		m_notifyCallback->OnApplyExternalForce(threadIndex, timestep);
+		if (m_notifyCallback->HasDefaultExternalForce())
+		{
+			// same as the base notification, without the virtual call.
+			if (m_invMass.m_w > dFloat32(0.0f))
+			{
+				SetForce(m_notifyCallback->GetGravity().Scale(m_mass.m_w));
+				SetTorque(dVector::m_zero);
+			}
+		}
+		else
+		{
+			m_notifyCallback->OnApplyExternalForce(threadIndex, timestep);
+		}
 		dAssert(m_externalForce.m_w == dFloat32(0.0f));
 		dAssert(m_externalTorque.m_w == dFloat32(0.0f));
 	}
@@ -23,37 +23,36 @@
 #include "ndNewtonStdafx.h"
 #include "ndWorld.h"
 #include "ndBodySphFluid.h"
+#include "ndBodyDynamic.h"
 
-
-/*
-{
-dFloat32 xxx[6][6][6];
-for (dInt32 i = 0; i < 6 * 6 * 6; i++)
-{
-dFloat32* yyy = &xxx[0][0][0];
-yyy[i] = 1.0f;
-}
-for (dInt32 i = 0; i < uniqueCount; i++)
-{
-dInt32 x = m_hashGridMap[i].m_x;
-dInt32 y = m_hashGridMap[i].m_y;
-dInt32 z = m_hashGridMap[i].m_z;
-
-xxx[z][y][x] = 0.0f;
-}
-
-dIsoSurfaceOld isoSurcase;
-isoSurcase.GenerateSurface(&xxx[0][0][0], 0.5f, 5, 5, 5, gridSize, gridSize, gridSize);
-cellCount *= 1;
-}
-*/
+#define D_SPH_CELL_BUFFER_SIZE	1024
 
 ndBodySphFluid::ndBodySphFluid()
 	:ndBodyParticleSet()
 	,m_box0(dFloat32(-1e10f))
 	,m_box1(dFloat32(1e10f))
+	,m_positSoa()
+	,m_veloc()
+	,m_accel()
+	,m_density()
+	,m_pressure()
+	,m_neighborCount()
+	,m_neighbors()
+	,m_gridScans()
 	,m_hashGridMap(1024)
 	,m_hashGridMapScratchBuffer(1024)
+	,m_bodyImpulses()
+	,m_bodyImpulsesScratchBuffer()
+	,m_isoSurfaceCells()
+	,m_mass(dFloat32(0.02f))
+	,m_restDensity(dFloat32(1000.0f))
+	,m_gasConstant(dFloat32(3.0f))
+	,m_viscosity(dFloat32(3.5f))
+	,m_neighborCapacity(D_SPH_MAX_NEIGHBORS)
+	,m_isoSurcase()
+	,m_frameIndex(0xffffffff)
+	,m_subStepIndex(0)
+	,m_updateIsoSurface(false)
 {
 }
 
@@ -61,8 +60,28 @@ ndBodySphFluid::ndBodySphFluid(const nd::TiXmlNode* const xmlNode, const dTree<c
 	:ndBodyParticleSet(xmlNode->FirstChild("ndBodyKinematic"), shapesCache)
 	,m_box0(dFloat32(-1e10f))
 	,m_box1(dFloat32(1e10f))
+	,m_positSoa()
+	,m_veloc()
+	,m_accel()
+	,m_density()
+	,m_pressure()
+	,m_neighborCount()
+	,m_neighbors()
+	,m_gridScans()
 	,m_hashGridMap()
 	,m_hashGridMapScratchBuffer()
+	,m_bodyImpulses()
+	,m_bodyImpulsesScratchBuffer()
+	,m_isoSurfaceCells()
+	,m_mass(dFloat32(0.02f))
+	,m_restDensity(dFloat32(1000.0f))
+	,m_gasConstant(dFloat32(3.0f))
+	,m_viscosity(dFloat32(3.5f))
+	,m_neighborCapacity(D_SPH_MAX_NEIGHBORS)
+	,m_isoSurcase()
+	,m_frameIndex(0xffffffff)
+	,m_subStepIndex(0)
+	,m_updateIsoSurface(false)
 {
 	// nothing was saved
 	dAssert(0);
@@ -81,20 +100,71 @@ void ndBodySphFluid::Save(nd::TiXmlElement* const rootNode, const char* const as
 
 void ndBodySphFluid::AddParticle(const dFloat32 mass, const dVector& position, const dVector& velocity)
 {
+	// all particles of a fluid have the same mass
+	dAssert(mass > dFloat32(0.0f));
+	if (!m_posit.GetCount())
+	{
+		m_mass = mass;
+	}
+	dAssert(dAbs(mass - m_mass) <= m_mass * dFloat32(1.0e-3f));
+
 	dVector point(position);
 	point.m_w = dFloat32(1.0f);
 	m_posit.PushBack(point);
+	m_positSoa.PushBack(point);
+	m_veloc.PushBack(velocity);
 }
 
 void ndBodySphFluid::CaculateAABB(const ndWorld* const world, dVector& boxP0, dVector& boxP1) const
 {
 	D_TRACKTIME();
+	class ndContext
+	{
+		public:
+		const ndBodySphFluid* m_fluid;
+		dVector m_box0[D_MAX_THREADS_COUNT];
+		dVector m_box1[D_MAX_THREADS_COUNT];
+	};
+
+	class ndCalculateAabb: public ndScene::ndBaseJob
+	{
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			ndContext* const context = (ndContext*)m_context;
+			const ndBodySphFluid* const fluid = context->m_fluid;
+			const dInt32 threadIndex = GetThredId();
+			const dInt32 threadCount = m_owner->GetThreadCount();
+			const dInt32 particleCount = fluid->m_posit.GetCount();
+			const dInt32 step = particleCount / threadCount;
+			const dInt32 start = threadIndex * step;
+			const dInt32 count = ((threadIndex + 1) < threadCount) ? step : particleCount - start;
+
+			dVector box0(dFloat32(1e20f));
+			dVector box1(dFloat32(-1e20f));
+			const dVector* const posit = &fluid->m_posit[start];
+			for (dInt32 i = 0; i < count; i++)
+			{
+				box0 = box0.GetMin(posit[i]);
+				box1 = box1.GetMax(posit[i]);
+			}
+			context->m_box0[threadIndex] = box0;
+			context->m_box1[threadIndex] = box1;
+		}
+	};
+
+	ndContext context;
+	context.m_fluid = this;
+	ndScene* const scene = world->GetScene();
+	scene->SubmitJobs<ndCalculateAabb>(&context);
+
 	dVector box0(dFloat32(1e20f));
 	dVector box1(dFloat32(-1e20f));
-	for (dInt32 i = m_posit.GetCount() - 1; i >= 0; i--)
+	const dInt32 threadCount = scene->GetThreadCount();
+	for (dInt32 i = 0; i < threadCount; i++)
 	{
-		box0 = box0.GetMin(m_posit[i]);
-		box1 = box1.GetMax(m_posit[i]);
+		box0 = box0.GetMin(context.m_box0[i]);
+		box1 = box1.GetMax(context.m_box1[i]);
 	}
 	boxP0 = box0;
 	boxP1 = box1;
@@ -102,6 +172,11 @@ void ndBodySphFluid::CaculateAABB(const ndWorld* const world, dVector& boxP0, dV
 
 void ndBodySphFluid::Update(const ndWorld* const world, dFloat32 timestep)
 {
+	if (!m_posit.GetCount())
+	{
+		return;
+	}
+
 	dVector boxP0;
 	dVector boxP1;
 	CaculateAABB(world, boxP0, boxP1);
@@ -110,16 +185,27 @@ void ndBodySphFluid::Update(const ndWorld* const world, dFloat32 timestep)
 
 	CreateGrids(world);
 	SortGrids(world);
+	CalculateScans(world);
+
+	const dUnsigned32 frameIndex = world->GetFrameIndex();
+	m_subStepIndex = (frameIndex == m_frameIndex) ? m_subStepIndex + 1 : 0;
+	m_frameIndex = frameIndex;
+	if (m_updateIsoSurface && (m_subStepIndex == (world->GetSubSteps() - 1)))
+	{
+		GenerateIsoSurface(world);
+	}
+
+	BuildNeighbors(world);
+	CalculateDensities(world);
+	CalculateAccelerations(world);
+	IntegrateParticles(world, timestep);
+	CollideWithBodies(world, timestep);
+	ApplyBodyImpulses(world);
 }
 
 void ndBodySphFluid::CreateGrids(const ndWorld* const world)
 {
 	D_TRACKTIME();
-	if (m_hashGridMap.GetCount() < m_posit.GetCount() * 16)
-	{
-		m_hashGridMap.SetCount(m_posit.GetCount() * 16);
-	}
-
 	class ndCreateGrids: public ndScene::ndBaseJob
 	{
 		public:
@@ -157,8 +243,7 @@ void ndBodySphFluid::CreateGrids(const ndWorld* const world)
 			const dInt32 start = threadIndex * step;
 			const dInt32 count = ((threadIndex + 1) < threadCount) ? step : particleCount - start;
 
-			const dFloat32 diameter = radius * dFloat32(2.0f);
-			const dFloat32 gridSize = diameter * dFloat32(1.0625f);
+			const dFloat32 gridSize = fluid->GetGridSize();
 
 			const dVector origin(fluid->m_box0);
 			const dVector invGridSize(dFloat32(1.0f) / gridSize);
@@ -174,17 +259,21 @@ void ndBodySphFluid::CreateGrids(const ndWorld* const world)
 				dVector r(posit[start + i] - origin);
 				dVector p(r * invGridSize);
 			
-				ndGridHash hashKey(p, i, ndHomeGrid);
+				const dInt32 homeEntry = scratchBufferCount;
+				ndGridHash hashKey(p, start + i, ndHomeGrid);
 				scratchBuffer[scratchBufferCount] = hashKey;
 				scratchBufferCount++;
-				fluid->m_upperDigisIsValid[0] |= hashKey.m_xHigh;
-				fluid->m_upperDigisIsValid[1] |= hashKey.m_yHigh;
-				fluid->m_upperDigisIsValid[2] |= hashKey.m_zHigh;
 			
-				for (dInt32 j = 0; j < sizeof(m_neighborkDirs) / sizeof(m_neighborkDirs[0]); j++)
+				// a particle is adjacent to every cell its box overlaps, but only once per cell.
+				for (dInt32 j = 0; j < dInt32(sizeof(m_neighborkDirs) / sizeof(m_neighborkDirs[0])); j++)
 				{
-					ndGridHash neighborKey(p + m_neighborkDirs[j], i, ndAdjacentGrid);
-					if (neighborKey.m_gridHash != hashKey.m_gridHash)
+					ndGridHash neighborKey((r + m_neighborkDirs[j]) * invGridSize, start + i, ndAdjacentGrid);
+					bool unique = true;
+					for (dInt32 k = homeEntry; k < scratchBufferCount; k++)
+					{
+						unique = unique && (neighborKey.m_gridHash != scratchBuffer[k].m_gridHash);
+					}
+					if (unique)
 					{
 						scratchBuffer[scratchBufferCount] = neighborKey;
 						scratchBufferCount++;
@@ -203,444 +292,779 @@ void ndBodySphFluid::CreateGrids(const ndWorld* const world)
 			if (scratchBufferCount)
 			{
 				dInt32 entry = iterator.fetch_add(scratchBufferCount);
-				dAssert(iterator.load() < fluid->m_hashGridMap.GetCount());
+				dAssert(iterator.load() <= fluid->m_hashGridMap.GetCount());
 				memcpy(&fluid->m_hashGridMap[entry], scratchBuffer, scratchBufferCount * sizeof(ndGridHash));
 			}
 		}
 	};
 
-	if (m_hashGridMap.GetCount() < m_posit.GetCount() * 16)
+	// one home cell and up to eight adjacent cells per particle
+	const dInt32 maxEntries = m_posit.GetCount() * 9;
+	if (m_hashGridMap.GetCount() < maxEntries)
 	{
-		m_hashGridMap.Resize(m_posit.GetCount() * 16);
-		m_hashGridMap.SetCount(m_posit.GetCount() * 16);
+		m_hashGridMap.Resize(maxEntries);
 	}
+	m_hashGridMap.SetCount(maxEntries);
 
 	ndScene* const scene = world->GetScene();
-	m_upperDigisIsValid[0] = 0;
-	m_upperDigisIsValid[1] = 0;
-	m_upperDigisIsValid[2] = 0;
-
 	ndCreateGrids::ndContext context;
 	context.m_fluid = this;
+	context.m_iterator.store(0);
 	scene->SubmitJobs<ndCreateGrids>(&context);
 	m_hashGridMap.SetCount(context.m_iterator.load());
 }
 
-void ndBodySphFluid::SortSingleThreaded(const ndWorld* const world)
+void ndBodySphFluid::SortGrids(const ndWorld* const world)
 {
-	const dInt32 count = m_hashGridMap.GetCount();
-
-	//const dInt32 size = count / threadCount;
-	//const dInt32 start = threadId * size;
-	//const dInt32 batchSize = (threadId == threadCount - 1) ? count - start : size;
-	//const dInt32 start = 0;
-	//const dInt32 size = count;
-	//const dInt32 batchSize = count;
-
-	dInt32 histogram0[1 << (D_RADIX_DIGIT_SIZE + 1)];
-	dInt32 histogram1[5][1 << D_RADIX_DIGIT_SIZE];
-	memset(histogram0, 0, sizeof(histogram0));
-	memset(histogram1, 0, sizeof(histogram1));
-
-	ndGridHash* srcArray = &m_hashGridMap[0];
-	for (dInt32 i = 0; i < count; i++)
-	{
-		const ndGridHash& entry = srcArray[i];
-	
-		const dInt32 xlow = dInt32(entry.m_xLow * 2 + entry.m_cellType);
-		histogram0[xlow] = histogram0[xlow] + 1;
-	
-		const dInt32 xHigh = entry.m_xHigh;
-		histogram1[0][xHigh] = histogram1[0][xHigh] + 1;
-	
-		const dInt32 ylow = entry.m_yLow;
-		histogram1[1][ylow] = histogram1[1][ylow] + 1;
-	
-		const dInt32 yHigh = entry.m_yHigh;
-		histogram1[2][yHigh] = histogram1[2][yHigh] + 1;
-	
-		const dInt32 zlow = entry.m_zLow;
-		histogram1[3][zlow] = histogram1[3][zlow] + 1;
-	
-		const dInt32 zHigh = entry.m_zHigh;
-		histogram1[4][zHigh] = histogram1[4][zHigh] + 1;
-	}
-	
-	dInt32 acc0 = 0;
-	for (dInt32 i = 0; i < (1 << (D_RADIX_DIGIT_SIZE + 1)); i++)
-	{
-		const dInt32 n = histogram0[i];
-		histogram0[i] = acc0;
-		acc0 += n;
-	}
-	dInt32 acc[5];
-	memset(acc, 0, sizeof(acc));
-	for (dInt32 i = 0; i < (1 << D_RADIX_DIGIT_SIZE); i++)
+	D_TRACKTIME();
+	m_hashGridMapScratchBuffer.SetCount(m_hashGridMap.GetCount());
+	dParallelRadixSort<ndGridHash, ndGridHashKey>(world->GetScene(), &m_hashGridMap[0], &m_hashGridMapScratchBuffer[0], m_hashGridMap.GetCount());
+
+#ifdef _DEBUG
+	for (dInt32 i = 0; i < (m_hashGridMap.GetCount() - 1); i++)
 	{
-		for (dInt32 j = 0; j < 5; j++)
-		{
-			const dInt32 n = histogram1[j][i];
-			histogram1[j][i] = acc[j];
-			acc[j] += n;
-		}
+		const ndGridHash& entry0 = m_hashGridMap[i + 0];
+		const ndGridHash& entry1 = m_hashGridMap[i + 1];
+		dUnsigned64 gridHashA = entry0.m_gridHash * 2 + entry0.m_cellType;
+		dUnsigned64 gridHashB = entry1.m_gridHash * 2 + entry1.m_cellType;
+		dAssert(gridHashA <= gridHashB);
 	}
-	
-	dInt32 shiftbits = 0;
-	dUnsigned64 mask = ~dUnsigned64(dInt64(-1 << D_RADIX_DIGIT_SIZE));
-	ndGridHash* dstArray = &m_hashGridMapScratchBuffer[0];
-	for (dInt32 i = 0; i < count; i++)
+#endif
+}
+
+void ndBodySphFluid::CalculateScans(const ndWorld* const world)
+{
+	D_TRACKTIME();
+	class ndContext
 	{
-		const ndGridHash& entry = srcArray[i];
-		const dInt32 key = dUnsigned32((entry.m_gridHash & mask) >> shiftbits) * 2 + entry.m_cellType;
-		const dInt32 index = histogram0[key];
-		dstArray[index] = entry;
-		histogram0[key] = index + 1;
-	}
-	mask <<= D_RADIX_DIGIT_SIZE;
-	shiftbits += D_RADIX_DIGIT_SIZE;
-	dSwap(dstArray, srcArray);
-	
-	if (m_upperDigisIsValid[0]) 
+		public:
+		ndBodySphFluid* m_fluid;
+		dInt32 m_cellCount[D_MAX_THREADS_COUNT + 1];
+	};
+
+	class ndCountCells: public ndScene::ndBaseJob
 	{
-		dInt32* const scan2 = &histogram1[0][0];
-		for (dInt32 i = 0; i < count; i++)
+		virtual void Execute()
 		{
-			const ndGridHash& entry = dstArray[i];
-			const dInt32 key = dUnsigned32((entry.m_gridHash & mask) >> shiftbits);
-			const dInt32 index = scan2[key];
-			srcArray[index] = entry;
-			scan2[key] = index + 1;
+			D_TRACKTIME();
+			ndContext* const context = (ndContext*)m_context;
+			ndBodySphFluid* const fluid = context->m_fluid;
+			const dInt32 threadIndex = GetThredId();
+			const dInt32 threadCount = m_owner->GetThreadCount();
+			const dInt32 entryCount = fluid->m_hashGridMap.GetCount();
+			const dInt32 step = entryCount / threadCount;
+			const dInt32 start = threadIndex * step;
+			const dInt32 count = ((threadIndex + 1) < threadCount) ? step : entryCount - start;
+
+			dInt32 cellCount = 0;
+			const ndGridHash* const hashGridMap = &fluid->m_hashGridMap[0];
+			for (dInt32 i = start; i < (start + count); i++)
+			{
+				cellCount += ((i == 0) || (hashGridMap[i].m_gridHash != hashGridMap[i - 1].m_gridHash)) ? 1 : 0;
+			}
+			context->m_cellCount[threadIndex] = cellCount;
 		}
-		dSwap(dstArray, srcArray);
-	}
-	mask <<= D_RADIX_DIGIT_SIZE;
-	shiftbits += D_RADIX_DIGIT_SIZE;
-	
-	for (dInt32 radix = 0; radix < 2; radix++)
+	};
+
+	class ndWriteScans: public ndScene::ndBaseJob
 	{
-		dInt32* const scan0 = &histogram1[radix * 2 + 1][0];
-		for (dInt32 i = 0; i < count; i++)
-		{
-			const ndGridHash& entry = srcArray[i];
-			const dInt32 key = dUnsigned32((entry.m_gridHash & mask) >> shiftbits);
-			const dInt32 index = scan0[key];
-			dstArray[index] = entry;
-			scan0[key] = index + 1;
-		}
-		mask <<= D_RADIX_DIGIT_SIZE;
-		shiftbits += D_RADIX_DIGIT_SIZE;
-		dSwap(dstArray, srcArray);
-	
-		if (m_upperDigisIsValid[radix + 1])
+		virtual void Execute()
 		{
-			dInt32* const scan1 = &histogram1[radix * 2 + 2][0];
-			for (dInt32 i = 0; i < count; i++)
+			D_TRACKTIME();
+			ndContext* const context = (ndContext*)m_context;
+			ndBodySphFluid* const fluid = context->m_fluid;
+			const dInt32 threadIndex = GetThredId();
+			const dInt32 threadCount = m_owner->GetThreadCount();
+			const dInt32 entryCount = fluid->m_hashGridMap.GetCount();
+			const dInt32 step = entryCount / threadCount;
+			const dInt32 start = threadIndex * step;
+			const dInt32 count = ((threadIndex + 1) < threadCount) ? step : entryCount - start;
+
+			dInt32 cellIndex = context->m_cellCount[threadIndex];
+			dInt32* const scans = &fluid->m_gridScans[0];
+			const ndGridHash* const hashGridMap = &fluid->m_hashGridMap[0];
+			for (dInt32 i = start; i < (start + count); i++)
 			{
-				const ndGridHash& entry = dstArray[i];
-				const dInt32 key = dUnsigned32((entry.m_gridHash & mask) >> shiftbits);
-				const dInt32 index = scan1[key];
-				srcArray[index] = entry;
-				scan1[key] = index + 1;
+				if ((i == 0) || (hashGridMap[i].m_gridHash != hashGridMap[i - 1].m_gridHash))
+				{
+					scans[cellIndex] = i;
+					cellIndex++;
+				}
 			}
-			dSwap(dstArray, srcArray);
 		}
-		mask <<= D_RADIX_DIGIT_SIZE;
-		shiftbits += D_RADIX_DIGIT_SIZE;
-	}
-	if (srcArray != &m_hashGridMap[0])
-	{
-		m_hashGridMap.Swap(m_hashGridMapScratchBuffer);
-	}
-	dAssert(srcArray == &m_hashGridMap[0]);
-}
+	};
 
-void ndBodySphFluid::AddCounters(const ndWorld* const world, ndContext& context) const
-{
-	D_TRACKTIME();
+	ndContext context;
+	context.m_fluid = this;
+	ndScene* const scene = world->GetScene();
+	scene->SubmitJobs<ndCountCells>(&context);
 
-	dInt32 acc[1 << 11];
-	memset(acc, 0, sizeof(acc));
-	
-	const dInt32 threadCount = world->GetThreadCount();
-	for (dInt32 threadId = 0; threadId < threadCount; threadId++)
+	dInt32 acc = 0;
+	const dInt32 threadCount = scene->GetThreadCount();
+	for (dInt32 i = 0; i < threadCount; i++)
 	{
-		for (dInt32 i = 0; i < sizeof(context.m_scan) / sizeof(dInt32); i++)
-		{
-			dInt32 a = context.m_histogram[threadId][i];
-			context.m_histogram[threadId][i] = acc[i] + context.m_scan[i];
-			acc[i] += a;
-		}
+		const dInt32 count = context.m_cellCount[i];
+		context.m_cellCount[i] = acc;
+		acc += count;
 	}
+
+	// m_gridScans[i] is the first entry of cell i, the last one is the end of the array.
+	m_gridScans.SetCount(acc + 1);
+	scene->SubmitJobs<ndWriteScans>(&context);
+	m_gridScans[acc] = m_hashGridMap.GetCount();
 }
 
-void ndBodySphFluid::SortParallel(const ndWorld* const world)
+void ndBodySphFluid::BuildNeighbors(const ndWorld* const world)
 {
 	D_TRACKTIME();
-	class ndBodySphFluidCountDigits : public ndScene::ndBaseJob
+	class ndContext
+	{
+		public:
+		ndBodySphFluid* m_fluid;
+		dInt32 m_maxCount[D_MAX_THREADS_COUNT];
+	};
+
+	class ndBuildNeighbors: public ndScene::ndBaseJob
 	{
 		virtual void Execute()
 		{
 			D_TRACKTIME();
-
-			ndWorld* const world = m_owner->GetWorld();
 			ndContext* const context = (ndContext*)m_context;
 			ndBodySphFluid* const fluid = context->m_fluid;
-			const dInt32 threadId = GetThredId();
-			const dInt32 threadCount = world->GetThreadCount();
-			
-			const dInt32 count = fluid->m_hashGridMap.GetCount();
-			const dInt32 size = count / threadCount;
-			const dInt32 start = threadId * size;
-			const dInt32 batchSize = (threadId == threadCount - 1) ? count - start : size;
-			
-			ndGridHash* const hashArray = &fluid->m_hashGridMap[start];
-			dInt32* const histogram = context->m_histogram[threadId];
-			if (context->m_pass)
-			{
-				memset(histogram, 0, sizeof(context->m_scan)/2);
-				dInt32 shiftbits = context->m_pass * D_RADIX_DIGIT_SIZE;
-				dUnsigned64 mask = ~dUnsigned64(dInt64(-1 << D_RADIX_DIGIT_SIZE));
-				mask = mask << shiftbits;
+			const dInt32 threadIndex = GetThredId();
+			const dInt32 threadCount = m_owner->GetThreadCount();
+			const dInt32 cellCount = fluid->m_gridScans.GetCount() - 1;
+			const dInt32 step = cellCount / threadCount;
+			const dInt32 start = threadIndex * step;
+			const dInt32 count = ((threadIndex + 1) < threadCount) ? step : cellCount - start;
+
+			const dFloat32 h2 = fluid->m_radius * fluid->m_radius;
+			const dFloat32* const x = &fluid->m_positSoa.m_x[0];
+			const dFloat32* const y = &fluid->m_positSoa.m_y[0];
+			const dFloat32* const z = &fluid->m_positSoa.m_z[0];
+			const dInt32* const scans = &fluid->m_gridScans[0];
+			const ndGridHash* const hashGridMap = &fluid->m_hashGridMap[0];
+			dInt32* const neighborCount = &fluid->m_neighborCount[0];
+			dInt32* const neighbors = &fluid->m_neighbors[0];
+			const dInt32 capacity = fluid->m_neighborCapacity;
 
-				for (dInt32 i = 0; i < batchSize; i++)
+			// neighbors past the capacity are counted but not stored, the caller
+			// grows the lists and builds them again.
+			dInt32 maxCount = 0;
+
+			// the home entries of a cell are sorted before the adjacent entries, each particle
+			// finds all its neighbors in its home cell. The cell is copied to a local soa 
+			// buffer so that each home particle tests four candidates at a time.
+			dVector cellX[D_SPH_CELL_BUFFER_SIZE / 4];
+			dVector cellY[D_SPH_CELL_BUFFER_SIZE / 4];
+			dVector cellZ[D_SPH_CELL_BUFFER_SIZE / 4];
+			dInt32 cellIndex[D_SPH_CELL_BUFFER_SIZE];
+			dFloat32* const bufferX = &cellX[0].m_x;
+			dFloat32* const bufferY = &cellY[0].m_x;
+			dFloat32* const bufferZ = &cellZ[0].m_x;
+			const dVector radius2(h2);
+			for (dInt32 cell = start; cell < (start + count); cell++)
+			{
+				const dInt32 cellStart = scans[cell];
+				const dInt32 cellEnd = scans[cell + 1];
+				const dInt32 entryCount = cellEnd - cellStart;
+				if (entryCount <= D_SPH_CELL_BUFFER_SIZE)
 				{
-					const ndGridHash& entry = hashArray[i];
-					const dInt32 key = dUnsigned32((entry.m_gridHash & mask) >> shiftbits);
-					histogram[key] += 1;
+					for (dInt32 i = 0; i < entryCount; i++)
+					{
+						const dInt32 index = hashGridMap[cellStart + i].m_particleIndex;
+						bufferX[i] = x[index];
+						bufferY[i] = y[index];
+						bufferZ[i] = z[index];
+						cellIndex[i] = index;
+					}
+					const dInt32 groupCount = (entryCount + 3) >> 2;
+					for (dInt32 i = entryCount; i < groupCount * 4; i++)
+					{
+						bufferX[i] = dFloat32(1.0e10f);
+						bufferY[i] = dFloat32(1.0e10f);
+						bufferZ[i] = dFloat32(1.0e10f);
+						cellIndex[i] = -1;
+					}
+
+					for (dInt32 i = 0; (i < entryCount) && (hashGridMap[cellStart + i].m_cellType == ndHomeGrid); i++)
+					{
+						const dInt32 index = cellIndex[i];
+						const dVector px(bufferX[i]);
+						const dVector py(bufferY[i]);
+						const dVector pz(bufferZ[i]);
+						dInt32* const neighborArray = &neighbors[index * capacity];
+						dInt32 n = 0;
+						for (dInt32 j = 0; j < groupCount; j++)
+						{
+							const dVector dx(cellX[j] - px);
+							const dVector dy(cellY[j] - py);
+							const dVector dz(cellZ[j] - pz);
+							const dVector dist2(dx * dx + dy * dy + dz * dz);
+							const dInt32 mask = (dist2 < radius2).GetSignMask();
+							if (mask)
+							{
+								for (dInt32 k = 0; k < 4; k++)
+								{
+									const dInt32 neighbor = cellIndex[j * 4 + k];
+									if ((mask & (1 << k)) && (neighbor != index))
+									{
+										if (n < capacity)
+										{
+											neighborArray[n] = neighbor;
+										}
+										n++;
+									}
+								}
+							}
+						}
+						maxCount = dMax(maxCount, n);
+						neighborCount[index] = dMin(n, capacity);
+					}
 				}
-			}
-			else
-			{
-				memset(histogram, 0, sizeof(context->m_scan));
-				for (dInt32 i = 0; i < batchSize; i++)
+				else
 				{
-					const ndGridHash& entry = hashArray[i];
-					const dInt32 xlow = dInt32(entry.m_xLow * 2 + entry.m_cellType);
-					histogram[xlow] += 1;
+					for (dInt32 i = cellStart; (i < cellEnd) && (hashGridMap[i].m_cellType == ndHomeGrid); i++)
+					{
+						const dInt32 index = hashGridMap[i].m_particleIndex;
+						dInt32* const neighborArray = &neighbors[index * capacity];
+						dInt32 n = 0;
+						for (dInt32 j = cellStart; j < cellEnd; j++)
+						{
+							const dInt32 neighbor = hashGridMap[j].m_particleIndex;
+							const dFloat32 dx = x[index] - x[neighbor];
+							const dFloat32 dy = y[index] - y[neighbor];
+							const dFloat32 dz = z[index] - z[neighbor];
+							const dFloat32 dist2 = dx * dx + dy * dy + dz * dz;
+							if ((dist2 < h2) && (neighbor != index))
+							{
+								if (n < capacity)
+								{
+									neighborArray[n] = neighbor;
+								}
+								n++;
+							}
+						}
+						maxCount = dMax(maxCount, n);
+						neighborCount[index] = dMin(n, capacity);
+					}
 				}
 			}
+			context->m_maxCount[threadIndex] = maxCount;
 		}
 	};
 
-	class ndBodySphFluidAddPartialSum : public ndScene::ndBaseJob
+	const dInt32 particleCount = m_posit.GetCount();
+	m_neighborCount.SetCount(particleCount);
+
+	ndContext context;
+	context.m_fluid = this;
+	ndScene* const scene = world->GetScene();
+	const dInt32 threadCount = scene->GetThreadCount();
+	for (bool overflow = true; overflow; )
+	{
+		m_neighbors.SetCount(particleCount * m_neighborCapacity);
+		scene->SubmitJobs<ndBuildNeighbors>(&context);
+
+		dInt32 maxCount = 0;
+		for (dInt32 i = 0; i < threadCount; i++)
+		{
+			maxCount = dMax(maxCount, context.m_maxCount[i]);
+		}
+		overflow = maxCount > m_neighborCapacity;
+		if (overflow)
+		{
+			m_neighborCapacity = (maxCount + 7) & -8;
+		}
+	}
+}
+
+void ndBodySphFluid::CalculateDensities(const ndWorld* const world)
+{
+	D_TRACKTIME();
+	class ndCalculateDensities: public ndScene::ndBaseJob
 	{
 		virtual void Execute()
 		{
 			D_TRACKTIME();
-			ndWorld* const world = m_owner->GetWorld();
-			ndContext* const context = (ndContext*)m_context;
-			const dInt32 threadId = GetThredId();
-			const dInt32 threadCount = world->GetThreadCount();
-			
-			const dInt32 count = context->m_pass ? sizeof (context->m_scan) / sizeof (dInt32) : sizeof(context->m_scan) / (2 * sizeof(dInt32));
-			const dInt32 size = count / threadCount;
-			const dInt32 start = threadId * size;
-			const dInt32 batchSize = (threadId == threadCount - 1) ? count - start : size;
+			ndBodySphFluid* const fluid = (ndBodySphFluid*)m_context;
+			const dInt32 threadIndex = GetThredId();
+			const dInt32 threadCount = m_owner->GetThreadCount();
+			const dInt32 particleCount = fluid->m_posit.GetCount();
+			const dInt32 step = particleCount / threadCount;
+			const dInt32 start = threadIndex * step;
+			const dInt32 count = ((threadIndex + 1) < threadCount) ? step : particleCount - start;
+
+			// poly6 kernel
+			const dFloat32 h = fluid->m_radius;
+			const dFloat32 h2 = h * h;
+			const dFloat32 kernelMass = fluid->m_mass * dFloat32(315.0f) / (dFloat32(64.0f) * dPi * h2 * h2 * h2 * h2 * h);
+			const dFloat32 restDensity = fluid->m_restDensity;
+			const dFloat32 gasConstant = fluid->m_gasConstant;
+
+			const dFloat32* const x = &fluid->m_positSoa.m_x[0];
+			const dFloat32* const y = &fluid->m_positSoa.m_y[0];
+			const dFloat32* const z = &fluid->m_positSoa.m_z[0];
+			const dInt32* const neighborCount = &fluid->m_neighborCount[0];
+			const dInt32* const neighbors = &fluid->m_neighbors[0];
+			const dInt32 capacity = fluid->m_neighborCapacity;
+			dFloat32* const density = &fluid->m_density[0];
+			dFloat32* const pressure = &fluid->m_pressure[0];
 
-			dInt32* const scan = context->m_scan;
-			for (dInt32 i = 0; i < batchSize; i++)
+			for (dInt32 i = start; i < (start + count); i++)
 			{
-				dInt32 acc = 0;
-				for (dInt32 j = 0; j < threadCount; j++)
+				const dInt32* const neighborArray = &neighbors[i * capacity];
+				dFloat32 sum = h2 * h2 * h2;
+				for (dInt32 j = neighborCount[i] - 1; j >= 0; j--)
 				{
-					acc += context->m_histogram[j][i + start];
+					const dInt32 neighbor = neighborArray[j];
+					const dFloat32 dx = x[i] - x[neighbor];
+					const dFloat32 dy = y[i] - y[neighbor];
+					const dFloat32 dz = z[i] - z[neighbor];
+					const dFloat32 q = dMax(h2 - (dx * dx + dy * dy + dz * dz), dFloat32(0.0f));
+					sum += q * q * q;
 				}
-				scan[i + start] = acc;
+				density[i] = kernelMass * sum;
+				// no tension, a free surface pulling particles together makes the fluid clump.
+				pressure[i] = dMax(gasConstant * (density[i] - restDensity), dFloat32(0.0f));
 			}
 		}
 	};
 
-	class ndBodySphFluidReorderBuckets: public ndScene::ndBaseJob
+	const dInt32 particleCount = m_posit.GetCount();
+	m_density.SetCount(particleCount);
+	m_pressure.SetCount(particleCount);
+
+	ndScene* const scene = world->GetScene();
+	scene->SubmitJobs<ndCalculateDensities>(this);
+}
+
+void ndBodySphFluid::CalculateAccelerations(const ndWorld* const world)
+{
+	D_TRACKTIME();
+	class ndContext
+	{
+		public:
+		ndBodySphFluid* m_fluid;
+		dVector m_gravity;
+	};
+
+	class ndCalculateAccelerations: public ndScene::ndBaseJob
 	{
 		virtual void Execute()
 		{
 			D_TRACKTIME();
-			ndWorld* const world = m_owner->GetWorld();
 			ndContext* const context = (ndContext*)m_context;
 			ndBodySphFluid* const fluid = context->m_fluid;
-			const dInt32 threadId = GetThredId();
-			const dInt32 threadCount = world->GetThreadCount();
-
-			const dInt32 count = fluid->m_hashGridMap.GetCount();
-			const dInt32 size = count / threadCount;
-			const dInt32 start = threadId * size;
-			const dInt32 batchSize = (threadId == threadCount - 1) ? count - start : size;
-
-			ndGridHash* const srcArray = &fluid->m_hashGridMap[start];
-			ndGridHash* const dstArray = &fluid->m_hashGridMapScratchBuffer[0];
-
-			dInt32 shiftbits = context->m_pass * D_RADIX_DIGIT_SIZE;
-			dUnsigned64 mask = ~dUnsigned64(dInt64(-1 << D_RADIX_DIGIT_SIZE));
-			mask = mask << shiftbits;
-			dInt32* const histogram = context->m_histogram[threadId];
-			if (context->m_pass)
-			{
-				for (dInt32 i = 0; i < batchSize; i++)
-				{
-					const ndGridHash& entry = srcArray[i];
-					const dInt32 key = dUnsigned32((entry.m_gridHash & mask) >> shiftbits);
-					const dInt32 index = histogram[key];
-					dstArray[index] = entry;
-					histogram[key] = index + 1;
-				}
-			}
-			else
+			const dInt32 threadIndex = GetThredId();
+			const dInt32 threadCount = m_owner->GetThreadCount();
+			const dInt32 particleCount = fluid->m_posit.GetCount();
+			const dInt32 step = particleCount / threadCount;
+			const dInt32 start = threadIndex * step;
+			const dInt32 count = ((threadIndex + 1) < threadCount) ? step : particleCount - start;
+
+			// spiky kernel gradient for pressure and viscosity kernel laplacian, 
+			// both have the same constant.
+			const dFloat32 h = fluid->m_radius;
+			const dFloat32 h2 = h * h;
+			const dFloat32 kernelMass = fluid->m_mass * dFloat32(45.0f) / (dPi * h2 * h2 * h2);
+			const dFloat32 viscosity = fluid->m_viscosity;
+			const dFloat32 gx = context->m_gravity.m_x;
+			const dFloat32 gy = context->m_gravity.m_y;
+			const dFloat32 gz = context->m_gravity.m_z;
+
+			const dFloat32* const x = &fluid->m_positSoa.m_x[0];
+			const dFloat32* const y = &fluid->m_positSoa.m_y[0];
+			const dFloat32* const z = &fluid->m_positSoa.m_z[0];
+			const dFloat32* const vx = &fluid->m_veloc.m_x[0];
+			const dFloat32* const vy = &fluid->m_veloc.m_y[0];
+			const dFloat32* const vz = &fluid->m_veloc.m_z[0];
+			const dFloat32* const density = &fluid->m_density[0];
+			const dFloat32* const pressure = &fluid->m_pressure[0];
+			const dInt32* const neighborCount = &fluid->m_neighborCount[0];
+			const dInt32* const neighbors = &fluid->m_neighbors[0];
+			const dInt32 capacity = fluid->m_neighborCapacity;
+			dFloat32* const ax = &fluid->m_accel.m_x[0];
+			dFloat32* const ay = &fluid->m_accel.m_y[0];
+			dFloat32* const az = &fluid->m_accel.m_z[0];
+
+			for (dInt32 i = start; i < (start + count); i++)
 			{
-				for (dInt32 i = 0; i < batchSize; i++)
+				dFloat32 fx = dFloat32(0.0f);
+				dFloat32 fy = dFloat32(0.0f);
+				dFloat32 fz = dFloat32(0.0f);
+				const dInt32* const neighborArray = &neighbors[i * capacity];
+				for (dInt32 j = neighborCount[i] - 1; j >= 0; j--)
 				{
-					const ndGridHash& entry = srcArray[i];
-					const dInt32 key = dUnsigned32((entry.m_gridHash & mask) >> shiftbits) * 2 + entry.m_cellType;
-					const dInt32 index = histogram[key];
-					dstArray[index] = entry;
-					histogram[key] = index + 1;
+					const dInt32 neighbor = neighborArray[j];
+					const dFloat32 dx = x[i] - x[neighbor];
+					const dFloat32 dy = y[i] - y[neighbor];
+					const dFloat32 dz = z[i] - z[neighbor];
+					const dFloat32 dist2 = dx * dx + dy * dy + dz * dz;
+					const dFloat32 dist = dSqrt(dist2);
+					const dFloat32 q = dMax(h - dist, dFloat32(0.0f));
+					const dFloat32 invDensity = dFloat32(1.0f) / density[neighbor];
+
+					const dFloat32 pressureForce = (dist > dFloat32(1.0e-6f)) ? dFloat32(0.5f) * (pressure[i] + pressure[neighbor]) * invDensity * q * q / dist : dFloat32(0.0f);
+					fx += pressureForce * dx;
+					fy += pressureForce * dy;
+					fz += pressureForce * dz;
+
+					const dFloat32 viscosityForce = viscosity * invDensity * q;
+					fx += viscosityForce * (vx[neighbor] - vx[i]);
+					fy += viscosityForce * (vy[neighbor] - vy[i]);
+					fz += viscosityForce * (vz[neighbor] - vz[i]);
 				}
+
+				const dFloat32 scale = kernelMass / density[i];
+				ax[i] = fx * scale + gx;
+				ay[i] = fy * scale + gy;
+				az[i] = fz * scale + gz;
 			}
 		}
 	};
 
+	m_accel.SetCount(m_posit.GetCount());
+
 	ndContext context;
 	context.m_fluid = this;
+	context.m_gravity = GetNotifyCallback() ? GetNotifyCallback()->GetGravity() : dVector::m_zero;
+
 	ndScene* const scene = world->GetScene();
-	for (dInt32 pass = 0; pass < 6; pass++)
+	scene->SubmitJobs<ndCalculateAccelerations>(&context);
+}
+
+void ndBodySphFluid::IntegrateParticles(const ndWorld* const world, dFloat32 timestep)
+{
+	D_TRACKTIME();
+	class ndContext
+	{
+		public:
+		ndBodySphFluid* m_fluid;
+		dFloat32 m_timestep;
+	};
+
+	class ndIntegrateParticles: public ndScene::ndBaseJob
 	{
-		if (!(pass & 1) || m_upperDigisIsValid[pass >> 1])
+		virtual void Execute()
 		{
-			context.m_pass = pass;
-			scene->SubmitJobs<ndBodySphFluidCountDigits>(&context);
-			scene->SubmitJobs<ndBodySphFluidAddPartialSum>(&context);
+			D_TRACKTIME();
+			ndContext* const context = (ndContext*)m_context;
+			ndBodySphFluid* const fluid = context->m_fluid;
+			const dInt32 threadIndex = GetThredId();
+			const dInt32 threadCount = m_owner->GetThreadCount();
+			const dInt32 particleCount = fluid->m_posit.GetCount();
+			const dInt32 step = particleCount / threadCount;
+			const dInt32 start = threadIndex * step;
+			const dInt32 count = ((threadIndex + 1) < threadCount) ? step : particleCount - start;
+
+			const dFloat32 timestep = context->m_timestep;
+			dFloat32* const x = &fluid->m_positSoa.m_x[0];
+			dFloat32* const y = &fluid->m_positSoa.m_y[0];
+			dFloat32* const z = &fluid->m_positSoa.m_z[0];
+			dFloat32* const vx = &fluid->m_veloc.m_x[0];
+			dFloat32* const vy = &fluid->m_veloc.m_y[0];
+			dFloat32* const vz = &fluid->m_veloc.m_z[0];
+			const dFloat32* const ax = &fluid->m_accel.m_x[0];
+			const dFloat32* const ay = &fluid->m_accel.m_y[0];
+			const dFloat32* const az = &fluid->m_accel.m_z[0];
+			dVector* const posit = &fluid->m_posit[0];
 
-			dInt32 acc = 0;
-			for (dInt32 i = 0; i < sizeof(context.m_scan) / sizeof(dInt32); i++)
+			// symplectic euler
+			for (dInt32 i = start; i < (start + count); i++)
 			{
-				dInt32 sum = context.m_scan[i];
-				context.m_scan[i] = acc;
-				acc += sum;
+				vx[i] += ax[i] * timestep;
+				vy[i] += ay[i] * timestep;
+				vz[i] += az[i] * timestep;
+				x[i] += vx[i] * timestep;
+				y[i] += vy[i] * timestep;
+				z[i] += vz[i] * timestep;
+				posit[i] = dVector(x[i], y[i], z[i], dFloat32(1.0f));
 			}
-			AddCounters(world, context);
-
-			scene->SubmitJobs<ndBodySphFluidReorderBuckets>(&context);
-			m_hashGridMap.Swap(m_hashGridMapScratchBuffer);
 		}
-	}	
+	};
+
+	ndContext context;
+	context.m_fluid = this;
+	context.m_timestep = timestep;
+
+	ndScene* const scene = world->GetScene();
+	scene->SubmitJobs<ndIntegrateParticles>(&context);
 }
 
-void ndBodySphFluid::SortGrids(const ndWorld* const world)
+void ndBodySphFluid::CollideWithBodies(const ndWorld* const world, dFloat32 timestep)
 {
-	const dInt32 threadCount = world->GetThreadCount();
-	m_hashGridMapScratchBuffer.SetCount(m_hashGridMap.GetCount());
-	if (threadCount <= 1)
+	D_TRACKTIME();
+	class ndContext
 	{
-		dAssert(threadCount == 1);
-		SortSingleThreaded(world);
-	}
-	else
+		public:
+		ndBodySphFluid* m_fluid;
+		dFloat32 m_timestep;
+	};
+
+	class ndParticleRayCast: public ndRayCastNotify
 	{
-		SortParallel(world);
-	}
+		public:
+		ndParticleRayCast(const ndScene* const scene)
+			:ndRayCastNotify(scene)
+		{
+		}
 
-#ifdef _DEBUG
-	for (dInt32 i = 0; i < (m_hashGridMap.GetCount() - 1); i++)
+		dFloat32 OnRayCastAction(const ndContactPoint&, dFloat32 intersetParam)
+		{
+			return intersetParam;
+		}
+	};
+
+	class ndCollideWithBodies: public ndScene::ndBaseJob
 	{
-		const ndGridHash& entry0 = m_hashGridMap[i + 0];
-		const ndGridHash& entry1 = m_hashGridMap[i + 1];
-		dUnsigned64 gridHashA = entry0.m_gridHash * 2 + entry0.m_cellType;
-		dUnsigned64 gridHashB = entry1.m_gridHash * 2 + entry1.m_cellType;
-		dAssert(gridHashA <= gridHashB);
-	}
-#endif
-}
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			ndContext* const context = (ndContext*)m_context;
+			ndBodySphFluid* const fluid = context->m_fluid;
+			const dInt32 threadIndex = GetThredId();
+			const dInt32 threadCount = m_owner->GetThreadCount();
+			const dInt32 cellCount = fluid->m_gridScans.GetCount() - 1;
+			const dInt32 step = cellCount / threadCount;
+			const dInt32 start = threadIndex * step;
+			const dInt32 count = ((threadIndex + 1) < threadCount) ? step : cellCount - start;
 
-D_NEWTON_API void ndBodySphFluid::GenerateIsoSurface(const ndWorld* const world)
-{
-	D_TRACKTIME();
-	dVector boxP0;
-	dVector boxP1;
-	CaculateAABB(world, boxP0, boxP1);
+			const dFloat32 timestep = context->m_timestep;
+			const dFloat32 radius = fluid->m_radius;
+			const dFloat32 impulseToForce = fluid->m_mass / timestep;
+			const dInt32* const scans = &fluid->m_gridScans[0];
+			const ndGridHash* const hashGridMap = &fluid->m_hashGridMap[0];
+			dFloat32* const x = &fluid->m_positSoa.m_x[0];
+			dFloat32* const y = &fluid->m_positSoa.m_y[0];
+			dFloat32* const z = &fluid->m_positSoa.m_z[0];
+			dFloat32* const vx = &fluid->m_veloc.m_x[0];
+			dFloat32* const vy = &fluid->m_veloc.m_y[0];
+			dFloat32* const vz = &fluid->m_veloc.m_z[0];
+			dVector* const posit = &fluid->m_posit[0];
 
-	dFloat32 gridSize = m_radius * dFloat32(2.0f);
-	const dVector invGridSize (dFloat32 (1.0f) / gridSize);
+			dArray<ndBodyImpulse>& impulses = fluid->m_threadBodyImpulses[threadIndex];
+			impulses.SetCount(0);
 
-	dVector padd(dFloat32(2.0f) * gridSize);
-	boxP0 -= padd & dVector::m_triplexMask;
-	boxP1 += padd & dVector::m_triplexMask;
+			ndBodyKinematic* bodies[D_SPH_MAX_CELL_BODIES];
+			for (dInt32 i = start; i < (start + count); i++)
+			{
+				// each particle has one home entry, and they are sorted first in their cell.
+				const dInt32 cellStart = scans[i];
+				dInt32 cellEnd = cellStart;
+				for (; (cellEnd < scans[i + 1]) && (hashGridMap[cellEnd].m_cellType == ndHomeGrid); cellEnd++);
 
-	m_hashGridMap.SetCount(m_posit.GetCount());
-	m_hashGridMapScratchBuffer.SetCount(m_posit.GetCount());
-	const dVector* const posit = &m_posit[0];
-	
-	for (dInt32 i = m_posit.GetCount() - 1; i >= 0; i--)
-	{
-		dVector r(posit[i] - boxP0);
-		dVector p(r * invGridSize);
-		ndGridHash hashKey(p, i, ndHomeGrid);
-		m_hashGridMap[i] = hashKey;
-	}
+				// one scene query for all the particles in the cell, with the box they swept this step.
+				dVector box0(dFloat32(1e20f));
+				dVector box1(dFloat32(-1e20f));
+				for (dInt32 j = cellStart; j < cellEnd; j++)
+				{
+					const dInt32 index = hashGridMap[j].m_particleIndex;
+					const dVector p1(x[index], y[index], z[index], dFloat32(0.0f));
+					const dVector p0(p1 - dVector(vx[index], vy[index], vz[index], dFloat32(0.0f)).Scale(timestep));
+					box0 = box0.GetMin(p0.GetMin(p1));
+					box1 = box1.GetMax(p0.GetMax(p1));
+				}
+				const dInt32 bodyCount = (cellEnd > cellStart) ? m_owner->BodiesInAabb(box0 - dVector(radius), box1 + dVector(radius), bodies, D_SPH_MAX_CELL_BODIES) : 0;
+
+				for (dInt32 j = 0; j < bodyCount; j++)
+				{
+					ndBodyKinematic* const body = bodies[j];
+					if (body->GetAsBodyTriggerVolume())
+					{
+						continue;
+					}
+
+					// the cell is rejected at once when its swept box, in the space of the shape,
+					// misses the shape obb, otherwise each particle is swept in the space of the shape.
+					const ndShapeInstance& shape = body->GetCollisionShape();
+					const dMatrix& matrix = shape.GetGlobalMatrix();
+					dVector obbOrigin;
+					dVector obbSize;
+					shape.CalculateObb(obbOrigin, obbSize);
+					const dMatrix absMatrix(matrix.m_front.Abs(), matrix.m_up.Abs(), matrix.m_right.Abs(), dVector::m_wOne);
+					const dVector boxCenter(matrix.UntransformVector((box0 + box1) * dVector::m_half) - obbOrigin);
+					const dVector boxSize(absMatrix.UnrotateVector((box1 - box0) * dVector::m_half + dVector(radius)));
+					const dVector gap(((boxCenter.Abs() - boxSize - obbSize) & dVector::m_triplexMask) > dVector::m_zero);
+					if (gap.GetSignMask())
+					{
+						continue;
+					}
+
+					// remove the approaching velocity of each particle that hits the body.
+					dVector force(dVector::m_zero);
+					dVector torque(dVector::m_zero);
+					ndParticleRayCast rayCaster(m_owner);
+					const dVector com(body->GetMatrix().TransformVector(body->GetCentreOfMass()));
+					for (dInt32 k = cellStart; k < cellEnd; k++)
+					{
+						const dInt32 index = hashGridMap[k].m_particleIndex;
+						const dVector p1(x[index], y[index], z[index], dFloat32(1.0f));
+						const dVector veloc(vx[index], vy[index], vz[index], dFloat32(0.0f));
+						const dVector relVeloc(veloc - body->GetVelocityAtPoint(p1));
+						const dVector displacement(relVeloc.Scale(timestep));
+						const dFloat32 dist2 = displacement.DotProduct(displacement).GetScalar();
+						if (dist2 > dFloat32(1.0e-12f))
+						{
+							const dVector dir(displacement.Scale(dFloat32(1.0f) / dSqrt(dist2)));
+							const dVector localP0(matrix.UntransformVector(p1 - displacement) & dVector::m_triplexMask);
+							const dVector localP1(matrix.UntransformVector(p1 + dir.Scale(radius)) & dVector::m_triplexMask);
+
+							ndContactPoint contact;
+							const dFloat32 param = shape.RayCast(rayCaster, localP0, localP1, body, contact);
+							if (param < dFloat32(1.0f))
+							{
+								const dVector normal(matrix.RotateVector(contact.m_normal) & dVector::m_triplexMask);
+								const dFloat32 normalSpeed = relVeloc.DotProduct(normal).GetScalar();
+								if (normalSpeed < dFloat32(0.0f))
+								{
+									const dVector deltaVeloc(normal.Scale(-normalSpeed));
+									const dVector point(matrix.TransformVector(localP0 + (localP1 - localP0).Scale(param)) & dVector::m_triplexMask);
+									const dVector p((point + normal.Scale(radius)) | dVector::m_wOne);
+									const dVector v(veloc + deltaVeloc);
+									x[index] = p.m_x;
+									y[index] = p.m_y;
+									z[index] = p.m_z;
+									vx[index] = v.m_x;
+									vy[index] = v.m_y;
+									vz[index] = v.m_z;
+									posit[index] = p;
+
+									const dVector reaction(deltaVeloc.Scale(-impulseToForce));
+									force += reaction;
+									torque += (point - com).CrossProduct(reaction);
+								}
+							}
+						}
+					}
+
+					ndBodyDynamic* const dynBody = body->GetAsBodyDynamic();
+					if (dynBody && (dynBody->GetInvMass() > dFloat32(0.0f)) && (force.DotProduct(force).GetScalar() > dFloat32(0.0f)))
+					{
+						ndBodyImpulse impulse;
+						impulse.m_force = force & dVector::m_triplexMask;
+						impulse.m_torque = torque & dVector::m_triplexMask;
+						impulse.m_body = dynBody;
+						impulses.PushBack(impulse);
+					}
+				}
+			}
+		}
+	};
 
 	ndContext context;
 	context.m_fluid = this;
+	context.m_timestep = timestep;
+
+	ndScene* const scene = world->GetScene();
+	scene->SubmitJobs<ndCollideWithBodies>(&context);
+}
 
-	SortSingleThreaded(world);
-	dInt32 uniqueCount = 0;
-	for (dInt32 i = 0; i < m_hashGridMap.GetCount();)
+void ndBodySphFluid::ApplyBodyImpulses(const ndWorld* const world)
+{
+	D_TRACKTIME();
+	class ndApplyBodyImpulses: public ndScene::ndBaseJob
 	{
-		dUnsigned64 key0 = m_hashGridMap[i].m_gridHash;
-		m_hashGridMap[uniqueCount].m_gridHash = m_hashGridMap[i].m_gridHash;
-		uniqueCount++;
-		for (i ++; (i < m_hashGridMap.GetCount()) && (key0 == m_hashGridMap[i].m_gridHash); i++);
-	}
+		virtual void Execute()
+		{
+			D_TRACKTIME();
+			ndBodySphFluid* const fluid = (ndBodySphFluid*)m_context;
+			const dInt32 threadIndex = GetThredId();
+			const dInt32 threadCount = m_owner->GetThreadCount();
+			const dInt32 impulseCount = fluid->m_bodyImpulses.GetCount();
+			const dInt32 step = impulseCount / threadCount;
+			const dInt32 start = threadIndex * step;
+			const dInt32 count = ((threadIndex + 1) < threadCount) ? step : impulseCount - start;
 
-	ndGridHash hashBox0(dVector::m_zero, 0, ndHomeGrid);
-	ndGridHash hashBox1((boxP1 - boxP0) * invGridSize, 0, ndHomeGrid);
+			// the impulses are sorted by body, a thread owns the runs that start in its range.
+			const ndBodyImpulse* const impulses = &fluid->m_bodyImpulses[0];
+			dInt32 i = start;
+			for (; (i < (start + count)) && i && (impulses[i].m_body == impulses[i - 1].m_body); i++);
+			while (i < (start + count))
+			{
+				ndBodyDynamic* const body = impulses[i].m_body;
+				dVector force(dVector::m_zero);
+				dVector torque(dVector::m_zero);
+				for (; (i < impulseCount) && (impulses[i].m_body == body); i++)
+				{
+					force += impulses[i].m_force;
+					torque += impulses[i].m_torque;
+				}
+				body->SetForce(body->GetForce() + force);
+				body->SetTorque(body->GetTorque() + torque);
+			}
+		}
+	};
 
-	dUnsigned64 cellCount = (hashBox1.m_z - hashBox0.m_z) * (hashBox1.m_y - hashBox0.m_y) * (hashBox1.m_x - hashBox0.m_x);
+	ndScene* const scene = world->GetScene();
+	const dInt32 threadCount = scene->GetThreadCount();
+	dInt32 impulseCount = 0;
+	for (dInt32 i = 0; i < threadCount; i++)
+	{
+		impulseCount += m_threadBodyImpulses[i].GetCount();
+	}
+	if (!impulseCount)
+	{
+		return;
+	}
 
-	//if (cellCount <= 128)
-	if (cellCount <= 256)
+	m_bodyImpulses.SetCount(impulseCount);
+	m_bodyImpulsesScratchBuffer.SetCount(impulseCount);
+	impulseCount = 0;
+	for (dInt32 i = 0; i < threadCount; i++)
 	{
-		dAssert((hashBox1.m_z - hashBox0.m_z) > 1);
-		dAssert((hashBox1.m_y - hashBox0.m_y) > 1);
-		dAssert((hashBox1.m_x - hashBox0.m_x) > 1);
-
-		const int x_ = 6;
-		const int y_ = 6;
-		const int z_ = 20;
-		dFloat32 xxx[z_][y_][x_];
-		memset(xxx, 0, sizeof(xxx));
-		for (dInt32 i = 0; i < uniqueCount; i++)
+		const dArray<ndBodyImpulse>& impulses = m_threadBodyImpulses[i];
+		for (dInt32 j = 0; j < impulses.GetCount(); j++)
 		{
-			dInt32 x = m_hashGridMap[i].m_x;
-			dInt32 y = m_hashGridMap[i].m_y;
-			dInt32 z = m_hashGridMap[i].m_z;
-			xxx[z][y][x] = 1.0f;
+			m_bodyImpulses[impulseCount] = impulses[j];
+			impulseCount++;
 		}
-		
-		dInt32 gridCountX = dInt32(hashBox1.m_x - hashBox0.m_x) + 32;
-		dInt32 gridCountY = dInt32(hashBox1.m_y - hashBox0.m_y) + 32;
-		dInt32 gridCountZ = dInt32(hashBox1.m_z - hashBox0.m_z) + 32;
-		m_isoSurcase.Begin(boxP0, dFloat32(0.5f), gridSize, gridCountX, gridCountY, gridCountZ);
-		
-		dIsoSurface::dIsoCell cell;
-		for (dInt32 z = 0; z < z_-1; z++)
+	}
+
+	dParallelRadixSort<ndBodyImpulse, ndBodyImpulseKey>(scene, &m_bodyImpulses[0], &m_bodyImpulsesScratchBuffer[0], impulseCount);
+	scene->SubmitJobs<ndApplyBodyImpulses>(this);
+}
+
+void ndBodySphFluid::GenerateIsoSurface(const ndWorld* const world)
+{
+	D_TRACKTIME();
+	class ndBuildIsoSurfaceCells: public ndScene::ndBaseJob
+	{
+		virtual void Execute()
 		{
-			cell.m_z = z;
-			for (dInt32 y = 0; y < y_-1; y++)
+			D_TRACKTIME();
+			ndBodySphFluid* const fluid = (ndBodySphFluid*)m_context;
+			const dInt32 threadIndex = GetThredId();
+			const dInt32 threadCount = m_owner->GetThreadCount();
+			const dInt32 cellCount = fluid->m_gridScans.GetCount() - 1;
+			const dInt32 step = cellCount / threadCount;
+			const dInt32 start = threadIndex * step;
+			const dInt32 count = ((threadIndex + 1) < threadCount) ? step : cellCount - start;
+
+			// the grid is sorted by z, y and x, and the home entries are first in each cell.
+			const dInt32* const scans = &fluid->m_gridScans[0];
+			const ndGridHash* const hashGridMap = &fluid->m_hashGridMap[0];
+			dIsoSurface::dGridCell* const cells = &fluid->m_isoSurfaceCells[0];
+			for (dInt32 i = start; i < (start + count); i++)
 			{
-				cell.m_y = y;
-				for (dInt32 x = 0; x < x_-1; x++)
-				{
-					cell.m_x = x;
-					cell.m_isoValues[0][0][0] = xxx[z + 0][y + 0][x + 0];
-					cell.m_isoValues[0][0][1] = xxx[z + 0][y + 0][x + 1];
-					cell.m_isoValues[0][1][0] = xxx[z + 0][y + 1][x + 0];
-					cell.m_isoValues[0][1][1] = xxx[z + 0][y + 1][x + 1];
-					cell.m_isoValues[1][0][0] = xxx[z + 1][y + 0][x + 0];
-					cell.m_isoValues[1][0][1] = xxx[z + 1][y + 0][x + 1];
-					cell.m_isoValues[1][1][0] = xxx[z + 1][y + 1][x + 0];
-					cell.m_isoValues[1][1][1] = xxx[z + 1][y + 1][x + 1];
-					m_isoSurcase.ProcessCell(cell);
-				}
+				const ndGridHash& entry = hashGridMap[scans[i]];
+				dIsoSurface::dGridCell& cell = cells[i];
+				cell.m_x = dInt32(entry.m_x);
+				cell.m_y = dInt32(entry.m_y);
+				cell.m_z = dInt32(entry.m_z);
+				cell.m_start = scans[i];
+				dInt32 end = scans[i];
+				for (; (end < scans[i + 1]) && (hashGridMap[end].m_cellType == ndHomeGrid); end++);
+				cell.m_count = end - scans[i];
 			}
 		}
-		m_isoSurcase.End();
-	}
-}
\ No newline at end of file
+	};
+
+	const dInt32 cellCount = m_gridScans.GetCount() - 1;
+	m_isoSurfaceCells.SetCount(cellCount);
+	ndScene* const scene = world->GetScene();
+	scene->SubmitJobs<ndBuildIsoSurfaceCells>(this);
+
+	// half the kernel peak as the surface level
+	m_isoSurcase.GenerateMesh(scene, &m_posit[0], &m_isoSurfaceCells[0], cellCount, &m_hashGridMap[0].m_particleIndex, sizeof(ndGridHash), m_box0, GetGridSize(), dFloat32(0.5f));
+}
@@ -25,7 +25,11 @@
 #include "ndNewtonStdafx.h"
 #include "ndBodyParticleSet.h"
 
+class ndBodyDynamic;
+
 #define D_RADIX_DIGIT_SIZE	10
+#define D_SPH_MAX_NEIGHBORS	32
+#define D_SPH_MAX_CELL_BODIES	32
 
 D_MSV_NEWTON_ALIGN_32
 class ndBodySphFluid: public ndBodyParticleSet
@@ -40,9 +44,31 @@ class ndBodySphFluid: public ndBodyParticleSet
 
 	D_NEWTON_API virtual void AddParticle(const dFloat32 mass, const dVector& position, const dVector& velocity);
 
-	D_NEWTON_API virtual void GenerateIsoSurface(const ndWorld* const world);
-
+	// when enabled, the iso surface is rebuilt once per world update from the cells of the 
+	// sph grid, in the last substep before the particles move.
 	const dIsoSurface& GetIsoSurface() const;
+	bool GetUpdateIsoSurface() const;
+	void SetUpdateIsoSurface(bool state);
+
+	// the particle radius is the smoothing length of the sph kernels.
+	// all particles have the mass of the first one added to the fluid.
+	dFloat32 GetParticleMass() const;
+
+	// the densities of the last update
+	const dArray<dFloat32>& GetDensities() const;
+
+	// the neighbor list of each particle has room for D_SPH_MAX_NEIGHBORS, and it
+	// grows when a particle has more neighbors, so no neighbor is ever dropped.
+	dInt32 GetNeighborCapacity() const;
+
+	dFloat32 GetRestDensity() const;
+	void SetRestDensity(dFloat32 density);
+
+	dFloat32 GetGasConstant() const;
+	void SetGasConstant(dFloat32 stiffness);
+
+	dFloat32 GetViscosity() const;
+	void SetViscosity(dFloat32 viscosity);
 
 	protected:
 	D_NEWTON_API virtual void Update(const ndWorld* const world, dFloat32 timestep);
@@ -105,29 +131,93 @@ class ndBodySphFluid: public ndBodyParticleSet
 		ndGridType m_cellType;
 	};
 
-	class ndContext
+	class ndGridHashKey
+	{
+		public:
+		ndGridHashKey(void* const)
+		{
+		}
+
+		dUnsigned64 GetKey(const ndGridHash& entry) const
+		{
+			return entry.m_gridHash * 2 + entry.m_cellType;
+		}
+	};
+
+	// the reaction of the particles of one cell on one rigid body
+	class ndBodyImpulse
+	{
+		public:
+		dVector m_force;
+		dVector m_torque;
+		ndBodyDynamic* m_body;
+	};
+
+	class ndBodyImpulseKey
+	{
+		public:
+		ndBodyImpulseKey(void* const)
+		{
+		}
+
+		dUnsigned64 GetKey(const ndBodyImpulse& entry) const
+		{
+			return dUnsigned64(size_t(entry.m_body));
+		}
+	};
+
+	class ndSoaVector
 	{
 		public:
-		ndBodySphFluid* m_fluid;
-		dInt32 m_pass;
-		dInt32 m_scan[1 << (D_RADIX_DIGIT_SIZE + 1)];
-		dInt32 m_histogram[D_MAX_THREADS_COUNT][1 << (D_RADIX_DIGIT_SIZE + 1)];
+		void SetCount(dInt32 count);
+		void PushBack(const dVector& v);
+		dVector Get(dInt32 i) const;
+		void Set(dInt32 i, const dVector& v);
+
+		dArray<dFloat32> m_x;
+		dArray<dFloat32> m_y;
+		dArray<dFloat32> m_z;
 	};
 
 	void SortGrids(const ndWorld* const world);
 	void CreateGrids(const ndWorld* const world);
-	void AddCounters(const ndWorld* const world, ndContext& context) const;
 	void CaculateAABB(const ndWorld* const world, dVector& boxP0, dVector& boxP1) const;
+	dFloat32 GetGridSize() const;
 
-	void SortParallel(const ndWorld* const world);
-	void SortSingleThreaded(const ndWorld* const world);
+	void CalculateScans(const ndWorld* const world);
+	void BuildNeighbors(const ndWorld* const world);
+	void CalculateDensities(const ndWorld* const world);
+	void CalculateAccelerations(const ndWorld* const world);
+	void IntegrateParticles(const ndWorld* const world, dFloat32 timestep);
+	void CollideWithBodies(const ndWorld* const world, dFloat32 timestep);
+	void ApplyBodyImpulses(const ndWorld* const world);
+	void GenerateIsoSurface(const ndWorld* const world);
 
 	dVector m_box0;
 	dVector m_box1;
+	ndSoaVector m_positSoa;
+	ndSoaVector m_veloc;
+	ndSoaVector m_accel;
+	dArray<dFloat32> m_density;
+	dArray<dFloat32> m_pressure;
+	dArray<dInt32> m_neighborCount;
+	dArray<dInt32> m_neighbors;
+	dArray<dInt32> m_gridScans;
 	dArray<ndGridHash> m_hashGridMap;
 	dArray<ndGridHash> m_hashGridMapScratchBuffer;
-	dInt32 m_upperDigisIsValid[3];
+	dArray<ndBodyImpulse> m_bodyImpulses;
+	dArray<ndBodyImpulse> m_bodyImpulsesScratchBuffer;
+	dArray<ndBodyImpulse> m_threadBodyImpulses[D_MAX_THREADS_COUNT];
+	dArray<dIsoSurface::dGridCell> m_isoSurfaceCells;
+	dFloat32 m_mass;
+	dFloat32 m_restDensity;
+	dFloat32 m_gasConstant;
+	dFloat32 m_viscosity;
+	dInt32 m_neighborCapacity;
 	dIsoSurface m_isoSurcase;
+	dUnsigned32 m_frameIndex;
+	dInt32 m_subStepIndex;
+	bool m_updateIsoSurface;
 } D_GCC_NEWTON_ALIGN_32 ;
 
 inline dFloat32 ndBodySphFluid::RayCast(ndRayCastNotify& callback, const dFastRayTest& ray, const dFloat32 maxT) const
@@ -145,6 +235,92 @@ inline const dIsoSurface& ndBodySphFluid::GetIsoSurface() const
 	return m_isoSurcase;
 }
 
+inline bool ndBodySphFluid::GetUpdateIsoSurface() const
+{
+	return m_updateIsoSurface;
+}
+
+inline void ndBodySphFluid::SetUpdateIsoSurface(bool state)
+{
+	m_updateIsoSurface = state;
+}
+
+inline dFloat32 ndBodySphFluid::GetGridSize() const
+{
+	return m_radius * dFloat32(2.0f * 1.0625f);
+}
+
+inline dFloat32 ndBodySphFluid::GetParticleMass() const
+{
+	return m_mass;
+}
+
+inline const dArray<dFloat32>& ndBodySphFluid::GetDensities() const
+{
+	return m_density;
+}
+
+inline dInt32 ndBodySphFluid::GetNeighborCapacity() const
+{
+	return m_neighborCapacity;
+}
+
+inline dFloat32 ndBodySphFluid::GetRestDensity() const
+{
+	return m_restDensity;
+}
+
+inline void ndBodySphFluid::SetRestDensity(dFloat32 density)
+{
+	m_restDensity = dMax(density, dFloat32(1.0e-3f));
+}
+
+inline dFloat32 ndBodySphFluid::GetGasConstant() const
+{
+	return m_gasConstant;
+}
+
+inline void ndBodySphFluid::SetGasConstant(dFloat32 stiffness)
+{
+	m_gasConstant = dMax(stiffness, dFloat32(0.0f));
+}
+
+inline dFloat32 ndBodySphFluid::GetViscosity() const
+{
+	return m_viscosity;
+}
+
+inline void ndBodySphFluid::SetViscosity(dFloat32 viscosity)
+{
+	m_viscosity = dMax(viscosity, dFloat32(0.0f));
+}
+
+inline void ndBodySphFluid::ndSoaVector::SetCount(dInt32 count)
+{
+	m_x.SetCount(count);
+	m_y.SetCount(count);
+	m_z.SetCount(count);
+}
+
+inline void ndBodySphFluid::ndSoaVector::PushBack(const dVector& v)
+{
+	m_x.PushBack(v.m_x);
+	m_y.PushBack(v.m_y);
+	m_z.PushBack(v.m_z);
+}
+
+inline dVector ndBodySphFluid::ndSoaVector::Get(dInt32 i) const
+{
+	return dVector(m_x[i], m_y[i], m_z[i], dFloat32(0.0f));
+}
+
+inline void ndBodySphFluid::ndSoaVector::Set(dInt32 i, const dVector& v)
+{
+	m_x[i] = v.m_x;
+	m_y[i] = v.m_y;
+	m_z[i] = v.m_z;
+}
+
 #endif 
 
 
@@ -32,8 +32,11 @@
 ndDynamicsUpdate::ndDynamicsUpdate()
 	:m_velocTol(dFloat32(1.0e-8f))
 	,m_islands(1024)
+	,m_jointIsland(1024)
+	,m_jointResidual(1024)
 	,m_bodyIslandOrder(1024)
 	,m_internalForces(1024)
+	,m_skeletonArray(256)
 	,m_jointArray()
 	,m_leftHandSide(1024 * 4)
 	,m_rightHandSide(1024)
@@ -59,14 +62,51 @@ ndDynamicsUpdate::~ndDynamicsUpdate()
 	Clear();
 }
 
+ndDynamicsUpdate::ndBodyStateArray::ndBodyStateArray()
+	:m_invInertia(1024)
+	,m_invMass(1024)
+	,m_force(1024)
+	,m_torque(1024)
+	,m_body(1024)
+	,m_index(1024)
+	,m_gyroscopic(1024)
+{
+}
+
+void ndDynamicsUpdate::ndBodyStateArray::SetCount(dInt32 count)
+{
+	m_invInertia.SetCount(count);
+	m_invMass.SetCount(count);
+	m_force.SetCount(count);
+	m_torque.SetCount(count);
+	m_body.SetCount(count);
+	m_index.SetCount(count);
+	m_gyroscopic.SetCount(count);
+}
+
+void ndDynamicsUpdate::ndBodyStateArray::Resize(dInt32 count)
+{
+	m_invInertia.Resize(count);
+	m_invMass.Resize(count);
+	m_force.Resize(count);
+	m_torque.Resize(count);
+	m_body.Resize(count);
+	m_index.Resize(count);
+	m_gyroscopic.Resize(count);
+}
+
 void ndDynamicsUpdate::Clear()
 {
 	m_islands.Resize(0);
+	m_jointIsland.Resize(0);
+	m_jointResidual.Resize(0);
 	m_jointArray.Resize(0);
 	m_leftHandSide.Resize(0);
 	m_rightHandSide.Resize(0);
 	m_internalForces.Resize(0);
 	m_bodyIslandOrder.Resize(0);
+	m_bodyState.Resize(0);
+	m_skeletonArray.Resize(0);
 }
 
 dInt32 ndDynamicsUpdate::CompareIslands(const ndIsland* const islandA, const ndIsland* const islandB, void* const context)
@@ -84,6 +124,21 @@ dInt32 ndDynamicsUpdate::CompareIslands(const ndIsland* const islandA, const ndI
 	return 0;
 }
 
+dInt32 ndDynamicsUpdate::CompareSkeletons(ndSkeletonContainer* const* const skeletonA, ndSkeletonContainer* const* const skeletonB, void* const context)
+{
+	const dInt32 costA = (*skeletonA)->GetSolverCost();
+	const dInt32 costB = (*skeletonB)->GetSolverCost();
+	if (costA < costB)
+	{
+		return 1;
+	}
+	else if (costA > costB)
+	{
+		return -1;
+	}
+	return 0;
+}
+
 void ndDynamicsUpdate::BuildIsland()
 {
 	ndScene* const scene = m_world->GetScene();
@@ -244,6 +299,13 @@ void ndDynamicsUpdate::BuildIsland()
 
 			m_unConstrainedBodyCount = unConstrainedCount;
 			dSort(&m_islands[0], m_islands.GetCount(), CompareIslands);
+
+			// the rank is not needed once the islands are built, the roots
+			// keep the negated island index so that the joints can find it.
+			for (dInt32 i = 0; i < m_islands.GetCount(); i++)
+			{
+				m_islands[i].m_root->m_rank = -(i + 1);
+			}
 		}
 	}
 }
@@ -305,6 +367,8 @@ void ndDynamicsUpdate::InitWeights()
 	const dInt32 jointCount = constraintArray.GetCount();
 
 	m_jointArray.SetCount(jointCount);
+	m_jointIsland.SetCount(jointCount);
+	m_jointResidual.SetCount(jointCount);
 	const dInt32 buffersCount = dMax(scene->GetThreadCount(), 1) + 1;
 	m_internalForces.SetCount(bodyCount * buffersCount);
 
@@ -317,6 +381,10 @@ void ndDynamicsUpdate::InitWeights()
 		ndBodyKinematic* const body0 = constraint->GetBody0();
 		ndBodyKinematic* const body1 = constraint->GetBody1();
 		maxRowCount += constraint->GetRowsCount();
+
+		// joints of islands that are not simulated have no island.
+		const ndBodyKinematic* const root = FindRootAndSplit(body0);
+		m_jointIsland[i] = (root->m_rank < 0) ? -root->m_rank - 1 : -1;
 		
 		if (body1->GetInvMass() == dFloat32(0.0f))
 		{
@@ -333,6 +401,14 @@ void ndDynamicsUpdate::InitWeights()
 		extraPasses = dMax(body0->m_weigh, extraPasses);
 	}
 
+	for (dInt32 i = 0; i < m_islands.GetCount(); i++)
+	{
+		ndIsland& island = m_islands[i];
+		island.m_iterations = 0;
+		island.m_initialResidual = dFloat32(0.0f);
+		island.m_residual = dFloat32(0.0f);
+	}
+
 	m_maxRowsCount = maxRowCount;
 	m_leftHandSide.SetCount(maxRowCount);
 	m_rightHandSide.SetCount(maxRowCount);
@@ -359,12 +435,13 @@ void ndDynamicsUpdate::InitBodyArray()
 			const dInt32 step = bodyCount / threadCount;
 			const dInt32 start = threadIndex * step;
 			const dInt32 count = ((threadIndex + 1) < threadCount) ? step : bodyCount - start;
-			const dFloat32 timestep = m_timestep;
+			ndBodyStateArray& bodyState = world->m_bodyState;
 
 			for (dInt32 i = 0; i < count; i++)
 			{
-				ndBodyKinematic* const body = bodyArray[start + i]->GetAsBodyDynamic();
-				ndBodyDynamic* const kinBody = body->GetAsBodyDynamic();
+				const dInt32 index = start + i;
+				ndBodyDynamic* const kinBody = bodyArray[index]->GetAsBodyDynamic();
+				bodyState.m_body[index] = kinBody;
 				if (kinBody)
 				{
 					dAssert(kinBody->m_bodyIsConstrained);
@@ -372,11 +449,36 @@ void ndDynamicsUpdate::InitBodyArray()
 					kinBody->AddDampingAcceleration(m_timestep);
 					kinBody->m_accel = kinBody->m_veloc;
 					kinBody->m_alpha = kinBody->m_omega;
+
+					// same integration rule as ndBodyDynamic::IntegrateForceAndToque, 
+					// an isotropic inertia becomes a diagonal matrix so that all 
+					// non gyroscopic bodies run the same kernel.
+					const dVector invMass(kinBody->m_invMass);
+					bodyState.m_gyroscopic[index] = 0;
+					if ((dAbs(invMass.m_x - invMass.m_y) < dFloat32(1.0e-5f)) &&
+						(dAbs(invMass.m_x - invMass.m_z) < dFloat32(1.0e-5f)))
+					{
+						bodyState.m_invInertia[index] = dMatrix(
+							dVector(invMass.m_x, dFloat32(0.0f), dFloat32(0.0f), dFloat32(0.0f)),
+							dVector(dFloat32(0.0f), invMass.m_y, dFloat32(0.0f), dFloat32(0.0f)),
+							dVector(dFloat32(0.0f), dFloat32(0.0f), invMass.m_z, dFloat32(0.0f)),
+							dVector::m_wOne);
+					}
+					else
+					{
+						bodyState.m_invInertia[index] = kinBody->m_invWorldInertiaMatrix;
+						bodyState.m_gyroscopic[index] = kinBody->GetGyroMode() ? 1 : 0;
+					}
+					bodyState.m_index[index] = kinBody->m_index;
+					bodyState.m_invMass[index] = dVector(invMass.m_w);
+					bodyState.m_force[index] = kinBody->GetForce();
+					bodyState.m_torque[index] = kinBody->GetTorque();
 				}
 			}
 		}
 	};
 
+	m_bodyState.SetCount(m_bodyIslandOrder.GetCount() - m_unConstrainedBodyCount);
 	ndScene* const scene = m_world->GetScene();
 	scene->SubmitJobs<ndInitBodyArray>();
 }
@@ -633,7 +735,7 @@ void ndDynamicsUpdate::InitJacobianMatrix()
 
 				const dInt32 bodyCount = m_owner->GetActiveBodyArray().GetCount();
 				ndJacobian* const internalForces = &world->m_internalForces[threadIndex * bodyCount];
-				memset(internalForces, 0, bodyCount * sizeof(ndJacobian));
+				memset((void*)internalForces, 0, bodyCount * sizeof(ndJacobian));
 				for (dInt32 i = 0; i < count; i++)
 				{
 					ndConstraint* const joint = jointArray[i + start];
@@ -685,7 +787,7 @@ void ndDynamicsUpdate::InitJacobianMatrix()
 
 		if (scene->GetThreadCount() <= 1)
 		{
-			memset(&m_internalForces[0], 0, bodyArray.GetCount() * sizeof(ndJacobian));
+			memset((void*)&m_internalForces[0], 0, bodyArray.GetCount() * sizeof(ndJacobian));
 			scene->SubmitJobs<ndInitJacobianMatrix>();
 		}
 		else
@@ -739,7 +841,7 @@ void ndDynamicsUpdate::CalculateJointsAcceleration()
 	m_firstPassCoef = dFloat32(1.0f);
 }
 
-dFloat32 ndDynamicsUpdate::CalculateJointsForce(ndConstraint* const joint, ndJacobian* const internalForces)
+dFloat32 ndDynamicsUpdate::CalculateJointsForce(ndConstraint* const joint, const ndJacobian* const bodyForces, ndJacobian* const internalForces)
 {
 	dVector accNorm(dVector::m_zero);
 	dFloat32 normalForce[D_CONSTRAINT_MAX_ROWS + 1];
@@ -760,10 +862,10 @@ dFloat32 ndDynamicsUpdate::CalculateJointsForce(ndConstraint* const joint, ndJac
 		dVector preconditioner0(joint->m_preconditioner0);
 		dVector preconditioner1(joint->m_preconditioner1);
 		
-		dVector forceM0(m_internalForces[m0].m_linear * preconditioner0);
-		dVector torqueM0(m_internalForces[m0].m_angular * preconditioner0);
-		dVector forceM1(m_internalForces[m1].m_linear * preconditioner1);
-		dVector torqueM1(m_internalForces[m1].m_angular * preconditioner1);
+		dVector forceM0(bodyForces[m0].m_linear * preconditioner0);
+		dVector torqueM0(bodyForces[m0].m_angular * preconditioner0);
+		dVector forceM1(bodyForces[m1].m_linear * preconditioner1);
+		dVector torqueM1(bodyForces[m1].m_angular * preconditioner1);
 		
 		preconditioner0 = preconditioner0.Scale(body0->m_weigh);
 		preconditioner1 = preconditioner1.Scale(body1->m_weigh);
@@ -855,12 +957,19 @@ dFloat32 ndDynamicsUpdate::CalculateJointsForce(ndConstraint* const joint, ndJac
 		}
 	}
 		
+	AddJointForce(joint, internalForces);
+	return accNorm.GetScalar();
+}
+
+void ndDynamicsUpdate::AddJointForce(const ndConstraint* const joint, ndJacobian* const internalForces) const
+{
 	dVector forceM0(dVector::m_zero);
 	dVector torqueM0(dVector::m_zero);
 	dVector forceM1(dVector::m_zero);
 	dVector torqueM1(dVector::m_zero);
-		
-	for (dInt32 j = 0; j < rowsCount; j++)
+
+	const dInt32 rowStart = joint->m_rowStart;
+	for (dInt32 j = 0; j < joint->m_rowCount; j++)
 	{
 		const ndRightHandSide* const rhs = &m_rightHandSide[rowStart + j];
 		const ndLeftHandSide* const lhs = &m_leftHandSide[rowStart + j];
@@ -872,16 +981,50 @@ dFloat32 ndDynamicsUpdate::CalculateJointsForce(ndConstraint* const joint, ndJac
 		torqueM1 = torqueM1.MulAdd(lhs->m_Jt.m_jacobianM1.m_angular, f);
 	}
 
-
-	ndJacobian& outBody0 = internalForces[m0];
+	ndJacobian& outBody0 = internalForces[joint->GetBody0()->m_index];
 	outBody0.m_linear += forceM0;
 	outBody0.m_angular += torqueM0;
 
-	ndJacobian& outBody1 = internalForces[m1];
+	ndJacobian& outBody1 = internalForces[joint->GetBody1()->m_index];
 	outBody1.m_linear += forceM1;
 	outBody1.m_angular += torqueM1;
+}
 
-	return accNorm.GetScalar();
+bool ndDynamicsUpdate::UpdateIslandResiduals(dInt32 iterations)
+{
+	// only the islands that were still converging got this pass, 
+	// their residual is the sum of the residual of their joints.
+	const dInt32 islandCount = m_islands.GetCount() - m_unConstrainedBodyCount;
+	for (dInt32 i = 0; i < islandCount; i++)
+	{
+		ndIsland& island = m_islands[i];
+		if (island.m_residual > D_SOLVER_MAX_ERROR)
+		{
+			island.m_residual = dFloat32(0.0f);
+			island.m_iterations += iterations;
+		}
+	}
+
+	for (dInt32 i = m_jointArray.GetCount() - 1; i >= 0; i--)
+	{
+		const dInt32 index = m_jointIsland[i];
+		if (index >= 0)
+		{
+			m_islands[index].m_residual += m_jointResidual[i];
+		}
+	}
+
+	bool converging = false;
+	for (dInt32 i = 0; i < islandCount; i++)
+	{
+		ndIsland& island = m_islands[i];
+		if (island.m_iterations == iterations)
+		{
+			island.m_initialResidual = island.m_residual;
+		}
+		converging = converging || (island.m_residual > D_SOLVER_MAX_ERROR);
+	}
+	return converging;
 }
 
 void ndDynamicsUpdate::IntegrateBodiesVelocity()
@@ -894,15 +1037,14 @@ void ndDynamicsUpdate::IntegrateBodiesVelocity()
 		{
 			//D_TRACKTIME();
 			ndWorld* const world = m_owner->GetWorld();
-			dArray<ndBodyKinematic*>& bodyArray = world->m_bodyIslandOrder;
+			ndBodyStateArray& bodyState = world->m_bodyState;
 
 			const dInt32 threadIndex = GetThredId();
 			const dInt32 threadCount = m_owner->GetThreadCount();
-			const dInt32 bodyCount = bodyArray.GetCount() - world->m_unConstrainedBodyCount;
+			const dInt32 bodyCount = bodyState.m_body.GetCount();
 			const dInt32 step = bodyCount / threadCount;
 			const dInt32 start = threadIndex * step;
 			const dInt32 count = ((threadIndex + 1) < threadCount) ? step : bodyCount - start;
-			const dFloat32 timestep = m_timestep;
 
 			const dVector timestep4(world->m_timestepRK);
 			const dVector speedFreeze2(world->m_freezeSpeed2 * dFloat32(0.1f));
@@ -910,21 +1052,29 @@ void ndDynamicsUpdate::IntegrateBodiesVelocity()
 			const dArray<ndJacobian>& internalForces = world->m_internalForces;
 			for (dInt32 i = 0; i < count; i++)
 			{
-				ndBodyKinematic* const body = bodyArray[i + start];
-				ndBodyDynamic* const dynBody = body->GetAsBodyDynamic();
-				if (dynBody)
+				const dInt32 index = i + start;
+				ndBodyDynamic* const body = bodyState.m_body[index];
+				if (body)
 				{
-					dAssert(dynBody->m_bodyIsConstrained);
-					const dInt32 index = dynBody->m_index;
-					const ndJacobian& forceAndTorque = internalForces[index];
-					const dVector force(dynBody->GetForce() + forceAndTorque.m_linear);
-					const dVector torque(dynBody->GetTorque() + forceAndTorque.m_angular);
+					dAssert(body->m_bodyIsConstrained);
+					const ndJacobian& forceAndTorque = internalForces[bodyState.m_index[index]];
+					const dVector force(bodyState.m_force[index] + forceAndTorque.m_linear);
+					const dVector torque(bodyState.m_torque[index] + forceAndTorque.m_angular);
 
-//dTrace(("%d bodyid: %d f(%f %f %f)\n", xxxx, dynBody->GetId(), force.m_x, force.m_y, force.m_z));
+					ndJacobian velocStep;
+					if (!bodyState.m_gyroscopic[index])
+					{
+						velocStep.m_linear = force * bodyState.m_invMass[index] * timestep4;
+						velocStep.m_angular = bodyState.m_invInertia[index].RotateVector(torque) * timestep4;
+					}
+					else
+					{
+						velocStep = body->IntegrateForceAndToque(force, torque, timestep4);
+					}
 
-					const ndJacobian velocStep(dynBody->IntegrateForceAndToque(force, torque, timestep4));
 					if (!body->m_resting)
 					{
+						// joints read the velocity from the body, so it stays in the body.
 						body->m_veloc += velocStep.m_linear;
 						body->m_omega += velocStep.m_angular;
 					}
@@ -1017,9 +1167,13 @@ void ndDynamicsUpdate::IntegrateBodies()
 			const dFloat32 timestep = m_timestep;
 			const dFloat32 maxAccNorm2 = D_SOLVER_MAX_ERROR * D_SOLVER_MAX_ERROR;
 			const dVector invTime(world->m_invTimestep);
+			const ndBodyStateArray& bodyState = world->m_bodyState;
+			const dInt32 constrainedCount = bodyState.m_body.GetCount();
 			for (dInt32 i = 0; i < count; i++)
 			{
-				ndBodyDynamic* const dynBody = bodyArray[start + i]->GetAsBodyDynamic();
+				// the constrained bodies were already resolved by the state gather
+				const dInt32 index = start + i;
+				ndBodyDynamic* const dynBody = (index < constrainedCount) ? bodyState.m_body[index] : bodyArray[index]->GetAsBodyDynamic();
 
 				// the initial velocity and angular velocity were stored in m_accel and dynBody->m_alpha for memory saving
 				if (dynBody)
@@ -1036,7 +1190,7 @@ void ndDynamicsUpdate::IntegrateBodies()
 				}
 				else
 				{
-					ndBodyKinematic* const kinBody = bodyArray[start + i]->GetAsBodyKinematic();
+					ndBodyKinematic* const kinBody = bodyArray[index]->GetAsBodyKinematic();
 					dAssert(kinBody);
 					if (!kinBody->m_equilibrium)
 					{
@@ -1299,33 +1453,37 @@ void ndDynamicsUpdate::InitSkeletons()
 		virtual void Execute()
 		{
 			//D_TRACKTIME();
-			const dInt32 threadIndex = GetThredId();
 			ndWorld* const world = m_owner->GetWorld();
-			ndSkeletonList::dListNode* node = world->GetSkeletonList().GetFirst();
-			for (dInt32 i = 0; i < threadIndex; i++)
-			{
-				node = node ? node->GetNext() : nullptr;
-			}
+			dAtomic<dInt32>& iterator = *((dAtomic<dInt32>*)m_context);
+			const dArray<ndSkeletonContainer*>& skeletonArray = world->m_skeletonArray;
 
 			dArray<ndRightHandSide>& rightHandSide = world->m_rightHandSide;
 			const dArray<ndLeftHandSide>& leftHandSide = world->m_leftHandSide;
 			
-			const dInt32 threadCount = m_owner->GetThreadCount();
-			while (node)
+			const dInt32 count = skeletonArray.GetCount();
+			for (dInt32 i = iterator.fetch_add(1); i < count; i = iterator.fetch_add(1))
 			{
-				ndSkeletonContainer* const skeleton = &node->GetInfo();
+				ndSkeletonContainer* const skeleton = skeletonArray[i];
 				skeleton->InitMassMatrix(&leftHandSide[0], &rightHandSide[0]);
-
-				for (dInt32 i = 0; i < threadCount; i++)
-				{
-					node = node ? node->GetNext() : nullptr;
-				}
 			}
 		}
 	};
 
+	// skeletons are handed to the threads one at a time, most expensive first, 
+	// so that a few large articulations do not end up in the same thread.
+	const ndSkeletonList& skeletonList = m_world->GetSkeletonList();
+	m_skeletonArray.SetCount(skeletonList.GetCount());
+	dInt32 index = 0;
+	for (ndSkeletonList::dListNode* node = skeletonList.GetFirst(); node; node = node->GetNext())
+	{
+		m_skeletonArray[index] = &node->GetInfo();
+		index++;
+	}
+	dSort(&m_skeletonArray[0], m_skeletonArray.GetCount(), CompareSkeletons);
+
+	dAtomic<dInt32> iterator(0);
 	ndScene* const scene = m_world->GetScene();
-	scene->SubmitJobs<ndInitSkeletons>();
+	scene->SubmitJobs<ndInitSkeletons>(&iterator);
 }
 
 void ndDynamicsUpdate::UpdateSkeletons()
@@ -1337,34 +1495,26 @@ void ndDynamicsUpdate::UpdateSkeletons()
 		virtual void Execute()
 		{
 			//D_TRACKTIME();
-			const dInt32 threadIndex = GetThredId();
 			ndWorld* const world = m_owner->GetWorld();
-			ndSkeletonList::dListNode* node = world->GetSkeletonList().GetFirst();
-			for (dInt32 i = 0; i < threadIndex; i++)
-			{
-				node = node ? node->GetNext() : nullptr;
-			}
+			dAtomic<dInt32>& iterator = *((dAtomic<dInt32>*)m_context);
+			const dArray<ndSkeletonContainer*>& skeletonArray = world->m_skeletonArray;
 
 			ndJacobian* const internalForces = &world->m_internalForces[0];
 			const dArray<ndBodyKinematic*>& ativeBodies = m_owner->ndScene::GetActiveBodyArray();
 			const ndBodyKinematic** const bodyArray = (const ndBodyKinematic**)&ativeBodies[0];
 
-			const dInt32 threadCount = m_owner->GetThreadCount();
-			while (node)
+			const dInt32 count = skeletonArray.GetCount();
+			for (dInt32 i = iterator.fetch_add(1); i < count; i = iterator.fetch_add(1))
 			{
-				ndSkeletonContainer* const skeleton = &node->GetInfo();
+				ndSkeletonContainer* const skeleton = skeletonArray[i];
 				skeleton->CalculateJointForce(bodyArray, internalForces);
-
-				for (dInt32 i = 0; i < threadCount; i++)
-				{
-					node = node ? node->GetNext() : nullptr;
-				}
 			}
 		}
 	};
 
+	dAtomic<dInt32> iterator(0);
 	ndScene* const scene = m_world->GetScene();
-	scene->SubmitJobs<ndUpdateSkeletons>();
+	scene->SubmitJobs<ndUpdateSkeletons>(&iterator);
 }
 
 void ndDynamicsUpdate::CalculateJointsForce()
@@ -1377,9 +1527,7 @@ void ndDynamicsUpdate::CalculateJointsForce()
 		{
 			//D_TRACKTIME();
 			ndWorld* const world = m_owner->GetWorld();
-			ndConstraintArray& jointArray = world->m_jointArray;
-			dFloat32 accNorm = dFloat32(0.0f);
-			const dInt32 jointCount = jointArray.GetCount();
+			const dInt32 jointCount = world->m_jointArray.GetCount();
 			const dInt32 bodyCount = m_owner->GetActiveBodyArray().GetCount();
 			const dInt32 threadCount = dMax(m_owner->GetThreadCount(), 1);
 			if (threadCount == 1)
@@ -1387,11 +1535,8 @@ void ndDynamicsUpdate::CalculateJointsForce()
 				ndJacobian* const internalForces = &world->m_internalForces[bodyCount];
 				for (dInt32 i = 0; i < jointCount; i++)
 				{
-					ndConstraint* const joint = jointArray[i];
-					accNorm += world->CalculateJointsForce(joint, internalForces);
+					CalculateJointForce(world, i, internalForces);
 				}
-				dFloat32* const accelNorm = (dFloat32*)m_context;
-				accelNorm[0] = accNorm;
 			}
 			else
 			{
@@ -1401,14 +1546,27 @@ void ndDynamicsUpdate::CalculateJointsForce()
 				const dInt32 count = ((threadIndex + 1) < threadCount) ? step : jointCount - start;
 
 				ndJacobian* const internalForces = &world->m_internalForces[bodyCount * (threadIndex + 1)];
-				memset(internalForces, 0, bodyCount * sizeof(ndJacobian));
+				memset((void*)internalForces, 0, bodyCount * sizeof(ndJacobian));
 				for (dInt32 i = 0; i < count; i++)
 				{
-					ndConstraint* const joint = jointArray[i + start];
-					accNorm += world->CalculateJointsForce(joint, internalForces);
+					CalculateJointForce(world, i + start, internalForces);
 				}
-				dFloat32* const accelNorm = (dFloat32*)m_context;
-				accelNorm[threadIndex] = accNorm;
+			}
+		}
+
+		void CalculateJointForce(ndWorld* const world, dInt32 index, ndJacobian* const internalForces) const
+		{
+			// joints of converged islands keep their forces from the last pass.
+			ndConstraint* const joint = world->m_jointArray[index];
+			const dInt32 island = world->m_jointIsland[index];
+			if ((island < 0) || (world->m_islands[island].m_residual > D_SOLVER_MAX_ERROR))
+			{
+				world->m_jointResidual[index] = world->CalculateJointsForce(joint, &world->m_internalForces[0], internalForces);
+			}
+			else
+			{
+				world->m_jointResidual[index] = dFloat32(0.0f);
+				world->AddJointForce(joint, internalForces);
 			}
 		}
 	};
@@ -1444,28 +1602,156 @@ void ndDynamicsUpdate::CalculateJointsForce()
 		}
 	};
 
+	class ndCalculateJointsForceBlock : public ndScene::ndBaseJob
+	{
+		public:
+		virtual void Execute()
+		{
+			//D_TRACKTIME();
+			ndWorld* const world = m_owner->GetWorld();
+			ndConstraintArray& jointArray = world->m_jointArray;
+			const dInt32 threadIndex = GetThredId();
+			const dInt32 threadCount = dMax(m_owner->GetThreadCount(), 1);
+			const dInt32 jointCount = jointArray.GetCount();
+			const dInt32 bodyCount = m_owner->GetActiveBodyArray().GetCount();
+			const dInt32 step = jointCount / threadCount;
+			const dInt32 start = threadIndex * step;
+			const dInt32 count = ((threadIndex + 1) < threadCount) ? step : jointCount - start;
+
+			// the thread starts from the body forces of the last synchronization, 
+			// and its own joints see each other changes right away.
+			ndJacobian* const bodyForces = &world->m_internalForces[bodyCount * (threadIndex + 1)];
+			memcpy((void*)bodyForces, &world->m_internalForces[0], bodyCount * sizeof(ndJacobian));
+
+			for (dInt32 k = 0; k < D_SOLVER_BLOCK_SWEEPS; k++)
+			{
+				for (dInt32 i = 0; i < count; i++)
+				{
+					// the forces of joints of converged islands are already in the body forces.
+					const dInt32 index = i + start;
+					const dInt32 island = world->m_jointIsland[index];
+					if ((island >= 0) && (world->m_islands[island].m_residual <= D_SOLVER_MAX_ERROR))
+					{
+						world->m_jointResidual[index] = dFloat32(0.0f);
+						continue;
+					}
+
+					ndConstraint* const joint = jointArray[index];
+					const dInt32 rowStart = joint->m_rowStart;
+					const dInt32 m0 = joint->GetBody0()->m_index;
+					const dInt32 m1 = joint->GetBody1()->m_index;
+
+					dVector forceM0(dVector::m_zero);
+					dVector torqueM0(dVector::m_zero);
+					dVector forceM1(dVector::m_zero);
+					dVector torqueM1(dVector::m_zero);
+					for (dInt32 j = 0; j < joint->m_rowCount; j++)
+					{
+						const ndRightHandSide* const rhs = &world->m_rightHandSide[rowStart + j];
+						const ndLeftHandSide* const lhs = &world->m_leftHandSide[rowStart + j];
+						const dVector f(rhs->m_force);
+						forceM0 = forceM0.MulAdd(lhs->m_Jt.m_jacobianM0.m_linear, f);
+						torqueM0 = torqueM0.MulAdd(lhs->m_Jt.m_jacobianM0.m_angular, f);
+						forceM1 = forceM1.MulAdd(lhs->m_Jt.m_jacobianM1.m_linear, f);
+						torqueM1 = torqueM1.MulAdd(lhs->m_Jt.m_jacobianM1.m_angular, f);
+					}
+
+					// add the new joint forces and remove the old ones.
+					world->m_jointResidual[index] = world->CalculateJointsForce(joint, bodyForces, bodyForces);
+					bodyForces[m0].m_linear -= forceM0;
+					bodyForces[m0].m_angular -= torqueM0;
+					bodyForces[m1].m_linear -= forceM1;
+					bodyForces[m1].m_angular -= torqueM1;
+				}
+			}
+		}
+	};
+
+	class ndAccumulateBlockForces : public ndScene::ndBaseJob
+	{
+		public:
+		virtual void Execute()
+		{
+			//D_TRACKTIME();
+			ndWorld* const world = m_owner->GetWorld();
+			const dInt32 threadIndex = GetThredId();
+			const dInt32 threadCount = m_owner->GetThreadCount();
+			const dInt32 bodyCount = m_owner->GetActiveBodyArray().GetCount();
+			const dInt32 step = bodyCount / threadCount;
+			const dInt32 start = threadIndex * step;
+			const dInt32 count = ((threadIndex + 1) < threadCount) ? step : bodyCount - start;
+
+			// each block changed the body forces by the forces of its own joints.
+			ndJacobian* const internalForces = &world->m_internalForces[0];
+			for (dInt32 i = 0; i < count; i++)
+			{
+				const dInt32 base = i + start;
+				const dVector force0(internalForces[base].m_linear);
+				const dVector torque0(internalForces[base].m_angular);
+				dVector force(force0);
+				dVector torque(torque0);
+				for (dInt32 j = 1; j <= threadCount; j++)
+				{
+					force += internalForces[bodyCount * j + base].m_linear - force0;
+					torque += internalForces[bodyCount * j + base].m_angular - torque0;
+				}
+				internalForces[base].m_linear = force;
+				internalForces[base].m_angular = torque;
+			}
+		}
+	};
+
 	ndScene* const scene = m_world->GetScene();
-	const dInt32 passes = m_solverPasses;
 	const dInt32 bodyCount = scene->GetActiveBodyArray().GetCount();
 	const dInt32 threadsCount = dMax(scene->GetThreadCount(), 1);
 
-	dFloat32 m_accelNorm[D_MAX_THREADS_COUNT];
-	dFloat32 accNorm = D_SOLVER_MAX_ERROR * dFloat32(2.0f);
+	// every island starts the pass still converging, and stops
+	// getting passes once the residual of its joints is small enough.
+	const dInt32 islandCount = m_islands.GetCount() - m_unConstrainedBodyCount;
+	for (dInt32 i = 0; i < islandCount; i++)
+	{
+		m_islands[i].m_residual = D_SOLVER_MAX_ERROR * dFloat32(2.0f);
+	}
 
-	for (dInt32 i = 0; (i < passes) && (accNorm > D_SOLVER_MAX_ERROR); i++)
+	bool converging = true;
+	if (m_world->m_solver == 2)
+	{
+		// block jacobi: each thread runs several gauss seidel sweeps over its 
+		// own joints between synchronizations, so the joints are visited the 
+		// same number of times with fewer barriers.
+		const dInt32 passes = dMax(dInt32(m_solverPasses + D_SOLVER_BLOCK_SWEEPS - 1) / D_SOLVER_BLOCK_SWEEPS, 1);
+		for (dInt32 i = 0; (i < passes) && converging; i++)
+		{
+			scene->SubmitJobs<ndCalculateJointsForceBlock>();
+			if (threadsCount == 1)
+			{
+				memcpy((void*)&m_internalForces[0], &m_internalForces[bodyCount], bodyCount * sizeof(ndJacobian));
+			}
+			else
+			{
+				scene->SubmitJobs<ndAccumulateBlockForces>();
+			}
+			converging = UpdateIslandResiduals(D_SOLVER_BLOCK_SWEEPS);
+		}
+		return;
+	}
+
+	const dInt32 passes = m_solverPasses;
+
+	for (dInt32 i = 0; (i < passes) && converging; i++)
 	{
 #ifdef D_PROFILE_JOINTS
 		dUnsigned64 cpuClock = dGetCpuClock();
 #endif
 		if (threadsCount == 1)
 		{
-			memset(&m_internalForces[bodyCount], 0, bodyCount * sizeof(ndJacobian));
-			scene->SubmitJobs<ndCalculateJointsForce>(m_accelNorm);
-			memcpy(&m_internalForces[0], &m_internalForces[bodyCount], bodyCount * sizeof(ndJacobian));
+			memset((void*)&m_internalForces[bodyCount], 0, bodyCount * sizeof(ndJacobian));
+			scene->SubmitJobs<ndCalculateJointsForce>();
+			memcpy((void*)&m_internalForces[0], &m_internalForces[bodyCount], bodyCount * sizeof(ndJacobian));
 		}
 		else
 		{
-			scene->SubmitJobs<ndCalculateJointsForce>(m_accelNorm);
+			scene->SubmitJobs<ndCalculateJointsForce>();
 			scene->SubmitJobs<ndInitJacobianAccumulatePartialForces>();
 		}
 
@@ -1486,11 +1772,7 @@ void ndDynamicsUpdate::CalculateJointsForce()
 		}
 #endif
 
-		accNorm = dFloat32(0.0f);
-		for (dInt32 j = 0; j < threadsCount; j++)
-		{
-			accNorm = dMax(accNorm, m_accelNorm[j]);
-		}
+		converging = UpdateIslandResiduals(1);
 	}
 }
 
@@ -33,6 +33,7 @@
 #define D_SMALL_ISLAND_COUNT			32
 #define	D_FREEZZING_VELOCITY_DRAG		dFloat32 (0.9f)
 #define	D_SOLVER_MAX_ERROR				(D_FREEZE_MAG * dFloat32 (0.5f))
+#define	D_SOLVER_BLOCK_SWEEPS			2
 
 //#define D_CCD_EXTRA_CONTACT_COUNT			(8 * 3)
 
@@ -69,25 +70,57 @@ class ndDynamicsUpdate
 		ndBodyKinematic* m_root;
 	};
 
+	// m_iterations are the solver passes the island got in the last step, 
+	// the passes stop once the island residual is below D_SOLVER_MAX_ERROR.
+	// m_initialResidual is the residual of the first pass, it shows how good 
+	// the warm start from the last step forces was, m_residual is the last one.
 	class ndIsland
 	{
 		public:
 		ndIsland(ndBodyKinematic* const root)
 			:m_start(0)
 			,m_count(0)
+			,m_iterations(0)
+			,m_initialResidual(dFloat32(0.0f))
+			,m_residual(dFloat32(0.0f))
 			,m_root(root)
 		{
 		}
 
 		dInt32 m_start;
 		dInt32 m_count;
+		dInt32 m_iterations;
+		dFloat32 m_initialResidual;
+		dFloat32 m_residual;
 		ndBodyKinematic* m_root;
 	};
 
+	// per step copy of the state the velocity integrator reads, one contiguous 
+	// array per field in the constrained bodies order of m_bodyIslandOrder.
+	// the velocities stay in the bodies because the joints read them there.
+	class ndBodyStateArray
+	{
+		public:
+		ndBodyStateArray();
+		void SetCount(dInt32 count);
+		void Resize(dInt32 count);
+
+		dArray<dMatrix> m_invInertia;
+		dArray<dVector> m_invMass;
+		dArray<dVector> m_force;
+		dArray<dVector> m_torque;
+		dArray<ndBodyDynamic*> m_body;
+		dArray<dInt32> m_index;
+		dArray<dInt32> m_gyroscopic;
+	};
+
 	public:
 	ndDynamicsUpdate();
 	~ndDynamicsUpdate();
 
+	// only valid while the world is synchronized.
+	const dArray<ndIsland>& GetIslands() const;
+
 	protected:
 	void Update();
 	void UpdateAvx2();
@@ -112,9 +145,12 @@ class ndDynamicsUpdate
 	void UpdateIslandState(const ndIsland& island);
 	void GetJacobianDerivatives(ndConstraint* const joint);
 	void BuildJacobianMatrix(ndConstraint* const joint, ndJacobian* const output);
-	dFloat32 CalculateJointsForce(ndConstraint* const joint, ndJacobian* const output);
+	dFloat32 CalculateJointsForce(ndConstraint* const joint, const ndJacobian* const bodyForces, ndJacobian* const output);
+	void AddJointForce(const ndConstraint* const joint, ndJacobian* const output) const;
+	bool UpdateIslandResiduals(dInt32 iterations);
 
 	static dInt32 CompareIslands(const ndIsland* const  A, const ndIsland* const B, void* const context);
+	static dInt32 CompareSkeletons(ndSkeletonContainer* const* const skeletonA, ndSkeletonContainer* const* const skeletonB, void* const context);
 	ndBodyKinematic* FindRootAndSplit(ndBodyKinematic* const body);
 
 	// Avx2 solver implementation
@@ -142,8 +178,12 @@ class ndDynamicsUpdate
 
 	dVector m_velocTol;
 	dArray<ndIsland> m_islands;
+	dArray<dInt32> m_jointIsland;
+	dArray<dFloat32> m_jointResidual;
 	dArray<ndBodyKinematic*> m_bodyIslandOrder;
 	dArray<ndJacobian> m_internalForces;
+	ndBodyStateArray m_bodyState;
+	dArray<ndSkeletonContainer*> m_skeletonArray;
 	ndConstraintArray m_jointArray;
 	dArray<ndLeftHandSide> m_leftHandSide;
 	dArray<ndRightHandSide> m_rightHandSide;
@@ -170,6 +210,11 @@ class ndDynamicsUpdate
 } D_GCC_NEWTON_ALIGN_32;
 
 
+inline const dArray<ndDynamicsUpdate::ndIsland>& ndDynamicsUpdate::GetIslands() const
+{
+	return m_islands;
+}
+
 inline ndBodyKinematic* ndDynamicsUpdate::FindRootAndSplit(ndBodyKinematic* const body)
 {
 	ndBodyKinematic* node = body;
@@ -0,0 +1,40 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include "dCoreStdafx.h"
+#include "ndNewtonStdafx.h"
+#include "ndForceField.h"
+
+ndForceField::ndForceField()
+	:dClassAlloc()
+	,m_minBox(dFloat32(-1.0e10f))
+	,m_maxBox(dFloat32(1.0e10f))
+	,m_node(nullptr)
+{
+	m_minBox.m_w = dFloat32(0.0f);
+	m_maxBox.m_w = dFloat32(0.0f);
+}
+
+ndForceField::~ndForceField()
+{
+	dAssert(!m_node);
+}
@@ -0,0 +1,126 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef __D_FORCE_FIELD_H__
+#define __D_FORCE_FIELD_H__
+
+#include "ndNewtonStdafx.h"
+#include "ndForceFieldList.h"
+
+#define D_FORCE_FIELD_BATCH_SIZE	64
+
+class ndBodyDynamic;
+
+// a force field adds forces to all the dynamic bodies whose center of mass is inside its box.
+// fields are evaluated by the world after the body notifications, over batches of bodies
+// whose state is copied to structure of arrays, so a field costs one virtual call per batch
+// and can process four bodies at once. The batch is padded to a multiple of four with
+// massless entries, whose forces are ignored.
+D_MSV_NEWTON_ALIGN_32
+class ndForceField: public dClassAlloc
+{
+	public:
+	D_MSV_NEWTON_ALIGN_32
+	class ndSoaVector
+	{
+		public:
+		dVector Get(dInt32 i) const;
+		void Set(dInt32 i, const dVector& v);
+
+		dFloat32 m_x[D_FORCE_FIELD_BATCH_SIZE];
+		dFloat32 m_y[D_FORCE_FIELD_BATCH_SIZE];
+		dFloat32 m_z[D_FORCE_FIELD_BATCH_SIZE];
+	} D_GCC_NEWTON_ALIGN_32;
+
+	D_MSV_NEWTON_ALIGN_32
+	class ndBodyBatch
+	{
+		public:
+		ndSoaVector m_posit;
+		ndSoaVector m_veloc;
+		ndSoaVector m_omega;
+		ndSoaVector m_minBox;
+		ndSoaVector m_maxBox;
+		ndSoaVector m_force;
+		ndSoaVector m_torque;
+		dFloat32 m_mass[D_FORCE_FIELD_BATCH_SIZE];
+		ndBodyDynamic* m_bodies[D_FORCE_FIELD_BATCH_SIZE];
+		dInt32 m_count;
+	} D_GCC_NEWTON_ALIGN_32;
+
+	D_NEWTON_API ndForceField();
+	D_NEWTON_API virtual ~ndForceField();
+
+	void GetBox(dVector& minBox, dVector& maxBox) const;
+	void SetBox(const dVector& minBox, const dVector& maxBox);
+
+	// adds the force and torque of the field to the bodies of the batch,
+	// it is called from the world threads.
+	virtual void ApplyForces(ndBodyBatch& batch, dFloat32 timestep) const = 0;
+
+	protected:
+	// mask of the four bodies from index i whose center of mass is inside the box of the field
+	dVector IsInside(const ndBodyBatch& batch, dInt32 i) const;
+
+	dVector m_minBox;
+	dVector m_maxBox;
+	ndForceFieldList::dListNode* m_node;
+
+	friend class ndWorld;
+} D_GCC_NEWTON_ALIGN_32;
+
+inline void ndForceField::GetBox(dVector& minBox, dVector& maxBox) const
+{
+	minBox = m_minBox;
+	maxBox = m_maxBox;
+}
+
+inline void ndForceField::SetBox(const dVector& minBox, const dVector& maxBox)
+{
+	m_minBox = minBox & dVector::m_triplexMask;
+	m_maxBox = maxBox & dVector::m_triplexMask;
+}
+
+inline dVector ndForceField::IsInside(const ndBodyBatch& batch, dInt32 i) const
+{
+	const dVector x(&batch.m_posit.m_x[i]);
+	const dVector y(&batch.m_posit.m_y[i]);
+	const dVector z(&batch.m_posit.m_z[i]);
+	const dVector insideX((x >= m_minBox.BroadcastX()) & (x <= m_maxBox.BroadcastX()));
+	const dVector insideY((y >= m_minBox.BroadcastY()) & (y <= m_maxBox.BroadcastY()));
+	const dVector insideZ((z >= m_minBox.BroadcastZ()) & (z <= m_maxBox.BroadcastZ()));
+	return insideX & insideY & insideZ;
+}
+
+inline dVector ndForceField::ndSoaVector::Get(dInt32 i) const
+{
+	return dVector(m_x[i], m_y[i], m_z[i], dFloat32(0.0f));
+}
+
+inline void ndForceField::ndSoaVector::Set(dInt32 i, const dVector& v)
+{
+	m_x[i] = v.m_x;
+	m_y[i] = v.m_y;
+	m_z[i] = v.m_z;
+}
+
+#endif
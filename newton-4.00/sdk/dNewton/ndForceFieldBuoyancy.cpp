@@ -0,0 +1,91 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include "dCoreStdafx.h"
+#include "ndNewtonStdafx.h"
+#include "ndBodyDynamic.h"
+#include "ndForceFieldBuoyancy.h"
+
+ndForceFieldBuoyancy::ndForceFieldBuoyancy(const dPlane& plane, const dVector& gravity, dFloat32 density)
+	:ndForceField()
+	,m_plane(plane)
+	,m_gravity(gravity & dVector::m_triplexMask)
+	,m_density(dMax(density, dFloat32(0.0f)))
+	,m_linearDrag(dFloat32(1.0f))
+	,m_angularDrag(dFloat32(1.0f))
+{
+}
+
+void ndForceFieldBuoyancy::ApplyForces(ndBodyBatch& batch, dFloat32) const
+{
+	const dVector half(dVector::m_half);
+	const dVector nx(m_plane.BroadcastX());
+	const dVector ny(m_plane.BroadcastY());
+	const dVector nz(m_plane.BroadcastZ());
+	const dVector nw(m_plane.BroadcastW());
+	const dVector absNx(nx.Abs());
+	const dVector absNy(ny.Abs());
+	const dVector absNz(nz.Abs());
+	for (dInt32 i = 0; i < batch.m_count; i += 4)
+	{
+		// only bodies with a corner of the aabb below the plane can be submerged,
+		// the volume integral is only calculated for those.
+		const dVector minX(&batch.m_minBox.m_x[i]);
+		const dVector minY(&batch.m_minBox.m_y[i]);
+		const dVector minZ(&batch.m_minBox.m_z[i]);
+		const dVector maxX(&batch.m_maxBox.m_x[i]);
+		const dVector maxY(&batch.m_maxBox.m_y[i]);
+		const dVector maxZ(&batch.m_maxBox.m_z[i]);
+		const dVector center(nx * (maxX + minX) + ny * (maxY + minY) + nz * (maxZ + minZ));
+		const dVector size(absNx * (maxX - minX) + absNy * (maxY - minY) + absNz * (maxZ - minZ));
+		const dVector dist((center - size) * half + nw);
+		const dVector mask((dist < dVector::m_zero) & (dVector(&batch.m_mass[i]) > dVector::m_zero) & IsInside(batch, i));
+		dInt32 laneMask = mask.GetSignMask();
+		for (dInt32 j = i; laneMask; j++, laneMask >>= 1)
+		{
+			if (laneMask & 1)
+			{
+				ApplyBuoyancy(batch, j);
+			}
+		}
+	}
+}
+
+void ndForceFieldBuoyancy::ApplyBuoyancy(ndBodyBatch& batch, dInt32 index) const
+{
+	ndBodyDynamic* const body = batch.m_bodies[index];
+	const ndShapeInstance& shape = body->GetCollisionShape();
+	dVector centerOfPressure;
+	const dFloat32 volume = shape.CalculateBuoyancyCenterOfPresure(centerOfPressure, body->GetMatrix(), m_plane);
+	if (volume > dFloat32(0.0f))
+	{
+		const dVector posit(batch.m_posit.Get(index));
+		const dVector force(m_gravity.Scale(-m_density * volume));
+		const dVector torque((centerOfPressure - posit).CrossProduct(force));
+		const dFloat32 fraction = dMin(volume / shape.GetVolume(), dFloat32(1.0f));
+		const dVector mass(body->GetMassMatrix());
+		const dMatrix& matrix = body->GetMatrix();
+		const dVector omega(matrix.RotateVector(matrix.UnrotateVector(batch.m_omega.Get(index)) * mass));
+		batch.m_force.Set(index, batch.m_force.Get(index) + force - batch.m_veloc.Get(index).Scale(mass.m_w * m_linearDrag * fraction));
+		batch.m_torque.Set(index, batch.m_torque.Get(index) + torque - omega.Scale(m_angularDrag * fraction));
+	}
+}
@@ -0,0 +1,90 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef __D_FORCE_FIELD_BUOYANCY_H__
+#define __D_FORCE_FIELD_BUOYANCY_H__
+
+#include "ndNewtonStdafx.h"
+#include "ndForceField.h"
+
+// Archimedes buoyancy of a fluid below a plane, the fluid is on the negative side of the plane.
+// the force is the weight of the fluid displaced by the submerged part of the collision shape,
+// applied at its center of pressure, plus a drag proportional to the submerged fraction.
+D_MSV_NEWTON_ALIGN_32
+class ndForceFieldBuoyancy: public ndForceField
+{
+	public:
+	D_NEWTON_API ndForceFieldBuoyancy(const dPlane& plane, const dVector& gravity, dFloat32 density);
+
+	dPlane GetPlane() const;
+	void SetPlane(const dPlane& plane);
+
+	dFloat32 GetDensity() const;
+	void SetDensity(dFloat32 density);
+
+	void GetDrag(dFloat32& linearDrag, dFloat32& angularDrag) const;
+	void SetDrag(dFloat32 linearDrag, dFloat32 angularDrag);
+
+	protected:
+	D_NEWTON_API virtual void ApplyForces(ndBodyBatch& batch, dFloat32 timestep) const;
+	void ApplyBuoyancy(ndBodyBatch& batch, dInt32 index) const;
+
+	dPlane m_plane;
+	dVector m_gravity;
+	dFloat32 m_density;
+	dFloat32 m_linearDrag;
+	dFloat32 m_angularDrag;
+} D_GCC_NEWTON_ALIGN_32;
+
+inline dPlane ndForceFieldBuoyancy::GetPlane() const
+{
+	return m_plane;
+}
+
+inline void ndForceFieldBuoyancy::SetPlane(const dPlane& plane)
+{
+	m_plane = plane;
+}
+
+inline dFloat32 ndForceFieldBuoyancy::GetDensity() const
+{
+	return m_density;
+}
+
+inline void ndForceFieldBuoyancy::SetDensity(dFloat32 density)
+{
+	m_density = dMax(density, dFloat32(0.0f));
+}
+
+inline void ndForceFieldBuoyancy::GetDrag(dFloat32& linearDrag, dFloat32& angularDrag) const
+{
+	linearDrag = m_linearDrag;
+	angularDrag = m_angularDrag;
+}
+
+inline void ndForceFieldBuoyancy::SetDrag(dFloat32 linearDrag, dFloat32 angularDrag)
+{
+	m_linearDrag = dMax(linearDrag, dFloat32(0.0f));
+	m_angularDrag = dMax(angularDrag, dFloat32(0.0f));
+}
+
+#endif
@@ -0,0 +1,45 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include "dCoreStdafx.h"
+#include "ndNewtonStdafx.h"
+#include "ndForceFieldGravity.h"
+
+ndForceFieldGravity::ndForceFieldGravity(const dVector& gravity)
+	:ndForceField()
+	,m_gravity(gravity & dVector::m_triplexMask)
+{
+}
+
+void ndForceFieldGravity::ApplyForces(ndBodyBatch& batch, dFloat32) const
+{
+	const dVector gx(m_gravity.BroadcastX());
+	const dVector gy(m_gravity.BroadcastY());
+	const dVector gz(m_gravity.BroadcastZ());
+	for (dInt32 i = 0; i < batch.m_count; i += 4)
+	{
+		const dVector mass(dVector(&batch.m_mass[i]) & IsInside(batch, i));
+		(dVector(&batch.m_force.m_x[i]) + gx * mass).Store(&batch.m_force.m_x[i]);
+		(dVector(&batch.m_force.m_y[i]) + gy * mass).Store(&batch.m_force.m_y[i]);
+		(dVector(&batch.m_force.m_z[i]) + gz * mass).Store(&batch.m_force.m_z[i]);
+	}
+}
@@ -0,0 +1,60 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include "dCoreStdafx.h"
+#include "ndNewtonStdafx.h"
+#include "ndForceFieldRadial.h"
+
+ndForceFieldRadial::ndForceFieldRadial(const dVector& center, dFloat32 radius, dFloat32 strength)
+	:ndForceField()
+	,m_center(center & dVector::m_triplexMask)
+	,m_radius(dMax(radius, dFloat32(1.0e-3f)))
+	,m_strength(strength)
+{
+}
+
+void ndForceFieldRadial::ApplyForces(ndBodyBatch& batch, dFloat32) const
+{
+	const dVector cx(m_center.BroadcastX());
+	const dVector cy(m_center.BroadcastY());
+	const dVector cz(m_center.BroadcastZ());
+	const dVector minDist2(dFloat32(1.0e-6f));
+	const dVector radius2(m_radius * m_radius);
+	const dVector invRadius(dFloat32(1.0f) / m_radius);
+	const dVector strength(m_strength);
+	for (dInt32 i = 0; i < batch.m_count; i += 4)
+	{
+		const dVector dx(cx - dVector(&batch.m_posit.m_x[i]));
+		const dVector dy(cy - dVector(&batch.m_posit.m_y[i]));
+		const dVector dz(cz - dVector(&batch.m_posit.m_z[i]));
+		const dVector dist2(dx * dx + dy * dy + dz * dz);
+		const dVector mask((dist2 < radius2) & (dist2 > minDist2) & IsInside(batch, i));
+
+		// the force fades linearly to zero at the radius
+		const dVector invDist(dist2.GetMax(minDist2).InvSqrt());
+		const dVector dist(dist2 * invDist);
+		const dVector accel((strength * (dVector::m_one - dist * invRadius) * invDist * dVector(&batch.m_mass[i])) & mask);
+		(dVector(&batch.m_force.m_x[i]) + dx * accel).Store(&batch.m_force.m_x[i]);
+		(dVector(&batch.m_force.m_y[i]) + dy * accel).Store(&batch.m_force.m_y[i]);
+		(dVector(&batch.m_force.m_z[i]) + dz * accel).Store(&batch.m_force.m_z[i]);
+	}
+}
@@ -0,0 +1,84 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef __D_FORCE_FIELD_RADIAL_H__
+#define __D_FORCE_FIELD_RADIAL_H__
+
+#include "ndNewtonStdafx.h"
+#include "ndForceField.h"
+
+// acceleration toward the center, positive strength attracts and negative repels.
+// the strength fades linearly from the center to zero at the radius.
+D_MSV_NEWTON_ALIGN_32
+class ndForceFieldRadial: public ndForceField
+{
+	public:
+	D_NEWTON_API ndForceFieldRadial(const dVector& center, dFloat32 radius, dFloat32 strength);
+
+	dVector GetCenter() const;
+	void SetCenter(const dVector& center);
+
+	dFloat32 GetRadius() const;
+	void SetRadius(dFloat32 radius);
+
+	dFloat32 GetStrength() const;
+	void SetStrength(dFloat32 strength);
+
+	protected:
+	D_NEWTON_API virtual void ApplyForces(ndBodyBatch& batch, dFloat32 timestep) const;
+
+	dVector m_center;
+	dFloat32 m_radius;
+	dFloat32 m_strength;
+} D_GCC_NEWTON_ALIGN_32;
+
+inline dVector ndForceFieldRadial::GetCenter() const
+{
+	return m_center;
+}
+
+inline void ndForceFieldRadial::SetCenter(const dVector& center)
+{
+	m_center = center & dVector::m_triplexMask;
+}
+
+inline dFloat32 ndForceFieldRadial::GetRadius() const
+{
+	return m_radius;
+}
+
+inline void ndForceFieldRadial::SetRadius(dFloat32 radius)
+{
+	m_radius = dMax(radius, dFloat32(1.0e-3f));
+}
+
+inline dFloat32 ndForceFieldRadial::GetStrength() const
+{
+	return m_strength;
+}
+
+inline void ndForceFieldRadial::SetStrength(dFloat32 strength)
+{
+	m_strength = strength;
+}
+
+#endif
@@ -0,0 +1,69 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+* 
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* 
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef __D_FORCE_FIELD_WIND_H__
+#define __D_FORCE_FIELD_WIND_H__
+
+#include "ndNewtonStdafx.h"
+#include "ndForceField.h"
+
+// linear drag toward the wind velocity, for the bodies inside the field box.
+D_MSV_NEWTON_ALIGN_32
+class ndForceFieldWind: public ndForceField
+{
+	public:
+	D_NEWTON_API ndForceFieldWind(const dVector& minBox, const dVector& maxBox, const dVector& velocity, dFloat32 drag);
+
+	dVector GetVelocity() const;
+	void SetVelocity(const dVector& velocity);
+
+	dFloat32 GetDrag() const;
+	void SetDrag(dFloat32 drag);
+
+	protected:
+	D_NEWTON_API virtual void ApplyForces(ndBodyBatch& batch, dFloat32 timestep) const;
+
+	dVector m_velocity;
+	dFloat32 m_drag;
+} D_GCC_NEWTON_ALIGN_32;
+
+inline dVector ndForceFieldWind::GetVelocity() const
+{
+	return m_velocity;
+}
+
+inline void ndForceFieldWind::SetVelocity(const dVector& velocity)
+{
+	m_velocity = velocity & dVector::m_triplexMask;
+}
+
+inline dFloat32 ndForceFieldWind::GetDrag() const
+{
+	return m_drag;
+}
+
+inline void ndForceFieldWind::SetDrag(dFloat32 drag)
+{
+	m_drag = dMax(drag, dFloat32(0.0f));
+}
+
+#endif
@@ -43,24 +43,33 @@
 #include <ndJointHinge.h>
 #include <ndBodyNotify.h>
 #include <ndSceneMixed.h>
+#include <ndSceneSegregated.h>
+#include <ndSceneSweepAndPrune.h>
 #include <ndSolverAvx2.h>
 #include <ndJointWheel.h>
 #include <ndJointSlider.h>
+#include <ndForceField.h>
 #include <ndShapeConvex.h>
 #include <ndBodyDynamic.h>
 #include <ndContactList.h>
 #include <ndBodySphFluid.h>
 #include <ndSkeletonList.h>
 #include <ndBodyKinematic.h>
+#include <ndForceFieldWind.h>
 #include <ndContactSolver.h>
 #include <ndShapeInstance.h>
 #include <ndRayCastNotify.h>
 #include <ndContactNotify.h>
 #include <ndDynamicsUpdate.h>
+#include <ndForceFieldList.h>
 #include <ndBodyParticleSet.h>
+#include <ndForceFieldRadial.h>
 #include <ndJointDoubleHinge.h>
+#include <ndForceFieldGravity.h>
 #include <ndMultiBodyVehicle.h>
+#include <ndForceFieldBuoyancy.h>
 #include <ndSkeletonContainer.h>
+#include <ndStaticWorldStreamer.h>
 #include <ndJointBallAndSocket.h>
 #include <ndBodyParticleSetList.h>
 #include <ndJointKinematicController.h>
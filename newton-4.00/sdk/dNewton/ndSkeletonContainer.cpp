@@ -80,17 +80,6 @@ ndSkeletonContainer::ndNode* ndSkeletonContainer::FindNode(ndBodyKinematic* cons
 	return nullptr;
 }
 
-void ndSkeletonContainer::RemoveLoopJoint(ndJointBilateralConstraint* const joint)
-{
-	for (dInt32 i = 0; i < m_loopCount; i++) {
-		if (m_loopingJoints[i] == joint) {
-			joint->m_isInSkeleton = false;
-			m_loopCount--;
-			m_loopingJoints[i] = m_loopingJoints[m_loopCount];
-			break;
-		}
-	}
-}
 #endif
 
 dInt64 ndSkeletonContainer::ndNode::m_ordinalInit = 0x050403020100ll;
@@ -514,6 +503,36 @@ void ndSkeletonContainer::Finalize(dInt32 loopJointsCount, ndJointBilateralConst
 	}
 }
 
+void ndSkeletonContainer::AddLoopJoint(ndJointBilateralConstraint* const joint)
+{
+	dAssert(!joint->m_isInSkeleton);
+	// the self collision joints are rebuilt every step, so they can be overwritten here
+	m_dynamicsLoopCount = 0;
+	if (m_loopingJoints.GetCount() < (m_loopCount + 1))
+	{
+		m_loopingJoints.SetCount(2 * (m_loopCount + 1));
+	}
+	m_loopingJoints[m_loopCount] = joint;
+	m_loopCount++;
+	joint->m_isInSkeleton = true;
+}
+
+bool ndSkeletonContainer::RemoveLoopJoint(ndJointBilateralConstraint* const joint)
+{
+	for (dInt32 i = 0; i < m_loopCount; i++) 
+	{
+		if (m_loopingJoints[i] == joint) 
+		{
+			joint->m_isInSkeleton = false;
+			m_dynamicsLoopCount = 0;
+			m_loopCount--;
+			m_loopingJoints[i] = m_loopingJoints[m_loopCount];
+			return true;
+		}
+	}
+	return false;
+}
+
 void ndSkeletonContainer::ClearSelfCollision()
 {
 	m_dynamicsLoopCount = 0;
@@ -1018,12 +1037,8 @@ void ndSkeletonContainer::InitLoopMassMatrix()
 			const dFloat32* const row = &m_massMatrix11[rowStart];
 			for (dInt32 j = 0; j < i; j++) 
 			{
-				const dFloat32 s = row[j];
 				const dFloat32* const x = &m_massMatrix11[j * m_auxiliaryRowCount + m_blockSize];
-				for (dInt32 k = 0; k < boundedSize; k++) 
-				{
-					acc[k] += s * x[k];
-				}
+				dRowMulAdd(boundedSize, acc, x, row[j]);
 			}
 
 			dFloat32* const x = &m_massMatrix11[rowStart + m_blockSize];
@@ -1042,10 +1057,7 @@ void ndSkeletonContainer::InitLoopMassMatrix()
 			{
 				const dFloat32 s = m_massMatrix11[j * m_auxiliaryRowCount + i];
 				const dFloat32* const x = &m_massMatrix11[j * m_auxiliaryRowCount + m_blockSize];
-				for (dInt32 k = 0; k < boundedSize; k++) 
-				{
-					acc[k] += s * x[k];
-				}
+				dRowMulAdd(boundedSize, acc, x, s);
 			}
 
 			dFloat32* const x = &m_massMatrix11[i * m_auxiliaryRowCount + m_blockSize];
@@ -1067,7 +1079,7 @@ void ndSkeletonContainer::InitLoopMassMatrix()
 			for (int j = i; j < boundedSize; j++) 
 			{
 				const dFloat32* const row1 = &m_massMatrix11[(m_blockSize + j) * m_auxiliaryRowCount];
-				dFloat32 elem = row1[m_blockSize + i] + dDotProduct(m_blockSize, acc, row1);
+				dFloat32 elem = row1[m_blockSize + i] + dRowDotProduct(m_blockSize, acc, row1);
 				arow[j] = elem;
 				m_massMatrix11[(m_blockSize + j) * m_auxiliaryRowCount + m_blockSize + i] = elem;
 			}
@@ -1258,7 +1270,7 @@ void ndSkeletonContainer::SolveLcp(dInt32 stride, dInt32 size, const dFloat32* c
 		for (dInt32 i = 0; i < size; i++) 
 		{
 			const dFloat32* const row = &matrix[base];
-			residual[i] = b[i] - dDotProduct(size, row, x);
+			residual[i] = b[i] - dRowDotProduct(size, row, x);
 			base += stride;
 		}
 
@@ -1301,10 +1313,7 @@ void ndSkeletonContainer::SolveLcp(dInt32 stride, dInt32 size, const dFloat32* c
 				x[i] = f;
 				if (dAbs(dx) > dFloat32(1.0e-6f)) 
 				{
-					for (dInt32 j = 0; j < size; j++) 
-					{
-						residual[j] -= row[j] * dx;
-					}
+					dRowMulAdd(size, residual, row, -dx);
 				}
 				base += stride;
 			}
@@ -1324,7 +1333,7 @@ void ndSkeletonContainer::SolveBlockLcp(dInt32 size, dInt32 blockSize, const dFl
 			dInt32 base = blockSize * size;
 			for (dInt32 i = blockSize; i < size; i++) 
 			{
-				b[i] -= dDotProduct(blockSize, &m_massMatrix11[base], x);
+				b[i] -= dRowDotProduct(blockSize, &m_massMatrix11[base], x);
 				base += size;
 			}
 
@@ -1336,12 +1345,7 @@ void ndSkeletonContainer::SolveBlockLcp(dInt32 size, dInt32 blockSize, const dFl
 			for (dInt32 j = 0; j < blockSize; j++) 
 			{
 				const dFloat32* const row = &m_massMatrix11[j * size + blockSize];
-				dFloat32 acc = dFloat32(0.0f);
-				for (dInt32 i = 0; i < boundedSize; i++) 
-				{
-					acc += x[blockSize + i] * row[i];
-				}
-				x[j] += acc;
+				x[j] += dRowDotProduct(boundedSize, &x[blockSize], row);
 			}
 		}
 	}
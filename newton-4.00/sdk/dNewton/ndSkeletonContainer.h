@@ -118,9 +118,13 @@ class ndSkeletonContainer
 	void Init(ndBodyKinematic* const rootBody);
 
 	ndNode* GetRoot() const;
+	dInt32 GetSolverCost() const;
 	ndNode* AddChild(ndJointBilateralConstraint* const joint, ndNode* const parent);
 	void Finalize(dInt32 loopJoints, ndJointBilateralConstraint** const loopJointArray);
 
+	void AddLoopJoint(ndJointBilateralConstraint* const joint);
+	bool RemoveLoopJoint(ndJointBilateralConstraint* const joint);
+
 	void ClearSelfCollision();
 	void AddSelfCollisionJoint(ndConstraint* const joint);
 	void CalculateJointForce(const ndBodyKinematic** const bodyArray, ndJacobian* const internalForces);
@@ -148,7 +152,6 @@ class ndSkeletonContainer
 #if 0
 
 	dInt32 GetJointCount () const {return m_nodeCount - 1;}
-	void RemoveLoopJoint(ndJointBilateralConstraint* const joint);  
 	ndBodyKinematic* GetBody(ndNode* const node) const;
 	ndJointBilateralConstraint* GetJoint(ndNode* const node) const;
 	ndNode* GetParent (ndNode* const node) const;
@@ -188,6 +191,12 @@ inline ndSkeletonContainer::ndNode* ndSkeletonContainer::GetRoot() const
 	return m_skeleton;
 }
 
+// relative cost of the factorization and solve, from the row counts of the last step.
+inline dInt32 ndSkeletonContainer::GetSolverCost() const
+{
+	return m_nodeList.GetCount() + m_auxiliaryRowCount * m_auxiliaryRowCount;
+}
+
 #endif
 
 
@@ -44,6 +44,13 @@ class ndSkeletonList: public dList<ndSkeletonContainer, dContainersFreeListAlloc
 		return container;
 	}
 
+	// the remaining joints of a destroyed skeleton are regrouped in the next update
+	void DestroyContatiner(ndSkeletonContainer* const container)
+	{
+		Remove(GetNodeFromInfo(*container));
+		m_skelListIsDirty = true;
+	}
+
 	bool m_skelListIsDirty;
 };
 
@@ -0,0 +1,375 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "dCoreStdafx.h"
+#include "ndNewtonStdafx.h"
+#include "ndWorld.h"
+#include "ndBodyDynamic.h"
+#include "ndStaticWorldStreamer.h"
+
+ndStaticWorldStreamer::ndStaticWorldStreamer(const char* const tilePath, dFloat32 tileSize, dFloat32 loadRadius, dUnsigned64 memoryBudget)
+	:dClassAlloc()
+	,dThread()
+	,m_tiles()
+	,m_requestQueue()
+	,m_doneQueue()
+	,m_observers()
+	,m_observersPosit()
+	,m_statistics()
+	,m_world(nullptr)
+	,m_lock()
+	,m_memoryBudget(memoryBudget)
+	,m_tileSize(dMax(tileSize, dFloat32(1.0f)))
+	,m_loadRadius(dMax(loadRadius, dFloat32(0.0f)))
+	,m_maxTilesPerUpdate(2)
+{
+	strncpy(m_tilePath, tilePath, sizeof(m_tilePath) - 1);
+	m_tilePath[sizeof(m_tilePath) - 1] = 0;
+	SetName("staticStreamer");
+}
+
+ndStaticWorldStreamer::~ndStaticWorldStreamer()
+{
+	Finish();
+
+	// the loader is gone, anything still in the queues belong to us now.
+	m_requestQueue.RemoveAll();
+	m_doneQueue.RemoveAll();
+	while (m_tiles.GetRoot())
+	{
+		DeleteTile(m_world, &m_tiles.GetRoot()->GetInfo());
+	}
+}
+
+void ndStaticWorldStreamer::AddObserver(const ndBodyKinematic* const body)
+{
+	dScopeSpinLock lock(m_lock);
+	for (dInt32 i = 0; i < m_observers.GetCount(); i++)
+	{
+		if (m_observers[i] == body)
+		{
+			return;
+		}
+	}
+	m_observers.PushBack(body);
+}
+
+void ndStaticWorldStreamer::RemoveObserver(const ndBodyKinematic* const body)
+{
+	dScopeSpinLock lock(m_lock);
+	for (dInt32 i = 0; i < m_observers.GetCount(); i++)
+	{
+		if (m_observers[i] == body)
+		{
+			m_observers[i] = m_observers[m_observers.GetCount() - 1];
+			m_observers.SetCount(m_observers.GetCount() - 1);
+			break;
+		}
+	}
+}
+
+void ndStaticWorldStreamer::GetTileName(dInt32 x, dInt32 z, char* const name, dInt32 maxSize) const
+{
+	snprintf(name, size_t(maxSize), "%s/tile_%d_%d.bin", m_tilePath, x, z);
+}
+
+ndBodyKinematic* ndStaticWorldStreamer::CreateTileBody(ndShapeStaticBVH* const shape, dInt32, dInt32) const
+{
+	ndBodyDynamic* const body = new ndBodyDynamic();
+	body->SetMatrix(dGetIdentityMatrix());
+	body->SetCollisionShape(ndShapeInstance(shape));
+	return body;
+}
+
+void ndStaticWorldStreamer::SaveTile(const dPolygonSoupBuilder& builder, dInt32 x, dInt32 z) const
+{
+	char name[1024];
+	GetTileName(x, z, name, sizeof(name));
+	ndShapeInstance shape(new ndShapeStaticBVH(builder));
+	((ndShapeStaticBVH*)shape.GetShape())->Serialize(name);
+}
+
+void ndStaticWorldStreamer::ThreadFunction()
+{
+	D_TRACKTIME();
+	ndTile* tile = nullptr;
+	{
+		dScopeSpinLock lock(m_lock);
+		if (m_requestQueue.GetCount())
+		{
+			tile = m_requestQueue.GetFirst()->GetInfo();
+			m_requestQueue.Remove(m_requestQueue.GetFirst());
+			if (tile->m_cancel)
+			{
+				m_doneQueue.Append(tile);
+				tile = nullptr;
+			}
+		}
+	}
+
+	if (tile)
+	{
+		char name[1024];
+		GetTileName(tile->m_x, tile->m_z, name, sizeof(name));
+		FILE* const file = fopen(name, "rb");
+		if (file)
+		{
+			fclose(file);
+			tile->m_shape = new ndShapeStaticBVH(name);
+			tile->m_bytes = tile->m_shape->GetMemoryUsed();
+		}
+
+		dScopeSpinLock lock(m_lock);
+		m_doneQueue.Append(tile);
+	}
+}
+
+void ndStaticWorldStreamer::Update(ndWorld* const world)
+{
+	D_TRACKTIME();
+	m_world = world;
+	{
+		dScopeSpinLock lock(m_lock);
+		m_observersPosit.SetCount(0);
+		for (dInt32 i = 0; i < m_observers.GetCount(); i++)
+		{
+			m_observersPosit.PushBack(m_observers[i]->GetMatrix().m_posit);
+		}
+	}
+
+	CommitTiles(world);
+	RequestTiles();
+	EvictTiles(world);
+}
+
+void ndStaticWorldStreamer::CommitTiles(ndWorld* const world)
+{
+	dInt32 committed = 0;
+	while (committed < m_maxTilesPerUpdate)
+	{
+		ndTile* tile = nullptr;
+		bool cancel = false;
+		{
+			dScopeSpinLock lock(m_lock);
+			if (!m_doneQueue.GetCount())
+			{
+				break;
+			}
+			tile = m_doneQueue.GetFirst()->GetInfo();
+			m_doneQueue.Remove(m_doneQueue.GetFirst());
+			cancel = tile->m_cancel;
+		}
+
+		dAssert(tile->m_state == m_requested);
+		m_statistics.m_pendingTiles--;
+		if (cancel)
+		{
+			DeleteTile(world, tile);
+		}
+		else if (!tile->m_shape)
+		{
+			tile->m_state = m_empty;
+		}
+		else
+		{
+			tile->m_body = CreateTileBody(tile->m_shape, tile->m_x, tile->m_z);
+			tile->m_shape = nullptr;
+			tile->m_state = m_resident;
+			world->AddBody(tile->m_body);
+
+			const dFloat32 latency = dFloat32(dGetTimeInMicrosenconds() - tile->m_requestTime) * dFloat32(1.0e-6f);
+			const dFloat32 loaded = dFloat32(m_statistics.m_loadedTiles);
+			m_statistics.m_averageLoadLatency = (m_statistics.m_averageLoadLatency * loaded + latency) / (loaded + dFloat32(1.0f));
+			m_statistics.m_maxLoadLatency = dMax(m_statistics.m_maxLoadLatency, latency);
+			m_statistics.m_residentBytes += tile->m_bytes;
+			m_statistics.m_loadedBytes += tile->m_bytes;
+			m_statistics.m_residentTiles++;
+			m_statistics.m_loadedTiles++;
+			committed++;
+		}
+	}
+}
+
+void ndStaticWorldStreamer::RequestTiles()
+{
+	const dFloat32 halfSize = m_tileSize * dFloat32(0.5f);
+	const dFloat32 radius2 = m_loadRadius * m_loadRadius;
+
+	// distance from each tile to the closest observer
+	dArray<ndTile*> emptyTiles;
+	ndTileMap::Iterator iter(m_tiles);
+	for (iter.Begin(); iter; iter++)
+	{
+		ndTile& tile = iter.GetNode()->GetInfo();
+		const dFloat32 centerX = (dFloat32(tile.m_x) + dFloat32(0.5f)) * m_tileSize;
+		const dFloat32 centerZ = (dFloat32(tile.m_z) + dFloat32(0.5f)) * m_tileSize;
+		tile.m_distance2 = dFloat32(1.0e20f);
+		for (dInt32 i = 0; i < m_observersPosit.GetCount(); i++)
+		{
+			const dVector& posit = m_observersPosit[i];
+			const dFloat32 dx = dMax(dAbs(posit.m_x - centerX) - halfSize, dFloat32(0.0f));
+			const dFloat32 dz = dMax(dAbs(posit.m_z - centerZ) - halfSize, dFloat32(0.0f));
+			tile.m_distance2 = dMin(tile.m_distance2, dx * dx + dz * dz);
+		}
+
+		const bool inRange = tile.m_distance2 <= radius2;
+		if (tile.m_state == m_requested)
+		{
+			dScopeSpinLock lock(m_lock);
+			tile.m_cancel = !inRange;
+		}
+		else if ((tile.m_state == m_empty) && !inRange)
+		{
+			emptyTiles.PushBack(&tile);
+		}
+	}
+
+	for (dInt32 i = 0; i < emptyTiles.GetCount(); i++)
+	{
+		DeleteTile(m_world, emptyTiles[i]);
+	}
+
+	// new tiles in range of an observer
+	dArray<ndTile*> requests;
+	const dFloat32 invTileSize = dFloat32(1.0f) / m_tileSize;
+	for (dInt32 i = 0; i < m_observersPosit.GetCount(); i++)
+	{
+		const dVector& posit = m_observersPosit[i];
+		// tiles touching the load radius on either side are in range
+		const dInt32 x0 = dInt32(dCeil((posit.m_x - m_loadRadius) * invTileSize)) - 1;
+		const dInt32 x1 = dInt32(dFloor((posit.m_x + m_loadRadius) * invTileSize));
+		const dInt32 z0 = dInt32(dCeil((posit.m_z - m_loadRadius) * invTileSize)) - 1;
+		const dInt32 z1 = dInt32(dFloor((posit.m_z + m_loadRadius) * invTileSize));
+		for (dInt32 z = z0; z <= z1; z++)
+		{
+			const dFloat32 dz = dMax(dAbs(posit.m_z - (dFloat32(z) + dFloat32(0.5f)) * m_tileSize) - halfSize, dFloat32(0.0f));
+			for (dInt32 x = x0; x <= x1; x++)
+			{
+				const dFloat32 dx = dMax(dAbs(posit.m_x - (dFloat32(x) + dFloat32(0.5f)) * m_tileSize) - halfSize, dFloat32(0.0f));
+				const dFloat32 dist2 = dx * dx + dz * dz;
+				if (dist2 <= radius2)
+				{
+					bool found = false;
+					ndTileMap::dTreeNode* const node = m_tiles.FindCreate(GetKey(x, z), found);
+					ndTile& tile = node->GetInfo();
+					if (!found)
+					{
+						tile.m_shape = nullptr;
+						tile.m_body = nullptr;
+						tile.m_bytes = 0;
+						tile.m_requestTime = dGetTimeInMicrosenconds();
+						tile.m_distance2 = dist2;
+						tile.m_x = x;
+						tile.m_z = z;
+						tile.m_state = m_requested;
+						tile.m_cancel = false;
+						requests.PushBack(&tile);
+					}
+					tile.m_distance2 = dMin(tile.m_distance2, dist2);
+				}
+			}
+		}
+	}
+
+	if (requests.GetCount())
+	{
+		// nearest tiles are loaded first
+		dSort(&requests[0], requests.GetCount(), CompareTiles);
+		{
+			dScopeSpinLock lock(m_lock);
+			for (dInt32 i = 0; i < requests.GetCount(); i++)
+			{
+				m_requestQueue.Append(requests[i]);
+			}
+		}
+		m_statistics.m_pendingTiles += requests.GetCount();
+		for (dInt32 i = 0; i < requests.GetCount(); i++)
+		{
+			Signal();
+		}
+	}
+}
+
+void ndStaticWorldStreamer::EvictTiles(ndWorld* const world)
+{
+	if (m_statistics.m_residentBytes <= m_memoryBudget)
+	{
+		return;
+	}
+
+	const dFloat32 radius2 = m_loadRadius * m_loadRadius;
+	dArray<ndTile*> candidates;
+	ndTileMap::Iterator iter(m_tiles);
+	for (iter.Begin(); iter; iter++)
+	{
+		ndTile& tile = iter.GetNode()->GetInfo();
+		if ((tile.m_state == m_resident) && (tile.m_distance2 > radius2))
+		{
+			candidates.PushBack(&tile);
+		}
+	}
+
+	if (candidates.GetCount())
+	{
+		dSort(&candidates[0], candidates.GetCount(), CompareTiles);
+		for (dInt32 i = candidates.GetCount() - 1; (i >= 0) && (m_statistics.m_residentBytes > m_memoryBudget); i--)
+		{
+			m_statistics.m_evictedTiles++;
+			DeleteTile(world, candidates[i]);
+		}
+	}
+}
+
+void ndStaticWorldStreamer::DeleteTile(ndWorld* const world, ndTile* const tile)
+{
+	if (tile->m_body)
+	{
+		dAssert(tile->m_state == m_resident);
+		m_statistics.m_residentBytes -= tile->m_bytes;
+		m_statistics.m_residentTiles--;
+		if (world)
+		{
+			world->DeleteBody(tile->m_body);
+		}
+		else
+		{
+			delete tile->m_body;
+		}
+	}
+	if (tile->m_shape)
+	{
+		delete tile->m_shape;
+	}
+	m_tiles.Remove(m_tiles.GetNodeFromInfo(*tile));
+}
+
+dInt32 ndStaticWorldStreamer::CompareTiles(ndTile* const* const tileA, ndTile* const* const tileB, void* const)
+{
+	if ((*tileA)->m_distance2 < (*tileB)->m_distance2)
+	{
+		return -1;
+	}
+	else if ((*tileA)->m_distance2 > (*tileB)->m_distance2)
+	{
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,190 @@
+/* Copyright (c) <2003-2019> <Julio Jerez, Newton Game Dynamics>
+*
+* This software is provided 'as-is', without any express or implied
+* warranty. In no event will the authors be held liable for any damages
+* arising from the use of this software.
+*
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+*
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+*
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+*
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __D_STATIC_WORLD_STREAMER_H__
+#define __D_STATIC_WORLD_STREAMER_H__
+
+#include "ndNewtonStdafx.h"
+
+class ndWorld;
+
+// pages the static collision of a large world in square tiles on the x-z plane.
+// each tile is a serialized ndShapeStaticBVH in world space. Tiles in range of
+// an observer are loaded by a background thread and added to the world at the
+// beginning of the next update, tiles out of range are evicted, farthest first,
+// when the resident memory goes over budget.
+class ndStaticWorldStreamer: public dClassAlloc, public dThread
+{
+	public:
+	class ndStatistics
+	{
+		public:
+		ndStatistics()
+			:m_residentBytes(0)
+			,m_loadedBytes(0)
+			,m_averageLoadLatency(dFloat32 (0.0f))
+			,m_maxLoadLatency(dFloat32(0.0f))
+			,m_residentTiles(0)
+			,m_pendingTiles(0)
+			,m_loadedTiles(0)
+			,m_evictedTiles(0)
+		{
+		}
+
+		dUnsigned64 m_residentBytes;
+		dUnsigned64 m_loadedBytes;
+		dFloat32 m_averageLoadLatency;
+		dFloat32 m_maxLoadLatency;
+		dInt32 m_residentTiles;
+		dInt32 m_pendingTiles;
+		dInt32 m_loadedTiles;
+		dInt32 m_evictedTiles;
+	};
+
+	D_NEWTON_API ndStaticWorldStreamer(const char* const tilePath, dFloat32 tileSize, dFloat32 loadRadius, dUnsigned64 memoryBudget);
+	D_NEWTON_API virtual ~ndStaticWorldStreamer();
+
+	// observers are removed automatically when their body is removed from the world.
+	D_NEWTON_API void AddObserver(const ndBodyKinematic* const body);
+	D_NEWTON_API void RemoveObserver(const ndBodyKinematic* const body);
+	dInt32 GetObserverCount() const;
+
+	D_NEWTON_API void SaveTile(const dPolygonSoupBuilder& builder, dInt32 x, dInt32 z) const;
+
+	dFloat32 GetTileSize() const;
+	dFloat32 GetLoadRadius() const;
+	void SetLoadRadius(dFloat32 radius);
+
+	dUnsigned64 GetMemoryBudget() const;
+	void SetMemoryBudget(dUnsigned64 budget);
+
+	dInt32 GetMaxTilesPerUpdate() const;
+	void SetMaxTilesPerUpdate(dInt32 count);
+
+	// only valid while the world is synchronized.
+	const ndStatistics& GetStatistics() const;
+
+	protected:
+	D_NEWTON_API virtual void GetTileName(dInt32 x, dInt32 z, char* const name, dInt32 maxSize) const;
+	D_NEWTON_API virtual ndBodyKinematic* CreateTileBody(ndShapeStaticBVH* const shape, dInt32 x, dInt32 z) const;
+
+	private:
+	enum ndTileState
+	{
+		m_requested,
+		m_resident,
+		m_empty,
+	};
+
+	class ndTile
+	{
+		public:
+		ndShapeStaticBVH* m_shape;
+		ndBodyKinematic* m_body;
+		dUnsigned64 m_bytes;
+		dUnsigned64 m_requestTime;
+		dFloat32 m_distance2;
+		dInt32 m_x;
+		dInt32 m_z;
+		ndTileState m_state;
+		bool m_cancel;
+	};
+
+	typedef dTree<ndTile, dUnsigned64> ndTileMap;
+
+	void Update(ndWorld* const world);
+	void CommitTiles(ndWorld* const world);
+	void RequestTiles();
+	void EvictTiles(ndWorld* const world);
+	void DeleteTile(ndWorld* const world, ndTile* const tile);
+	virtual void ThreadFunction();
+
+	static dUnsigned64 GetKey(dInt32 x, dInt32 z);
+	static dInt32 CompareTiles(ndTile* const* const tileA, ndTile* const* const tileB, void* const context);
+
+	char m_tilePath[256];
+	ndTileMap m_tiles;
+	dList<ndTile*> m_requestQueue;
+	dList<ndTile*> m_doneQueue;
+	dArray<const ndBodyKinematic*> m_observers;
+	dArray<dVector> m_observersPosit;
+	ndStatistics m_statistics;
+	ndWorld* m_world;
+	dSpinLock m_lock;
+	dUnsigned64 m_memoryBudget;
+	dFloat32 m_tileSize;
+	dFloat32 m_loadRadius;
+	dInt32 m_maxTilesPerUpdate;
+
+	friend class ndWorld;
+};
+
+inline dInt32 ndStaticWorldStreamer::GetObserverCount() const
+{
+	return m_observers.GetCount();
+}
+
+inline dFloat32 ndStaticWorldStreamer::GetTileSize() const
+{
+	return m_tileSize;
+}
+
+inline dFloat32 ndStaticWorldStreamer::GetLoadRadius() const
+{
+	return m_loadRadius;
+}
+
+inline void ndStaticWorldStreamer::SetLoadRadius(dFloat32 radius)
+{
+	m_loadRadius = dMax(radius, dFloat32(0.0f));
+}
+
+inline dUnsigned64 ndStaticWorldStreamer::GetMemoryBudget() const
+{
+	return m_memoryBudget;
+}
+
+inline void ndStaticWorldStreamer::SetMemoryBudget(dUnsigned64 budget)
+{
+	m_memoryBudget = budget;
+}
+
+inline dInt32 ndStaticWorldStreamer::GetMaxTilesPerUpdate() const
+{
+	return m_maxTilesPerUpdate;
+}
+
+inline void ndStaticWorldStreamer::SetMaxTilesPerUpdate(dInt32 count)
+{
+	m_maxTilesPerUpdate = dMax(count, 1);
+}
+
+inline const ndStaticWorldStreamer::ndStatistics& ndStaticWorldStreamer::GetStatistics() const
+{
+	return m_statistics;
+}
+
+inline dUnsigned64 ndStaticWorldStreamer::GetKey(dInt32 x, dInt32 z)
+{
+	return (dUnsigned64(dUnsigned32(x)) << 32) | dUnsigned64(dUnsigned32(z));
+}
+
+#endif
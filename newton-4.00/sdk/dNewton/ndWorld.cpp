@@ -24,9 +24,11 @@
 #include "ndWorld.h"
 #include "ndModel.h"
 #include "ndWorldScene.h"
+#include "ndForceField.h"
 #include "ndBodyDynamic.h"
 #include "ndSkeletonList.h"
 #include "ndBodyParticleSet.h"
+#include "ndStaticWorldStreamer.h"
 #include "ndJointBilateralConstraint.h"
 
 ndWorld::ndWorld()
@@ -36,8 +38,10 @@ ndWorld::ndWorld()
 	,m_sentinelBody(nullptr)
 	,m_jointList()
 	,m_modelList()
+	,m_forceFieldList()
 	,m_skeletonList()
 	,m_particleSetList()
+	,m_staticStreamer(nullptr)
 	,m_timestep(dFloat32 (0.0f))
 	,m_freezeAccel2(D_FREEZE_ACCEL2)
 	,m_freezeAlpha2(D_FREEZE_ACCEL2)
@@ -48,6 +52,7 @@ ndWorld::ndWorld()
 	,m_averageFramesCount(dFloat32(0.0f))
 	,m_lastExecutionTime(dFloat32(0.0f))
 	,m_solver(0)
+	,m_selectedScene(0)
 	,m_subSteps(1)
 	,m_solverIterations(4)
 	,m_frameIndex(0)
@@ -93,6 +98,14 @@ ndWorld::~ndWorld()
 {
 	Sync();
 
+	if (m_staticStreamer)
+	{
+		// the streamer deletes its tiles bodies, it can not be asked to remove them as observers
+		ndStaticWorldStreamer* const streamer = m_staticStreamer;
+		m_staticStreamer = nullptr;
+		delete streamer;
+	}
+
 	while (m_skeletonList.GetFirst())
 	{
 		m_skeletonList.Remove(m_skeletonList.GetFirst());
@@ -119,6 +132,13 @@ ndWorld::~ndWorld()
 		delete model;
 	}
 
+	while (m_forceFieldList.GetFirst())
+	{
+		ndForceField* const field = m_forceFieldList.GetFirst()->GetInfo();
+		RemoveForceField(field);
+		delete field;
+	}
+
 	const ndBodyList& bodyList = GetBodyList();
 	while (bodyList.GetFirst())
 	{
@@ -139,14 +159,12 @@ void ndWorld::ClearCache()
 	ndContact::FlushFreeList();
 	ndBodyList::FlushFreeList();
 	ndModelList::FlushFreeList();
+	ndForceFieldList::FlushFreeList();
 	ndJointList::FlushFreeList();
-	ndContactList::FlushFreeList();
 	ndSkeletonList::FlushFreeList();
 	ndContactPointList::FlushFreeList();
 	ndBodyParticleSetList::FlushFreeList();
 	ndScene::ndFitnessList::FlushFreeList();
-	dIsoSurface::dIsoVertexMap::FlushFreeList();
-	ndBodyKinematic::ndContactMap::FlushFreeList();
 	ndSkeletonContainer::ndNodeList::FlushFreeList();
 }
 
@@ -191,17 +209,80 @@ void ndWorld::ApplyExternalForces()
 			const dInt32 count = ((threadIndex + 1) < threadCount) ? step : bodyCount - start;
 			const dFloat32 timestep = m_timestep;
 
+			const ndForceFieldList& fieldList = ((ndWorld*)m_context)->m_forceFieldList;
+			const bool hasFields = fieldList.GetCount() ? true : false;
+
+			ndForceField::ndBodyBatch batch;
+			batch.m_count = 0;
 			for (dInt32 i = 0; i < count; i++)
 			{
 				ndBodyDynamic* const body = bodyArray[start + i]->GetAsBodyDynamic();
 				if (body)
 				{
 					body->ApplyExternalForces(threadIndex, timestep);
+					if (hasFields && (body->GetInvMass() > dFloat32(0.0f)))
+					{
+						dVector minBox;
+						dVector maxBox;
+						body->GetAABB(minBox, maxBox);
+						const dInt32 index = batch.m_count;
+						const dMatrix& matrix = body->GetMatrix();
+						batch.m_posit.Set(index, matrix.TransformVector(body->GetCentreOfMass()));
+						batch.m_veloc.Set(index, body->GetVelocity());
+						batch.m_omega.Set(index, body->GetOmega());
+						batch.m_minBox.Set(index, minBox);
+						batch.m_maxBox.Set(index, maxBox);
+						batch.m_mass[index] = body->GetMassMatrix().m_w;
+						batch.m_bodies[index] = body;
+						batch.m_count = index + 1;
+						if (batch.m_count == D_FORCE_FIELD_BATCH_SIZE)
+						{
+							ApplyForceFields(fieldList, batch, timestep);
+						}
+					}
 				}
 			}
+			if (batch.m_count)
+			{
+				ApplyForceFields(fieldList, batch, timestep);
+			}
+		}
+
+		void ApplyForceFields(const ndForceFieldList& fieldList, ndForceField::ndBodyBatch& batch, dFloat32 timestep) const
+		{
+			// pad the batch to the simd width with massless bodies at the origin
+			for (dInt32 i = batch.m_count; i & 3; i++)
+			{
+				batch.m_posit.Set(i, dVector::m_zero);
+				batch.m_veloc.Set(i, dVector::m_zero);
+				batch.m_omega.Set(i, dVector::m_zero);
+				batch.m_minBox.Set(i, dVector::m_zero);
+				batch.m_maxBox.Set(i, dVector::m_zero);
+				batch.m_mass[i] = dFloat32(0.0f);
+				batch.m_bodies[i] = nullptr;
+			}
+			const dInt32 paddedCount = (batch.m_count + 3) & -4;
+			for (dInt32 i = 0; i < paddedCount; i++)
+			{
+				batch.m_force.Set(i, dVector::m_zero);
+				batch.m_torque.Set(i, dVector::m_zero);
+			}
+
+			for (ndForceFieldList::dListNode* node = fieldList.GetFirst(); node; node = node->GetNext())
+			{
+				node->GetInfo()->ApplyForces(batch, timestep);
+			}
+
+			for (dInt32 i = 0; i < batch.m_count; i++)
+			{
+				ndBodyDynamic* const body = batch.m_bodies[i];
+				body->SetForce(body->GetForce() + batch.m_force.Get(i));
+				body->SetTorque(body->GetTorque() + batch.m_torque.Get(i));
+			}
+			batch.m_count = 0;
 		}
 	};
-	m_scene->SubmitJobs<ndApplyExternalForces>();
+	m_scene->SubmitJobs<ndApplyExternalForces>(this);
 }
 
 void ndWorld::PostUpdate(dFloat32 timestep)
@@ -235,6 +316,11 @@ void ndWorld::RemoveBody(ndBody* const body)
 	if (kinematicBody)
 	{
 		m_scene->RemoveBody(kinematicBody);
+		if (m_staticStreamer)
+		{
+			// a body that leaves the world stops pulling in tiles
+			m_staticStreamer->RemoveObserver(kinematicBody);
+		}
 	}
 	else if (body->GetAsBodyParticleSet())
 	{
@@ -244,6 +330,64 @@ void ndWorld::RemoveBody(ndBody* const body)
 	}
 }
 
+void ndWorld::SelectScene(dInt32 scene)
+{
+	Sync();
+	scene = dClamp(scene, 0, 2);
+	if (scene != m_selectedScene)
+	{
+		ndScene* newScene = nullptr;
+		switch (scene)
+		{
+			case 1:
+				newScene = new ndWorldSegregatedScene(this);
+				break;
+			case 2:
+				newScene = new ndWorldSweepAndPruneScene(this);
+				break;
+			default:
+				newScene = new ndWorldMixedScene(this);
+		}
+		newScene->SetCount(m_scene->GetCount());
+		newScene->SetTimestep(m_scene->GetTimestep());
+		newScene->SetTransformExport(m_scene->GetTransformExport());
+
+		// the bodies are moved with the default notify of the new scene in both 
+		// scenes, so the user notify does not see them removed and added again.
+		ndContactNotify* const notify = m_scene->m_contactNotifyCallback;
+		m_scene->m_contactNotifyCallback = newScene->m_contactNotifyCallback;
+		while (m_scene->GetBodyList().GetFirst())
+		{
+			ndBodyKinematic* const body = m_scene->GetBodyList().GetFirst()->GetInfo();
+			m_scene->RemoveBody(body);
+			newScene->AddBody(body);
+		}
+
+		newScene->m_contactNotifyCallback = notify;
+		newScene->m_contactNotifyCallback->m_scene = newScene;
+		m_scene->m_contactNotifyCallback->m_scene = m_scene;
+
+		delete m_scene;
+		m_scene = newScene;
+		m_selectedScene = scene;
+	}
+}
+
+void ndWorld::SetStaticStreamer(ndStaticWorldStreamer* const streamer)
+{
+	Sync();
+	ndStaticWorldStreamer* const oldStreamer = m_staticStreamer;
+	m_staticStreamer = streamer;
+	if (oldStreamer && (oldStreamer != streamer))
+	{
+		delete oldStreamer;
+	}
+	if (m_staticStreamer)
+	{
+		m_staticStreamer->m_world = this;
+	}
+}
+
 void ndWorld::DeleteBody(ndBody* const body)
 {
 	RemoveBody(body);
@@ -265,7 +409,41 @@ void ndWorld::AddJoint(ndJointBilateralConstraint* const joint)
 	dAssert(joint->m_worldNode == nullptr);
 	if (joint->m_solverModel < 3)
 	{
-		m_skeletonList.m_skelListIsDirty = true;
+		// skeletons the joint does not touch keep their graph and buffers,
+		// a joint closing a loop on a single skeleton is added to its loop set.
+		ndBodyKinematic* const body0 = joint->GetBody0();
+		ndBodyKinematic* const body1 = joint->GetBody1();
+		ndSkeletonContainer* const skeleton0 = body0->GetSkeleton();
+		ndSkeletonContainer* const skeleton1 = body1->GetSkeleton();
+		if (skeleton0 || skeleton1)
+		{
+			bool isLoop = (joint->m_solverModel == 0);
+			isLoop = isLoop && (joint->m_preconditioner0 == dFloat32(1.0f));
+			isLoop = isLoop && (joint->m_preconditioner1 == dFloat32(1.0f));
+			isLoop = isLoop && (skeleton0 || (body0->GetInvMass() == dFloat32(0.0f)));
+			isLoop = isLoop && (skeleton1 || (body1->GetInvMass() == dFloat32(0.0f)));
+			isLoop = isLoop && (!skeleton0 || !skeleton1 || (skeleton0 == skeleton1));
+			if (isLoop)
+			{
+				ndSkeletonContainer* const skeleton = skeleton0 ? skeleton0 : skeleton1;
+				skeleton->AddLoopJoint(joint);
+			}
+			else
+			{
+				if (skeleton0)
+				{
+					m_skeletonList.DestroyContatiner(skeleton0);
+				}
+				if (skeleton1 && (skeleton1 != skeleton0))
+				{
+					m_skeletonList.DestroyContatiner(skeleton1);
+				}
+			}
+		}
+		else
+		{
+			m_skeletonList.m_skelListIsDirty = true;
+		}
 	}
 	joint->m_worldNode = m_jointList.Append(joint);
 	joint->m_body0Node = joint->GetBody0()->AttachJoint(joint);
@@ -277,14 +455,20 @@ void ndWorld::RemoveJoint(ndJointBilateralConstraint* const joint)
 	dAssert(joint->m_worldNode != nullptr);
 	dAssert(joint->m_body0Node != nullptr);
 	dAssert(joint->m_body1Node != nullptr);
+	if (joint->m_isInSkeleton)
+	{
+		ndSkeletonContainer* const skeleton = joint->GetBody0()->GetSkeleton() ? joint->GetBody0()->GetSkeleton() : joint->GetBody1()->GetSkeleton();
+		dAssert(skeleton);
+		if (!skeleton->RemoveLoopJoint(joint))
+		{
+			m_skeletonList.DestroyContatiner(skeleton);
+		}
+	}
+
 	joint->GetBody0()->DetachJoint(joint->m_body0Node);
 	joint->GetBody1()->DetachJoint(joint->m_body1Node);
 
 	m_jointList.Remove(joint->m_worldNode);
-	if (joint->m_solverModel < 3)
-	{
-		m_skeletonList.m_skelListIsDirty = true;
-	}
 	joint->m_worldNode = nullptr;
 	joint->m_body0Node = nullptr;
 	joint->m_body1Node = nullptr;
@@ -307,6 +491,23 @@ void ndWorld::RemoveModel(ndModel* const model)
 	}
 }
 
+void ndWorld::AddForceField(ndForceField* const field)
+{
+	if (!field->m_node)
+	{
+		field->m_node = m_forceFieldList.Append(field);
+	}
+}
+
+void ndWorld::RemoveForceField(ndForceField* const field)
+{
+	if (field->m_node)
+	{
+		m_forceFieldList.Remove(field->m_node);
+		field->m_node = nullptr;
+	}
+}
+
 dInt32 ndWorld::CompareJointByInvMass(const ndJointBilateralConstraint* const jointA, const ndJointBilateralConstraint* const jointB, void* notUsed)
 {
 	dInt32 modeA = jointA->m_solverModel;
@@ -342,15 +543,9 @@ void ndWorld::UpdateSkeletons()
 
 	if (m_skeletonList.m_skelListIsDirty) 
 	{
+		// only joints that are not part of a skeleton are grouped, 
+		// the skeletons already built are not changed.
 		m_skeletonList.m_skelListIsDirty = false;
-		ndSkeletonList::Iterator iter(m_skeletonList);
-		for (iter.Begin(); iter; iter++) 
-		{
-			dAssert(0);
-			//ndSkeletonContainer* const skeleton = iter.GetNode()->GetInfo();
-			//delete skeleton;
-		}
-		m_skeletonList.RemoveAll();
 
 		ndDynamicsUpdate& solverUpdate = *this;
 		ndConstraintArray& jointArray = solverUpdate.m_jointArray;
@@ -362,6 +557,9 @@ void ndWorld::UpdateSkeletons()
 			ndJointBilateralConstraint* const constraint = node->GetInfo();
 			dAssert(constraint && constraint->GetAsBilateral());
 			bool test = constraint->m_solverModel < 2;
+			test = test && !constraint->m_isInSkeleton;
+			test = test && !constraint->GetBody0()->GetSkeleton();
+			test = test && !constraint->GetBody1()->GetSkeleton();
 			test = test && (constraint->m_preconditioner0 == dFloat32(1.0f));
 			test = test && (constraint->m_preconditioner1 == dFloat32(1.0f));
 			if (test) 
@@ -370,8 +568,6 @@ void ndWorld::UpdateSkeletons()
 				constraint->m_mark = 1;
 				constraint->GetBody0()->m_skeletonMark = 1;
 				constraint->GetBody1()->m_skeletonMark = 1;
-				dAssert(!constraint->GetBody0()->GetSkeleton());
-				dAssert(!constraint->GetBody1()->GetSkeleton());
 				jointCount++;
 			}
 		}
@@ -772,6 +968,12 @@ void ndWorld::ThreadFunction()
 	else
 	{
 		D_TRACKTIME();
+		if (m_staticStreamer)
+		{
+			// add the tiles loaded in the background and evict the distant ones
+			m_staticStreamer->Update(this);
+		}
+
 		m_scene->Begin();
 		m_scene->BalanceScene();
 
@@ -847,13 +1049,13 @@ void ndWorld::SubStepUpdate(dFloat32 timestep)
 	ModelUpdate();
 
 	// calculate internal forces, integrate bodies and update matrices.
-	if (m_solver == 0)
+	if (m_solver == 1)
 	{
-		ndDynamicsUpdate::Update();
+		ndDynamicsUpdate::UpdateAvx2();
 	} 
 	else
 	{
-		ndDynamicsUpdate::UpdateAvx2();
+		ndDynamicsUpdate::Update();
 	}
 
 	UpdatePostlisteners();
@@ -25,6 +25,7 @@
 #include "ndNewtonStdafx.h"
 #include "ndJointList.h"
 #include "ndModelList.h"
+#include "ndForceFieldList.h"
 #include "ndSkeletonList.h"
 #include "ndDynamicsUpdate.h"
 #include "ndBodyParticleSetList.h"
@@ -32,6 +33,8 @@
 class ndWorld;
 class ndModel;
 class ndBodyDynamic;
+class ndForceField;
+class ndStaticWorldStreamer;
 class ndJointBilateralConstraint;
 
 #define D_NEWTON_ENGINE_MAJOR_VERSION 4
@@ -63,9 +66,16 @@ class ndWorld: public dClassAlloc, public ndDynamicsUpdate
 	dInt32 GetSubSteps() const;
 	void SetSubSteps(dInt32 subSteps);
 
+	// 0: default, 1: avx2, 2: block jacobi, each thread sweeps its own joints 
+	// a few times between synchronizations.
 	dInt32 GetSelectedSolver() const;
 	void SelectSolver(dInt32 solver);
 
+	// 0: static and dynamic bodies share one tree, 1: separate static and dynamic trees, 2: sweep and prune.
+	// changing the scene moves all the bodies to the new scene and deletes all contacts.
+	dInt32 GetSelectedScene() const;
+	D_NEWTON_API void SelectScene(dInt32 scene);
+
 	D_NEWTON_API bool AddBody(ndBody* const body);
 	D_NEWTON_API void RemoveBody(ndBody* const body);
 	D_NEWTON_API void AddJoint(ndJointBilateralConstraint* const joint);
@@ -74,8 +84,14 @@ class ndWorld: public dClassAlloc, public ndDynamicsUpdate
 	D_NEWTON_API void AddModel(ndModel* const model);
 	D_NEWTON_API void RemoveModel(ndModel* const model);
 
+	D_NEWTON_API void AddForceField(ndForceField* const field);
+	D_NEWTON_API void RemoveForceField(ndForceField* const field);
+
 	D_NEWTON_API void DeleteBody(ndBody* const body);
 
+	ndStaticWorldStreamer* GetStaticStreamer() const;
+	D_NEWTON_API void SetStaticStreamer(ndStaticWorldStreamer* const streamer);
+
 	D_NEWTON_API void Load(const char* const path);
 	D_NEWTON_API void Load(const nd::TiXmlElement* const rootNode, const char* const assetPath);
 	D_NEWTON_API virtual ndBody* LoadUserDefinedBody(const nd::TiXmlNode* const parentNode, const char* const bodyClassName, dTree<const ndShape*, dUnsigned32>& shapesCache, const char* const assetPath) const;
@@ -86,6 +102,7 @@ class ndWorld: public dClassAlloc, public ndDynamicsUpdate
 	const ndBodyList& GetBodyList() const;
 	const ndJointList& GetJointList() const;
 	const ndModelList& GetModelList() const;
+	const ndForceFieldList& GetForceFieldList() const;
 	const ndContactList& GetContactList() const;
 	const ndSkeletonList& GetSkeletonList() const;
 	const ndBodyParticleSetList& GetParticleList() const;
@@ -134,8 +151,10 @@ class ndWorld: public dClassAlloc, public ndDynamicsUpdate
 	ndBodyDynamic* m_sentinelBody;
 	ndJointList m_jointList;
 	ndModelList m_modelList;
+	ndForceFieldList m_forceFieldList;
 	ndSkeletonList m_skeletonList;
 	ndBodyParticleSetList m_particleSetList;
+	ndStaticWorldStreamer* m_staticStreamer;
 
 	dFloat32 m_timestep;
 	dFloat32 m_freezeAccel2;
@@ -150,6 +169,7 @@ class ndWorld: public dClassAlloc, public ndDynamicsUpdate
 	dgSolverProgressiveSleepEntry m_sleepTable[D_SLEEP_ENTRIES];
 
 	dInt32 m_solver;
+	dInt32 m_selectedScene;
 	dInt32 m_subSteps;
 	dInt32 m_solverIterations;
 	dUnsigned32 m_frameIndex;
@@ -159,6 +179,7 @@ class ndWorld: public dClassAlloc, public ndDynamicsUpdate
 	friend class ndDynamicsUpdate;
 	friend class ndWorldMixedScene;
 	friend class ndWorldSegregatedScene;
+	friend class ndWorldSweepAndPruneScene;
 } D_GCC_NEWTON_ALIGN_32;
 
 inline void ndWorld::Sync()
@@ -212,6 +233,11 @@ inline void ndWorld::SetContactNotify(ndContactNotify* const notify)
 }
 
 
+inline ndStaticWorldStreamer* ndWorld::GetStaticStreamer() const
+{
+	return m_staticStreamer;
+}
+
 inline ndBodyDynamic* ndWorld::GetSentinelBody() const
 {
 	return m_sentinelBody;
@@ -247,6 +273,11 @@ inline const ndModelList& ndWorld::GetModelList() const
 	return m_modelList;
 }
 
+inline const ndForceFieldList& ndWorld::GetForceFieldList() const
+{
+	return m_forceFieldList;
+}
+
 inline dFloat32 ndWorld::GetUpdateTime() const
 {
 	return m_lastExecutionTime;
@@ -291,7 +322,12 @@ inline dInt32 ndWorld::GetSelectedSolver() const
 
 inline void ndWorld::SelectSolver(dInt32 solver)
 {
-	m_solver = dClamp(solver, 0, 1);
+	m_solver = dClamp(solver, 0, 2);
+}
+
+inline dInt32 ndWorld::GetSelectedScene() const
+{
+	return m_selectedScene;
 }
 
 #endif
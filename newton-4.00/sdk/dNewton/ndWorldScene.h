@@ -54,11 +54,25 @@ class ndWorldMixedScene: public ndWorldScene<ndSceneMixed>
 	}
 };
 
-class ndWorldSegregatedScene: public ndWorldScene<ndSceneMixed>
+class ndWorldSegregatedScene: public ndWorldScene<ndSceneSegregated>
 {
 	public:
-		ndWorldSegregatedScene(ndWorld* const world)
-		:ndWorldScene<ndSceneMixed>(world)
+	ndWorldSegregatedScene(ndWorld* const world)
+		:ndWorldScene<ndSceneSegregated>(world)
+	{
+	}
+
+	void ThreadFunction()
+	{
+		m_world->ThreadFunction();
+	}
+};
+
+class ndWorldSweepAndPruneScene: public ndWorldScene<ndSceneSweepAndPrune>
+{
+	public:
+	ndWorldSweepAndPruneScene(ndWorld* const world)
+		:ndWorldScene<ndSceneSweepAndPrune>(world)
 	{
 	}
 